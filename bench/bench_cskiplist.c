@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <skiplist.h>
+#include <cskiplist.h>
+#include <zmalloc.h>
+
+/* Compares the lock free skiplist with a zskiplist behind a mutex, with a
+ * growing number of threads running a mix of lookups and updates over a
+ * preloaded set of keys. An update deletes a random key and inserts it
+ * back, so that the size doesn't change.
+ *
+ * Usage: bench_cskiplist [keys] [ops per thread] [update %] */
+
+#define BENCH_MAX_THREADS 8
+
+typedef struct benchArg {
+    cskiplist *csl;
+    zskiplist *zsl;
+    pthread_mutex_t *lock;
+    long keys, ops;
+    int updates;
+    uint64_t seed;
+    unsigned long found;
+} benchArg;
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+static uint64_t benchRand(uint64_t *s) {
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return *s * 0x2545f4914f6cdd1dULL;
+}
+
+static long *benchEle(long k) {
+    long *ele = zmalloc(sizeof(*ele));
+    *ele = k;
+    return ele;
+}
+
+static void *benchCsl(void *privdata) {
+    benchArg *arg = privdata;
+    long j, k;
+    int token;
+
+    for (j = 0; j < arg->ops; j++) {
+        uint64_t r = benchRand(&arg->seed);
+
+        k = (long)((r >> 8) % arg->keys);
+        if ((long)(r & 0xff) * 100 < arg->updates * 256) {
+            long *ele;
+
+            cslDelete(arg->csl, k, &k, sizeof(k));
+            ele = benchEle(k);
+            if (!cslInsert(arg->csl, k, ele, sizeof(k))) zfree(ele);
+        } else {
+            token = cslEnter(arg->csl);
+            if (cslFind(arg->csl, k, &k, sizeof(k))) arg->found++;
+            cslExit(arg->csl, token);
+        }
+    }
+    return NULL;
+}
+
+static void *benchZsl(void *privdata) {
+    benchArg *arg = privdata;
+    long j, k;
+
+    for (j = 0; j < arg->ops; j++) {
+        uint64_t r = benchRand(&arg->seed);
+
+        k = (long)((r >> 8) % arg->keys);
+        pthread_mutex_lock(arg->lock);
+        if ((long)(r & 0xff) * 100 < arg->updates * 256) {
+            zslDelete(arg->zsl, k, &k, sizeof(k), NULL);
+            zslInsert(arg->zsl, k, benchEle(k), sizeof(k));
+        } else {
+            if (zslGetRank(arg->zsl, k, &k, sizeof(k))) arg->found++;
+        }
+        pthread_mutex_unlock(arg->lock);
+    }
+    return NULL;
+}
+
+static double benchRun(int concurrent, int threads, long keys, long ops, int updates) {
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_t tids[BENCH_MAX_THREADS];
+    benchArg args[BENCH_MAX_THREADS];
+    cskiplist *csl = NULL;
+    zskiplist *zsl = NULL;
+    long long start, elapsed;
+    long j;
+
+    if (concurrent) csl = cslCreate(NULL);
+    else zsl = zslCreate(NULL);
+    for (j = 0; j < keys; j++) {
+        long k = (j * 7919) % keys;
+        if (concurrent) cslInsert(csl, k, benchEle(k), sizeof(k));
+        else zslInsert(zsl, k, benchEle(k), sizeof(k));
+    }
+
+    start = nstime();
+    for (j = 0; j < threads; j++) {
+        args[j] = (benchArg){csl, zsl, &lock, keys, ops, updates, 0x9e3779b97f4a7c15ULL*(j+1), 0};
+        pthread_create(&tids[j], NULL, concurrent ? benchCsl : benchZsl, &args[j]);
+    }
+    for (j = 0; j < threads; j++)
+        pthread_join(tids[j], NULL);
+    elapsed = nstime()-start;
+
+    if (concurrent) cslRelease(csl);
+    else zslFree(zsl);
+    return (double)ops*threads*1000/elapsed;
+}
+
+int main(int argc, char **argv) {
+    long keys = argc > 1 ? atol(argv[1]) : 200000;
+    long ops = argc > 2 ? atol(argv[2]) : 200000;
+    int updates = argc > 3 ? atoi(argv[3]) : 10;
+    int threads;
+
+    printf("%ld keys, %d%% updates, Mops/s\n", keys, updates);
+    printf("%-8s %12s %12s\n", "threads", "zsl+mutex", "cskiplist");
+    for (threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2) {
+        double locked = benchRun(0, threads, keys, ops, updates);
+        double lockfree = benchRun(1, threads, keys, ops, updates);
+        printf("%-8d %12.2f %12.2f\n", threads, locked, lockfree);
+    }
+    return 0;
+}
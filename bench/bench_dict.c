@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <dict.h>
+#include <util.h>
+
+/* Compares dictFindMany() / dictAddMany() against the equivalent loops of
+ * dictFind() / dictAdd(), on a table large enough not to fit in cache.
+ *
+ * Usage: bench_dict [keys] [batch] */
+
+static uint64_t benchHash(const void *key) {
+    return dictGenHashFunction(&key, sizeof(key));
+}
+
+static dictType benchType = {
+    .hashFunction = benchHash,
+};
+
+static void report(const char *name, long long start, unsigned long ops) {
+    long long elapsed = ustime()-start;
+
+    printf("%-24s %8.2f ns/op %10.0f ops/sec\n", name,
+        (double)elapsed*1000/ops, (double)ops*1000000/(elapsed ? elapsed : 1));
+}
+
+int main(int argc, char **argv) {
+    unsigned long count = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+    unsigned long batch = argc > 2 ? strtoul(argv[2], NULL, 10) : 64;
+    void **keys = malloc(sizeof(void*)*count);
+    void **lookups = malloc(sizeof(void*)*count);
+    dictEntry **entries = malloc(sizeof(dictEntry*)*batch);
+    unsigned long j, i, found = 0, found_many = 0;
+    long long start;
+    dict *d;
+
+    for (j = 0; j < count; j++) keys[j] = (void*)(uintptr_t)(j+1);
+    /* Random lookups, half of them missing. */
+    for (j = 0; j < count; j++)
+        lookups[j] = (void*)(uintptr_t)(rand() % (count*2) + 1);
+    printf("keys: %lu, batch: %lu\n", count, batch);
+
+    d = dictCreate(&benchType, NULL);
+    start = ustime();
+    for (j = 0; j < count; j++) dictAdd(d, keys[j], keys[j]);
+    report("dictAdd", start, count);
+    dictRelease(d);
+
+    d = dictCreate(&benchType, NULL);
+    start = ustime();
+    for (j = 0; j < count; j += batch)
+        dictAddMany(d, keys+j, keys+j, count-j < batch ? count-j : batch);
+    report("dictAddMany", start, count);
+
+    while (dictRehash(d, 1000));
+
+    start = ustime();
+    for (j = 0; j < count; j += batch) {
+        for (i = j; i < j+batch && i < count; i++)
+            if (dictFind(d, lookups[i])) found++;
+    }
+    report("dictFind", start, count);
+
+    start = ustime();
+    for (j = 0; j < count; j += batch) {
+        found_many += dictFindMany(d, (const void**)lookups+j,
+                                   count-j < batch ? count-j : batch, entries);
+    }
+    report("dictFindMany", start, count);
+    if (found != found_many) {
+        printf("mismatch: dictFind found %lu keys, dictFindMany %lu\n",
+            found, found_many);
+        return 1;
+    }
+
+    dictRelease(d);
+    free(entries);
+    free(lookups);
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dict.h>
+#include <dictimage.h>
+#include <zmalloc.h>
+
+/* Compares the ways to get a dict back at startup: inserting every key
+ * again, loading an image saved with dictImageSave(), and mapping the image
+ * to use it in place.
+ *
+ * Usage: bench_dict_image [keys] [path] */
+
+static size_t benchKeyBytes(const dictEntry *de, const void **data) {
+    *data = de->key;
+    return strlen(de->key)+1;
+}
+
+static size_t benchValBytes(const dictEntry *de, const void **data) {
+    *data = &de->v.u64;
+    return sizeof(de->v.u64);
+}
+
+static void *benchKeyLoad(void *privdata, const void *data, size_t len) {
+    DICT_NOTUSED(privdata);
+    return memcpy(zmalloc(len), data, len);
+}
+
+static void benchValLoad(void *privdata, dictEntry *de, const void *data, size_t len) {
+    DICT_NOTUSED(privdata);
+    DICT_NOTUSED(len);
+    memcpy(&de->v.u64, data, sizeof(de->v.u64));
+}
+
+static dictImageType benchImageType = {
+    .keyBytes = benchKeyBytes,
+    .valBytes = benchValBytes,
+    .keyLoad = benchKeyLoad,
+    .valLoad = benchValLoad,
+};
+
+static long long ustime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+
+static dict *build(unsigned long count) {
+    dict *d = dictCreate(&dictTypeHeapStringCopyKey, NULL);
+    char key[32];
+    unsigned long j;
+
+    for (j = 0; j < count; j++) {
+        snprintf(key, sizeof(key), "key:%lu", j);
+        dictSetUnsignedIntegerVal(dictAddRaw(d, key, NULL), j);
+    }
+    return d;
+}
+
+int main(int argc, char **argv) {
+    unsigned long count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1<<21;
+    const char *path = argc > 2 ? argv[2] : "/tmp/bench_dict_image.img";
+    unsigned long j, found = 0;
+    long long start;
+    dictImage *img;
+    char key[32];
+    dict *d;
+
+    printf("keys: %lu\n", count);
+    start = ustime();
+    d = build(count);
+    printf("%-10s %8lld us\n", "insert", ustime()-start);
+
+    start = ustime();
+    dictImageSave(d, &benchImageType, path);
+    printf("%-10s %8lld us\n", "save", ustime()-start);
+    dictRelease(d);
+
+    start = ustime();
+    img = dictImageOpen(path);
+    printf("%-10s %8lld us\n", "open", ustime()-start);
+    if (img == NULL) {
+        perror("dictImageOpen");
+        return 1;
+    }
+
+    start = ustime();
+    dictImageVerify(img);
+    printf("%-10s %8lld us\n", "verify", ustime()-start);
+
+    start = ustime();
+    d = dictImageLoad(img, &dictTypeHeapStringCopyKey, &benchImageType, NULL);
+    printf("%-10s %8lld us\n", "load", ustime()-start);
+
+    start = ustime();
+    for (j = 0; j < count; j++) {
+        snprintf(key, sizeof(key), "key:%lu", j);
+        found += dictImageFind(img, dictTypeHeapStringCopyKey.hashFunction(key),
+            key, strlen(key)+1) != NULL;
+    }
+    printf("%-10s %8lld us  (%lu found, including the key formatting)\n",
+        "find", ustime()-start, found);
+
+    dictRelease(d);
+    dictImageClose(img);
+    unlink(path);
+    return 0;
+}
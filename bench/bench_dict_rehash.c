@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <dict.h>
+
+/* Measures the latency distribution of dictAdd() while the table doubles,
+ * with the incremental rehashing driven by the foreground and by the
+ * background helper thread.
+ *
+ * Usage: bench_dict_rehash [keys] */
+
+static uint64_t benchHash(const void *key) {
+    return dictGenHashFunction(&key, sizeof(key));
+}
+
+static dictType benchType = {
+    .hashFunction = benchHash,
+};
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+static int cmpLatency(const void *a, const void *b) {
+    long long la = *(const long long*)a, lb = *(const long long*)b;
+    return (la > lb) - (la < lb);
+}
+
+/* Fill the table to exactly 'count' keys, the next insertion starts a
+ * rehashing, then time the insertion of other 'count' keys. */
+static void run(const char *name, unsigned long count, int background) {
+    long long *lat = malloc(sizeof(long long)*count), start;
+    unsigned long j, moved, total;
+    dict *d = dictCreate(&benchType, NULL);
+    double sum = 0;
+
+    dictExpand(d, count);
+    for (j = 0; j < count; j++)
+        dictAdd(d, (void*)(uintptr_t)(j+1), NULL);
+    if (background) dictEnableBackgroundRehash(d);
+
+    for (j = 0; j < count; j++) {
+        start = nstime();
+        dictAdd(d, (void*)(uintptr_t)(count+j+1), NULL);
+        lat[j] = nstime()-start;
+        sum += lat[j];
+    }
+    dictRehashProgress(d, &moved, &total);
+    qsort(lat, count, sizeof(long long), cmpLatency);
+    printf("%-12s avg %6.0f ns  p50 %6lld ns  p99 %6lld ns  p99.9 %7lld ns  "
+           "max %9lld ns  (rehashing: %lu/%lu buckets)\n", name, sum/count,
+        lat[count/2], lat[count*99/100], lat[count*999/1000], lat[count-1],
+        moved, total);
+    dictRelease(d);
+    free(lat);
+}
+
+int main(int argc, char **argv) {
+    unsigned long count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1<<22;
+
+    printf("keys: %lu -> %lu\n", count, count*2);
+    run("foreground", count, 0);
+    run("background", count, 1);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <dict.h>
+#include <dictscan.h>
+
+/* Measures a full expiry-like sweep of a dict with dictScan() and with a
+ * dictScanPool of an increasing number of threads: every thread counts the
+ * entries whose value is below a threshold.
+ *
+ * Usage: bench_dict_scan [keys] [maxthreads] */
+
+static uint64_t benchHash(const void *key) {
+    return dictGenHashFunction(&key, sizeof(key));
+}
+
+static dictType benchType = {
+    .hashFunction = benchHash,
+};
+
+static long long ustime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+
+static void countExpired(void *privdata, const dictEntry *de) {
+    unsigned long *expired = privdata;
+
+    if (dictGetUnsignedIntegerVal(de) < 1000) (*expired)++;
+}
+
+int main(int argc, char **argv) {
+    unsigned long count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1<<22;
+    int maxthreads = argc > 2 ? atoi(argv[2]) : 8;
+    dict *d = dictCreate(&benchType, NULL);
+    unsigned long j, v, expired = 0;
+    long long start;
+    int threads, t;
+
+    srand(1);
+    for (j = 0; j < count; j++)
+        dictSetUnsignedIntegerVal(dictAddRaw(d, (void*)(uintptr_t)(j+1), NULL),
+            (unsigned long)rand() % 100000);
+    while (dictRehash(d, 1000));
+
+    start = ustime();
+    v = 0;
+    do {
+        v = dictScan(d, v, countExpired, NULL, &expired);
+    } while (v);
+    printf("dictScan     %8lld us  (%lu expired)\n", ustime()-start, expired);
+
+    for (threads = 1; threads <= maxthreads; threads *= 2) {
+        dictScanPool *pool = dictScanPoolCreate(threads);
+        unsigned long *counters = calloc(threads, sizeof(*counters));
+        void **privdata = malloc(sizeof(void*)*threads);
+
+        for (t = 0; t < threads; t++) privdata[t] = &counters[t];
+        start = ustime();
+        dictScanPoolRun(pool, d, countExpired, NULL, privdata);
+        start = ustime()-start;
+        for (expired = 0, t = 0; t < threads; t++) expired += counters[t];
+        printf("%2d threads   %8lld us  (%lu expired, %lu partitions)\n",
+            threads, start, expired, dictScanPoolPartitions(pool, d));
+        dictScanPoolRelease(pool);
+        free(privdata);
+        free(counters);
+    }
+    dictRelease(d);
+    return 0;
+}
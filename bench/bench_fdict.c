@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <dict.h>
+#include <fdict.h>
+
+/* Compares lookups and memory of a dict and of the fdict frozen from it.
+ *
+ * Usage: bench_fdict [keys] [lookups] */
+
+static uint64_t benchHash(const void *key) {
+    return dictGenHashFunction(&key, sizeof(key));
+}
+
+static dictType benchType = {
+    .hashFunction = benchHash,
+};
+
+static long long ustime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+
+int main(int argc, char **argv) {
+    unsigned long count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1<<22;
+    unsigned long lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 1<<22;
+    unsigned long j, found = 0, *keys = malloc(sizeof(*keys)*lookups);
+    dict *d = dictCreate(&benchType, NULL);
+    dictStats stats;
+    long long start;
+    fdict *fd;
+
+    for (j = 0; j < count; j++)
+        dictAdd(d, (void*)(uintptr_t)(j+1), NULL);
+    srand(1);
+    for (j = 0; j < lookups; j++)
+        keys[j] = (unsigned long)rand() % count + 1;
+
+    start = ustime();
+    for (j = 0; j < lookups; j++)
+        found += dictFind(d, (void*)(uintptr_t)keys[j]) != NULL;
+    printf("dict:  %6.1f ns/lookup\n", (double)(ustime()-start)*1000/lookups);
+    dictCollectStats(d, &stats, DICT_STATS_MEMORY);
+
+    start = ustime();
+    fd = fdictFreeze(d);
+    printf("freeze %6lld ms\n", (ustime()-start)/1000);
+
+    start = ustime();
+    for (j = 0; j < lookups; j++)
+        found += fdictFind(fd, (void*)(uintptr_t)keys[j]) != NULL;
+    printf("fdict: %6.1f ns/lookup\n", (double)(ustime()-start)*1000/lookups);
+
+    printf("memory: dict %.1f bytes/key, fdict %.1f bytes/key (%lu found)\n",
+        (double)stats.total_bytes/count, (double)fdictMemoryUsage(fd)/count,
+        found);
+    fdictRelease(fd);
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <hashfunc.h>
+
+/* Throughput of the hash functions of hashfunc.h per key length.
+ *
+ * Usage: bench_hash [iterations] */
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    static const size_t lengths[] = {4, 8, 16, 24, 32, 64, 256, 1024, 4096};
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : 2000000;
+    const hashFunctionEntry *list = hashFunctionList(), *e;
+    unsigned char buf[4096+64];
+    uint64_t sink = 0;
+    size_t l, j;
+
+    for (j = 0; j < sizeof(buf); j++) buf[j] = rand();
+    printf("crc32c hardware support: %s\n", crc32cHardwareSupported() ? "yes" : "no");
+    printf("%-16s", "len");
+    for (e = list; e->name; e++) printf("%20s", e->name);
+    printf("%20s\n", "crc32c-software");
+
+    for (l = 0; l < sizeof(lengths)/sizeof(lengths[0]); l++) {
+        size_t len = lengths[l];
+        long n = iterations*16/(len < 16 ? 16 : len);
+        long i;
+
+        printf("%-16zu", len);
+        for (e = list; ; e++) {
+            hashFunction *fn = e->name ? e->fn : crc32cHash64Software;
+            long long start = nstime(), elapsed;
+
+            /* Move the key around so that every call hashes different
+             * bytes, the hash of the previous call is the seed. */
+            for (i = 0; i < n; i++)
+                sink = fn(buf+(i & 63), len, sink);
+            elapsed = nstime()-start;
+            printf("%8.2f ns %5.2f GB/s", (double)elapsed/n,
+                (double)len*n/elapsed);
+            if (e->name == NULL) break;
+        }
+        printf("\n");
+    }
+    return sink == 42;
+}
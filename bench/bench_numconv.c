@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <util.h>
+
+/* Compares the number conversions of util.c with the libc ones.
+ *
+ * Usage: bench_numconv [numbers per measure] */
+
+#define BENCH_SET 4096
+
+static long long benchInts[BENCH_SET];
+static double benchDoubles[BENCH_SET];
+static char benchIntStr[BENCH_SET][LONG_STR_SIZE];
+static char benchDoubleStr[BENCH_SET][MAX_D2STRING_CHARS];
+static volatile size_t benchSink;
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+static uint64_t benchRand(void) {
+    static uint64_t x = 88172645463325252ULL;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+}
+
+static void report(const char *name, long long libc, long long ours, long n) {
+    printf("%-28s %10.1f %10.1f %8.1fx\n", name, (double)libc/n, (double)ours/n,
+        (double)libc/ours);
+}
+
+/* Run the conversions on integers of up to 'maxbits' bits, and doubles
+ * either random or with few digits like prices. */
+static void bench(long n, int maxbits, int shortdoubles) {
+    char buf[MAX_D2STRING_CHARS], name[64];
+    long long start, libc, ours, v;
+    double d;
+    long j;
+
+    for (j = 0; j < BENCH_SET; j++) {
+        uint64_t r = benchRand();
+
+        benchInts[j] = (long long)(r >> (64-maxbits)) * (j & 1 ? -1 : 1);
+        if (shortdoubles) {
+            benchDoubles[j] = (double)(long long)(r % 10000000) / 100;
+        } else {
+            do {
+                r = benchRand();
+                memcpy(&benchDoubles[j], &r, sizeof(double));
+            } while (benchDoubles[j] != benchDoubles[j] ||
+                     benchDoubles[j]-benchDoubles[j] != 0);
+        }
+        snprintf(benchIntStr[j], LONG_STR_SIZE, "%lld", benchInts[j]);
+        d2string(benchDoubleStr[j], MAX_D2STRING_CHARS, benchDoubles[j]);
+    }
+
+    start = nstime();
+    for (j = 0; j < n; j++) benchSink += snprintf(buf, sizeof(buf), "%lld", benchInts[j % BENCH_SET]);
+    libc = nstime()-start;
+    start = nstime();
+    for (j = 0; j < n; j++) benchSink += ll2string(buf, sizeof(buf), benchInts[j % BENCH_SET]);
+    ours = nstime()-start;
+    snprintf(name, sizeof(name), "ll2string %d bits", maxbits);
+    report(name, libc, ours, n);
+
+    start = nstime();
+    for (j = 0; j < n; j++) benchSink += strtoll(benchIntStr[j % BENCH_SET], NULL, 10);
+    libc = nstime()-start;
+    start = nstime();
+    for (j = 0; j < n; j++) {
+        const char *s = benchIntStr[j % BENCH_SET];
+
+        string2ll(s, strlen(s), &v);
+        benchSink += v;
+    }
+    ours = nstime()-start;
+    snprintf(name, sizeof(name), "string2ll %d bits", maxbits);
+    report(name, libc, ours, n);
+
+    start = nstime();
+    for (j = 0; j < n; j++) benchSink += snprintf(buf, sizeof(buf), "%.17g", benchDoubles[j % BENCH_SET]);
+    libc = nstime()-start;
+    start = nstime();
+    for (j = 0; j < n; j++) benchSink += d2string(buf, sizeof(buf), benchDoubles[j % BENCH_SET]);
+    ours = nstime()-start;
+    snprintf(name, sizeof(name), "d2string %s", shortdoubles ? "prices" : "random");
+    report(name, libc, ours, n);
+
+    start = nstime();
+    for (j = 0; j < n; j++) benchSink += (size_t)strtod(benchDoubleStr[j % BENCH_SET], NULL);
+    libc = nstime()-start;
+    start = nstime();
+    for (j = 0; j < n; j++) {
+        const char *s = benchDoubleStr[j % BENCH_SET];
+
+        string2d(s, strlen(s), &d);
+        benchSink += (size_t)d;
+    }
+    ours = nstime()-start;
+    snprintf(name, sizeof(name), "string2d %s", shortdoubles ? "prices" : "random");
+    report(name, libc, ours, n);
+}
+
+int main(int argc, char **argv) {
+    long n = argc > 1 ? atol(argv[1]) : 2000000;
+
+    printf("%-28s %10s %10s %9s   (ns per number)\n", "", "libc", "util", "speedup");
+    bench(n, 16, 1);
+    bench(n, 63, 0);
+    return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <rax.h>
+
+/* Resolving requests of BENCH_REQ keys, with raxFind() one key at a time
+ * against raxFindMany(), on a tree of prefix-routing like keys. 3 out of 4
+ * looked up keys exist.
+ *
+ * Usage: bench_rax_many [keys] [lookups] */
+
+#define BENCH_REQ 256
+#define BENCH_KEYLEN 32
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+static size_t benchKey(unsigned char *buf, long id) {
+    return snprintf((char*)buf, BENCH_KEYLEN, "/svc%ld/v%ld/obj/%ld",
+                    id % 97, id % 5, id * 2654435761UL % 1000000007);
+}
+
+int main(int argc, char **argv) {
+    long count = argc > 1 ? atol(argv[1]) : 1000000;
+    long lookups = argc > 2 ? atol(argv[2]) : 2000000;
+    unsigned char (*bufs)[BENCH_KEYLEN] = malloc(sizeof(*bufs)*lookups);
+    unsigned char **keys = malloc(sizeof(char*)*lookups);
+    size_t *lens = malloc(sizeof(size_t)*lookups);
+    void *values[BENCH_REQ];
+    int found[BENCH_REQ];
+    unsigned char key[BENCH_KEYLEN];
+    unsigned long hits1 = 0, hits2 = 0;
+    long long start, tone, tmany;
+    rax *rt = raxNew();
+    long j, k;
+
+    for (j = 0; j < count; j++)
+        raxInsert(rt, key, benchKey(key, j), (void*)(j+1), NULL);
+    srandom(1);
+    for (j = 0; j < lookups; j++) {
+        long id = random() % (count*4/3);
+
+        lens[j] = benchKey(bufs[j], id);
+        keys[j] = bufs[j];
+    }
+    lookups -= lookups % BENCH_REQ;
+
+    start = nstime();
+    for (j = 0; j < lookups; j += BENCH_REQ)
+        for (k = 0; k < BENCH_REQ; k++)
+            hits1 += raxFind(rt, keys[j+k], lens[j+k], &values[k]);
+    tone = nstime()-start;
+
+    start = nstime();
+    for (j = 0; j < lookups; j += BENCH_REQ)
+        hits2 += raxFindMany(rt, keys+j, lens+j, BENCH_REQ, values, found);
+    tmany = nstime()-start;
+
+    printf("%ld keys, %ld nodes, %lu/%lu found\n", count, (long)rt->numnodes, hits1, hits2);
+    printf("raxFind      %8.1f ns/key\n", (double)tone/lookups);
+    printf("raxFindMany  %8.1f ns/key\n", (double)tmany/lookups);
+    raxFree(rt);
+    free(bufs);
+    free(keys);
+    free(lens);
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sds.h>
+#include <sdsbuilder.h>
+#include <zmalloc.h>
+
+/* Builds a multi-megabyte reply made of bulk strings ("$<len>\r\n<value>\r\n")
+ * and writes it to /dev/null, with a single sds grown by sdscatlen() or with
+ * a chunked sdsBuilder written by writev().
+ *
+ * Usage: bench_sds_builder [reply MB] [rounds] */
+
+#define BENCH_VALUES 64
+#define BENCH_IOV 64
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+static void benchSds(int fd, sds *values, size_t bytes) {
+    sds reply = sdsempty();
+    size_t j = 0;
+
+    while (sdslen(reply) < bytes) {
+        sds v = values[j++ % BENCH_VALUES];
+
+        reply = sdscatfmt(reply, "$%U\r\n", (unsigned long long)sdslen(v));
+        reply = sdscatsds(reply, v);
+        reply = sdscatlen(reply, "\r\n", 2);
+    }
+    if (write(fd, reply, sdslen(reply)) < 0) exit(1);
+    sdsfree(reply);
+}
+
+static void benchBuilder(int fd, sds *values, size_t bytes) {
+    struct iovec iov[BENCH_IOV];
+    sdsBuilder b;
+    size_t j = 0;
+
+    sdsBuilderInit(&b, NULL, 0);
+    while (sdsBuilderLen(&b) < bytes) {
+        sds v = values[j++ % BENCH_VALUES];
+
+        sdsBuilderCatFmt(&b, "$%U\r\n", (unsigned long long)sdslen(v));
+        sdsBuilderCatSds(&b, v);
+        sdsBuilderCatLen(&b, "\r\n", 2);
+    }
+    while (sdsBuilderLen(&b)) {
+        ssize_t n = writev(fd, iov, sdsBuilderIovec(&b, iov, BENCH_IOV));
+
+        if (n <= 0) exit(1);
+        sdsBuilderConsume(&b, n);
+    }
+    sdsBuilderRelease(&b);
+}
+
+int main(int argc, char **argv) {
+    size_t bytes = (size_t)(argc > 1 ? atol(argv[1]) : 8) << 20;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20, r, j, v;
+    static const size_t vlen[] = {32, 512, 16384};
+    int fd = open("/dev/null", O_WRONLY);
+    sds values[BENCH_VALUES];
+
+    if (fd == -1) return 1;
+    printf("%-24s %10s %10s   (ms per %zu MB reply)\n", "", "sds", "builder",
+        bytes >> 20);
+    for (v = 0; v < 4; v++) {
+        long long start, tsds, tbuilder;
+        int shared = v == 3;
+        size_t len = vlen[shared ? 2 : v];
+
+        for (j = 0; j < BENCH_VALUES; j++) {
+            values[j] = shared ? sdsnewlen_shared(SDS_NOINIT, len+j) :
+                                 sdsnewlen(SDS_NOINIT, len+j);
+            memset(values[j], 'a'+j%26, len+j);
+        }
+        start = nstime();
+        for (r = 0; r < rounds; r++) benchSds(fd, values, bytes);
+        tsds = nstime()-start;
+        start = nstime();
+        for (r = 0; r < rounds; r++) benchBuilder(fd, values, bytes);
+        tbuilder = nstime()-start;
+        printf("values of %-6zu%-8s %10.2f %10.2f\n", len,
+            shared ? " shared" : "", (double)tsds/rounds/1e6,
+            (double)tbuilder/rounds/1e6);
+        for (j = 0; j < BENCH_VALUES; j++) sdsfree(values[j]);
+    }
+    close(fd);
+    return 0;
+}
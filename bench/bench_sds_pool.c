@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <mempool.h>
+#include <sds.h>
+
+/* Simulates requests building a few dozens of strings, released at the end
+ * of the request one by one (heap) or by resetting a pool.
+ *
+ * Usage: bench_sds_pool [requests] */
+
+#define BENCH_STRINGS 32
+
+static volatile size_t benchSink;
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+/* Build the strings of a request, from the pool if not NULL. */
+static void benchRequest(mem_pool_t *pool, sds *strings, int pieces) {
+    int j, k;
+
+    for (j = 0; j < BENCH_STRINGS; j++) {
+        sds s = pool ? sdsnewlen_pool(pool, "key:", 4) : sdsnewlen("key:", 4);
+
+        for (k = 0; k < pieces; k++) {
+            s = sdscatlen(s, "0123456789abcdef", 1+(j+k)%16);
+            s = sdscatfmt(s, ":%i", j*k);
+        }
+        strings[j] = s;
+        benchSink += sdslen(s);
+    }
+}
+
+int main(int argc, char **argv) {
+    long requests = argc > 1 ? atol(argv[1]) : 200000, r;
+    static const int pieces[] = {1, 4, 16};
+    sds strings[BENCH_STRINGS];
+    mem_pool_t *pool = mem_create_pool(MEM_DEFAULT_POOL_SIZE);
+    size_t p;
+    int j;
+
+    printf("%-20s %12s %12s   (ns per request of %d strings)\n",
+        "", "heap", "pool", BENCH_STRINGS);
+    for (p = 0; p < sizeof(pieces)/sizeof(pieces[0]); p++) {
+        long long start, heap, pooled;
+
+        start = nstime();
+        for (r = 0; r < requests; r++) {
+            benchRequest(NULL, strings, pieces[p]);
+            for (j = 0; j < BENCH_STRINGS; j++) sdsfree(strings[j]);
+        }
+        heap = nstime()-start;
+
+        start = nstime();
+        for (r = 0; r < requests; r++) {
+            benchRequest(pool, strings, pieces[p]);
+            mem_reset_pool(pool);
+        }
+        pooled = nstime()-start;
+        printf("appends per string %-2d %11.0f %12.0f\n", pieces[p]*2,
+            (double)heap/requests, (double)pooled/requests);
+    }
+    mem_destroy_pool(pool);
+    return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <sds.h>
+#include <strsimd.h>
+
+/* Compares sdscatrepr() with the byte by byte version it replaced, on text,
+ * binary keys and random bytes, for every kernel implementation.
+ *
+ * Usage: bench_sds_repr [MB] */
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+/* The previous sdscatrepr(). */
+static sds benchReprOld(sds s, const char *p, size_t len) {
+    s = sdscatlen(s, "\"", 1);
+    while (len--) {
+        switch (*p) {
+        case '\\':
+        case '"':
+            s = sdscatprintf(s, "\\%c", *p);
+            break;
+        case '\n': s = sdscatlen(s,"\\n",2); break;
+        case '\r': s = sdscatlen(s,"\\r",2); break;
+        case '\t': s = sdscatlen(s,"\\t",2); break;
+        case '\a': s = sdscatlen(s,"\\a",2); break;
+        case '\b': s = sdscatlen(s,"\\b",2); break;
+        default:
+            if (isprint((unsigned char)*p))
+                s = sdscatprintf(s,"%c",*p);
+            else
+                s = sdscatprintf(s,"\\x%02x",(unsigned char)*p);
+            break;
+        }
+        p++;
+    }
+    return sdscatlen(s,"\"",1);
+}
+
+/* Escape 'buf' as 64 byte keys into the same log line, returning the ns
+ * per key. */
+static double benchRun(sds (*repr)(sds, const char *, size_t), const char *buf, size_t len) {
+    long long start = nstime();
+    sds s = sdsempty();
+    size_t j;
+
+    for (j = 0; j+64 <= len; j += 64) {
+        sdsclear(s);
+        s = repr(s, buf+j, 64);
+    }
+    sdsfree(s);
+    return (double)(nstime()-start)/(len/64);
+}
+
+int main(int argc, char **argv) {
+    size_t len = (size_t)(argc > 1 ? atol(argv[1]) : 8) << 20, j;
+    static const char *names[] = {"text", "binary keys", "random bytes"};
+    char *buf = malloc(len);
+    int kind, impl;
+
+    printf("%-14s %10s", "", "old");
+    for (impl = STRSIMD_SCALAR; impl <= STRSIMD_AVX2; impl++)
+        printf(" %10s", strsimdImplementationName(impl));
+    printf("   (ns per 64 byte key)\n");
+    for (kind = 0; kind < 3; kind++) {
+        for (j = 0; j < len; j++) {
+            if (kind == 0)
+                buf[j] = j % 9 == 8 ? ' ' : 'a'+rand()%26;
+            else if (kind == 1)
+                buf[j] = rand() % 8 ? 'a'+rand()%26 : (char)rand();
+            else
+                buf[j] = (char)rand();
+        }
+        printf("%-14s %10.1f", names[kind], benchRun(benchReprOld, buf, len));
+        for (impl = STRSIMD_SCALAR; impl <= STRSIMD_AVX2; impl++) {
+            if (strsimdSetImplementation(impl) == -1) {
+                printf(" %10s", "-");
+                continue;
+            }
+            printf(" %10.1f", benchRun(sdscatrepr, buf, len));
+        }
+        printf("\n");
+    }
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sds.h>
+#include <zmalloc.h>
+
+/* Duplicates a value many times, as a cache handing out copies of the same
+ * string to its readers would, comparing heap copies and shared strings.
+ *
+ * Usage: bench_sds_shared [copies] */
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+/* Take 'copies' references of 's', returning the elapsed ns. The memory
+ * used while they are all alive is stored in 'used'. */
+static long long benchDup(sds s, sds *refs, long copies, size_t *used) {
+    long long start = nstime();
+    size_t before = zmalloc_used_memory();
+    long j;
+
+    for (j = 0; j < copies; j++) refs[j] = sdsdup(s);
+    *used = zmalloc_used_memory()-before;
+    for (j = 0; j < copies; j++) sdsfree(refs[j]);
+    return nstime()-start;
+}
+
+int main(int argc, char **argv) {
+    long copies = argc > 1 ? atol(argv[1]) : 10000;
+    static const size_t sizes[] = {16, 256, 4096, 16384};
+    sds *refs = zmalloc(sizeof(sds)*copies);
+    size_t p;
+
+    printf("%-12s %12s %12s %14s %14s   (ns per dup+free, bytes for %ld copies)\n",
+        "", "heap", "shared", "heap mem", "shared mem", copies);
+    for (p = 0; p < sizeof(sizes)/sizeof(sizes[0]); p++) {
+        sds heap = sdsnewlen(SDS_NOINIT, sizes[p]), shared;
+        long long theap, tshared;
+        size_t mheap, mshared;
+
+        memset(heap, 'x', sizes[p]);
+        shared = sdsnewlen_shared(heap, sizes[p]);
+        theap = benchDup(heap, refs, copies, &mheap);
+        tshared = benchDup(shared, refs, copies, &mshared);
+        printf("len %-8zu %12.1f %12.1f %14zu %14zu\n", sizes[p],
+            (double)theap/copies, (double)tshared/copies, mheap, mshared);
+        sdsfree(heap);
+        sdsfree(shared);
+    }
+    zfree(refs);
+    return 0;
+}
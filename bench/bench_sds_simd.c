@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <strsimd.h>
+
+/* Measures the string kernels used by sds, for every implementation and a
+ * range of string lengths, against the byte by byte loops sds used before.
+ *
+ * Usage: bench_sds_simd [bytes per measure] */
+
+#define BENCH_MAX_LEN 4096
+
+static const size_t benchLengths[] = {8, 16, 32, 64, 256, 1024, 4096};
+static char benchBuf[BENCH_MAX_LEN], benchOther[BENCH_MAX_LEN];
+static volatile size_t benchSink;
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+/* The loops of sds before the kernels. */
+static void oldToLower(char *p, size_t len) {
+    size_t j;
+
+    for (j = 0; j < len; j++) p[j] = tolower(p[j]);
+}
+
+static void oldMapChars(char *p, size_t len, const char *from, const char *to, size_t setlen) {
+    size_t j, i;
+
+    for (j = 0; j < len; j++) {
+        for (i = 0; i < setlen; i++) {
+            if (p[j] == from[i]) {
+                p[j] = to[i];
+                break;
+            }
+        }
+    }
+}
+
+static size_t oldSpan(const char *p, size_t len, const char *cset) {
+    size_t j;
+
+    for (j = 0; j < len && strchr(cset, p[j]); j++);
+    return j;
+}
+
+static int oldCaseCmp(const char *p1, const char *p2, size_t len) {
+    size_t j;
+
+    for (j = 0; j < len; j++) {
+        int c1 = tolower((unsigned char)p1[j]), c2 = tolower((unsigned char)p2[j]);
+        if (c1 != c2) return c1-c2;
+    }
+    return 0;
+}
+
+/* Run a kernel 'op' (0 to 5) with the implementation 'impl', or the old
+ * loop if 'impl' is -1, and return the ns per call. */
+static double run(int op, int impl, size_t len, size_t bytes) {
+    size_t iters = bytes/len+1, j;
+    long long start;
+
+    if (impl >= 0) strsimdSetImplementation(impl);
+    /* Spaces for the span, letters for everything else. */
+    memset(benchBuf, op == 3 ? ' ' : 'a', len);
+    memset(benchOther, 'A', len);
+    start = nstime();
+    for (j = 0; j < iters; j++) {
+        switch (op) {
+        case 0:
+            if (impl < 0) oldToLower(benchBuf, len);
+            else strsimdToLower(benchBuf, len);
+            break;
+        case 1:
+            if (impl < 0) oldMapChars(benchBuf, len, "ab", "ba", 2);
+            else strsimdMapChars(benchBuf, len, "ab", "ba", 2);
+            break;
+        case 2:
+            if (impl < 0) oldMapChars(benchBuf, len, "abcdefgh", "hgfedcba", 8);
+            else strsimdMapChars(benchBuf, len, "abcdefgh", "hgfedcba", 8);
+            break;
+        case 3:
+            if (impl < 0) benchSink += oldSpan(benchBuf, len, " \t\r\n");
+            else benchSink += strsimdSpan(benchBuf, len, " \t\r\n", 4);
+            break;
+        case 4:
+            if (impl < 0) benchSink += len-oldSpan(benchBuf, len, "abcdefghijklmnopqrstuvwxyz");
+            else benchSink += strsimdFindChars(benchBuf, len, "\r\n", 2);
+            break;
+        case 5:
+            if (impl < 0) benchSink += oldCaseCmp(benchBuf, benchOther, len);
+            else benchSink += strsimdCaseCmp(benchBuf, benchOther, len);
+            break;
+        }
+    }
+    return (double)(nstime()-start)/iters;
+}
+
+int main(int argc, char **argv) {
+    static const char *ops[] = {"tolower", "mapchars/2", "mapchars/8",
+        "trim span", "find \\r\\n", "casecmp"};
+    size_t bytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 1<<26;
+    size_t j;
+    int op, impl;
+
+    for (op = 0; op < 6; op++) {
+        printf("%-12s %8s %10s", ops[op], "len", "bytewise");
+        for (impl = STRSIMD_SCALAR; impl <= STRSIMD_AVX2; impl++)
+            printf(" %10s", strsimdImplementationName(impl));
+        printf("   (ns per call)\n");
+        for (j = 0; j < sizeof(benchLengths)/sizeof(benchLengths[0]); j++) {
+            size_t len = benchLengths[j];
+
+            printf("%-12s %8zu %10.1f", "", len, run(op, -1, len, bytes));
+            for (impl = STRSIMD_SCALAR; impl <= STRSIMD_AVX2; impl++) {
+                if (strsimdSetImplementation(impl) == -1)
+                    printf(" %10s", "-");
+                else
+                    printf(" %10.1f", run(op, impl, len, bytes));
+            }
+            printf("\n");
+        }
+    }
+    strsimdSetImplementation(STRSIMD_AUTO);
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sds.h>
+
+/* Compares splitting into an array of sds with the iterators returning
+ * views into the string, for lines with a growing number of tokens.
+ *
+ * Usage: bench_sds_split [tokens per measure] */
+
+static const int benchTokens[] = {4, 16, 64, 256, 1024};
+static volatile size_t benchSink;
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+/* A line of 'ntok' tokens of 3 to 12 chars, separated by 'sep'. */
+static sds benchLine(int ntok, const char *sep) {
+    sds line = sdsempty();
+    int j, k;
+
+    for (j = 0; j < ntok; j++) {
+        int len = 3+rand()%10;
+
+        if (j) line = sdscat(line, sep);
+        for (k = 0; k < len; k++) line = sdscatlen(line, &"abcdefghijklmnop"[rand()%16], 1);
+    }
+    return line;
+}
+
+int main(int argc, char **argv) {
+    long total = argc > 1 ? atol(argv[1]) : 4000000;
+    const char *tok;
+    size_t toklen;
+    size_t t;
+
+    srand(1);
+    printf("%-14s %6s %12s %12s   (ns per token)\n", "", "tokens", "array", "iterator");
+    for (t = 0; t < sizeof(benchTokens)/sizeof(benchTokens[0]); t++) {
+        int ntok = benchTokens[t], count, j;
+        long rounds = total/ntok, r;
+        sds line = benchLine(ntok, "\r\n");
+        long long start, arr, it;
+
+        start = nstime();
+        for (r = 0; r < rounds; r++) {
+            sds *tokens = sdssplitlen(line, sdslen(line), "\r\n", 2, &count);
+
+            for (j = 0; j < count; j++) benchSink += sdslen(tokens[j]);
+            sdsfreesplitres(tokens, count);
+        }
+        arr = nstime()-start;
+
+        start = nstime();
+        for (r = 0; r < rounds; r++) {
+            sdsSplitIter si;
+
+            sdsSplitIterInit(&si, line, sdslen(line), "\r\n", 2);
+            while (sdsSplitIterNext(&si, &tok, &toklen)) benchSink += toklen;
+        }
+        it = nstime()-start;
+        printf("%-14s %6d %12.1f %12.1f\n", "splitlen \\r\\n", ntok,
+            (double)arr/(rounds*ntok), (double)it/(rounds*ntok));
+        sdsfree(line);
+    }
+
+    for (t = 0; t < sizeof(benchTokens)/sizeof(benchTokens[0]); t++) {
+        int ntok = benchTokens[t], count, j;
+        long rounds = total/ntok, r;
+        sds line = benchLine(ntok, " ");
+        long long start, arr, it;
+
+        start = nstime();
+        for (r = 0; r < rounds; r++) {
+            sds *tokens = sdssplitargs(line, &count);
+
+            for (j = 0; j < count; j++) benchSink += sdslen(tokens[j]);
+            sdsfreesplitres(tokens, count);
+        }
+        arr = nstime()-start;
+
+        start = nstime();
+        for (r = 0; r < rounds; r++) {
+            sdsArgsIter ai;
+
+            sdsArgsIterInit(&ai, line);
+            while (sdsArgsIterNext(&ai, &tok, &toklen) == 1) benchSink += toklen;
+            sdsArgsIterRelease(&ai);
+        }
+        it = nstime()-start;
+        printf("%-14s %6d %12.1f %12.1f\n", "splitargs", ntok,
+            (double)arr/(rounds*ntok), (double)it/(rounds*ntok));
+        sdsfree(line);
+    }
+    return 0;
+}
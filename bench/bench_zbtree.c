@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <skiplist.h>
+#include <zbtree.h>
+#include <zmalloc.h>
+
+/* Compares zskiplist with zbtree on random insertions, rank lookups and
+ * range scans of BENCH_RANGE elements reading their score and element, as
+ * ZRANGEBYSCORE does. Both reference elements of 16 bytes allocated
+ * before the sorted set.
+ *
+ * Usage: bench_zbtree [elements] [queries] */
+
+#define BENCH_ELE 16
+#define BENCH_RANGE 20
+
+static volatile unsigned long benchSink;
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+static void benchRun(int btree, long count, long queries) {
+    char **eles = malloc(sizeof(char*)*count);
+    double *scores = malloc(sizeof(double)*count);
+    zskiplist *zsl = NULL;
+    zbtree *zbt = NULL;
+    long long start, tinsert, trank, trange;
+    unsigned long sum = 0;
+    size_t before, mem;
+    long j, k;
+
+    srandom(1);
+    for (j = 0; j < count; j++) {
+        eles[j] = zmalloc(BENCH_ELE);
+        snprintf(eles[j], BENCH_ELE, "ele:%011d", (int)j);
+        scores[j] = random() % (count*4);
+    }
+    before = zmalloc_used_memory();
+    if (btree) zbt = zbtCreate(NULL);
+    else zsl = zslCreate(NULL);
+
+    start = nstime();
+    for (j = 0; j < count; j++) {
+        if (btree) zbtInsert(zbt, scores[j], eles[j], BENCH_ELE);
+        else zslInsert(zsl, scores[j], eles[j], BENCH_ELE);
+    }
+    tinsert = nstime()-start;
+    mem = zmalloc_used_memory()-before;
+
+    srandom(2);
+    start = nstime();
+    for (j = 0; j < queries; j++) {
+        k = random() % count;
+        if (btree) sum += zbtGetRank(zbt, scores[k], eles[k], BENCH_ELE);
+        else sum += zslGetRank(zsl, scores[k], eles[k], BENCH_ELE);
+    }
+    trank = nstime()-start;
+
+    srandom(3);
+    start = nstime();
+    for (j = 0; j < queries; j++) {
+        zrangespec range;
+
+        range.min = random() % (count*4);
+        range.max = range.min+count*4;
+        range.minex = range.maxex = 0;
+        if (btree) {
+            zbtreeIter *iter = zbtNthInRange(zbt, &range, 0);
+            double score;
+            void *ele;
+
+            if (iter == NULL) continue;
+            for (k = 0; k < BENCH_RANGE && zbtNext(iter, &score, &ele); k++)
+                sum += ((unsigned char*)ele)[BENCH_ELE-2]+(unsigned long)score;
+            zbtReleaseIterator(iter);
+        } else {
+            zskiplistNode *x = zslNthInRange(zsl, &range, 0);
+
+            for (k = 0; x && k < BENCH_RANGE; k++, x = x->level[0].forward)
+                sum += ((unsigned char*)x->ele)[BENCH_ELE-2]+(unsigned long)x->score;
+        }
+    }
+    trange = nstime()-start;
+    benchSink += sum;
+
+    printf("%-10s %10.1f %10.1f %12.1f %12.1f\n", btree ? "zbtree" : "zskiplist",
+        (double)tinsert/count, (double)trank/queries, (double)trange/queries,
+        (double)mem/count);
+    if (btree) zbtFree(zbt);
+    else zslFree(zsl);
+    free(eles);
+    free(scores);
+}
+
+int main(int argc, char **argv) {
+    long count = argc > 1 ? atol(argv[1]) : 1000000;
+    long queries = argc > 2 ? atol(argv[2]) : 1000000;
+
+    printf("%-10s %10s %10s %12s %12s\n", "", "insert ns", "rank ns",
+        "range ns", "bytes/ele");
+    benchRun(0, count, queries);
+    benchRun(1, count, queries);
+    return 0;
+}
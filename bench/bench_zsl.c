@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <skiplist.h>
+#include <zmalloc.h>
+
+/* Compares a skiplist referencing its elements with an inline one, for
+ * 16 byte elements: insertion, full iteration and range queries reading
+ * the elements, as ZRANGEBYSCORE does. The referenced elements are all
+ * allocated before the skiplist, as the keys of a loaded dataset would be,
+ * instead of next to their node.
+ *
+ * Usage: bench_zsl [elements] [queries] */
+
+#define BENCH_ELE 16
+#define BENCH_RANGE 20
+#define BENCH_ROUNDS 5
+
+static volatile unsigned long benchSink;
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+static void benchRun(const char *name, int inl, int sorted, long count, long queries) {
+    size_t before = zmalloc_used_memory();
+    zskiplist *zsl = inl ? zslCreateInline(NULL, BENCH_ELE) : zslCreate(NULL);
+    char **eles = malloc(sizeof(char*)*count);
+    long long start, t, tinsert, titer, trange;
+    zskiplistNode *x;
+    unsigned long sum = 0;
+    size_t mem;
+    long j, k;
+    int r;
+
+    for (j = 0; j < count; j++) {
+        eles[j] = zmalloc(BENCH_ELE);
+        snprintf(eles[j], BENCH_ELE, "ele:%011d", (int)j);
+    }
+    srandom(1);
+    start = nstime();
+    for (j = 0; j < count; j++) {
+        zslInsert(zsl, sorted ? j*4 : random() % (count*4), eles[j], BENCH_ELE);
+        /* The inline skiplist copied it. */
+        if (inl) zfree(eles[j]);
+    }
+    tinsert = nstime()-start;
+    mem = zmalloc_used_memory()-before;
+
+    /* Best of a few rounds, the timings of cache misses are noisy. */
+    titer = trange = -1;
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        start = nstime();
+        for (x = zsl->header->level[0].forward; x; x = x->level[0].forward)
+            sum += ((unsigned char*)x->ele)[BENCH_ELE-2]+(unsigned long)x->score;
+        t = nstime()-start;
+        if (titer == -1 || t < titer) titer = t;
+
+        srandom(2);
+        start = nstime();
+        for (j = 0; j < queries; j++) {
+            zrangespec range;
+
+            range.min = random() % (count*4);
+            range.max = range.min+count*4;
+            range.minex = range.maxex = 0;
+            x = zslNthInRange(zsl, &range, 0);
+            for (k = 0; x && k < BENCH_RANGE; k++, x = x->level[0].forward)
+                sum += ((unsigned char*)x->ele)[BENCH_ELE-2];
+        }
+        t = nstime()-start;
+        if (trange == -1 || t < trange) trange = t;
+    }
+    benchSink += sum;
+
+    printf("%-12s %10.1f %10.2f %12.1f %12.1f\n", name,
+        (double)tinsert/count, (double)titer/count,
+        (double)trange/queries, (double)mem/count);
+    zslFree(zsl);
+    free(eles);
+}
+
+int main(int argc, char **argv) {
+    long count = argc > 1 ? atol(argv[1]) : 1000000;
+    long queries = argc > 2 ? atol(argv[2]) : 1000000;
+
+    printf("%-12s %10s %10s %12s %12s\n", "", "insert ns", "iter ns",
+        "range ns", "bytes/ele");
+    benchRun("pointer", 0, 0, count, queries);
+    benchRun("inline", 1, 0, count, queries);
+    /* Scores inserted in order, as timestamps: the nodes next to each other
+     * in the list are also next to each other in memory. */
+    benchRun("pointer/asc", 0, 1, count, queries);
+    benchRun("inline/asc", 1, 1, count, queries);
+    return 0;
+}
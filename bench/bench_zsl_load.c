@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <skiplist.h>
+#include <zmalloc.h>
+
+/* Loading a sorted set: one zslInsert() per element, in sorted order as
+ * a restore reads them, against zslBulkLoad(). Then adding shuffled
+ * batches to an existing skiplist, with zslInsert() against
+ * zslInsertMany(). The lookup time afterwards shows the shape of the
+ * resulting skiplist.
+ *
+ * Usage: bench_zsl_load [elements] [batch] */
+
+#define BENCH_ELE 16
+
+static volatile unsigned long benchSink;
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+/* Average ns of a rank lookup of random elements. */
+static double benchLookup(zskiplist *zsl, zskiplistEntry *entries, long count) {
+    unsigned long sum = 0;
+    long long start;
+    long j, k;
+
+    srandom(3);
+    start = nstime();
+    for (j = 0; j < count; j++) {
+        k = random() % count;
+        sum += zslGetRank(zsl, entries[k].score, entries[k].ele, BENCH_ELE);
+    }
+    benchSink += sum;
+    return (double)(nstime()-start)/count;
+}
+
+static void benchReport(const char *name, long long elapsed, long count,
+                        zskiplist *zsl, zskiplistEntry *entries)
+{
+    printf("%-28s %10.1f %10.1f\n", name, (double)elapsed/count,
+        benchLookup(zsl, entries, zsl->length));
+}
+
+int main(int argc, char **argv) {
+    long count = argc > 1 ? atol(argv[1]) : 1000000;
+    long batch = argc > 2 ? atol(argv[2]) : 10000;
+    zskiplistEntry *entries = malloc(sizeof(*entries)*count);
+    zskiplistEntry *shuffled = malloc(sizeof(*entries)*count);
+    char *eles = malloc((size_t)count*BENCH_ELE);
+    long long start;
+    zskiplist *zsl;
+    long j, k, half = count/2;
+
+    for (j = 0; j < count; j++) {
+        snprintf(eles+j*BENCH_ELE, BENCH_ELE, "ele:%011d", (int)j);
+        entries[j].score = j/4;
+        entries[j].ele = eles+j*BENCH_ELE;
+        entries[j].size = BENCH_ELE;
+    }
+    /* The second half in random order, as new members come. */
+    memcpy(shuffled, entries, sizeof(*entries)*count);
+    srandom(1);
+    for (j = count-1; j > half; j--) {
+        zskiplistEntry tmp;
+
+        k = half+random() % (j-half+1);
+        tmp = shuffled[j];
+        shuffled[j] = shuffled[k];
+        shuffled[k] = tmp;
+    }
+
+    printf("%-28s %10s %10s\n", "", "ns/ele", "lookup ns");
+
+    zsl = zslCreateInline(NULL, BENCH_ELE);
+    start = nstime();
+    for (j = 0; j < count; j++)
+        zslInsert(zsl, entries[j].score, entries[j].ele, BENCH_ELE);
+    benchReport("load: zslInsert", nstime()-start, count, zsl, entries);
+    zslFree(zsl);
+
+    zsl = zslCreateInline(NULL, BENCH_ELE);
+    start = nstime();
+    zslBulkLoad(zsl, entries, count);
+    benchReport("load: zslBulkLoad", nstime()-start, count, zsl, entries);
+
+    /* zslBulkLoad() didn't change the entries, that are reused. */
+    zslFree(zsl);
+    zsl = zslCreateInline(NULL, BENCH_ELE);
+    zslBulkLoad(zsl, entries, half);
+    start = nstime();
+    for (j = half; j < count; j++)
+        zslInsert(zsl, shuffled[j].score, shuffled[j].ele, BENCH_ELE);
+    benchReport("add: zslInsert", nstime()-start, count-half, zsl, entries);
+    zslFree(zsl);
+
+    zsl = zslCreateInline(NULL, BENCH_ELE);
+    zslBulkLoad(zsl, entries, half);
+    start = nstime();
+    for (j = half; j < count; j += batch)
+        zslInsertMany(zsl, shuffled+j, j+batch < count ? batch : count-j);
+    benchReport("add: zslInsertMany", nstime()-start, count-half, zsl, entries);
+    zslFree(zsl);
+
+    free(entries);
+    free(shuffled);
+    free(eles);
+    return 0;
+}
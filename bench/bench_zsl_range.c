@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <skiplist.h>
+#include <zmalloc.h>
+
+/* Counting the elements of score ranges of a few widths by walking them
+ * against zslCountInRange(), then deleting ranges one element at a time
+ * with zslDelete() against zslDeleteRangeByScore().
+ *
+ * Usage: bench_zsl_range [elements] [queries] */
+
+#define BENCH_ELE 16
+
+static volatile unsigned long benchSink;
+
+static long long nstime(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+static zskiplist *benchCreate(long count) {
+    zskiplist *zsl = zslCreateInline(NULL, BENCH_ELE);
+    char ele[BENCH_ELE];
+    long j;
+
+    srandom(1);
+    for (j = 0; j < count; j++) {
+        snprintf(ele, sizeof(ele), "ele:%011d", (int)j);
+        zslInsert(zsl, random() % count, ele, BENCH_ELE);
+    }
+    return zsl;
+}
+
+int main(int argc, char **argv) {
+    long count = argc > 1 ? atol(argv[1]) : 1000000;
+    long queries = argc > 2 ? atol(argv[2]) : 10000;
+    static const long widths[] = {10, 1000, 100000};
+    zskiplist *zsl = benchCreate(count);
+    zskiplistNode *x;
+    long long start, twalk, tcount, tdel, trange;
+    unsigned long sum = 0, removed;
+    size_t w;
+    long j;
+
+    printf("%-8s %12s %12s %12s %12s\n", "width", "walk ns", "count ns",
+        "del ns/ele", "range ns/ele");
+    for (w = 0; w < sizeof(widths)/sizeof(widths[0]); w++) {
+        zrangespec range = { .minex = 0, .maxex = 0 };
+        long q = queries / (widths[w] > 1000 ? 100 : 1);
+
+        srandom(2);
+        start = nstime();
+        for (j = 0; j < q; j++) {
+            range.min = random() % count;
+            range.max = range.min+widths[w]-1;
+            x = zslNthInRange(zsl, &range, 0);
+            while (x && zslValueLteMax(x->score, &range)) {
+                sum++;
+                x = x->level[0].forward;
+            }
+        }
+        twalk = (nstime()-start)/q;
+
+        srandom(2);
+        start = nstime();
+        for (j = 0; j < q; j++) {
+            range.min = random() % count;
+            range.max = range.min+widths[w]-1;
+            sum += zslCountInRange(zsl, &range);
+        }
+        tcount = (nstime()-start)/q;
+
+        /* Delete the same range of a fresh copy both ways. */
+        range.min = count/2;
+        range.max = range.min+widths[w]-1;
+        start = nstime();
+        removed = 0;
+        while ((x = zslNthInRange(zsl, &range, 0)) != NULL) {
+            zslDelete(zsl, x->score, x->ele, BENCH_ELE, NULL);
+            removed++;
+        }
+        tdel = removed ? (nstime()-start)/removed : 0;
+        zslFree(zsl);
+        zsl = benchCreate(count);
+
+        start = nstime();
+        removed = zslDeleteRangeByScore(zsl, &range, NULL, NULL);
+        trange = removed ? (nstime()-start)/removed : 0;
+        zslFree(zsl);
+        zsl = benchCreate(count);
+
+        printf("%-8ld %12lld %12lld %12lld %12lld\n", widths[w], twalk, tcount, tdel, trange);
+    }
+    benchSink += sum;
+    zslFree(zsl);
+    return 0;
+}
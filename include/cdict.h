@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __CDICT_H__
+#define __CDICT_H__
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <dict.h>
+#include <epoch.h>
+
+/* cdict is a thread safe variant of dict using the same dictType.
+ *
+ * - Readers never take locks: lookups run inside an epoch read side
+ *   critical section (see epoch.h), so entries and tables unlinked by
+ *   writers are released only when no reader can reference them anymore.
+ * - Writers serialize on one of CDICT_STRIPES mutexes, selected by the low
+ *   bits of the hash. Since tables are never smaller than CDICT_STRIPES
+ *   buckets, all the buckets where a key may live, in both tables, are
+ *   protected by the same stripe.
+ * - Rehashing is incremental and concurrent: every write migrates one
+ *   bucket, claimed with an atomic counter, so many threads move different
+ *   buckets at the same time. Entries are copied to the new table before
+ *   being unlinked from the old one, so a reader looking into the old and
+ *   then the new table always finds them. The switch of the tables is
+ *   guarded by a sequence counter that readers check on misses.
+ *
+ * Write operations wait for grace periods from time to time, so they must
+ * not be called from within a read side critical section. */
+
+#define CDICT_STRIPES 64 /* Must be a power of two */
+
+typedef struct cdictEntry {
+    void *key;
+    union {
+        void *val;
+        uint64_t u64;
+        int64_t s64;
+        double d;
+    } v;
+    struct cdictEntry *next;
+    epochNode reclaim;
+} cdictEntry;
+
+typedef struct cdictht {
+    cdictEntry **table;
+    unsigned long size;
+    unsigned long sizemask;
+    long rehashidx; /* Next bucket to migrate when this is the old table */
+    long moved;     /* Buckets already migrated when this is the old table */
+    epochNode reclaim;
+} cdictht;
+
+typedef struct cdictStripe {
+    pthread_mutex_t lock;
+    long used; /* Number of keys hashing to this stripe */
+} __attribute__((aligned(64))) cdictStripe;
+
+typedef struct cdict {
+    dictType *type;
+    void *privdata;
+    cdictht *ht[2]; /* ht[1] is not NULL while rehashing */
+    unsigned long seq; /* Odd while ht[0] / ht[1] are being switched */
+    pthread_mutex_t resize_lock;
+    epochDomain *epoch;
+    cdictStripe stripes[CDICT_STRIPES];
+} cdict;
+
+#define cdictGetKey(he) ((he)->key)
+#define cdictGetVal(he) ((he)->v.val)
+#define cdictGetSignedIntegerVal(he) ((he)->v.s64)
+#define cdictGetUnsignedIntegerVal(he) ((he)->v.u64)
+#define cdictGetDoubleVal(he) ((he)->v.d)
+
+/* API */
+cdict *cdictCreate(dictType *type, void *privDataPtr);
+void cdictRelease(cdict *d);
+int cdictEnter(cdict *d);
+void cdictExit(cdict *d, int token);
+cdictEntry *cdictFind(cdict *d, const void *key);
+int cdictFetchValue(cdict *d, const void *key, void **val);
+int cdictAdd(cdict *d, void *key, void *val);
+int cdictReplace(cdict *d, void *key, void *val);
+int cdictDelete(cdict *d, const void *key);
+unsigned long cdictSize(cdict *d);
+int cdictIsRehashing(cdict *d);
+int cdictRehash(cdict *d, int n);
+
+#endif
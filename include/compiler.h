@@ -87,4 +87,15 @@
 #define __hot __attribute__((hot))
 #endif
 
+/* Hint the CPU to bring the cache line containing 'addr' close to the
+ * core, so that a later access doesn't stall. prefetchw() is for lines
+ * that are going to be written. */
+#ifndef prefetch
+#define prefetch(addr) __builtin_prefetch(addr, 0)
+#endif
+
+#ifndef prefetchw
+#define prefetchw(addr) __builtin_prefetch(addr, 1)
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __CSKIPLIST_H__
+#define __CSKIPLIST_H__
+#include <stdint.h>
+#include <stddef.h>
+#include <skiplist.h>
+#include <epoch.h>
+
+/* cskiplist is a thread safe variant of zskiplist, with the same ordering
+ * by score, then by element with the zslmemcmp comparator.
+ *
+ * - Insertions and deletions are lock free: nodes are linked level by
+ *   level with compare and swap, and deleted by marking the low bit of
+ *   their forward pointers, from the top level down to level 0. Marking
+ *   level 0 is the point where a node is deleted, any thread meeting a
+ *   marked node later unlinks it.
+ * - Readers never write: lookups and range iterations run inside an epoch
+ *   read side critical section (see epoch.h), so the nodes unlinked by
+ *   writers are released only when no reader can reference them anymore.
+ * - The levels of the new nodes come from a per thread generator, there is
+ *   no shared state to update on insertion but the links and the length.
+ *
+ * There are no spans nor backward pointers, since they can't be updated
+ * atomically with the links: ranks are not available and iteration only
+ * goes forward.
+ *
+ * Write operations wait for grace periods from time to time, so they must
+ * not be called from within a read side critical section. */
+
+#define CSKIPLIST_MAXLEVEL 32
+
+typedef struct cskiplistNode {
+    void *ele;
+    double score;
+    int level;
+    int state;              /* Linking status, see cslInsert(). */
+    epochNode reclaim;
+    uintptr_t next[];       /* Forward pointers, the low bit marks deletion. */
+} cskiplistNode;
+
+typedef struct cskiplist {
+    cskiplistNode *header;
+    long length;
+    zslmemcmp mcmp;
+    epochDomain *epoch;
+} cskiplist;
+
+/* API */
+cskiplist *cslCreate(zslmemcmp mp);
+void cslRelease(cskiplist *csl);
+int cslEnter(cskiplist *csl);
+void cslExit(cskiplist *csl, int token);
+int cslInsert(cskiplist *csl, double score, void *ele, size_t size);
+int cslDelete(cskiplist *csl, double score, const void *ele, size_t size);
+cskiplistNode *cslFind(cskiplist *csl, double score, const void *ele, size_t size);
+cskiplistNode *cslFirstInRange(cskiplist *csl, zrangespec *range);
+cskiplistNode *cslNext(cskiplist *csl, cskiplistNode *x);
+unsigned long cslLength(cskiplist *csl);
+
+#endif
@@ -53,6 +53,11 @@ typedef struct dictType {
     int (*keyCompare)(void *privdata, const void *key1, const void *key2);
     void (*keyDestructor)(void *privdata, void *key);
     void (*valDestructor)(void *privdata, void *obj);
+    /* Optional: returns the number of bytes to copy for 'key'. Keys of up
+     * to DICT_EMBED_KEY_MAX bytes are then stored inside the entry itself,
+     * in the same allocation, instead of being duplicated by keyDup().
+     * Returning 0 means the key can't be embedded. */
+    size_t (*keyEmbedLen)(const void *key);
 } dictType;
 
 /* This is our hash table structure. Every dictionary has two of this as we
@@ -70,6 +75,8 @@ typedef struct dict {
     dictht ht[2];
     long rehashidx; /* rehashing not in progress if rehashidx == -1 */
     unsigned long iterators; /* number of iterators currently running */
+    struct dictBgRehash *bg; /* helper thread, NULL unless background rehashing */
+    uint64_t rngstate; /* xorshift state used by dictSampleKeys() */
 } dict;
 
 /* If safe is set to 1 this is a safe iterator, that means, you can call
@@ -80,17 +87,58 @@ typedef struct dictIterator {
     dict *d;
     long index;
     int table, safe;
+    int paused; /* unsafe iterator pausing the background rehashing */
     dictEntry *entry, *nextEntry;
     /* unsafe iterator fingerprint for misuse detection. */
     long long fingerprint;
 } dictIterator;
 
+/* Stats of a hash table, see dictCollectStats(). */
+#define DICT_STATS_VECTLEN 50
+
+#define DICT_STATS_CHAINS (1<<0)
+#define DICT_STATS_MEMORY (1<<1)
+#define DICT_STATS_KEYS   (1<<2)
+
+typedef struct dictHtStats {
+    unsigned long size;       /* Number of buckets */
+    unsigned long used;       /* Number of elements */
+    size_t table_bytes;       /* Bucket array */
+    size_t entry_bytes;       /* Entries (estimated without DICT_STATS_MEMORY) */
+    size_t key_bytes;         /* Keys not embedded (only with DICT_STATS_KEYS) */
+    /* Only with DICT_STATS_CHAINS, zero otherwise. */
+    unsigned long buckets;    /* Non empty buckets */
+    unsigned long max_chain;  /* Longest chain */
+    unsigned long chains[DICT_STATS_VECTLEN]; /* Buckets by chain length, the
+                                                 last counts longer chains too */
+} dictHtStats;
+
+typedef struct dictStats {
+    int flags;                   /* DICT_STATS_* flags used to collect */
+    int rehashing;
+    unsigned long rehash_moved;  /* Buckets of ht[0] already migrated */
+    unsigned long rehash_total;  /* Buckets of ht[0] */
+    unsigned long iterators;     /* Safe iterators pausing the rehashing */
+    size_t dict_bytes;           /* The dict structure itself */
+    size_t total_bytes;          /* Sum of all the bytes in this structure */
+    dictHtStats ht[2];
+} dictStats;
+
 typedef void (dictScanFunction)(void *privdata, const dictEntry *de);
+typedef double (dictSampleScoreFunction)(void *privdata, const dictEntry *de);
 typedef void (dictScanBucketFunction)(void *privdata, dictEntry **bucketref);
 
 /* This is the initial size of every hash table */
 #define DICT_HT_INITIAL_SIZE     4
 
+/* Keys longer than this are never embedded in the entry. */
+#define DICT_EMBED_KEY_MAX       48
+
+/* dictSampleKeys() looks at DICT_SAMPLE_WINDOW entries for every key it
+ * returns, visiting at most DICT_SAMPLE_MAXSTEPS buckets per wanted entry. */
+#define DICT_SAMPLE_WINDOW       4
+#define DICT_SAMPLE_MAXSTEPS     10
+
 #define dictFreeVal(d, entry)                                   \
     if ((d)->type->valDestructor)                               \
         (d)->type->valDestructor((d)->privdata, (entry)->v.val)
@@ -111,8 +159,12 @@ typedef void (dictScanBucketFunction)(void *privdata, dictEntry **bucketref);
 #define dictSetDoubleVal(entry, _val_) \
     do { (entry)->v.d = _val_; } while(0)
 
-#define dictFreeKey(d, entry)       \
-    if ((d)->type->keyDestructor)   \
+/* Embedded keys are stored right after the entry and are released with it. */
+#define dictEntryKeyIsEmbedded(entry) \
+    ((void*)(entry)->key == (void*)((entry)+1))
+
+#define dictFreeKey(d, entry)                                       \
+    if ((d)->type->keyDestructor && !dictEntryKeyIsEmbedded(entry)) \
         (d)->type->keyDestructor((d)->privdata, (entry)->key)
 
 #define dictSetKey(d, entry, _key_) do {                        \
@@ -134,7 +186,7 @@ typedef void (dictScanBucketFunction)(void *privdata, dictEntry **bucketref);
 #define dictGetUnsignedIntegerVal(he) ((he)->v.u64)
 #define dictGetDoubleVal(he) ((he)->v.d)
 #define dictSlots(d) ((d)->ht[0].size+(d)->ht[1].size)
-#define dictSize(d) ((d)->ht[0].used+(d)->ht[1].used)
+#define dictSize(d) ((d)->bg ? dictLockedSize(d) : (d)->ht[0].used+(d)->ht[1].used)
 #define dictIsRehashing(d) ((d)->rehashidx != -1)
 
 /* API */
@@ -150,6 +202,8 @@ void dictFreeUnlinkedEntry(dict *d, dictEntry *he);
 void dictRelease(dict *d);
 dictEntry * dictFind(dict *d, const void *key);
 void *dictFetchValue(dict *d, const void *key);
+unsigned long dictFindMany(dict *d, const void **keys, unsigned long count, dictEntry **entries);
+unsigned long dictAddMany(dict *d, void **keys, void **vals, unsigned long count);
 int dictResize(dict *d);
 dictIterator *dictGetIterator(dict *d);
 dictIterator *dictGetSafeIterator(dict *d);
@@ -157,23 +211,39 @@ dictEntry *dictNext(dictIterator *iter);
 void dictReleaseIterator(dictIterator *iter);
 dictEntry *dictGetRandomKey(dict *d);
 unsigned int dictGetSomeKeys(dict *d, dictEntry **des, unsigned int count);
+unsigned int dictSampleKeys(dict *d, dictEntry **des, unsigned int count);
+unsigned int dictSampleBestKeys(dict *d, dictEntry **des, double *scores, unsigned int count, unsigned int samples, dictSampleScoreFunction *score, void *privdata);
+void dictSetSampleSeed(dict *d, uint64_t seed);
 void dictGetStats(char *buf, size_t bufsize, dict *d);
+void dictCollectStats(dict *d, dictStats *stats, int flags);
 uint64_t dictGenHashFunction(const void *key, int len);
 uint64_t dictGenCaseHashFunction(const unsigned char *buf, int len);
+uint64_t dictGenWyHashFunction(const void *key, int len);
 void dictEmpty(dict *d, void(callback)(void*));
 void dictEnableResize(void);
 void dictDisableResize(void);
 int dictRehash(dict *d, int n);
 int dictRehashMilliseconds(dict *d, int ms);
+int dictEnableBackgroundRehash(dict *d);
+void dictDisableBackgroundRehash(dict *d);
+int dictRehashProgress(dict *d, unsigned long *moved, unsigned long *total);
+unsigned long dictLockedSize(dict *d);
 void dictSetHashFunctionSeed(uint8_t *seed);
 uint8_t *dictGetHashFunctionSeed(void);
 unsigned long dictScan(dict *d, unsigned long v, dictScanFunction *fn, dictScanBucketFunction *bucketfn, void *privdata);
+unsigned long dictScanPartition(dict *d, unsigned long v, unsigned long part, unsigned long nparts, dictScanFunction *fn, dictScanBucketFunction *bucketfn, void *privdata);
 uint64_t dictGetHash(dict *d, const void *key);
 dictEntry **dictFindEntryRefByPtrAndHash(dict *d, const void *oldptr, uint64_t hash);
+int dictReplaceKeyPtr(dict *d, const void *oldptr, void *newptr, uint64_t hash);
 
 /* Hash table types */
 extern dictType dictTypeHeapStringCopyKey;
 extern dictType dictTypeHeapStrings;
 extern dictType dictTypeHeapStringCopyKeyValue;
+extern dictType dictTypeStringCopyKeyWyhash;
+extern dictType dictTypeStringCopyKeyWyhashUnseeded;
+/* Keys of the same length that collide under crc32c collide with any seed,
+ * so this type has no seeded variant: use it only for trusted keys. */
+extern dictType dictTypeStringCopyKeyCrc32c;
 
 #endif
\ No newline at end of file
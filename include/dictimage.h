@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __DICTIMAGE_H__
+#define __DICTIMAGE_H__
+#include <stdint.h>
+#include <stddef.h>
+#include <dict.h>
+
+/* Dict images: a dict saved to a flat file that can be mmap()ed.
+ *
+ * The file contains a hash table of its own: an array of nbuckets+1
+ * offsets, and the records of every bucket stored contiguously, each one
+ * with the hash of its key. All the references are offsets from the start
+ * of the file, so a mapped image can be used as it is, read only, with
+ * dictImageFind(), or turned back into a dict with dictImageLoad(), that
+ * links the entries in the buckets given by the stored hashes without
+ * hashing or comparing any key.
+ *
+ * Saving only reads the dict, so it can be performed by a forked child
+ * without touching (and so copying) the pages of the parent.
+ *
+ * Images use the native byte order, and store the seed of the dict hash
+ * functions: hashes are valid only with the same hash function and seed.
+ *
+ * Layout:
+ *
+ * +--------+------------------------+---------------------------------+
+ * | header | uint64_t buckets[n+1]  | records, grouped by bucket      |
+ * +--------+------------------------+---------------------------------+
+ *
+ * Every record is: uint64_t hash, uint32_t keylen, uint32_t vallen, the
+ * key and the value, each one padded to 8 bytes. */
+
+#define DICT_IMAGE_VERSION 1
+
+typedef struct dictImageHeader {
+    char magic[8];           /* "DICTIMG1" */
+    uint32_t version;
+    uint32_t checksum;       /* CRC32C of everything after the header */
+    uint64_t count;          /* Number of records */
+    uint64_t nbuckets;       /* Power of two */
+    uint64_t buckets_offset; /* Offset of the bucket array */
+    uint64_t records_offset; /* Offset of the first record */
+    uint64_t file_size;
+    uint8_t seed[16];        /* dictGetHashFunctionSeed() when saved */
+} dictImageHeader;
+
+typedef struct dictImageRecord {
+    uint64_t hash;
+    uint32_t keylen;
+    uint32_t vallen;
+    /* Followed by the key and the value. */
+} dictImageRecord;
+
+/* Conversion of keys and values from / to bytes. */
+typedef struct dictImageType {
+    /* Set '*data' to the bytes of the key or of the value of 'de', and
+     * return their length. */
+    size_t (*keyBytes)(const dictEntry *de, const void **data);
+    size_t (*valBytes)(const dictEntry *de, const void **data);
+    /* Return a new key for the dict from its bytes. It is called only for
+     * the keys that can't be embedded in the entry (see keyEmbedLen). */
+    void *(*keyLoad)(void *privdata, const void *data, size_t len);
+    /* Set the value of 'de' from its bytes. */
+    void (*valLoad)(void *privdata, dictEntry *de, const void *data, size_t len);
+} dictImageType;
+
+typedef struct dictImage {
+    void *map;
+    size_t size;
+    const dictImageHeader *hdr;
+    const uint64_t *buckets;
+} dictImage;
+
+#define dictImageRecordKey(r) ((const void*)((r)+1))
+#define dictImageRecordVal(r) \
+    ((const void*)((const char*)((r)+1)+(((r)->keylen+7)&~7UL)))
+#define dictImageCount(img) ((img)->hdr->count)
+#define dictImageHashSeed(img) ((img)->hdr->seed)
+
+int dictImageSave(dict *d, dictImageType *itype, const char *path);
+dictImage *dictImageOpen(const char *path);
+void dictImageClose(dictImage *img);
+int dictImageVerify(dictImage *img);
+const dictImageRecord *dictImageFind(dictImage *img, uint64_t hash, const void *key, size_t keylen);
+dict *dictImageLoad(dictImage *img, dictType *type, dictImageType *itype, void *privDataPtr);
+
+#endif
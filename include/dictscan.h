@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __DICTSCAN_H__
+#define __DICTSCAN_H__
+#include <pthread.h>
+#include <dict.h>
+
+/* A pool of threads scanning the partitions of a dict concurrently, see
+ * dictScanPartition().
+ *
+ * The pool splits the cursor space in about DICT_SCAN_PARTS_PER_THREAD
+ * partitions per thread, that threads take one at a time, so that threads
+ * finishing early help with the rest. Threads are created once and reused
+ * by every scan. */
+
+#define DICT_SCAN_PARTS_PER_THREAD 16
+
+typedef struct dictScanPool {
+    pthread_t *threads;
+    int numthreads;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;     /* Signaled when a scan starts or the pool stops */
+    pthread_cond_t done;     /* Signaled when a thread completes a scan */
+    unsigned long generation;
+    int running;             /* Threads still scanning */
+    int stop;
+    /* The current scan. */
+    dict *d;
+    dictScanFunction *fn;
+    dictScanBucketFunction *bucketfn;
+    void **privdata;
+    unsigned long nparts;
+    unsigned long nextpart;
+} dictScanPool;
+
+dictScanPool *dictScanPoolCreate(int numthreads);
+void dictScanPoolRelease(dictScanPool *pool);
+unsigned long dictScanPoolPartitions(dictScanPool *pool, dict *d);
+void dictScanPoolRun(dictScanPool *pool, dict *d, dictScanFunction *fn, dictScanBucketFunction *bucketfn, void **privdata);
+
+#endif
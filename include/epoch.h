@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __EPOCH_H__
+#define __EPOCH_H__
+
+/* Epoch based memory reclamation for lock free readers.
+ *
+ * Readers wrap every access to a shared structure between epochEnter() and
+ * epochExit(). Writers unlink objects from the structure, then hand them to
+ * epochRetire() instead of freeing them: the object is actually released
+ * by epochReclaim() only after a grace period, that is, once all the
+ * readers that could have obtained a reference to it have exited.
+ *
+ * Readers only increment and decrement a counter in a per-thread slot, so
+ * they never wait and never write to cache lines shared with other threads.
+ * The grace period is detected by epochSynchronize() flipping the current
+ * epoch and waiting for the counters of the previous one to drain.
+ *
+ * epochSynchronize() and so epochReclaim() must never be called from
+ * within a read side critical section, or they'll wait forever. */
+
+#define EPOCH_SLOTS 64 /* Must be a power of two */
+#define EPOCH_RECLAIM_THRESHOLD 128 /* Retired objects per slot before reclaim */
+
+typedef struct epochNode epochNode;
+typedef void (epochFreeFunction)(epochNode *node, void *privdata);
+
+/* Objects to retire embed this structure. */
+struct epochNode {
+    epochNode *next;
+    epochFreeFunction *free;
+};
+
+typedef struct epochDomain epochDomain;
+
+epochDomain *epochCreate(void *privdata);
+void epochRelease(epochDomain *ed);
+int epochEnter(epochDomain *ed);
+void epochExit(epochDomain *ed, int token);
+void epochSynchronize(epochDomain *ed);
+void epochRetire(epochDomain *ed, epochNode *node, epochFreeFunction *fn);
+void epochReclaim(epochDomain *ed, int force);
+
+#endif
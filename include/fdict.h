@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FDICT_H__
+#define __FDICT_H__
+#include <stdint.h>
+#include <stddef.h>
+#include <dict.h>
+
+/* fdict is a frozen dict: an immutable table built once from a dict that
+ * is only read from then on.
+ *
+ * Keys are placed with a minimal perfect hash function, in the style of
+ * PTHash: keys are split in buckets of about FDICT_BUCKET_KEYS keys by
+ * their hash, and for every bucket a small "pilot" is searched so that the
+ * hash of every key mixed with the pilot of its bucket lands in a free
+ * position of a table a bit larger than the number of keys. Positions past
+ * the number of keys are then remapped to the holes left below it, so the
+ * entries are a flat array with exactly one slot per key and no next
+ * pointers.
+ *
+ * A lookup reads the pilot of the bucket (the pilots array is two bytes
+ * every FDICT_BUCKET_KEYS keys, so it is much more likely to be cached than
+ * the entries) and then the entry, compared with the keyCompare callback
+ * of the dictType. Keys that are not in the table still land in some
+ * entry, so the comparison is always needed. */
+
+#define FDICT_BUCKET_KEYS 3
+
+typedef struct fdictEntry {
+    void *key;
+    union {
+        void *val;
+        uint64_t u64;
+        int64_t s64;
+        double d;
+    } v;
+} fdictEntry;
+
+typedef struct fdict {
+    dictType *type;
+    void *privdata;
+    fdictEntry *entries;     /* One per key */
+    unsigned long size;      /* Number of keys */
+    unsigned long nbuckets;
+    unsigned long tablesize; /* Positions of the hash function, >= size */
+    uint64_t seed;
+    uint16_t *pilots;        /* One per bucket */
+    unsigned long *remap;    /* tablesize-size positions past 'size' */
+    char *keys;              /* Keys that were embedded in the dict */
+    size_t keyslen;
+} fdict;
+
+#define fdictGetKey(he) ((he)->key)
+#define fdictGetVal(he) ((he)->v.val)
+#define fdictGetSignedIntegerVal(he) ((he)->v.s64)
+#define fdictGetUnsignedIntegerVal(he) ((he)->v.u64)
+#define fdictGetDoubleVal(he) ((he)->v.d)
+#define fdictSize(d) ((d)->size)
+/* Entries can be walked in order, from 0 to fdictSize()-1. */
+#define fdictEntryAt(d, i) (&(d)->entries[i])
+
+/* API */
+fdict *fdictFreeze(dict *d);
+void fdictRelease(fdict *d);
+fdictEntry *fdictFind(fdict *d, const void *key);
+void *fdictFetchValue(fdict *d, const void *key);
+size_t fdictMemoryUsage(fdict *d);
+
+#endif
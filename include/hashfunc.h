@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __HASHFUNC_H__
+#define __HASHFUNC_H__
+#include <stdint.h>
+#include <stddef.h>
+
+/* Non cryptographic hash functions for trusted keys.
+ *
+ * SipHash, the default of dict, protects from hash flooding attacks when
+ * keys come from untrusted sources, but it costs a lot on short keys. The
+ * functions below are several times faster and have good distribution,
+ * but must only be used with keys an attacker can't choose.
+ *
+ * - wyhash: a multiply-mix hash in the wyhash (final 4) family. A secret
+ *   random seed makes attacks harder, but not impossible.
+ * - crc32c: two interleaved CRC32C streams and a final mix, using the
+ *   SSE4.2 crc32 instruction when the CPU supports it. CRC is affine in
+ *   its initial value, so the seed only xors in a constant that depends
+ *   on the length: keys of the same length that collide with a seed
+ *   collide with every seed, and a secret seed gives no protection. */
+
+typedef uint64_t (hashFunction)(const void *key, size_t len, uint64_t seed);
+
+/* An entry of the registry of the available hash functions. */
+typedef struct hashFunctionEntry {
+    const char *name;
+    hashFunction *fn;
+} hashFunctionEntry;
+
+uint64_t sipHash64(const void *key, size_t len, uint64_t seed);
+uint64_t wyHash64(const void *key, size_t len, uint64_t seed);
+uint64_t crc32cHash64(const void *key, size_t len, uint64_t seed);
+uint64_t crc32cHash64Software(const void *key, size_t len, uint64_t seed);
+uint32_t crc32c(uint32_t crc, const void *buf, size_t len);
+uint32_t crc32cSoftware(uint32_t crc, const void *buf, size_t len);
+int crc32cHardwareSupported(void);
+
+hashFunction *hashFunctionByName(const char *name);
+const hashFunctionEntry *hashFunctionList(void);
+
+#endif
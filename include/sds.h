@@ -29,11 +29,12 @@
 #define __SDS_H__
 
 #define SDS_MAX_PREALLOC (1024*1024)
-const char *SDS_NOINIT;
+extern const char *SDS_NOINIT;
 
 #include <sys/types.h>
 #include <stdarg.h>
 #include <stdint.h>
+#include <mempool.h>
 
 typedef char *sds;
 
@@ -68,6 +69,22 @@ struct __attribute__ ((__packed__)) sdshdr64 {
     char buf[];
 };
 
+/* Iterators over the tokens of a string, see sdsSplitIterInit() and
+ * sdsArgsIterInit(). They live on the stack of the caller and return views
+ * into the string instead of allocating a new sds per token. */
+typedef struct sdsSplitIter {
+    const char *p;      /* Start of the next token. */
+    const char *end;
+    const char *sep;
+    size_t seplen;
+    int done;
+} sdsSplitIter;
+
+typedef struct sdsArgsIter {
+    const char *p;      /* Next char of the line. */
+    sds buf;            /* Last token, if it had to be unescaped. */
+} sdsArgsIter;
+
 #define SDS_TYPE_5  0
 #define SDS_TYPE_8  1
 #define SDS_TYPE_16 2
@@ -75,6 +92,8 @@ struct __attribute__ ((__packed__)) sdshdr64 {
 #define SDS_TYPE_64 4
 #define SDS_TYPE_MASK 7
 #define SDS_TYPE_BITS 3
+#define SDS_POOL_FLAG (1<<SDS_TYPE_BITS) /* Allocated from a mem_pool_t, not type 5. */
+#define SDS_SHARED_FLAG (1<<(SDS_TYPE_BITS+1)) /* Refcounted, not type 5. */
 #define SDS_HDR_VAR(T,s) struct sdshdr##T *sh = (void*)((s)-(sizeof(struct sdshdr##T)));
 #define SDS_HDR(T,s) ((struct sdshdr##T *)((s)-(sizeof(struct sdshdr##T))))
 #define SDS_TYPE_5_LEN(f) ((f)>>SDS_TYPE_BITS)
@@ -213,6 +232,16 @@ static inline void sdssetalloc(sds s, size_t newlen) {
 sds sdsnewlen(const void *init, size_t initlen);
 sds sdsnew(const char *init);
 sds sdsempty(void);
+sds sdsnewlen_pool(mem_pool_t *pool, const void *init, size_t initlen);
+sds sdsnew_pool(mem_pool_t *pool, const char *init);
+sds sdsempty_pool(mem_pool_t *pool);
+mem_pool_t *sdsPool(const sds s);
+sds sdsnewlen_shared(const void *init, size_t initlen);
+sds sdsnew_shared(const char *init);
+sds sdsshare(sds s);
+sds sdsunshare(sds s);
+long sdsrefcount(const sds s);
+int sdsisshared(const sds s);
 sds sdsdup(const sds s);
 void sdsfree(sds s);
 sds sdsgrowzero(sds s, size_t len);
@@ -236,13 +265,22 @@ void sdsrange(sds s, ssize_t start, ssize_t end);
 void sdsupdatelen(sds s);
 void sdsclear(sds s);
 int sdscmp(const sds s1, const sds s2);
+int sdscasecmp(const sds s1, const sds s2);
+ssize_t sdsfindchars(const sds s, size_t start, const char *set, size_t setlen);
 sds *sdssplitlen(const char *s, ssize_t len, const char *sep, int seplen, int *count);
 void sdsfreesplitres(sds *tokens, int count);
+void sdsSplitIterInit(sdsSplitIter *it, const char *s, size_t len, const char *sep, size_t seplen);
+int sdsSplitIterNext(sdsSplitIter *it, const char **tok, size_t *toklen);
 void sdstolower(sds s);
 void sdstoupper(sds s);
 sds sdsfromlonglong(long long value);
+sds sdsfromdouble(double value);
+sds sdscatdouble(sds s, double value);
 sds sdscatrepr(sds s, const char *p, size_t len);
 sds *sdssplitargs(const char *line, int *argc);
+void sdsArgsIterInit(sdsArgsIter *it, const char *line);
+int sdsArgsIterNext(sdsArgsIter *it, const char **tok, size_t *toklen);
+void sdsArgsIterRelease(sdsArgsIter *it);
 sds sdsmapchars(sds s, const char *from, const char *to, size_t setlen);
 sds sdsjoin(char **argv, int argc, char *sep);
 sds sdsjoinsds(sds *argv, int argc, const char *sep, size_t seplen);
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __SDSBUILDER_H__
+#define __SDSBUILDER_H__
+
+#include <stddef.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <mempool.h>
+#include <sds.h>
+
+/* A string built as a list of fixed size chunks, for large replies made
+ * of many small pieces. Appending never moves what was already written,
+ * unlike sdscatlen() growing a single buffer, and the content is written
+ * out directly from the chunks with writev(), so every byte is copied
+ * only once.
+ *
+ * Shared sds strings (see sdsnewlen_shared()) of at least
+ * SDS_BUILDER_REF_MIN bytes are not copied at all: the chunk keeps a
+ * reference to them instead.
+ *
+ * The builder lives on the stack or inside another structure:
+ *
+ *   sdsBuilder b;
+ *   struct iovec iov[16];
+ *
+ *   sdsBuilderInit(&b, NULL, 0);
+ *   sdsBuilderCatFmt(&b, "$%U\r\n", (unsigned long long)sdslen(val));
+ *   sdsBuilderCatSds(&b, val);
+ *   sdsBuilderCatLen(&b, "\r\n", 2);
+ *   while (sdsBuilderLen(&b)) {
+ *       int cnt = sdsBuilderIovec(&b, iov, 16);
+ *       ssize_t n = writev(fd, iov, cnt);
+ *       if (n <= 0) break;
+ *       sdsBuilderConsume(&b, n);
+ *   }
+ *   sdsBuilderRelease(&b);
+ */
+
+#define SDS_BUILDER_CHUNK_SIZE (16*1024)
+#define SDS_BUILDER_REF_MIN 1024
+
+typedef struct sdsBuilderChunk {
+    struct sdsBuilderChunk *next;
+    char *data;         /* 'buf', or the referenced string. */
+    size_t len;         /* Bytes used. */
+    size_t size;        /* Bytes of 'buf', 'len' for references. */
+    sds ref;            /* Referenced shared string, or NULL. */
+    char buf[];
+} sdsBuilderChunk;
+
+typedef struct sdsBuilder {
+    mem_pool_t *pool;           /* Chunks allocated from it if not NULL. */
+    sdsBuilderChunk *head;
+    sdsBuilderChunk *tail;
+    size_t chunksize;
+    size_t len;                 /* Bytes not consumed yet. */
+    size_t offset;              /* Bytes of 'head' already consumed. */
+    unsigned long chunks;
+} sdsBuilder;
+
+int _sdsBuilderCatLen(sdsBuilder *b, const void *t, size_t len);
+
+static inline size_t sdsBuilderLen(const sdsBuilder *b) {
+    return b->len;
+}
+
+/* Append 'len' bytes of 't'. Return 0 on success, -1 if out of memory (the
+ * builder then holds part of 't'). Small appends fitting in the last chunk
+ * are inlined, see _sdsBuilderCatLen() for the others. */
+static inline int sdsBuilderCatLen(sdsBuilder *b, const void *t, size_t len) {
+    sdsBuilderChunk *c = b->tail;
+
+    if (c && c->size-c->len >= len) {
+        memcpy(c->buf+c->len, t, len);
+        c->len += len;
+        b->len += len;
+        return 0;
+    }
+    return _sdsBuilderCatLen(b, t, len);
+}
+
+void sdsBuilderInit(sdsBuilder *b, mem_pool_t *pool, size_t chunksize);
+void sdsBuilderReset(sdsBuilder *b);
+void sdsBuilderRelease(sdsBuilder *b);
+int sdsBuilderCat(sdsBuilder *b, const char *t);
+int sdsBuilderCatSds(sdsBuilder *b, const sds s);
+int sdsBuilderCatFmt(sdsBuilder *b, char const *fmt, ...);
+int sdsBuilderIovec(const sdsBuilder *b, struct iovec *iov, int iovcnt);
+void sdsBuilderConsume(sdsBuilder *b, size_t n);
+sds sdsBuilderToSds(const sdsBuilder *b);
+
+#endif
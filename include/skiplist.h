@@ -33,6 +33,7 @@
 #define ZL_START_TAIL 1
 
 typedef int (*zslmemcmp)(const void *v1, const void *v2, size_t size);
+typedef void (*zslfreefn)(void *ele, void *privdata);
 
 typedef struct zskiplistNode {
     void *ele;
@@ -54,6 +55,8 @@ typedef struct zskiplist {
     unsigned long length;
     int level;
     zslmemcmp mcmp;
+    size_t inlinemax;           /* Max size of the inline elements. */
+    struct zskiplistSlab *slab; /* Node allocator, NULL if not inline. */
 } zskiplist;
 
 /* Struct to hold an inclusive/exclusive range spec by score comparison. */
@@ -62,13 +65,42 @@ typedef struct {
     int minex, maxex;
 } zrangespec;
 
+/* Struct to hold an inclusive/exclusive range spec by element comparison,
+ * with zsl->mcmp. A NULL min / max is -inf / +inf. */
+typedef struct {
+    void *min, *max;
+    size_t minlen, maxlen;
+    int minex, maxex;
+} zlexrangespec;
+
+/* An element to add with zslBulkLoad() / zslInsertMany(). */
+typedef struct zskiplistEntry {
+    double score;
+    void *ele;
+    size_t size;
+} zskiplistEntry;
+
 zskiplist *zslCreate(zslmemcmp mp);
+zskiplist *zslCreateInline(zslmemcmp mp, size_t inlinemax);
 void zslFree(zskiplist *zsl);
+void zslFreeNode(zskiplist *zsl, zskiplistNode *node);
 zskiplistNode *zslInsert(zskiplist *zsl, double score, void *ele, size_t size);
+int zslBulkLoad(zskiplist *zsl, zskiplistEntry *entries, unsigned long count);
+void zslInsertMany(zskiplist *zsl, zskiplistEntry *entries, unsigned long count);
 int zslDelete(zskiplist *zsl, double score, void *ele, size_t size, zskiplistNode **node);
 zskiplistNode *zslNthInRange(zskiplist *zsl, zrangespec *range, long n);
 int zslValueGteMin(double value, zrangespec *spec);
 int zslValueLteMax(double value, zrangespec *spec);
+int zslLexValueGteMin(zskiplist *zsl, void *ele, zlexrangespec *spec);
+int zslLexValueLteMax(zskiplist *zsl, void *ele, zlexrangespec *spec);
+unsigned long zslCountInRange(zskiplist *zsl, zrangespec *range);
+unsigned long zslCountInLexRange(zskiplist *zsl, zlexrangespec *range);
+unsigned long zslDeleteRangeByScore(zskiplist *zsl, zrangespec *range,
+                                    zslfreefn freefn, void *privdata);
+unsigned long zslDeleteRangeByLex(zskiplist *zsl, zlexrangespec *range,
+                                  zslfreefn freefn, void *privdata);
+unsigned long zslDeleteRangeByRank(zskiplist *zsl, unsigned long start, unsigned long end,
+                                   zslfreefn freefn, void *privdata);
 unsigned long zslGetRank(zskiplist *zsl, double score, void *ele, size_t size);
 zskiplistIter *zslGetIterator(zskiplist *zsl, int direction);
 zskiplistNode *zslNext(zskiplistIter *iter);
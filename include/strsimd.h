@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __STRSIMD_H__
+#define __STRSIMD_H__
+#include <stddef.h>
+
+/* Vectorized byte string kernels, used by the sds functions working on
+ * every character of a string.
+ *
+ * Every kernel has a scalar, an SSE2 and an AVX2 implementation, selected
+ * at run time according to the CPU, or forced with strsimdSetImplementation()
+ * (to compare them in tests and benchmarks).
+ *
+ * Case mapping and case insensitive comparisons only know about ASCII, like
+ * tolower() and toupper() in the C and UTF-8 locales: bytes >= 128 are never
+ * changed.
+ *
+ * Kernels taking a set of characters compare every byte with every char of
+ * the set if the set has up to STRSIMD_SET_MAX chars (less for the mapping),
+ * and use a 256 bit bitmap or a table otherwise. */
+
+#define STRSIMD_SET_MAX 16
+
+#define STRSIMD_AUTO   -1
+#define STRSIMD_SCALAR 0
+#define STRSIMD_SSE2   1
+#define STRSIMD_AVX2   2
+
+void strsimdToLower(char *p, size_t len);
+void strsimdToUpper(char *p, size_t len);
+void strsimdMapChars(char *p, size_t len, const char *from, const char *to, size_t setlen);
+size_t strsimdSpan(const char *p, size_t len, const char *set, size_t setlen);
+size_t strsimdSpanReverse(const char *p, size_t len, const char *set, size_t setlen);
+size_t strsimdFindChars(const char *p, size_t len, const char *set, size_t setlen);
+size_t strsimdFind(const char *p, size_t len, const char *needle, size_t nlen);
+size_t strsimdReprSpan(const char *p, size_t len);
+int strsimdCaseCmp(const char *p1, const char *p2, size_t len);
+
+int strsimdSetImplementation(int impl);
+int strsimdImplementation(void);
+const char *strsimdImplementationName(int impl);
+
+#endif
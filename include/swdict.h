@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __SWDICT_H__
+#define __SWDICT_H__
+#include <stdint.h>
+#include <stddef.h>
+#include <dict.h>
+
+/* swdict is an open addressing hash table that can be used as a drop in
+ * alternative to dict when the number of keys is large and lookups are
+ * dominated by cache misses.
+ *
+ * Instead of chaining separately allocated dictEntry structures, slots are
+ * stored inline in groups of SWDICT_GROUP_SLOTS entries. Every group starts
+ * with an array of one byte control tags: a control byte is either EMPTY,
+ * DELETED, or the low 7 bits of the hash of the key stored in the slot, so
+ * that a lookup only calls the key comparison callback for slots whose tag
+ * matches. The remaining bits of the hash select the first group to probe.
+ *
+ * The table uses the same dictType callbacks (and so the same siphash seed)
+ * as dict, and implements incremental rehashing from ht[0] to ht[1] exactly
+ * like dict does. */
+
+#define SWDICT_GROUP_SLOTS 16
+
+/* Control byte values. Full slots store the 7 bit hash tag, so any value
+ * with the most significant bit set is a special marker. */
+#define SWDICT_CTRL_EMPTY   ((int8_t)-128)  /* 0x80 */
+#define SWDICT_CTRL_DELETED ((int8_t)-2)    /* 0xFE */
+
+typedef struct swdictEntry {
+    void *key;
+    union {
+        void *val;
+        uint64_t u64;
+        int64_t s64;
+        double d;
+    } v;
+} swdictEntry;
+
+typedef struct swdictGroup {
+    int8_t ctrl[SWDICT_GROUP_SLOTS];
+    swdictEntry slots[SWDICT_GROUP_SLOTS];
+} swdictGroup;
+
+/* Like dictht, but 'size' is the number of groups, not of slots. Deleted
+ * slots are tracked as they still count against the load factor. */
+typedef struct swdictht {
+    swdictGroup *groups;
+    unsigned long size;
+    unsigned long sizemask;
+    unsigned long used;
+    unsigned long deleted;
+} swdictht;
+
+typedef struct swdict {
+    dictType *type;
+    void *privdata;
+    swdictht ht[2];
+    long rehashidx; /* rehashing not in progress if rehashidx == -1 */
+    unsigned long pauserehash; /* number of scans currently running */
+} swdict;
+
+typedef void (swdictScanFunction)(void *privdata, const swdictEntry *de);
+
+/* This is the initial number of groups of every hash table */
+#define SWDICT_HT_INITIAL_SIZE 1
+
+/* The dict.c helper macros (dictSetKey, dictSetVal, dictFreeKey, ...) only
+ * touch the type, privdata, key and v fields, so they work unmodified
+ * against a swdict and a swdictEntry. The following are just aliases. */
+#define swdictGetKey(he) ((he)->key)
+#define swdictGetVal(he) ((he)->v.val)
+#define swdictGetSignedIntegerVal(he) ((he)->v.s64)
+#define swdictGetUnsignedIntegerVal(he) ((he)->v.u64)
+#define swdictGetDoubleVal(he) ((he)->v.d)
+#define swdictSlots(d) (((d)->ht[0].size+(d)->ht[1].size)*SWDICT_GROUP_SLOTS)
+#define swdictSize(d) ((d)->ht[0].used+(d)->ht[1].used)
+#define swdictIsRehashing(d) ((d)->rehashidx != -1)
+
+/* API */
+swdict *swdictCreate(dictType *type, void *privDataPtr);
+int swdictExpand(swdict *d, unsigned long size);
+int swdictAdd(swdict *d, void *key, void *val);
+swdictEntry *swdictAddRaw(swdict *d, void *key, swdictEntry **existing);
+int swdictReplace(swdict *d, void *key, void *val);
+int swdictDelete(swdict *d, const void *key);
+void swdictRelease(swdict *d);
+void swdictEmpty(swdict *d, void(callback)(void*));
+swdictEntry *swdictFind(swdict *d, const void *key);
+void *swdictFetchValue(swdict *d, const void *key);
+int swdictRehash(swdict *d, int n);
+int swdictRehashMilliseconds(swdict *d, int ms);
+unsigned long swdictScan(swdict *d, unsigned long v, swdictScanFunction *fn, void *privdata);
+const char *swdictProbeImplementation(void);
+
+#endif
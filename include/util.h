@@ -28,6 +28,14 @@
 #ifndef __UTIL_H__
 #define __UTIL_H__
 
+#include <stddef.h>
+#include <stdint.h>
+
+/* Size of the buffers big enough for any long long, and any double
+ * converted by d2string(), the null term included. */
+#define LONG_STR_SIZE 21
+#define MAX_D2STRING_CHARS 128
+
 /**
  * @param p Pattern string. Can contain normal characters and wildcard characters such as * and ?.
  *        * matches any number of characters (including zero).
@@ -50,6 +58,53 @@ int stringmatchlen(const char *p, int plen, const char *s, int slen, int nocase)
 */
 long long memtoll(const char *p, int *err);
 
+/**
+ * @return the number of digits of v in base 10
+ */
+uint32_t digits10(uint64_t v);
+
+/**
+ * Convert a number into a null terminated string, two digits at a time.
+ * @param dst the destination buffer
+ * @param dstlen the size of dst, LONG_STR_SIZE bytes always suffice
+ * @param value the number to convert
+ * @return the length of the string, or 0 if dst is too small
+ */
+int ull2string(char *dst, size_t dstlen, unsigned long long value);
+int ll2string(char *dst, size_t dstlen, long long value);
+
+/**
+ * Parse a number in its canonical form: no spaces, no '+', no leading
+ * zeros, "-0" is refused.
+ * @param s the string, not necessarily null terminated
+ * @param slen the length of s
+ * @param value if not NULL, set to the parsed number on success
+ * @return 1 on success, 0 if s is not a number or overflows
+ */
+int string2ll(const char *s, size_t slen, long long *value);
+int string2ull(const char *s, size_t slen, unsigned long long *value);
+
+/**
+ * Parse a double, exactly as strtod() would but faster for the numbers
+ * with up to 19 significant digits and small exponents.
+ * @param s the string, not necessarily null terminated
+ * @param slen the length of s
+ * @param dp if not NULL, set to the parsed number on success
+ * @return 1 on success, 0 on leading spaces, trailing characters, NaN,
+ *         overflows and underflows
+ */
+int string2d(const char *s, size_t slen, double *dp);
+
+/**
+ * Convert a double into the shortest string that parses back to the same
+ * double (Ryu), in the format of "%.17g" otherwise.
+ * @param buf the destination buffer
+ * @param len the size of buf, MAX_D2STRING_CHARS bytes always suffice
+ * @param value the number to convert
+ * @return the length of the string, or 0 if buf is too small
+ */
+int d2string(char *buf, size_t len, double value);
+
 /**
  * @return the UNIX time in microseconds
  */
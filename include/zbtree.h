@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __ZBTREE_H__
+#define __ZBTREE_H__
+
+#include <stddef.h>
+#include <skiplist.h>
+
+/* In memory B+tree of (score, element) pairs, ordered as in a zskiplist,
+ * with the same API. The elements are stored in the leaves, as arrays of
+ * scores and of element pointers, so a lookup or a range scan reads a few
+ * contiguous cache lines per node instead of a node per element. Each
+ * inner node keeps the number of elements under each child, for ranks in
+ * O(log(N)).
+ *
+ * Elements move between leaves on splits and merges, so unlike skiplist
+ * nodes, positions in the tree are only valid until the next change. */
+
+#define ZBTREE_LEAF_MAX 32      /* Elements per leaf. */
+#define ZBTREE_INNER_MAX 32     /* Children per inner node. */
+#define ZBTREE_LEAF_MIN (ZBTREE_LEAF_MAX/2)
+#define ZBTREE_INNER_MIN (ZBTREE_INNER_MAX/2)
+
+typedef struct zbtreeNode {
+    int leaf;                   /* 1 for leaves, 0 for inner nodes. */
+    int count;                  /* Elements of a leaf, children otherwise. */
+} zbtreeNode;
+
+typedef struct zbtreeLeaf {
+    zbtreeNode hdr;
+    struct zbtreeLeaf *prev, *next;
+    double scores[ZBTREE_LEAF_MAX];
+    void *eles[ZBTREE_LEAF_MAX];
+} zbtreeLeaf;
+
+/* scores[i] and eles[i] are the smallest key under children[i], and
+ * sizes[i] the number of elements under it. */
+typedef struct zbtreeInner {
+    zbtreeNode hdr;
+    double scores[ZBTREE_INNER_MAX];
+    void *eles[ZBTREE_INNER_MAX];
+    unsigned long sizes[ZBTREE_INNER_MAX];
+    zbtreeNode *children[ZBTREE_INNER_MAX];
+} zbtreeInner;
+
+typedef struct zbtree {
+    zbtreeNode *root;
+    zbtreeLeaf *head, *tail;
+    unsigned long length;
+    int height;
+    zslmemcmp mcmp;
+} zbtree;
+
+typedef struct zbtreeIter {
+    zbtreeLeaf *leaf;
+    int idx;
+    int direction;
+} zbtreeIter;
+
+zbtree *zbtCreate(zslmemcmp mp);
+void zbtFree(zbtree *zbt);
+void zbtInsert(zbtree *zbt, double score, void *ele, size_t size);
+int zbtDelete(zbtree *zbt, double score, void *ele, size_t size, void **removed);
+unsigned long zbtGetRank(zbtree *zbt, double score, void *ele, size_t size);
+int zbtGetElementByRank(zbtree *zbt, unsigned long rank, double *score, void **ele);
+unsigned long zbtCountInRange(zbtree *zbt, zrangespec *range);
+zbtreeIter *zbtNthInRange(zbtree *zbt, zrangespec *range, long n);
+zbtreeIter *zbtGetIterator(zbtree *zbt, int direction);
+int zbtNext(zbtreeIter *iter, double *score, void **ele);
+void zbtReleaseIterator(zbtreeIter *iter);
+
+#endif
@@ -11,6 +11,12 @@
  * atomicSet(var,value)  -- Set the atomic counter value
  * atomicGetWithSync(var,value)  -- 'atomicGet' with inter-thread synchronization
  * atomicSetWithSync(var,value)  -- 'atomicSet' with inter-thread synchronization
+ * atomicDecrGetWithSync(var,newvalue_var,count) -- Decrement and get the atomic
+ *     counter new value, with inter-thread synchronization (for refcounts)
+ * atomicCompareSwapWithSync(var,expected_var,desired,success_var) -- Set var
+ *     to 'desired' if it is equal to 'expected_var', with inter-thread
+ *     synchronization. 'expected_var' must be a variable, whose value is
+ *     undefined after a failure.
  * 
  * Atomic operations on flags. 
  * Flag type can be int, long, long long or their unsigned counterparts.
@@ -109,6 +115,11 @@
 } while(0)
 #define atomicSetWithSync(var,value) \
     atomic_store_explicit(&var,value,memory_order_seq_cst)
+#define atomicDecrGetWithSync(var,newvalue_var,count) \
+    newvalue_var = atomic_fetch_sub_explicit(&var,(count),memory_order_seq_cst) - (count)
+#define atomicCompareSwapWithSync(var,expected_var,desired,success_var) \
+    success_var = atomic_compare_exchange_strong_explicit(&var,&(expected_var),(desired), \
+        memory_order_seq_cst,memory_order_seq_cst)
 #define atomicFlagGetSet(var,oldvalue_var) \
     oldvalue_var = atomic_exchange_explicit(&var,1,memory_order_relaxed)
 #define REDIS_ATOMIC_API "c11-builtin"
@@ -134,6 +145,11 @@
 } while(0)
 #define atomicSetWithSync(var,value) \
     __atomic_store_n(&var,value,__ATOMIC_SEQ_CST)
+#define atomicDecrGetWithSync(var,newvalue_var,count) \
+    newvalue_var = __atomic_sub_fetch(&var,(count),__ATOMIC_SEQ_CST)
+#define atomicCompareSwapWithSync(var,expected_var,desired,success_var) \
+    success_var = __atomic_compare_exchange_n(&var,&(expected_var),(desired),0, \
+        __ATOMIC_SEQ_CST,__ATOMIC_SEQ_CST)
 #define atomicFlagGetSet(var,oldvalue_var) \
     oldvalue_var = __atomic_exchange_n(&var,1,__ATOMIC_RELAXED)
 #define REDIS_ATOMIC_API "atomic-builtin"
@@ -163,6 +179,11 @@
     ANNOTATE_HAPPENS_BEFORE(&var);  \
     while(!__sync_bool_compare_and_swap(&var,var,value,__sync_synchronize)); \
 } while(0)
+/* The builtin issues a full memory barrier. */
+#define atomicDecrGetWithSync(var,newvalue_var,count) \
+    newvalue_var = __sync_sub_and_fetch(&var,(count))
+#define atomicCompareSwapWithSync(var,expected_var,desired,success_var) \
+    success_var = __sync_bool_compare_and_swap(&var,expected_var,(desired))
 #define atomicFlagGetSet(var,oldvalue_var) \
     oldvalue_var = __sync_val_compare_and_swap(&var,0,1)
 #define REDIS_ATOMIC_API "sync-builtin"
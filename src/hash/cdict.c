@@ -0,0 +1,479 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fmacros.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include <pthread.h>
+#include <cdict.h>
+#include <atomicvar.h>
+#include <zmalloc.h>
+
+/* Tables are never smaller than the number of stripes, so that the stripe
+ * of a key, selected by the low bits of the hash, covers its bucket in
+ * both the old and the new table while rehashing. */
+#define CDICT_HT_INITIAL_SIZE CDICT_STRIPES
+
+/* Pointers traversed by lock free readers are always published and read
+ * with sequentially consistent atomics. */
+#define cdictLoadPtr(var, dst) atomicGetWithSync(var, dst)
+#define cdictStorePtr(var, val) atomicSetWithSync(var, val)
+
+#define cdictEntryOf(node) \
+    ((cdictEntry*)((char*)(node) - offsetof(cdictEntry, reclaim)))
+#define cdictTableOf(node) \
+    ((cdictht*)((char*)(node) - offsetof(cdictht, reclaim)))
+
+/* -------------------------- private prototypes ---------------------------- */
+
+static void _cdictExpandIfNeeded(cdict *d);
+static int _cdictRehash(cdict *d, int n);
+static unsigned long _cdictNextPower(unsigned long size);
+
+/* ------------------------- tables and reclamation ------------------------- */
+
+static cdictht *_cdictCreateTable(unsigned long size) {
+    cdictht *ht = zmalloc(sizeof(*ht));
+
+    ht->table = zcalloc(size*sizeof(cdictEntry*));
+    ht->size = size;
+    ht->sizemask = size-1;
+    ht->rehashidx = 0;
+    ht->moved = 0;
+    return ht;
+}
+
+/* Release a table that was already emptied by rehashing. */
+static void _cdictFreeTable(epochNode *node, void *privdata) {
+    cdictht *ht = cdictTableOf(node);
+
+    DICT_NOTUSED(privdata);
+    zfree(ht->table);
+    zfree(ht);
+}
+
+/* Release a deleted entry. */
+static void _cdictFreeEntry(epochNode *node, void *privdata) {
+    cdict *d = privdata;
+    cdictEntry *he = cdictEntryOf(node);
+
+    dictFreeKey(d, he);
+    dictFreeVal(d, he);
+    zfree(he);
+}
+
+/* Release an entry replaced by a copy with a new value: the key is owned
+ * by the copy now. */
+static void _cdictFreeEntryVal(epochNode *node, void *privdata) {
+    cdict *d = privdata;
+    cdictEntry *he = cdictEntryOf(node);
+
+    dictFreeVal(d, he);
+    zfree(he);
+}
+
+/* Release an entry migrated to the new table: both the key and the value
+ * are owned by the copy now. */
+static void _cdictFreeEntryShell(epochNode *node, void *privdata) {
+    DICT_NOTUSED(privdata);
+    zfree(cdictEntryOf(node));
+}
+
+/* Load a consistent pair of tables: ht[1] is NULL unless we are rehashing.
+ * Returns the sequence number the tables refer to. */
+static unsigned long _cdictTables(cdict *d, cdictht **t0, cdictht **t1) {
+    unsigned long seq, check;
+
+    while (1) {
+        atomicGetWithSync(d->seq, seq);
+        if (seq & 1) continue; /* Switch in progress. */
+        cdictLoadPtr(d->ht[0], *t0);
+        cdictLoadPtr(d->ht[1], *t1);
+        atomicGetWithSync(d->seq, check);
+        if (check == seq) return seq;
+    }
+}
+
+/* Switch the tables. Must be called with the resize lock held. */
+static void _cdictSetTables(cdict *d, cdictht *t0, cdictht *t1) {
+    unsigned long seq;
+
+    atomicGetWithSync(d->seq, seq);
+    atomicSetWithSync(d->seq, seq+1);
+    cdictStorePtr(d->ht[0], t0);
+    cdictStorePtr(d->ht[1], t1);
+    atomicSetWithSync(d->seq, seq+2);
+}
+
+/* ----------------------------- API implementation ------------------------- */
+
+/* Create a new concurrent hash table. */
+cdict *cdictCreate(dictType *type, void *privDataPtr) {
+    cdict *d;
+    int j;
+
+    /* The stripes must be cache line aligned, that zmalloc() can't do. */
+    if (posix_memalign((void**)&d, 64, sizeof(*d)) != 0) return NULL;
+    d->type = type;
+    d->privdata = privDataPtr;
+    d->ht[0] = _cdictCreateTable(CDICT_HT_INITIAL_SIZE);
+    d->ht[1] = NULL;
+    d->seq = 0;
+    d->epoch = epochCreate(d);
+    pthread_mutex_init(&d->resize_lock, NULL);
+    for (j = 0; j < CDICT_STRIPES; j++) {
+        pthread_mutex_init(&d->stripes[j].lock, NULL);
+        d->stripes[j].used = 0;
+    }
+    return d;
+}
+
+/* Destroy the table. No other thread must be using it. */
+void cdictRelease(cdict *d) {
+    unsigned long i;
+    int j;
+
+    /* Entries retired but not yet released are owned by the epoch domain,
+     * the tables only reference live entries. */
+    epochRelease(d->epoch);
+    for (j = 0; j < 2; j++) {
+        cdictht *ht = d->ht[j];
+
+        if (ht == NULL) continue;
+        for (i = 0; i < ht->size; i++) {
+            cdictEntry *he = ht->table[i], *next;
+            while (he) {
+                next = he->next;
+                dictFreeKey(d, he);
+                dictFreeVal(d, he);
+                zfree(he);
+                he = next;
+            }
+        }
+        zfree(ht->table);
+        zfree(ht);
+    }
+    for (j = 0; j < CDICT_STRIPES; j++)
+        pthread_mutex_destroy(&d->stripes[j].lock);
+    pthread_mutex_destroy(&d->resize_lock);
+    free(d);
+}
+
+/* Enter / exit a read side critical section. Entries returned by
+ * cdictFind() can be accessed only until the matching cdictExit() call.
+ * Critical sections are cheap, they don't take locks nor write to shared
+ * cache lines, and they can be nested. */
+int cdictEnter(cdict *d) {
+    return epochEnter(d->epoch);
+}
+
+void cdictExit(cdict *d, int token) {
+    epochExit(d->epoch, token);
+}
+
+/* Search 'key' in the bucket of 'ht'. If 'ref' is not NULL it is populated
+ * with the reference to the pointer linking the returned entry. */
+static cdictEntry *_cdictLookup(cdict *d, cdictht *ht, const void *key,
+                                uint64_t hash, cdictEntry ***ref)
+{
+    cdictEntry **heref = &ht->table[hash & ht->sizemask], *he;
+
+    cdictLoadPtr(*heref, he);
+    while (he) {
+        if (key == he->key || dictCompareKeys(d, key, he->key)) {
+            if (ref) *ref = heref;
+            return he;
+        }
+        heref = &he->next;
+        cdictLoadPtr(*heref, he);
+    }
+    return NULL;
+}
+
+/* Lock free lookup, must be called inside cdictEnter() / cdictExit().
+ *
+ * Migrated entries are linked into the new table before being unlinked
+ * from the old one, so searching the old and then the new table is enough
+ * while rehashing. However if the tables were switched while we were
+ * searching, the key may have moved to a table we don't know about, so on
+ * misses we retry if the sequence number changed. */
+cdictEntry *cdictFind(cdict *d, const void *key) {
+    cdictht *t0, *t1;
+    cdictEntry *he;
+    unsigned long seq, check;
+    uint64_t h = dictHashKey(d, key);
+
+    do {
+        seq = _cdictTables(d, &t0, &t1);
+        if ((he = _cdictLookup(d, t0, key, h, NULL)) != NULL) return he;
+        if (t1 && (he = _cdictLookup(d, t1, key, h, NULL)) != NULL) return he;
+        atomicGetWithSync(d->seq, check);
+    } while (check != seq);
+    return NULL;
+}
+
+/* Fetch the value of 'key' into '*val'. Returns DICT_OK if the key was
+ * found, otherwise DICT_ERR. Note that if the dict type has a value
+ * destructor the value may be released as soon as the function returns
+ * because of a concurrent write: use cdictFind() inside a read side
+ * critical section in that case. */
+int cdictFetchValue(cdict *d, const void *key, void **val) {
+    cdictEntry *he;
+    int token = cdictEnter(d);
+
+    he = cdictFind(d, key);
+    if (he) *val = cdictGetVal(he);
+    cdictExit(d, token);
+    return he ? DICT_OK : DICT_ERR;
+}
+
+/* Lock the stripe of 'hash' and load the tables. Since the tables can only
+ * be switched after all the buckets of the stripe were migrated, which
+ * requires the stripe lock, they stay valid for our bucket while we hold
+ * the lock. Must be called inside a read side critical section. */
+static cdictStripe *_cdictLockStripe(cdict *d, uint64_t hash, cdictht **t) {
+    cdictStripe *s = &d->stripes[hash & (CDICT_STRIPES-1)];
+
+    pthread_mutex_lock(&s->lock);
+    _cdictTables(d, &t[0], &t[1]);
+    return s;
+}
+
+/* Common tail of all the write operations: help the rehashing, and
+ * release retired objects once enough of them accumulated. */
+static void _cdictWriteDone(cdict *d, int token, int grow) {
+    if (grow) _cdictExpandIfNeeded(d);
+    _cdictRehash(d, 1);
+    epochExit(d->epoch, token);
+    epochReclaim(d->epoch, 0);
+}
+
+/* Add or update 'key'. Returns 1 if the key was added, 0 if it already
+ * existed, in which case the value is updated only if 'replace' is true.
+ *
+ * Updates don't modify the value in place, since readers may be reading
+ * it: a copy of the entry with the new value takes the place of the old
+ * entry, that is released after a grace period. */
+static int _cdictInsert(cdict *d, void *key, void *val, int replace) {
+    cdictht *t[2];
+    cdictEntry *he = NULL, **ref;
+    cdictStripe *s;
+    uint64_t h = dictHashKey(d, key);
+    int token, j, added = 0, grow = 0;
+    long used;
+
+    token = epochEnter(d->epoch);
+    s = _cdictLockStripe(d, h, t);
+    for (j = 0; j < 2 && t[j]; j++)
+        if ((he = _cdictLookup(d, t[j], key, h, &ref)) != NULL) break;
+
+    if (he) {
+        if (replace) {
+            cdictEntry *nhe = zmalloc(sizeof(*nhe));
+
+            nhe->key = he->key;
+            dictSetVal(d, nhe, val);
+            nhe->next = he->next;
+            cdictStorePtr(*ref, nhe);
+            epochRetire(d->epoch, &he->reclaim, _cdictFreeEntryVal);
+        }
+    } else {
+        /* While rehashing new keys always go into the new table. */
+        cdictht *ht = t[1] ? t[1] : t[0];
+        cdictEntry **bucket = &ht->table[h & ht->sizemask];
+
+        he = zmalloc(sizeof(*he));
+        dictSetKey(d, he, key);
+        dictSetVal(d, he, val);
+        he->next = *bucket;
+        cdictStorePtr(*bucket, he);
+        atomicIncrGet(s->used, used, 1);
+        added = 1;
+        /* Every stripe owns 1/CDICT_STRIPES of the buckets: check the
+         * global load factor only when the stripe reaches 1:1. */
+        grow = t[1] == NULL && used > (long)(t[0]->size/CDICT_STRIPES);
+    }
+    pthread_mutex_unlock(&s->lock);
+    _cdictWriteDone(d, token, grow);
+    return added;
+}
+
+/* Add an element, returning DICT_OK on success or DICT_ERR if the key
+ * already exists. */
+int cdictAdd(cdict *d, void *key, void *val) {
+    return _cdictInsert(d, key, val, 0) ? DICT_OK : DICT_ERR;
+}
+
+/* Add or Overwrite, see dictReplace(). */
+int cdictReplace(cdict *d, void *key, void *val) {
+    return _cdictInsert(d, key, val, 1);
+}
+
+/* Remove an element, returning DICT_OK on success or DICT_ERR if the
+ * element was not found. Key and value are released after a grace
+ * period. */
+int cdictDelete(cdict *d, const void *key) {
+    cdictht *t[2];
+    cdictEntry *he = NULL, **ref;
+    cdictStripe *s;
+    uint64_t h = dictHashKey(d, key);
+    int token, j;
+
+    token = epochEnter(d->epoch);
+    s = _cdictLockStripe(d, h, t);
+    for (j = 0; j < 2 && t[j]; j++) {
+        if ((he = _cdictLookup(d, t[j], key, h, &ref)) != NULL) {
+            cdictStorePtr(*ref, he->next);
+            atomicDecr(s->used, 1);
+            epochRetire(d->epoch, &he->reclaim, _cdictFreeEntry);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    _cdictWriteDone(d, token, 0);
+    return he ? DICT_OK : DICT_ERR;
+}
+
+/* Return the number of elements. The result is exact only if no write is
+ * in progress. */
+unsigned long cdictSize(cdict *d) {
+    unsigned long size = 0;
+    long used;
+    int j;
+
+    for (j = 0; j < CDICT_STRIPES; j++) {
+        atomicGet(d->stripes[j].used, used);
+        size += used;
+    }
+    return size;
+}
+
+int cdictIsRehashing(cdict *d) {
+    cdictht *t0, *t1;
+
+    _cdictTables(d, &t0, &t1);
+    return t1 != NULL;
+}
+
+/* Performs N steps of incremental rehashing, like dictRehash(). Returns 1
+ * if the rehashing is still in progress, otherwise 0. Can be called by any
+ * number of threads at the same time. */
+int cdictRehash(cdict *d, int n) {
+    int token, retval;
+
+    token = epochEnter(d->epoch);
+    retval = _cdictRehash(d, n);
+    epochExit(d->epoch, token);
+    epochReclaim(d->epoch, 0);
+    return retval;
+}
+
+/* ------------------------- private functions ------------------------------ */
+
+/* Start rehashing if the table reached the 1:1 ratio. Only a thread at a
+ * time performs the check, the others just go ahead. */
+static void _cdictExpandIfNeeded(cdict *d) {
+    cdictht *t0, *t1;
+    unsigned long used;
+
+    if (pthread_mutex_trylock(&d->resize_lock) != 0) return;
+    _cdictTables(d, &t0, &t1);
+    if (t1 == NULL && (used = cdictSize(d)) >= t0->size)
+        _cdictSetTables(d, t0, _cdictCreateTable(_cdictNextPower(used*2)));
+    pthread_mutex_unlock(&d->resize_lock);
+}
+
+/* Migrate N buckets (visiting at max N*10 empty buckets). Buckets are
+ * claimed by incrementing the rehashidx of the old table, so concurrent
+ * callers always work on different buckets. The thread migrating the last
+ * bucket switches the tables. Must be called inside a read side critical
+ * section. */
+static int _cdictRehash(cdict *d, int n) {
+    int empty_visits = n*10;
+    cdictht *t0, *t1;
+
+    _cdictTables(d, &t0, &t1);
+    if (t1 == NULL) return 0;
+
+    while (n > 0 && empty_visits > 0) {
+        cdictEntry *he, *nhe, *next, **bucket;
+        cdictStripe *s;
+        long idx, moved;
+
+        atomicGetIncr(t0->rehashidx, idx, 1);
+        if (idx >= (long)t0->size) return 1; /* Others are finishing. */
+
+        s = &d->stripes[idx & (CDICT_STRIPES-1)];
+        pthread_mutex_lock(&s->lock);
+        he = t0->table[idx];
+        if (he) n--; else empty_visits--;
+
+        /* Link a copy of every entry into the new table, and only then
+         * unlink the whole chain from the old one. */
+        for (; he; he = he->next) {
+            nhe = zmalloc(sizeof(*nhe));
+            nhe->key = he->key;
+            nhe->v = he->v;
+            bucket = &t1->table[dictHashKey(d, he->key) & t1->sizemask];
+            nhe->next = *bucket;
+            cdictStorePtr(*bucket, nhe);
+        }
+        he = t0->table[idx];
+        cdictStorePtr(t0->table[idx], NULL);
+        pthread_mutex_unlock(&s->lock);
+
+        for (; he; he = next) {
+            next = he->next;
+            epochRetire(d->epoch, &he->reclaim, _cdictFreeEntryShell);
+        }
+
+        atomicIncrGet(t0->moved, moved, 1);
+        if (moved == (long)t0->size) {
+            pthread_mutex_lock(&d->resize_lock);
+            _cdictSetTables(d, t1, NULL);
+            pthread_mutex_unlock(&d->resize_lock);
+            epochRetire(d->epoch, &t0->reclaim, _cdictFreeTable);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Our hash table capability is a power of two */
+static unsigned long _cdictNextPower(unsigned long size) {
+    unsigned long i = CDICT_HT_INITIAL_SIZE;
+
+    if (size >= LONG_MAX) return LONG_MAX + 1LU;
+    while(1) {
+        if (i >= size)
+            return i;
+        i *= 2;
+    }
+}
@@ -34,8 +34,13 @@
 #include <limits.h>
 #include <sys/time.h>
 #include <assert.h>
+#include <sched.h>
+#include <pthread.h>
 #include <dict.h>
+#include <compiler.h>
+#include <hashfunc.h>
 #include <zmalloc.h>
+#include <atomicvar.h>
 
 /* Using dictEnableResize() / dictDisableResize() we make possible to
  * enable/disable resizing of the hash table as needed. This is very important
@@ -46,14 +51,42 @@
  * prevented: a hash table is still allowed to grow if the ratio between
  * the number of elements and the buckets > dict_force_resize_ratio. */
 static int dict_can_resize = 1;
+static redisAtomic uint64_t _dictSampleSeq = 0; /* Seeds the generator of every dict */
 static unsigned int dict_force_resize_ratio = 5;
 
+/* State of the helper thread of a dict in background rehashing mode.
+ *
+ * The protocol is simple: the tables are accessed only with 'lock' held,
+ * both by the helper and by the public API functions, so the two sides
+ * never see a half migrated bucket. The helper holds the lock only for
+ * DICT_BG_REHASH_STEP buckets at a time, and after every step it waits
+ * for the foreground threads queued on the lock, so that an operation
+ * never waits for more than a single step. The lock is recursive since
+ * API functions call each other. */
+typedef struct dictBgRehash {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;       /* Signaled when there is work to do. */
+    redisAtomic long waiting;  /* Foreground threads waiting for the lock. */
+    int stop;
+} dictBgRehash;
+
+/* Buckets migrated by the helper thread every time it takes the lock. */
+#define DICT_BG_REHASH_STEP 64
+
+#define dictLock(d) do { if ((d)->bg) _dictBgLock((d)->bg); } while(0)
+#define dictUnlock(d) do { if ((d)->bg) pthread_mutex_unlock(&(d)->bg->lock); } while(0)
+
 /* -------------------------- private prototypes ---------------------------- */
 
 static int _dictExpandIfNeeded(dict *ht);
 static unsigned long _dictNextPower(unsigned long size);
 static long _dictKeyIndex(dict *ht, const void *key, uint64_t hash, dictEntry **existing);
+static dictEntry *_dictAddRaw(dict *d, void *key, uint64_t hash, dictEntry **existing);
 static int _dictInit(dict *ht, dictType *type, void *privDataPtr);
+static int _dictRehash(dict *d, int n);
+static void _dictBgLock(dictBgRehash *bg);
+static void _dictBgNotify(dict *d);
 
 /* -------------------------- hash functions -------------------------------- */
 
@@ -81,6 +114,20 @@ uint64_t dictGenCaseHashFunction(const unsigned char *buf, int len) {
     return siphash_nocase(buf,len,dict_hash_function_seed);
 }
 
+/* Faster hash function for trusted keys, see hashfunc.h. It is seeded
+ * with the same seed of dictGenHashFunction(), folded to 64 bits. */
+static uint64_t _dictHashSeed64(void) {
+    uint64_t a, b;
+
+    memcpy(&a, dict_hash_function_seed, 8);
+    memcpy(&b, dict_hash_function_seed+8, 8);
+    return a^b;
+}
+
+uint64_t dictGenWyHashFunction(const void *key, int len) {
+    return wyHash64(key, len, _dictHashSeed64());
+}
+
 /* ----------------------------- API implementation ------------------------- */
 
 /* Reset a hash table already initialized with ht_init().
@@ -108,23 +155,30 @@ int _dictInit(dict *d, dictType *type, void *privDataPtr) {
     d->privdata = privDataPtr;
     d->rehashidx = -1;
     d->iterators = 0;
+    d->bg = NULL;
+    /* Different dicts, even at the same address, get different samples. */
+    dictSetSampleSeed(d, (uintptr_t)d ^ ((uint64_t)atomicIncr(_dictSampleSeq, 1) << 32));
     return DICT_OK;
 }
 
 /* Resize the table to the minimal size that contains all the elements,
  * but with the invariant of a USED/BUCKETS ratio near to <= 1 */
 int dictResize(dict *d) {
-    int minimal;
-
-    if (!dict_can_resize || dictIsRehashing(d)) return DICT_ERR;
-    minimal = d->ht[0].used;
-    if (minimal < DICT_HT_INITIAL_SIZE)
-        minimal = DICT_HT_INITIAL_SIZE;
-    return dictExpand(d, minimal);
+    int minimal, retval = DICT_ERR;
+
+    dictLock(d);
+    if (dict_can_resize && !dictIsRehashing(d)) {
+        minimal = d->ht[0].used;
+        if (minimal < DICT_HT_INITIAL_SIZE)
+            minimal = DICT_HT_INITIAL_SIZE;
+        retval = dictExpand(d, minimal);
+    }
+    dictUnlock(d);
+    return retval;
 }
 
 /* Expand or create the hash table */
-int dictExpand(dict *d, unsigned long size) {
+static int _dictExpand(dict *d, unsigned long size) {
     /* the size is invalid if it is smaller than the number of
      * elements already inside the hash table */
     if (dictIsRehashing(d) || d->ht[0].used > size)
@@ -155,6 +209,16 @@ int dictExpand(dict *d, unsigned long size) {
     return DICT_OK;
 }
 
+int dictExpand(dict *d, unsigned long size) {
+    int retval;
+
+    dictLock(d);
+    retval = _dictExpand(d, size);
+    if (retval == DICT_OK && dictIsRehashing(d)) _dictBgNotify(d);
+    dictUnlock(d);
+    return retval;
+}
+
 /* Performs N steps of incremental rehashing. Returns 1 if there are still
  * keys to move from the old to the new hash table, otherwise 0 is returned.
  *
@@ -164,7 +228,7 @@ int dictExpand(dict *d, unsigned long size) {
  * guaranteed that this function will rehash even a single bucket, since it
  * will visit at max N*10 empty buckets in total, otherwise the amount of
  * work it does would be unbound and the function may block for a long time. */
-int dictRehash(dict *d, int n) {
+static int _dictRehash(dict *d, int n) {
     int empty_visits = n*10; /* Max number of empty buckets to visit. */
     if (!dictIsRehashing(d)) return 0;
 
@@ -209,6 +273,15 @@ int dictRehash(dict *d, int n) {
     return 1;
 }
 
+int dictRehash(dict *d, int n) {
+    int retval;
+
+    dictLock(d);
+    retval = _dictRehash(d, n);
+    dictUnlock(d);
+    return retval;
+}
+
 long long timeInMilliseconds(void) {
     struct timeval tv;
 
@@ -235,18 +308,21 @@ int dictRehashMilliseconds(dict *d, int ms) {
  *
  * This function is called by common lookup or update operations in the
  * dictionary so that the hash table automatically migrates from H1 to H2
- * while it is actively used. */
+ * while it is actively used. In background rehashing mode the helper
+ * thread does all the work instead. */
 static void _dictRehashStep(dict *d) {
-    if (d->iterators == 0) dictRehash(d, 1);
+    if (d->iterators == 0 && d->bg == NULL) _dictRehash(d, 1);
 }
 
 /* Add an element to the target hash table */
 int dictAdd(dict *d, void *key, void *val) {
-    dictEntry *entry = dictAddRaw(d, key, NULL);
+    dictEntry *entry;
 
-    if (!entry) return DICT_ERR;
-    dictSetVal(d, entry, val);
-    return DICT_OK;
+    dictLock(d);
+    entry = dictAddRaw(d, key, NULL);
+    if (entry) dictSetVal(d, entry, val);
+    dictUnlock(d);
+    return entry ? DICT_OK : DICT_ERR;
 }
 
 /* Low level add or find:
@@ -268,15 +344,26 @@ int dictAdd(dict *d, void *key, void *val) {
  * If key was added, the hash entry is returned to be manipulated by the caller.
  */
 dictEntry *dictAddRaw(dict *d, void *key, dictEntry **existing) {
-    long index;
     dictEntry *entry;
-    dictht *ht;
 
+    dictLock(d);
     if (dictIsRehashing(d)) _dictRehashStep(d);
+    entry = _dictAddRaw(d, key, dictHashKey(d, key), existing);
+    dictUnlock(d);
+    return entry;
+}
+
+/* Like dictAddRaw() but with the hash of the key already computed, and
+ * without performing a rehashing step. */
+static dictEntry *_dictAddRaw(dict *d, void *key, uint64_t hash, dictEntry **existing) {
+    size_t keylen;
+    long index;
+    dictEntry *entry;
+    dictht *ht;
 
     /* Get the index of the new element, or -1 if
      * the element already exists. */
-    if ((index = _dictKeyIndex(d, key, dictHashKey(d, key), existing)) == -1)
+    if ((index = _dictKeyIndex(d, key, hash, existing)) == -1)
         return NULL;
     
     /* Allocate the memory and store the new entry.
@@ -284,13 +371,20 @@ dictEntry *dictAddRaw(dict *d, void *key, dictEntry **existing) {
      * system it is more likely that recently added entries are accessed
      * more frequently. */
     ht = dictIsRehashing(d) ? &d->ht[1] : &d->ht[0];
-    entry = zmalloc(sizeof(*entry));
+    keylen = d->type->keyEmbedLen ? d->type->keyEmbedLen(key) : 0;
+    if (keylen && keylen <= DICT_EMBED_KEY_MAX) {
+        /* Short keys are copied right after the entry, so that a single
+         * allocation holds both. */
+        entry = zmalloc(sizeof(*entry)+keylen);
+        entry->key = entry+1;
+        memcpy(entry->key, key, keylen);
+    } else {
+        entry = zmalloc(sizeof(*entry));
+        dictSetKey(d, entry, key);
+    }
     entry->next = ht->table[index];
     ht->table[index] = entry;
     ht->used++;
-
-    /* Set the hash entry fields. */
-    dictSetKey(d, entry, key);
     return entry;
 }
 
@@ -304,9 +398,11 @@ int dictReplace(dict *d, void *key, void *val) {
 
     /* Try to add the element. If the key
      * does not exists dictAdd will succeed. */
+    dictLock(d);
     entry = dictAddRaw(d, key, &existing);
     if (entry) {
         dictSetVal(d, entry, val);
+        dictUnlock(d);
         return 1;
     }
 
@@ -317,6 +413,7 @@ int dictReplace(dict *d, void *key, void *val) {
      * reverse. */
     auxentry = *existing;
     dictSetVal(d, existing, val);
+    dictUnlock(d);
     dictFreeVal(d, &auxentry);
     return 0;
 }
@@ -377,7 +474,12 @@ static dictEntry *dictGenericDelete(dict *d, const void *key, int nofree) {
 /* Remove an element, returning DICT_OK on success or DICT_ERR if the
  * element was not found. */
 int dictDelete(dict *ht, const void *key) {
-    return dictGenericDelete(ht, key, 0) ? DICT_OK : DICT_ERR;
+    dictEntry *he;
+
+    dictLock(ht);
+    he = dictGenericDelete(ht, key, 0);
+    dictUnlock(ht);
+    return he ? DICT_OK : DICT_ERR;
 }
 
 /* Remove an element from the table, but without actually releasing
@@ -402,7 +504,12 @@ int dictDelete(dict *ht, const void *key) {
  * dictFreeUnlinkedEntry(entry); // <- This does not need to lookup again.
  */
 dictEntry *dictUnlink(dict *ht, const void *key) {
-    return dictGenericDelete(ht,key,1);
+    dictEntry *he;
+
+    dictLock(ht);
+    he = dictGenericDelete(ht,key,1);
+    dictUnlock(ht);
+    return he;
 }
 
 /* You need to call this function to really free the entry after a call
@@ -443,12 +550,13 @@ int _dictClear(dict *d, dictht *ht, void(callback)(void *)) {
 
 /* Clear & Release the hash table */
 void dictRelease(dict *d) {
+    dictDisableBackgroundRehash(d);
     _dictClear(d, &d->ht[0], NULL);
     _dictClear(d, &d->ht[1], NULL);
     zfree(d);
 }
 
-dictEntry *dictFind(dict *d, const void *key) {
+static dictEntry *_dictFind(dict *d, const void *key) {
     dictEntry *he;
     uint64_t h, idx, table;
 
@@ -468,6 +576,15 @@ dictEntry *dictFind(dict *d, const void *key) {
     return NULL;
 }
 
+dictEntry *dictFind(dict *d, const void *key) {
+    dictEntry *he;
+
+    dictLock(d);
+    he = _dictFind(d, key);
+    dictUnlock(d);
+    return he;
+}
+
 void *dictFetchValue(dict *d, const void *key) {
     dictEntry *he;
 
@@ -475,6 +592,135 @@ void *dictFetchValue(dict *d, const void *key) {
     return he ? dictGetVal(he) : NULL;
 }
 
+/* Number of keys dictFindMany() and dictAddMany() process at a time. */
+#define DICT_BATCH_SIZE 16
+
+/* Prefetch everything needed to lookup the keys with the given hashes:
+ * first the buckets, then the first entry of every chain and, if keys are
+ * compared by content, the key of that entry. Every stage issues all its
+ * prefetches before the next stage touches the memory of the previous one,
+ * so the cache misses of the different keys overlap instead of being paid
+ * one after the other. */
+static void _dictPrefetchBatch(dict *d, const uint64_t *hashes, int count) {
+    dictEntry *he;
+    int table, j;
+
+    for (table = 0; table <= 1; table++) {
+        dictht *ht = &d->ht[table];
+
+        if (ht->size == 0) continue;
+        for (j = 0; j < count; j++)
+            prefetch(&ht->table[hashes[j] & ht->sizemask]);
+    }
+    for (table = 0; table <= 1; table++) {
+        dictht *ht = &d->ht[table];
+
+        if (ht->size == 0) continue;
+        for (j = 0; j < count; j++)
+            if ((he = ht->table[hashes[j] & ht->sizemask]) != NULL)
+                prefetch(he);
+    }
+    if (d->type->keyCompare == NULL) return;
+    for (table = 0; table <= 1; table++) {
+        dictht *ht = &d->ht[table];
+
+        if (ht->size == 0) continue;
+        for (j = 0; j < count; j++)
+            if ((he = ht->table[hashes[j] & ht->sizemask]) != NULL)
+                prefetch(he->key);
+    }
+}
+
+/* Lookup 'count' keys at once. The entry of keys[j] is stored in
+ * entries[j], or NULL if the key is not found. Returns the number of keys
+ * found.
+ *
+ * This is equivalent to calling dictFind() for every key, but the keys are
+ * hashed and their buckets prefetched in batches of DICT_BATCH_SIZE before
+ * being searched, hiding most of the memory latency when the table doesn't
+ * fit in the CPU cache. */
+unsigned long dictFindMany(dict *d, const void **keys, unsigned long count, dictEntry **entries) {
+    uint64_t hashes[DICT_BATCH_SIZE];
+    unsigned long found = 0, i, j;
+    int batch, table;
+    dictEntry *he;
+
+    dictLock(d);
+    for (i = 0; i < count; i += batch) {
+        batch = count-i < DICT_BATCH_SIZE ? count-i : DICT_BATCH_SIZE;
+
+        if (d->ht[0].used+d->ht[1].used == 0) {
+            for (j = i; j < count; j++) entries[j] = NULL;
+            break;
+        }
+        /* Perform the rehashing steps dictFind() would have performed
+         * before prefetching: the tables must not change until the batch
+         * is searched. */
+        for (j = 0; j < (unsigned long)batch && dictIsRehashing(d); j++)
+            _dictRehashStep(d);
+
+        for (j = 0; j < (unsigned long)batch; j++)
+            hashes[j] = dictHashKey(d, keys[i+j]);
+        _dictPrefetchBatch(d, hashes, batch);
+
+        for (j = 0; j < (unsigned long)batch; j++) {
+            const void *key = keys[i+j];
+
+            he = NULL;
+            for (table = 0; table <= 1; table++) {
+                if (d->ht[table].size == 0) continue;
+                he = d->ht[table].table[hashes[j] & d->ht[table].sizemask];
+                while (he) {
+                    if (key == he->key || dictCompareKeys(d, key, he->key))
+                        break;
+                    he = he->next;
+                }
+                if (he || !dictIsRehashing(d)) break;
+            }
+            entries[i+j] = he;
+            if (he) found++;
+        }
+    }
+    dictUnlock(d);
+    return found;
+}
+
+/* Add 'count' elements at once, keys[j] with value vals[j]. Keys that
+ * already exist are skipped, like dictAdd() would. Returns the number of
+ * elements added.
+ *
+ * Keys are processed in batches like in dictFindMany(), so that the
+ * search for existing keys doesn't stall on every bucket. */
+unsigned long dictAddMany(dict *d, void **keys, void **vals, unsigned long count) {
+    uint64_t hashes[DICT_BATCH_SIZE];
+    unsigned long added = 0, i, j;
+    dictEntry *entry;
+    int batch;
+
+    dictLock(d);
+    for (i = 0; i < count; i += batch) {
+        batch = count-i < DICT_BATCH_SIZE ? count-i : DICT_BATCH_SIZE;
+
+        for (j = 0; j < (unsigned long)batch && dictIsRehashing(d); j++)
+            _dictRehashStep(d);
+
+        for (j = 0; j < (unsigned long)batch; j++)
+            hashes[j] = dictHashKey(d, keys[i+j]);
+        _dictPrefetchBatch(d, hashes, batch);
+
+        /* Inserting may start a rehashing, in that case the prefetched
+         * buckets of the rest of the batch are just wasted. */
+        for (j = 0; j < (unsigned long)batch; j++) {
+            entry = _dictAddRaw(d, keys[i+j], hashes[j], NULL);
+            if (entry == NULL) continue;
+            dictSetVal(d, entry, vals[i+j]);
+            added++;
+        }
+    }
+    dictUnlock(d);
+    return added;
+}
+
 /* A fingerprint is a 64 bit number that represents the state of the dictionary
  * at a given time, it's just a few dict properties xored together.
  * When an unsafe iterator is initialized, we get the dict fingerprint, and check
@@ -482,7 +728,7 @@ void *dictFetchValue(dict *d, const void *key) {
  * If the two fingerprints are different it means that the user of the iterator
  * performed forbidden operations against the dictionary while iterating. */
 long long dictFingerprint(dict *d) {
-    long long integers[6], hash = 0;
+    unsigned long long integers[6], hash = 0;
     int j;
 
     integers[0] = (long) d->ht[0].table;
@@ -520,6 +766,7 @@ dictIterator *dictGetIterator(dict *d) {
     iter->table = 0;
     iter->index = -1;
     iter->safe = 0;
+    iter->paused = 0;
     iter->entry = NULL;
     iter->nextEntry = NULL;
     return iter;
@@ -532,7 +779,7 @@ dictIterator *dictGetSafeIterator(dict *d) {
     return i;
 }
 
-dictEntry *dictNext(dictIterator *iter) {
+static dictEntry *_dictNext(dictIterator *iter) {
     while (1) {
         if (iter->entry == NULL) {
             dictht *ht = &iter->d->ht[iter->table];
@@ -541,6 +788,12 @@ dictEntry *dictNext(dictIterator *iter) {
                     iter->d->iterators++;
                 else
                     iter->fingerprint = dictFingerprint(iter->d);
+                /* The helper thread would change the tables under the
+                 * feet of unsafe iterators too. */
+                if (!iter->safe && iter->d->bg) {
+                    iter->d->iterators++;
+                    iter->paused = 1;
+                }
             }
             iter->index++;
             if (iter->index >= (long)ht->size) {
@@ -566,19 +819,34 @@ dictEntry *dictNext(dictIterator *iter) {
     return NULL;
 }
 
+dictEntry *dictNext(dictIterator *iter) {
+    dictEntry *he;
+
+    dictLock(iter->d);
+    he = _dictNext(iter);
+    dictUnlock(iter->d);
+    return he;
+}
+
 void dictReleaseIterator(dictIterator *iter) {
+    dict *d = iter->d;
+
+    dictLock(d);
     if (!(iter->index == -1 && iter->table == 0)) {
         if (iter->safe)
-            iter->d->iterators--;
+            d->iterators--;
         else
-            assert(iter->fingerprint == dictFingerprint(iter->d));
+            assert(iter->fingerprint == dictFingerprint(d));
+        if (iter->paused) d->iterators--;
+        if (d->iterators == 0) _dictBgNotify(d);
     }
+    dictUnlock(d);
     zfree(iter);
 }
 
 /* Return a random entry from the hash table. Useful to
  * implement randomized algorithms */
-dictEntry *dictGetRandomKey(dict *d)
+static dictEntry *_dictGetRandomKey(dict *d)
 {
     dictEntry *he, *orighe;
     unsigned long h;
@@ -641,7 +909,16 @@ dictEntry *dictGetRandomKey(dict *d)
  * of continuous elements to run some kind of algorithm or to produce
  * statistics. However the function is much faster than dictGetRandomKey()
  * at producing N elements. */
-unsigned int dictGetSomeKeys(dict *d, dictEntry **des, unsigned int count) {
+dictEntry *dictGetRandomKey(dict *d) {
+    dictEntry *he;
+
+    dictLock(d);
+    he = _dictGetRandomKey(d);
+    dictUnlock(d);
+    return he;
+}
+
+static unsigned int _dictGetSomeKeys(dict *d, dictEntry **des, unsigned int count) {
     unsigned long j; /* internal hash table id, 0 or 1. */
     unsigned long tables; /* 1 or 2 tables? */
     unsigned long stored = 0, maxsizemask;
@@ -710,6 +987,184 @@ unsigned int dictGetSomeKeys(dict *d, dictEntry **des, unsigned int count) {
     return stored;
 }
 
+unsigned int dictGetSomeKeys(dict *d, dictEntry **des, unsigned int count) {
+    unsigned int stored;
+
+    dictLock(d);
+    stored = _dictGetSomeKeys(d, des, count);
+    dictUnlock(d);
+    return stored;
+}
+
+/* ------------------------------- Sampling -------------------------------- */
+
+/* Scores kept on the stack by dictSampleBestKeys() when not requested. */
+#define DICT_SAMPLE_STACK_SCORES 64
+/* Steps between the prefetch of a bucket and its visit. */
+#define DICT_SAMPLE_PREFETCH 4
+
+/* xorshift64* generator, with the state stored in the dict. */
+static inline uint64_t _dictRandom(dict *d) {
+    uint64_t x = d->rngstate;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    d->rngstate = x;
+    return x * 0x2545f4914f6cdd1dULL;
+}
+
+/* Seed the generator used by dictSampleKeys() and dictSampleBestKeys(), to
+ * get the same samples from the same dict content. */
+void dictSetSampleSeed(dict *d, uint64_t seed) {
+    /* splitmix64 of the seed, as xorshift needs a non zero state. */
+    seed += 0x9e3779b97f4a7c15ULL;
+    seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebULL;
+    seed ^= seed >> 31;
+    dictLock(d);
+    d->rngstate = seed ? seed : 1;
+    dictUnlock(d);
+}
+
+typedef void (_dictSampleVisitFunction)(void *ctx, unsigned long seen, dictEntry *de);
+
+/* Visit every entry of the buckets found moving from a random bucket by a
+ * random odd stride, until at least 'wanted' entries are visited. Buckets
+ * are visited whole, and as the stride is odd, none is visited twice.
+ *
+ * The walk is over the larger table: buckets of the smaller one are visited
+ * only for indexes in its range, so every bucket of both tables has the
+ * same probability to be visited. Return the number of entries visited. */
+static unsigned long _dictSampleWalk(dict *d, unsigned long wanted,
+                                     _dictSampleVisitFunction *visit, void *ctx)
+{
+    unsigned long i, j, stride, mask, maxsteps, seen = 0;
+    unsigned long tables = dictIsRehashing(d) ? 2 : 1;
+    dictEntry *he;
+
+    mask = d->ht[0].sizemask;
+    if (tables > 1 && mask < d->ht[1].sizemask) mask = d->ht[1].sizemask;
+    if (d->ht[0].used+d->ht[1].used == 0) return 0;
+
+    maxsteps = wanted*DICT_SAMPLE_MAXSTEPS;
+    if (maxsteps > mask+1) maxsteps = mask+1;
+    i = _dictRandom(d) & mask;
+    stride = (_dictRandom(d) & mask) | 1;
+    while (seen < wanted && maxsteps--) {
+        /* Buckets are far apart: prefetch the slots some steps ahead and
+         * the entries of the slots prefetched before. */
+        for (j = 0; j < tables; j++) {
+            unsigned long slot = (i+stride*DICT_SAMPLE_PREFETCH*2) & mask;
+            unsigned long entry = (i+stride*DICT_SAMPLE_PREFETCH) & mask;
+
+            if (slot < d->ht[j].size) prefetch(&d->ht[j].table[slot]);
+            if (entry < d->ht[j].size && d->ht[j].table[entry])
+                prefetch(d->ht[j].table[entry]);
+        }
+        for (j = 0; j < tables; j++) {
+            /* No populated buckets in ht[0] before the rehashing index. */
+            if (tables == 2 && j == 0 && i < (unsigned long) d->rehashidx)
+                continue;
+            if (i >= d->ht[j].size) continue;
+            for (he = d->ht[j].table[i]; he; he = he->next)
+                visit(ctx, seen++, he);
+        }
+        i = (i+stride) & mask;
+    }
+    return seen;
+}
+
+typedef struct dictSampleReservoir {
+    dict *d;
+    dictEntry **des;
+    unsigned long count;
+} dictSampleReservoir;
+
+static void _dictSampleReservoirVisit(void *ctx, unsigned long seen, dictEntry *de) {
+    dictSampleReservoir *r = ctx;
+
+    if (seen < r->count) {
+        r->des[seen] = de;
+    } else {
+        unsigned long k = _dictRandom(r->d) % (seen+1);
+        if (k < r->count) r->des[k] = de;
+    }
+}
+
+/* Store in 'des' up to 'count' distinct entries sampled uniformly, with
+ * reservoir sampling, among about count*DICT_SAMPLE_WINDOW entries visited
+ * in one pass, see _dictSampleWalk(). Unlike dictGetSomeKeys(), entries in
+ * long chains are as likely to be returned as the others, and the random
+ * numbers come from a generator of the dict instead of random().
+ *
+ * Return the number of entries stored, that is less than 'count' only if
+ * not enough entries were found in a reasonable number of steps. */
+unsigned int dictSampleKeys(dict *d, dictEntry **des, unsigned int count) {
+    dictSampleReservoir r = {d, des, count};
+    unsigned long seen;
+
+    if (count == 0) return 0;
+    dictLock(d);
+    seen = _dictSampleWalk(d, (unsigned long)count*DICT_SAMPLE_WINDOW,
+                           _dictSampleReservoirVisit, &r);
+    dictUnlock(d);
+    return seen < count ? seen : count;
+}
+
+typedef struct dictSampleBest {
+    dictEntry **des;
+    double *scores;
+    unsigned long count;
+    unsigned long stored;
+    dictSampleScoreFunction *score;
+    void *privdata;
+} dictSampleBest;
+
+static void _dictSampleBestVisit(void *ctx, unsigned long seen, dictEntry *de) {
+    dictSampleBest *b = ctx;
+    double score = b->score(b->privdata, de);
+    unsigned long k;
+
+    DICT_NOTUSED(seen);
+    if (b->stored == b->count && score <= b->scores[b->count-1]) return;
+
+    /* Insertion in the array sorted by decreasing score, dropping the
+     * last entry if full. */
+    k = b->stored < b->count ? b->stored++ : b->count-1;
+    while (k > 0 && b->scores[k-1] < score) {
+        b->des[k] = b->des[k-1];
+        b->scores[k] = b->scores[k-1];
+        k--;
+    }
+    b->des[k] = de;
+    b->scores[k] = score;
+}
+
+/* Visit about 'samples' entries in one pass like dictSampleKeys(), calling
+ * 'score' for every one of them, and store in 'des' the 'count' entries
+ * with the highest score, sorted by decreasing score. If 'scores' is not
+ * NULL the scores are stored there too. This is what approximated LRU or
+ * LFU eviction needs: the best candidates among a sample of the keys.
+ *
+ * Return the number of entries stored. */
+unsigned int dictSampleBestKeys(dict *d, dictEntry **des, double *scores,
+                                unsigned int count, unsigned int samples,
+                                dictSampleScoreFunction *score, void *privdata)
+{
+    double buf[DICT_SAMPLE_STACK_SCORES];
+    dictSampleBest b = {des, scores, count, 0, score, privdata};
+
+    if (count == 0) return 0;
+    if (scores == NULL)
+        b.scores = count <= DICT_SAMPLE_STACK_SCORES ? buf : zmalloc(sizeof(double)*count);
+    dictLock(d);
+    _dictSampleWalk(d, samples < count ? count : samples, _dictSampleBestVisit, &b);
+    dictUnlock(d);
+    if (b.scores != buf && b.scores != scores) zfree(b.scores);
+    return b.stored;
+}
+
 /* Function to reverse bits. Algorithm from:
  * http://graphics.stanford.edu/~seander/bithacks.html#ReverseParallel */
 static unsigned long rev(unsigned long v) {
@@ -806,11 +1261,11 @@ static unsigned long rev(unsigned long v) {
  * 3) The reverse cursor is somewhat hard to understand at first, but this
  *    comment is supposed to help.
  */
-unsigned long dictScan(dict *d,
-                       unsigned long v,
-                       dictScanFunction *fn,
-                       dictScanBucketFunction* bucketfn,
-                       void *privdata)
+static unsigned long _dictScan(dict *d,
+                               unsigned long v,
+                               dictScanFunction *fn,
+                               dictScanBucketFunction* bucketfn,
+                               void *privdata)
 {
     dictht *t0, *t1;
     const dictEntry *de, *next;
@@ -887,8 +1342,185 @@ unsigned long dictScan(dict *d,
     return v;
 }
 
+unsigned long dictScan(dict *d,
+                       unsigned long v,
+                       dictScanFunction *fn,
+                       dictScanBucketFunction* bucketfn,
+                       void *privdata)
+{
+    dictLock(d);
+    v = _dictScan(d, v, fn, bucketfn, privdata);
+    dictUnlock(d);
+    return v;
+}
+
+/* Like dictScan(), but only visits the cursors of the partition 'part' of
+ * 'nparts', that must be a power of two. Partitions are disjoint and
+ * together cover the whole cursor space, so they can be scanned at the
+ * same time by different threads, as long as the dict is not modified,
+ * with the same guarantees of dictScan() for every partition: starting
+ * with a cursor of 0 until 0 is returned, all the elements present in the
+ * dictionary between the start and the end of the iteration are returned
+ * by the partition they hash to.
+ *
+ * The partition of a cursor is stored in its lower bits, that are the most
+ * significant ones of the reversed cursor, so a partition is a contiguous
+ * range of the reversed cursor space, whatever the size of the tables.
+ * If the smaller table has less than 'nparts' buckets, a bucket belongs to
+ * more than one partition and its elements are returned more than once. */
+unsigned long dictScanPartition(dict *d,
+                                unsigned long v,
+                                unsigned long part,
+                                unsigned long nparts,
+                                dictScanFunction *fn,
+                                dictScanBucketFunction* bucketfn,
+                                void *privdata)
+{
+    unsigned long mask = nparts-1;
+
+    assert(nparts && (nparts & mask) == 0 && part < nparts);
+    v = (v & ~mask) | part;
+    dictLock(d);
+    v = _dictScan(d, v, fn, bucketfn, privdata);
+    dictUnlock(d);
+
+    /* The lower bits only change when the reversed cursor moves past the
+     * end of the partition. */
+    if ((v & mask) != part) return 0;
+    return v & ~mask;
+}
+
+/* ------------------------- background rehashing -------------------------- */
+
+/* Main loop of the helper thread: migrate DICT_BG_REHASH_STEP buckets at a
+ * time while a rehashing is in progress and no iterator is active,
+ * otherwise sleep until _dictBgNotify() is called. */
+static void *_dictBgRehashMain(void *privdata) {
+    dict *d = privdata;
+    dictBgRehash *bg = d->bg;
+    long waiting;
+
+    pthread_mutex_lock(&bg->lock);
+    while (!bg->stop) {
+        if (!dictIsRehashing(d) || d->iterators) {
+            pthread_cond_wait(&bg->cond, &bg->lock);
+            continue;
+        }
+        _dictRehash(d, DICT_BG_REHASH_STEP);
+
+        /* Give way to the foreground: mutexes are not fair, and without
+         * waiting here we could take the lock again before a thread
+         * that was queued on it wakes up. */
+        pthread_mutex_unlock(&bg->lock);
+        while (1) {
+            atomicGet(bg->waiting, waiting);
+            if (waiting == 0) break;
+            sched_yield();
+        }
+        pthread_mutex_lock(&bg->lock);
+    }
+    pthread_mutex_unlock(&bg->lock);
+    return NULL;
+}
+
+/* Start a helper thread that performs the rehashing of 'd' in background,
+ * so that foreground operations no longer pay for rehashing steps, and
+ * the old table is dropped as soon as possible.
+ *
+ * In this mode the API functions serialize with the helper thread on a
+ * mutex, see dictBgRehash for the details. The dict itself is still not
+ * thread safe: it must be used by a single thread at a time, like in the
+ * default mode. Entries returned by the API stay valid while the helper
+ * moves them, since rehashing only relinks them. dictIsRehashing() and
+ * dictSlots() read the dict without the lock, so their result is only a
+ * hint: use dictRehashProgress() instead.
+ *
+ * Returns DICT_ERR if the mode is already enabled or the thread can't be
+ * created, otherwise DICT_OK. */
+int dictEnableBackgroundRehash(dict *d) {
+    dictBgRehash *bg;
+    pthread_mutexattr_t attr;
+
+    if (d->bg) return DICT_ERR;
+    bg = zmalloc(sizeof(*bg));
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&bg->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    pthread_cond_init(&bg->cond, NULL);
+    bg->waiting = 0;
+    bg->stop = 0;
+
+    d->bg = bg;
+    if (pthread_create(&bg->thread, NULL, _dictBgRehashMain, d) != 0) {
+        d->bg = NULL;
+        pthread_cond_destroy(&bg->cond);
+        pthread_mutex_destroy(&bg->lock);
+        zfree(bg);
+        return DICT_ERR;
+    }
+    return DICT_OK;
+}
+
+/* Stop the helper thread, waiting for it to exit. A rehashing in progress
+ * is continued incrementally by the foreground operations. */
+void dictDisableBackgroundRehash(dict *d) {
+    dictBgRehash *bg = d->bg;
+
+    if (bg == NULL) return;
+    pthread_mutex_lock(&bg->lock);
+    bg->stop = 1;
+    pthread_cond_signal(&bg->cond);
+    pthread_mutex_unlock(&bg->lock);
+    pthread_join(bg->thread, NULL);
+
+    d->bg = NULL;
+    pthread_cond_destroy(&bg->cond);
+    pthread_mutex_destroy(&bg->lock);
+    zfree(bg);
+}
+
+/* Report the progress of the rehashing: '*moved' is set to the number of
+ * buckets of the old table already migrated, and '*total' to the number
+ * of buckets of the old table. Returns 1 if a rehashing is in progress,
+ * otherwise 0 and both are set to 0. */
+int dictRehashProgress(dict *d, unsigned long *moved, unsigned long *total) {
+    int rehashing;
+
+    dictLock(d);
+    rehashing = dictIsRehashing(d);
+    *moved = rehashing ? (unsigned long)d->rehashidx : 0;
+    *total = rehashing ? d->ht[0].size : 0;
+    dictUnlock(d);
+    return rehashing;
+}
+
+/* Number of elements, for dictSize() in background rehashing mode, where
+ * the helper thread may be moving elements from ht[0] to ht[1]. */
+unsigned long dictLockedSize(dict *d) {
+    unsigned long size;
+
+    dictLock(d);
+    size = d->ht[0].used+d->ht[1].used;
+    dictUnlock(d);
+    return size;
+}
+
 /* ------------------------- private functions ------------------------------ */
 
+/* Take the lock of the helper thread. */
+static void _dictBgLock(dictBgRehash *bg) {
+    atomicIncr(bg->waiting, 1);
+    pthread_mutex_lock(&bg->lock);
+    atomicDecr(bg->waiting, 1);
+}
+
+/* Wake up the helper thread, if any, since there may be work to do.
+ * Must be called with the lock held. */
+static void _dictBgNotify(dict *d) {
+    if (d->bg) pthread_cond_signal(&d->bg->cond);
+}
+
 /* Expand the hash table if needed */
 static int _dictExpandIfNeeded(dict *d)
 {
@@ -957,10 +1589,12 @@ static long _dictKeyIndex(dict *d, const void *key, uint64_t hash, dictEntry **e
 }
 
 void dictEmpty(dict *d, void(callback)(void*)) {
+    dictLock(d);
     _dictClear(d,&d->ht[0],callback);
     _dictClear(d,&d->ht[1],callback);
     d->rehashidx = -1;
     d->iterators = 0;
+    dictUnlock(d);
 }
 
 void dictEnableResize(void) {
@@ -980,7 +1614,7 @@ uint64_t dictGetHash(dict *d, const void *key) {
  * the hash value should be provided using dictGetHash.
  * no string / key comparison is performed.
  * return value is the reference to the dictEntry if found, or NULL if not found. */
-dictEntry **dictFindEntryRefByPtrAndHash(dict *d, const void *oldptr, uint64_t hash) {
+static dictEntry **_dictFindEntryRefByPtrAndHash(dict *d, const void *oldptr, uint64_t hash) {
     dictEntry *he, **heref;
     unsigned long idx, table;
 
@@ -1000,13 +1634,100 @@ dictEntry **dictFindEntryRefByPtrAndHash(dict *d, const void *oldptr, uint64_t h
     return NULL;
 }
 
+/* The returned reference points into a table or into another entry, that
+ * a background rehashing thread could move or free as soon as the lock is
+ * released: with background rehashing use dictReplaceKeyPtr() instead. */
+dictEntry **dictFindEntryRefByPtrAndHash(dict *d, const void *oldptr, uint64_t hash) {
+    assert(d->bg == NULL);
+    return _dictFindEntryRefByPtrAndHash(d, oldptr, hash);
+}
+
+/* Replace the key pointer 'oldptr' of an entry with 'newptr', for instance
+ * after the key was moved in memory, looking the entry up as in
+ * dictFindEntryRefByPtrAndHash(). The lookup and the update are performed
+ * under the lock, so this is safe with background rehashing. Returns
+ * DICT_OK if the entry was found, DICT_ERR otherwise. */
+int dictReplaceKeyPtr(dict *d, const void *oldptr, void *newptr, uint64_t hash) {
+    dictEntry **heref;
+
+    dictLock(d);
+    heref = _dictFindEntryRefByPtrAndHash(d, oldptr, hash);
+    if (heref) (*heref)->key = newptr;
+    dictUnlock(d);
+    return heref ? DICT_OK : DICT_ERR;
+}
+
 /* ------------------------------- Debugging ---------------------------------*/
 
-#define DICT_STATS_VECTLEN 50
+/* Collect the stats of a single table. The bucket walk, the expensive
+ * part, is performed only if DICT_STATS_CHAINS or DICT_STATS_MEMORY are
+ * requested. */
+static void _dictCollectStatsHt(dictht *ht, dictHtStats *stats, int flags) {
+    unsigned long i, chainlen;
+    dictEntry *he;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->size = ht->size;
+    stats->used = ht->used;
+    if (ht->table) stats->table_bytes = zmalloc_size(ht->table);
+    stats->entry_bytes = ht->used*sizeof(dictEntry);
+    if (!(flags & (DICT_STATS_CHAINS|DICT_STATS_MEMORY))) return;
+
+    stats->entry_bytes = 0;
+    for (i = 0; i < ht->size; i++) {
+        chainlen = 0;
+        for (he = ht->table[i]; he; he = he->next) {
+            chainlen++;
+            if (!(flags & DICT_STATS_MEMORY)) continue;
+            /* Embedded keys are accounted with their entry. */
+            stats->entry_bytes += zmalloc_size(he);
+            if (flags & DICT_STATS_KEYS && he->key &&
+                !dictEntryKeyIsEmbedded(he))
+                stats->key_bytes += zmalloc_size(he->key);
+        }
+        if (!(flags & DICT_STATS_MEMORY))
+            stats->entry_bytes += chainlen*sizeof(dictEntry);
+        if (chainlen) stats->buckets++;
+        if (chainlen > stats->max_chain) stats->max_chain = chainlen;
+        stats->chains[chainlen < DICT_STATS_VECTLEN ? chainlen : DICT_STATS_VECTLEN-1]++;
+    }
+}
+
+/* Fill 'stats' with the state of the dictionary, that is cheap enough to
+ * be sampled often: by default it only costs a few zmalloc_size() calls.
+ * 'flags' select the additional, O(N), information to collect:
+ *
+ * DICT_STATS_CHAINS: number of non empty buckets and chain lengths.
+ * DICT_STATS_MEMORY: exact size of the entries as reported by the
+ *                    allocator, instead of an estimate based on the number
+ *                    of elements.
+ * DICT_STATS_KEYS:   with DICT_STATS_MEMORY, also the size of the keys not
+ *                    embedded in the entries. Keys must have been allocated
+ *                    with zmalloc(), like for dictTypeHeapStringCopyKey. */
+void dictCollectStats(dict *d, dictStats *stats, int flags) {
+    int j;
+
+    dictLock(d);
+    stats->flags = flags;
+    stats->rehashing = dictIsRehashing(d);
+    stats->rehash_moved = stats->rehashing ? (unsigned long)d->rehashidx : 0;
+    stats->rehash_total = stats->rehashing ? d->ht[0].size : 0;
+    stats->iterators = d->iterators;
+    stats->dict_bytes = zmalloc_size(d);
+    if (d->bg) stats->dict_bytes += zmalloc_size(d->bg);
+    stats->total_bytes = stats->dict_bytes;
+    for (j = 0; j <= 1; j++) {
+        _dictCollectStatsHt(&d->ht[j], &stats->ht[j], flags);
+        stats->total_bytes += stats->ht[j].table_bytes+
+                              stats->ht[j].entry_bytes+
+                              stats->ht[j].key_bytes;
+    }
+    dictUnlock(d);
+}
+
 size_t _dictGetStatsHt(char *buf, size_t bufsize, dictht *ht, int tableid) {
-    unsigned long i, slots = 0, chainlen, maxchainlen = 0;
-    unsigned long totchainlen = 0;
-    unsigned long clvector[DICT_STATS_VECTLEN];
+    dictHtStats stats;
+    unsigned long i;
     size_t l = 0;
 
     if (ht->used == 0) {
@@ -1015,26 +1736,7 @@ size_t _dictGetStatsHt(char *buf, size_t bufsize, dictht *ht, int tableid) {
     }
 
     /* Compute stats. */
-    for (i = 0; i < DICT_STATS_VECTLEN; i++) clvector[i] = 0;
-    for (i = 0; i < ht->size; i++) {
-        dictEntry *he;
-
-        if (ht->table[i] == NULL) {
-            clvector[0]++;
-            continue;
-        }
-        slots++;
-        /* For each hash entry on this slot... */
-        chainlen = 0;
-        he = ht->table[i];
-        while(he) {
-            chainlen++;
-            he = he->next;
-        }
-        clvector[(chainlen < DICT_STATS_VECTLEN) ? chainlen : (DICT_STATS_VECTLEN-1)]++;
-        if (chainlen > maxchainlen) maxchainlen = chainlen;
-        totchainlen += chainlen;
-    }
+    _dictCollectStatsHt(ht, &stats, DICT_STATS_CHAINS);
 
     /* Generate human readable stats. */
     l += snprintf(buf+l,bufsize-l,
@@ -1047,16 +1749,16 @@ size_t _dictGetStatsHt(char *buf, size_t bufsize, dictht *ht, int tableid) {
         " avg chain length (computed): %.02f\n"
         " Chain length distribution:\n",
         tableid, (tableid == 0) ? "main hash table" : "rehashing target",
-        ht->size, ht->used, slots, maxchainlen,
-        (float)totchainlen/slots, (float)ht->used/slots);
+        stats.size, stats.used, stats.buckets, stats.max_chain,
+        (float)stats.used/stats.buckets, (float)stats.used/stats.buckets);
 
     for (i = 0; i < DICT_STATS_VECTLEN-1; i++) {
-        if (clvector[i] == 0) continue;
+        if (stats.chains[i] == 0) continue;
         if (l >= bufsize) break;
         l += snprintf(buf+l,bufsize-l,
             "   %s%ld: %ld (%.02f%%)\n",
             (i == DICT_STATS_VECTLEN-1)?">= ":"",
-            i, clvector[i], ((float)clvector[i]/ht->size)*100);
+            i, stats.chains[i], ((float)stats.chains[i]/stats.size)*100);
     }
 
     /* Unlike snprintf(), teturn the number of characters actually written. */
@@ -1069,12 +1771,131 @@ void dictGetStats(char *buf, size_t bufsize, dict *d) {
     char *orig_buf = buf;
     size_t orig_bufsize = bufsize;
 
+    dictLock(d);
     l = _dictGetStatsHt(buf,bufsize,&d->ht[0],0);
     buf += l;
     bufsize -= l;
     if (dictIsRehashing(d) && bufsize > 0) {
         _dictGetStatsHt(buf,bufsize,&d->ht[1],1);
     }
+    dictUnlock(d);
     /* Make sure there is a NULL term at the end. */
     if (orig_bufsize) orig_buf[orig_bufsize-1] = '\0';
-}
\ No newline at end of file
+}
+
+/* ------------------------------- Hash table types ------------------------- */
+
+static uint64_t _dictStringCopyHTHashFunction(const void *key) {
+    return dictGenHashFunction(key, strlen(key));
+}
+
+static void *_dictStringDup(void *privdata, const void *key) {
+    size_t len = strlen(key);
+    char *copy = zmalloc(len+1);
+    DICT_NOTUSED(privdata);
+
+    memcpy(copy, key, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+static int _dictStringCopyHTKeyCompare(void *privdata, const void *key1,
+        const void *key2)
+{
+    DICT_NOTUSED(privdata);
+
+    return strcmp(key1, key2) == 0;
+}
+
+static void _dictStringDestructor(void *privdata, void *key) {
+    DICT_NOTUSED(privdata);
+
+    zfree(key);
+}
+
+/* Copied keys are owned by the dict, so short ones can live in the entry. */
+static size_t _dictStringEmbedLen(const void *key) {
+    return strlen(key)+1;
+}
+
+dictType dictTypeHeapStringCopyKey = {
+    _dictStringCopyHTHashFunction, /* hash function */
+    _dictStringDup,                /* key dup */
+    NULL,                          /* val dup */
+    _dictStringCopyHTKeyCompare,   /* key compare */
+    _dictStringDestructor,         /* key destructor */
+    NULL,                          /* val destructor */
+    _dictStringEmbedLen            /* key embed len */
+};
+
+/* This is like StringCopy but does not auto-duplicate the key: the
+ * caller hands heap allocated keys over to the dict. */
+dictType dictTypeHeapStrings = {
+    _dictStringCopyHTHashFunction, /* hash function */
+    NULL,                          /* key dup */
+    NULL,                          /* val dup */
+    _dictStringCopyHTKeyCompare,   /* key compare */
+    _dictStringDestructor,         /* key destructor */
+    NULL,                          /* val destructor */
+    NULL                           /* key embed len */
+};
+
+/* This is like StringCopy but also automatically handle dynamic
+ * allocated C strings as values. */
+dictType dictTypeHeapStringCopyKeyValue = {
+    _dictStringCopyHTHashFunction, /* hash function */
+    _dictStringDup,                /* key dup */
+    _dictStringDup,                /* val dup */
+    _dictStringCopyHTKeyCompare,   /* key compare */
+    _dictStringDestructor,         /* key destructor */
+    _dictStringDestructor,         /* val destructor */
+    _dictStringEmbedLen            /* key embed len */
+};
+
+/* The same as dictTypeHeapStringCopyKey with the faster hash functions.
+ * The unseeded variants always return the same hash for the same key,
+ * saving the seed load and making the layout of the table reproducible
+ * across runs: use them only when keys can't be chosen by an attacker.
+ * There is no seeded crc32c variant, as its collisions don't depend on the
+ * seed: dictTypeStringCopyKeyCrc32c is for trusted keys only. */
+static uint64_t _dictStringWyHash(const void *key) {
+    return dictGenWyHashFunction(key, strlen(key));
+}
+
+static uint64_t _dictStringWyHashUnseeded(const void *key) {
+    return wyHash64(key, strlen(key), 0);
+}
+
+static uint64_t _dictStringCrc32cHash(const void *key) {
+    return crc32cHash64(key, strlen(key), 0);
+}
+
+dictType dictTypeStringCopyKeyWyhash = {
+    _dictStringWyHash,             /* hash function */
+    _dictStringDup,                /* key dup */
+    NULL,                          /* val dup */
+    _dictStringCopyHTKeyCompare,   /* key compare */
+    _dictStringDestructor,         /* key destructor */
+    NULL,                          /* val destructor */
+    _dictStringEmbedLen            /* key embed len */
+};
+
+dictType dictTypeStringCopyKeyWyhashUnseeded = {
+    _dictStringWyHashUnseeded,     /* hash function */
+    _dictStringDup,                /* key dup */
+    NULL,                          /* val dup */
+    _dictStringCopyHTKeyCompare,   /* key compare */
+    _dictStringDestructor,         /* key destructor */
+    NULL,                          /* val destructor */
+    _dictStringEmbedLen            /* key embed len */
+};
+
+dictType dictTypeStringCopyKeyCrc32c = {
+    _dictStringCrc32cHash,         /* hash function */
+    _dictStringDup,                /* key dup */
+    NULL,                          /* val dup */
+    _dictStringCopyHTKeyCompare,   /* key compare */
+    _dictStringDestructor,         /* key destructor */
+    NULL,                          /* val destructor */
+    _dictStringEmbedLen            /* key embed len */
+};
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fmacros.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dict.h>
+#include <dictimage.h>
+#include <hashfunc.h>
+#include <zmalloc.h>
+
+static const char dictImageMagic[8] = {'D','I','C','T','I','M','G','1'};
+
+#define _dictImagePad(len) (((uint64_t)(len)+7)&~(uint64_t)7)
+#define _dictImageRecordSize(keylen, vallen) \
+    (sizeof(dictImageRecord)+_dictImagePad(keylen)+_dictImagePad(vallen))
+
+/* ------------------------------- Saving ----------------------------------*/
+
+static unsigned long _dictImageBuckets(unsigned long count) {
+    unsigned long n = DICT_HT_INITIAL_SIZE;
+
+    while (n < count) n <<= 1;
+    return n;
+}
+
+/* Save 'd' to the file at 'path', that is created or truncated.
+ *
+ * The dict is walked twice: the first time to get the size of every bucket,
+ * the second one to write every record at its place in the mapped file, so
+ * that no copy of the records is needed in memory. The dict must not be
+ * modified while it is saved, but it is never written either, which makes
+ * this function safe to call in a forked child.
+ *
+ * Return DICT_OK on success, or DICT_ERR with errno set. */
+int dictImageSave(dict *d, dictImageType *itype, const char *path) {
+    dictImageHeader *hdr;
+    dictIterator *iter;
+    dictEntry *de;
+    uint64_t *buckets, mask, off, filesize;
+    unsigned long nbuckets, count = 0, j;
+    const void *key, *val;
+    size_t keylen, vallen;
+    char *map;
+    int fd, saved_errno;
+
+    nbuckets = _dictImageBuckets(dictSize(d));
+    mask = nbuckets-1;
+
+    fd = open(path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if (fd == -1) return DICT_ERR;
+
+    /* The bucket array is used first to store the size of every bucket,
+     * at index + 1, so it is allocated here and copied into the file once
+     * the size of the file is known. */
+    buckets = zcalloc((nbuckets+1)*sizeof(uint64_t));
+    iter = dictGetIterator(d);
+    while ((de = dictNext(iter)) != NULL) {
+        keylen = itype->keyBytes(de, &key);
+        vallen = itype->valBytes(de, &val);
+        if (keylen > UINT32_MAX || vallen > UINT32_MAX) {
+            dictReleaseIterator(iter);
+            errno = EFBIG;
+            goto err;
+        }
+        buckets[(dictHashKey(d, de->key) & mask)+1] +=
+            _dictImageRecordSize(keylen, vallen);
+        count++;
+    }
+    dictReleaseIterator(iter);
+
+    /* Turn the sizes into offsets. */
+    off = sizeof(*hdr)+(nbuckets+1)*sizeof(uint64_t);
+    buckets[0] = off;
+    for (j = 1; j <= nbuckets; j++)
+        buckets[j] += buckets[j-1];
+    filesize = buckets[nbuckets];
+
+    if (ftruncate(fd, filesize) == -1) goto err;
+    map = mmap(NULL, filesize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) goto err;
+
+    /* Second walk: buckets[h] is the offset of the next record of the
+     * bucket h, so after the walk buckets[h] is the end of the bucket. */
+    iter = dictGetIterator(d);
+    while ((de = dictNext(iter)) != NULL) {
+        uint64_t hash = dictHashKey(d, de->key);
+        dictImageRecord *r = (dictImageRecord*)(map+buckets[hash & mask]);
+
+        keylen = itype->keyBytes(de, &key);
+        vallen = itype->valBytes(de, &val);
+        r->hash = hash;
+        r->keylen = keylen;
+        r->vallen = vallen;
+        memcpy((void*)dictImageRecordKey(r), key, keylen);
+        memcpy((void*)dictImageRecordVal(r), val, vallen);
+        buckets[hash & mask] += _dictImageRecordSize(keylen, vallen);
+    }
+    dictReleaseIterator(iter);
+
+    /* Shift the ends back to the starts. */
+    for (j = nbuckets; j > 0; j--)
+        buckets[j] = buckets[j-1];
+    buckets[0] = off;
+    memcpy(map+sizeof(*hdr), buckets, (nbuckets+1)*sizeof(uint64_t));
+
+    hdr = (dictImageHeader*)map;
+    memcpy(hdr->magic, dictImageMagic, sizeof(hdr->magic));
+    hdr->version = DICT_IMAGE_VERSION;
+    hdr->count = count;
+    hdr->nbuckets = nbuckets;
+    hdr->buckets_offset = sizeof(*hdr);
+    hdr->records_offset = off;
+    hdr->file_size = filesize;
+    memcpy(hdr->seed, dictGetHashFunctionSeed(), sizeof(hdr->seed));
+    hdr->checksum = crc32c(0, map+sizeof(*hdr), filesize-sizeof(*hdr));
+
+    zfree(buckets);
+    if (munmap(map, filesize) == -1 || fsync(fd) == -1) {
+        saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return DICT_ERR;
+    }
+    return close(fd) == -1 ? DICT_ERR : DICT_OK;
+
+err:
+    saved_errno = errno;
+    zfree(buckets);
+    close(fd);
+    errno = saved_errno;
+    return DICT_ERR;
+}
+
+/* ------------------------------- Loading ---------------------------------*/
+
+/* Map the image at 'path' read only. Only the header and the bucket array
+ * are checked: see dictImageVerify() to check the whole content.
+ *
+ * Return NULL with errno set on error (EINVAL if the file is not a valid
+ * image). */
+dictImage *dictImageOpen(const char *path) {
+    const dictImageHeader *hdr;
+    const uint64_t *buckets;
+    dictImage *img;
+    struct stat st;
+    void *map;
+    uint64_t j;
+    int fd, saved_errno;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1) return NULL;
+    if (fstat(fd, &st) == -1) goto err;
+    if ((size_t)st.st_size < sizeof(*hdr)) {
+        errno = EINVAL;
+        goto err;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) goto err;
+    close(fd);
+
+    hdr = map;
+    buckets = (const uint64_t*)((const char*)map+sizeof(*hdr));
+    if (memcmp(hdr->magic, dictImageMagic, sizeof(hdr->magic)) ||
+        hdr->version != DICT_IMAGE_VERSION ||
+        hdr->file_size != (uint64_t)st.st_size ||
+        hdr->buckets_offset != sizeof(*hdr) ||
+        hdr->nbuckets == 0 || (hdr->nbuckets & (hdr->nbuckets-1)) ||
+        hdr->nbuckets >= (hdr->file_size-sizeof(*hdr))/sizeof(uint64_t) ||
+        hdr->records_offset != sizeof(*hdr)+(hdr->nbuckets+1)*sizeof(uint64_t) ||
+        hdr->count > (hdr->file_size-hdr->records_offset)/sizeof(dictImageRecord))
+        goto inval;
+
+    /* Offsets must be sorted and inside the file, so that a lookup never
+     * reads outside of the mapping. */
+    if (buckets[0] != hdr->records_offset ||
+        buckets[hdr->nbuckets] != hdr->file_size)
+        goto inval;
+    for (j = 1; j <= hdr->nbuckets; j++)
+        if (buckets[j] < buckets[j-1]) goto inval;
+
+    img = zmalloc(sizeof(*img));
+    img->map = map;
+    img->size = st.st_size;
+    img->hdr = hdr;
+    img->buckets = buckets;
+    return img;
+
+inval:
+    munmap(map, st.st_size);
+    errno = EINVAL;
+    return NULL;
+
+err:
+    saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+    return NULL;
+}
+
+void dictImageClose(dictImage *img) {
+    munmap(img->map, img->size);
+    zfree(img);
+}
+
+/* Check the checksum and the records of the image. This reads the whole
+ * file, so it is optional: dictImageOpen() only checks what is needed for
+ * lookups to stay inside the mapping, and records are checked while they
+ * are read. Return DICT_OK if the image is intact. */
+int dictImageVerify(dictImage *img) {
+    const char *map = img->map;
+    uint64_t j, count = 0;
+
+    if (crc32c(0, map+sizeof(dictImageHeader), img->size-sizeof(dictImageHeader))
+        != img->hdr->checksum)
+        return DICT_ERR;
+
+    for (j = 0; j < img->hdr->nbuckets; j++) {
+        uint64_t off = img->buckets[j], end = img->buckets[j+1];
+
+        while (off < end) {
+            const dictImageRecord *r = (const dictImageRecord*)(map+off);
+
+            if (end-off < sizeof(*r) ||
+                end-off < _dictImageRecordSize(r->keylen, r->vallen) ||
+                (r->hash & (img->hdr->nbuckets-1)) != j)
+                return DICT_ERR;
+            off += _dictImageRecordSize(r->keylen, r->vallen);
+            count++;
+        }
+    }
+    return count == img->hdr->count ? DICT_OK : DICT_ERR;
+}
+
+/* Return the next record of a bucket ending at 'end', or NULL if 'off' is
+ * past the end or the record is truncated. */
+static inline const dictImageRecord *_dictImageRecordAt(dictImage *img, uint64_t off, uint64_t end) {
+    const dictImageRecord *r;
+
+    if (off >= end || end-off < sizeof(*r)) return NULL;
+    r = (const dictImageRecord*)((const char*)img->map+off);
+    if (end-off < _dictImageRecordSize(r->keylen, r->vallen)) return NULL;
+    return r;
+}
+
+/* Search in place the record of the key of 'keylen' bytes, as returned by
+ * the keyBytes() callback of the image type, with the hash 'hash' computed
+ * with the same function and seed used to save the image.
+ *
+ * Return the record, pointing inside the mapping, or NULL. */
+const dictImageRecord *dictImageFind(dictImage *img, uint64_t hash, const void *key, size_t keylen) {
+    uint64_t idx = hash & (img->hdr->nbuckets-1);
+    uint64_t off = img->buckets[idx], end = img->buckets[idx+1];
+    const dictImageRecord *r;
+
+    while ((r = _dictImageRecordAt(img, off, end)) != NULL) {
+        if (r->hash == hash && r->keylen == keylen &&
+            memcmp(dictImageRecordKey(r), key, keylen) == 0)
+            return r;
+        off += _dictImageRecordSize(r->keylen, r->vallen);
+    }
+    return NULL;
+}
+
+/* Create a new dict of type 'type' with the content of the image.
+ *
+ * The table is allocated once with the size of the image, and records are
+ * read in order and linked in the bucket of their stored hash: keys are
+ * neither hashed nor compared. Keys whose bytes contain a null terminator
+ * and are what type->keyEmbedLen() would copy are embedded in the entry,
+ * the others are created with the keyLoad() callback, that may also return
+ * pointers inside the mapping if the image outlives the dict.
+ *
+ * The stored hashes are checked against the hash function of 'type' on the
+ * first key: if they differ (different function or seed) every key is
+ * hashed again. Return NULL if the image has corrupted records, or
+ * if their number is not the count of the header. */
+dict *dictImageLoad(dictImage *img, dictType *type, dictImageType *itype, void *privDataPtr) {
+    uint64_t j, nbuckets = img->hdr->nbuckets, count = 0;
+    int checked = 0, rehash = 0;
+    unsigned long mask;
+    dictht *ht;
+    dict *d;
+
+    /* The count is not covered by the checksum, but dictImageOpen() made
+     * sure it is bounded by the size of the records area. */
+    d = dictCreate(type, privDataPtr);
+    if (dictExpand(d, img->hdr->count ? img->hdr->count : 1) != DICT_OK) {
+        dictRelease(d);
+        return NULL;
+    }
+    ht = &d->ht[0];
+    mask = ht->sizemask;
+
+    for (j = 0; j < nbuckets; j++) {
+        uint64_t off = img->buckets[j], end = img->buckets[j+1];
+        const dictImageRecord *r;
+
+        while ((r = _dictImageRecordAt(img, off, end)) != NULL) {
+            const void *key = dictImageRecordKey(r);
+            uint64_t hash = r->hash;
+            dictEntry *de;
+
+            /* keyEmbedLen() gets the raw bytes of the mapping, only call it
+             * if they are terminated inside the record, so that a string
+             * key can't make it read past the end of the image. */
+            if (type->keyEmbedLen && r->keylen && r->keylen <= DICT_EMBED_KEY_MAX &&
+                memchr(key, '\0', r->keylen) != NULL &&
+                type->keyEmbedLen(key) == r->keylen)
+            {
+                de = zmalloc(sizeof(*de)+r->keylen);
+                de->key = de+1;
+                memcpy(de->key, key, r->keylen);
+            } else {
+                de = zmalloc(sizeof(*de));
+                de->key = itype->keyLoad(privDataPtr, key, r->keylen);
+            }
+            itype->valLoad(privDataPtr, de, dictImageRecordVal(r), r->vallen);
+
+            if (!checked) {
+                rehash = dictHashKey(d, de->key) != hash;
+                checked = 1;
+            }
+            if (rehash) hash = dictHashKey(d, de->key);
+
+            de->next = ht->table[hash & mask];
+            ht->table[hash & mask] = de;
+            ht->used++;
+            count++;
+            off += _dictImageRecordSize(r->keylen, r->vallen);
+        }
+        if (off != end) {
+            dictRelease(d);
+            return NULL;
+        }
+    }
+    if (count != img->hdr->count) {
+        dictRelease(d);
+        return NULL;
+    }
+    return d;
+}
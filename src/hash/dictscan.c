@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fmacros.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <dict.h>
+#include <dictscan.h>
+#include <zmalloc.h>
+#include <atomicvar.h>
+
+typedef struct dictScanWorker {
+    dictScanPool *pool;
+    int id;
+} dictScanWorker;
+
+/* Scan partitions of the current scan until there are none left. */
+static void _dictScanPoolWork(dictScanPool *pool, int id) {
+    void *privdata = pool->privdata ? pool->privdata[id] : NULL;
+    unsigned long part, v;
+
+    while (1) {
+        atomicGetIncr(pool->nextpart, part, 1);
+        if (part >= pool->nparts) break;
+        v = 0;
+        do {
+            v = dictScanPartition(pool->d, v, part, pool->nparts,
+                                  pool->fn, pool->bucketfn, privdata);
+        } while (v);
+    }
+}
+
+static void *_dictScanPoolMain(void *arg) {
+    dictScanWorker *worker = arg;
+    dictScanPool *pool = worker->pool;
+    unsigned long generation = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->stop && pool->generation == generation)
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        if (pool->stop) break;
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        _dictScanPoolWork(pool, worker->id);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    zfree(worker);
+    return NULL;
+}
+
+/* Create a pool of 'numthreads' threads. Return NULL if the threads can't
+ * be created. */
+dictScanPool *dictScanPoolCreate(int numthreads) {
+    dictScanPool *pool = zcalloc(sizeof(*pool));
+    int j;
+
+    if (numthreads < 1) numthreads = 1;
+    pool->threads = zmalloc(sizeof(pthread_t)*numthreads);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (j = 0; j < numthreads; j++) {
+        dictScanWorker *worker = zmalloc(sizeof(*worker));
+
+        worker->pool = pool;
+        worker->id = j;
+        if (pthread_create(&pool->threads[j], NULL, _dictScanPoolMain, worker)) {
+            zfree(worker);
+            break;
+        }
+    }
+    pool->numthreads = j;
+    if (j < numthreads) {
+        dictScanPoolRelease(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void dictScanPoolRelease(dictScanPool *pool) {
+    int j;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+    for (j = 0; j < pool->numthreads; j++)
+        pthread_join(pool->threads[j], NULL);
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+    zfree(pool->threads);
+    zfree(pool);
+}
+
+/* Number of partitions used to scan 'd': a power of two, with about
+ * DICT_SCAN_PARTS_PER_THREAD partitions per thread, but not more than the
+ * buckets of the smaller table, so that no element is returned twice when
+ * the table doesn't shrink during the scan. */
+unsigned long dictScanPoolPartitions(dictScanPool *pool, dict *d) {
+    unsigned long want = (unsigned long)pool->numthreads*DICT_SCAN_PARTS_PER_THREAD;
+    unsigned long size = d->ht[0].size, nparts = 1;
+
+    if (d->ht[1].size && d->ht[1].size < size) size = d->ht[1].size;
+    while (nparts < want && nparts < size) nparts <<= 1;
+    return nparts;
+}
+
+/* Scan the whole dict with the threads of the pool, and return when all
+ * the partitions are scanned. The thread j of the pool calls 'fn' and
+ * 'bucketfn' with privdata[j] (or NULL if 'privdata' is NULL), so that
+ * every thread can accumulate its results without locking.
+ *
+ * The callbacks are called concurrently by different threads: the dict
+ * must not be modified until the scan returns. If the background rehashing
+ * of the dict is enabled, every step of the scan holds the lock of the
+ * dict, so only the callbacks run in parallel. */
+void dictScanPoolRun(dictScanPool *pool, dict *d, dictScanFunction *fn, dictScanBucketFunction *bucketfn, void **privdata) {
+    pthread_mutex_lock(&pool->lock);
+    pool->d = d;
+    pool->fn = fn;
+    pool->bucketfn = bucketfn;
+    pool->privdata = privdata;
+    pool->nparts = dictScanPoolPartitions(pool, d);
+    pool->nextpart = 0;
+    pool->running = pool->numthreads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->cond);
+    while (pool->running)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
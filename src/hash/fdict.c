@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fmacros.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <dict.h>
+#include <fdict.h>
+#include <zmalloc.h>
+
+/* Positions are 1/FDICT_TABLE_SLACK more than the keys: the last pilots are
+ * searched with the table about 95% full. Fuller tables save the memory of
+ * the remap array but make the search of the last pilots much longer. */
+#define FDICT_TABLE_SLACK 20
+/* Seeds tried before giving up, every one starting the search again. */
+#define FDICT_MAX_ATTEMPTS 16
+
+/* ----------------------------- Hashing -----------------------------------*/
+
+/* splitmix64 finalizer, a bijection mixing every input bit into every
+ * output bit. */
+static inline uint64_t _fdictMix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/* Map 'h' to [0, n) using the high bits, without a division. */
+static inline unsigned long _fdictReduce(uint64_t h, unsigned long n) {
+#ifdef __SIZEOF_INT128__
+    return (unsigned long)(((unsigned __int128)h * n) >> 64);
+#else
+    return (unsigned long)(h % n);
+#endif
+}
+
+static inline unsigned long _fdictBucket(fdict *d, uint64_t hash) {
+    return _fdictReduce(hash, d->nbuckets);
+}
+
+static inline uint64_t _fdictPilotHash(fdict *d, uint16_t pilot) {
+    return _fdictMix(d->seed+pilot);
+}
+
+/* Position in [0, tablesize) of a key, given the hash of its pilot. */
+static inline unsigned long _fdictSlot(fdict *d, uint64_t hash, uint64_t pilothash) {
+    return _fdictReduce(_fdictMix(hash ^ pilothash), d->tablesize);
+}
+
+static inline unsigned long _fdictPosition(fdict *d, uint64_t hash) {
+    uint16_t pilot = d->pilots[_fdictBucket(d, hash)];
+    unsigned long pos = _fdictSlot(d, hash, _fdictPilotHash(d, pilot));
+
+    return pos < d->size ? pos : d->remap[pos-d->size];
+}
+
+/* ----------------------------- Building ----------------------------------*/
+
+#define _fdictBitTest(bits, i) ((bits)[(i)>>6] & (1ULL<<((i)&63)))
+#define _fdictBitSet(bits, i) ((bits)[(i)>>6] |= (1ULL<<((i)&63)))
+#define _fdictBitClear(bits, i) ((bits)[(i)>>6] &= ~(1ULL<<((i)&63)))
+
+/* Search a pilot for every bucket, in order of decreasing size as larger
+ * buckets are harder to place. 'keys' holds the indexes of the keys grouped
+ * by bucket, the ones of bucket b in keys[start[b]..start[b+1]). On success
+ * the slot of every key is stored in 'slots'. Return 0 if some bucket has
+ * no valid pilot with the current seed. */
+static int _fdictSearch(fdict *d, const uint64_t *hashes, const unsigned long *keys,
+                        const unsigned long *start, const unsigned long *order,
+                        uint64_t *taken, unsigned long *slots)
+{
+    unsigned long i, j, k;
+
+    memset(taken, 0, ((d->tablesize+63)/64)*sizeof(uint64_t));
+    for (i = 0; i < d->nbuckets; i++) {
+        unsigned long b = order[i], first = start[b], last = start[b+1];
+        uint32_t pilot;
+
+        if (first == last) break; /* Only empty buckets left. */
+        for (pilot = 0; pilot <= UINT16_MAX; pilot++) {
+            uint64_t pilothash = _fdictPilotHash(d, pilot);
+
+            for (j = first; j < last; j++) {
+                unsigned long slot = _fdictSlot(d, hashes[keys[j]], pilothash);
+
+                if (_fdictBitTest(taken, slot)) break;
+                _fdictBitSet(taken, slot);
+                slots[keys[j]] = slot;
+            }
+            if (j == last) break;
+            /* Collision: release the slots taken by this pilot. */
+            for (k = first; k < j; k++)
+                _fdictBitClear(taken, slots[keys[k]]);
+        }
+        if (pilot > UINT16_MAX) return 0;
+        d->pilots[b] = pilot;
+    }
+    return 1;
+}
+
+/* The dict type used to release the dict once its keys and values belong
+ * to the fdict. */
+static dictType fdictMovedType = {0};
+
+/* Build a frozen dict with the content of 'd'.
+ *
+ * On success the keys and the values are moved to the new fdict, that keeps
+ * the type and the privdata of 'd', and 'd' is released. Keys that were
+ * embedded in the dict entries are copied to a single allocation.
+ *
+ * Return NULL if no perfect hash function was found (only possible if keys
+ * have the same 64 bit hash), in which case 'd' is left untouched, except
+ * that the background rehashing, if enabled, is stopped. */
+fdict *fdictFreeze(dict *d) {
+    unsigned long n, i, j, maxsize, attempt, nwords;
+    unsigned long *start, *keys, *order, *slots, *count;
+    dictEntry **des, *de;
+    dictIterator *iter;
+    uint64_t *hashes, *taken;
+    int found = 0;
+    fdict *fd;
+
+    dictDisableBackgroundRehash(d);
+    n = dictSize(d);
+
+    fd = zcalloc(sizeof(*fd));
+    fd->type = d->type;
+    fd->privdata = d->privdata;
+    fd->size = n;
+    fd->nbuckets = n/FDICT_BUCKET_KEYS+1;
+    fd->tablesize = n+n/FDICT_TABLE_SLACK+1;
+    fd->pilots = zcalloc(fd->nbuckets*sizeof(uint16_t));
+
+    des = zmalloc((n+1)*sizeof(*des));
+    hashes = zmalloc((n+1)*sizeof(*hashes));
+    keys = zmalloc((n+1)*sizeof(*keys));
+    slots = zmalloc((n+1)*sizeof(*slots));
+    start = zcalloc((fd->nbuckets+1)*sizeof(*start));
+    order = zmalloc(fd->nbuckets*sizeof(*order));
+    nwords = (fd->tablesize+63)/64;
+    taken = zmalloc(nwords*sizeof(*taken));
+
+    /* Group the keys by bucket, counting in start[b+1]. */
+    i = 0;
+    iter = dictGetIterator(d);
+    while ((de = dictNext(iter)) != NULL) {
+        des[i] = de;
+        hashes[i] = dictHashKey(d, de->key);
+        start[_fdictBucket(fd, hashes[i])+1]++;
+        i++;
+    }
+    dictReleaseIterator(iter);
+
+    maxsize = 0;
+    for (j = 1; j <= fd->nbuckets; j++)
+        if (start[j] > maxsize) maxsize = start[j];
+
+    /* Order the buckets by decreasing size with a counting sort. */
+    count = zcalloc((maxsize+2)*sizeof(*count));
+    for (j = 0; j < fd->nbuckets; j++)
+        count[maxsize-start[j+1]+1]++;
+    for (j = 1; j <= maxsize+1; j++)
+        count[j] += count[j-1];
+    for (j = 0; j < fd->nbuckets; j++)
+        order[count[maxsize-start[j+1]]++] = j;
+    zfree(count);
+
+    for (j = 1; j <= fd->nbuckets; j++)
+        start[j] += start[j-1];
+    for (i = 0; i < n; i++)
+        slots[i] = start[_fdictBucket(fd, hashes[i])]++;
+    for (i = 0; i < n; i++)
+        keys[slots[i]] = i;
+    /* start[b] is now the end of bucket b, shift it back. */
+    for (j = fd->nbuckets; j > 0; j--)
+        start[j] = start[j-1];
+    start[0] = 0;
+
+    for (attempt = 0; attempt < FDICT_MAX_ATTEMPTS && !found; attempt++) {
+        fd->seed = _fdictMix(attempt+1);
+        found = _fdictSearch(fd, hashes, keys, start, order, taken, slots);
+    }
+    zfree(keys);
+    zfree(start);
+    zfree(order);
+    zfree(hashes);
+    if (!found) {
+        zfree(taken);
+        zfree(slots);
+        zfree(des);
+        zfree(fd->pilots);
+        zfree(fd);
+        return NULL;
+    }
+
+    /* Remap the slots past the number of keys to the free ones below it. */
+    fd->remap = zcalloc((fd->tablesize-n)*sizeof(unsigned long));
+    for (i = n, j = 0; i < fd->tablesize; i++) {
+        if (!_fdictBitTest(taken, i)) continue;
+        while (_fdictBitTest(taken, j)) j++;
+        fd->remap[i-n] = j++;
+    }
+    zfree(taken);
+
+    /* Copy the embedded keys. */
+    for (i = 0; i < n; i++)
+        if (dictEntryKeyIsEmbedded(des[i]))
+            fd->keyslen += (d->type->keyEmbedLen(des[i]->key)+7)&~7UL;
+    if (fd->keyslen) fd->keys = zmalloc(fd->keyslen);
+
+    fd->entries = zmalloc((n+1)*sizeof(fdictEntry));
+    for (i = 0, j = 0; i < n; i++) {
+        unsigned long pos = slots[i] < n ? slots[i] : fd->remap[slots[i]-n];
+        fdictEntry *he = &fd->entries[pos];
+
+        de = des[i];
+        if (dictEntryKeyIsEmbedded(de)) {
+            size_t len = d->type->keyEmbedLen(de->key);
+
+            he->key = memcpy(fd->keys+j, de->key, len);
+            j += (len+7)&~7UL;
+        } else {
+            he->key = de->key;
+        }
+        he->v.u64 = de->v.u64;
+    }
+    zfree(slots);
+    zfree(des);
+
+    d->type = &fdictMovedType;
+    dictRelease(d);
+    return fd;
+}
+
+void fdictRelease(fdict *d) {
+    unsigned long i;
+
+    for (i = 0; i < d->size; i++) {
+        fdictEntry *he = &d->entries[i];
+        char *key = he->key;
+
+        if (d->type->keyDestructor &&
+            !(key >= d->keys && key < d->keys+d->keyslen))
+            d->type->keyDestructor(d->privdata, he->key);
+        dictFreeVal(d, he);
+    }
+    zfree(d->entries);
+    zfree(d->pilots);
+    zfree(d->remap);
+    zfree(d->keys);
+    zfree(d);
+}
+
+/* ----------------------------- Lookups -----------------------------------*/
+
+fdictEntry *fdictFind(fdict *d, const void *key) {
+    fdictEntry *he;
+
+    if (d->size == 0) return NULL;
+    he = &d->entries[_fdictPosition(d, dictHashKey(d, key))];
+    return dictCompareKeys(d, key, he->key) ? he : NULL;
+}
+
+void *fdictFetchValue(fdict *d, const void *key) {
+    fdictEntry *he = fdictFind(d, key);
+
+    return he ? fdictGetVal(he) : NULL;
+}
+
+/* Bytes used by the fdict, not counting keys that were not embedded and
+ * values. */
+size_t fdictMemoryUsage(fdict *d) {
+    return sizeof(*d)+
+           (d->size+1)*sizeof(fdictEntry)+
+           d->nbuckets*sizeof(uint16_t)+
+           (d->tablesize-d->size)*sizeof(unsigned long)+
+           d->keyslen;
+}
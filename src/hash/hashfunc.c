@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fmacros.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <hashfunc.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define HAVE_CRC32C_SSE42 1
+#endif
+
+uint64_t siphash(const uint8_t *in, const size_t inlen, const uint8_t *k);
+
+/* Unaligned little endian reads. On big endian systems the hashes are
+ * still good, just different. */
+static inline uint64_t _read64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t _read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* ------------------------------- SipHash ---------------------------------- */
+
+/* SipHash with the 64 bit seed expanded to the 128 bit key. */
+uint64_t sipHash64(const void *key, size_t len, uint64_t seed) {
+    uint8_t k[16];
+
+    memcpy(k, &seed, 8);
+    memcpy(k+8, &seed, 8);
+    return siphash(key, len, k);
+}
+
+/* ------------------------------- wyhash ----------------------------------- */
+
+static const uint64_t wyhash_secret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+/* 64x64 -> 128 bit multiplication, low half in *a and high half in *b. */
+static inline void _wymum(uint64_t *a, uint64_t *b) {
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = *a;
+    r *= *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r>>64);
+#else
+    uint64_t ha = *a>>32, hb = *b>>32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha*hb, rm0 = ha*lb, rm1 = hb*la, rl = la*lb;
+    uint64_t t = rl+(rm0<<32), c = t < rl, lo, hi;
+
+    lo = t+(rm1<<32);
+    c += lo < t;
+    hi = rh+(rm0>>32)+(rm1>>32)+c;
+    *a = lo;
+    *b = hi;
+#endif
+}
+
+static inline uint64_t _wymix(uint64_t a, uint64_t b) {
+    _wymum(&a, &b);
+    return a^b;
+}
+
+/* Read 1 to 3 bytes. */
+static inline uint64_t _wyr3(const uint8_t *p, size_t k) {
+    return (((uint64_t)p[0])<<16)|(((uint64_t)p[k>>1])<<8)|p[k-1];
+}
+
+uint64_t wyHash64(const void *key, size_t len, uint64_t seed) {
+    const uint8_t *p = key;
+    const uint64_t *s = wyhash_secret;
+    uint64_t a, b;
+
+    seed ^= _wymix(seed^s[0], s[1]);
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (_read32(p)<<32)|_read32(p+((len>>3)<<2));
+            b = (_read32(p+len-4)<<32)|_read32(p+len-4-((len>>3)<<2));
+        } else if (len > 0) {
+            a = _wyr3(p, len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = _wymix(_read64(p)^s[1], _read64(p+8)^seed);
+                see1 = _wymix(_read64(p+16)^s[2], _read64(p+24)^see1);
+                see2 = _wymix(_read64(p+32)^s[3], _read64(p+40)^see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1^see2;
+        }
+        while (i > 16) {
+            seed = _wymix(_read64(p)^s[1], _read64(p+8)^seed);
+            i -= 16;
+            p += 16;
+        }
+        a = _read64(p+i-16);
+        b = _read64(p+i-8);
+    }
+    a ^= s[1];
+    b ^= seed;
+    _wymum(&a, &b);
+    return _wymix(a^s[0]^len, b^s[1]);
+}
+
+/* ------------------------------- CRC32C ----------------------------------- */
+
+/* Reflected Castagnoli polynomial. */
+#define CRC32C_POLY 0x82f63b78
+
+static uint32_t crc32c_table[8][256];
+static pthread_once_t crc32c_table_once = PTHREAD_ONCE_INIT;
+
+/* Build the slicing-by-8 tables, once, see _crc32cEnsureTable(). */
+static void _crc32cInitTable(void) {
+    uint32_t crc;
+    int i, j;
+
+    for (i = 0; i < 256; i++) {
+        crc = i;
+        for (j = 0; j < 8; j++)
+            crc = crc & 1 ? (crc>>1)^CRC32C_POLY : crc>>1;
+        crc32c_table[0][i] = crc;
+    }
+    for (i = 0; i < 256; i++) {
+        crc = crc32c_table[0][i];
+        for (j = 1; j < 8; j++) {
+            crc = crc32c_table[0][crc & 0xff]^(crc>>8);
+            crc32c_table[j][i] = crc;
+        }
+    }
+}
+
+/* One step of CRC32C over the 8 bytes of 'v', without the inversions. */
+static inline uint32_t _crc32cStep64(uint32_t crc, uint64_t v) {
+    v ^= crc;
+    return crc32c_table[7][v & 0xff]^
+           crc32c_table[6][(v>>8) & 0xff]^
+           crc32c_table[5][(v>>16) & 0xff]^
+           crc32c_table[4][(v>>24) & 0xff]^
+           crc32c_table[3][(v>>32) & 0xff]^
+           crc32c_table[2][(v>>40) & 0xff]^
+           crc32c_table[1][(v>>48) & 0xff]^
+           crc32c_table[0][v>>56];
+}
+
+/* The tables are built on first use. Other threads wait for the build to
+ * complete, and then see the whole tables. */
+static inline void _crc32cEnsureTable(void) {
+    pthread_once(&crc32c_table_once, _crc32cInitTable);
+}
+
+/* Portable CRC32C, slicing by 8 bytes. Like crc32c(), 'crc' is the CRC
+ * of the previous data, or 0, and the returned value is finalized. */
+uint32_t crc32cSoftware(uint32_t crc, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+
+    _crc32cEnsureTable();
+    crc = ~crc;
+    while (len >= 8) {
+        crc = _crc32cStep64(crc, _read64(p));
+        p += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = crc32c_table[0][(crc^*p++) & 0xff]^(crc>>8);
+    return ~crc;
+}
+
+/* The 64 bit hash runs two CRC streams over the words of the key, and a
+ * last word made of the trailing bytes. Since CRC is linear, a second
+ * stream over the same words would just be the first one xored with a
+ * constant: the second stream sees the words multiplied by an odd
+ * constant instead, that is not linear in GF(2). The two paths below
+ * return the same values. */
+#define CRC32C_HASH_MUL 0x9e3779b97f4a7c15ULL
+
+/* Pack the last 1 to 7 bytes of the key in a word, with overlapping reads
+ * instead of a variable length copy. The length, mixed in at the end,
+ * tells apart keys packing to the same word. */
+static inline uint64_t _crc32cTail(const uint8_t *p, size_t len) {
+    if (len >= 4) return _read32(p)|(_read32(p+len-4)<<32);
+    return _wyr3(p, len);
+}
+
+static uint64_t _crc32cHash64Software(const void *key, size_t len, uint64_t seed) {
+    const uint8_t *p = key;
+    uint32_t c0 = (uint32_t)seed, c1 = (uint32_t)(seed>>32);
+    uint64_t v = 0;
+
+    _crc32cEnsureTable();
+    while (len >= 8) {
+        v = _read64(p);
+        c0 = _crc32cStep64(c0, v);
+        c1 = _crc32cStep64(c1, v*CRC32C_HASH_MUL);
+        p += 8;
+        len -= 8;
+    }
+    if (len) {
+        v = _crc32cTail(p, len);
+        c0 = _crc32cStep64(c0, v);
+        c1 = _crc32cStep64(c1, v*CRC32C_HASH_MUL);
+    }
+    return ((uint64_t)c1<<32)|c0;
+}
+
+#ifdef HAVE_CRC32C_SSE42
+__attribute__((target("sse4.2")))
+static uint32_t _crc32cHardware(uint32_t crc, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    uint64_t c = ~crc;
+
+    while (len >= 8) {
+        c = _mm_crc32_u64(c, _read64(p));
+        p += 8;
+        len -= 8;
+    }
+    while (len--) c = _mm_crc32_u8(c, *p++);
+    return ~(uint32_t)c;
+}
+
+/* The crc32 instruction has a latency of 3 cycles but a throughput of 1,
+ * so the second stream is almost free. */
+__attribute__((target("sse4.2")))
+static uint64_t _crc32cHash64Hardware(const void *key, size_t len, uint64_t seed) {
+    const uint8_t *p = key;
+    uint64_t c0 = (uint32_t)seed, c1 = seed>>32, v;
+
+    while (len >= 8) {
+        v = _read64(p);
+        c0 = _mm_crc32_u64(c0, v);
+        c1 = _mm_crc32_u64(c1, v*CRC32C_HASH_MUL);
+        p += 8;
+        len -= 8;
+    }
+    if (len) {
+        v = _crc32cTail(p, len);
+        c0 = _mm_crc32_u64(c0, v);
+        c1 = _mm_crc32_u64(c1, v*CRC32C_HASH_MUL);
+    }
+    return (c1<<32)|c0;
+}
+#endif
+
+int crc32cHardwareSupported(void) {
+#ifdef HAVE_CRC32C_SSE42
+    return __builtin_cpu_supports("sse4.2");
+#else
+    return 0;
+#endif
+}
+
+/* CRC32C of 'buf', continuing from 'crc' (0 for new data). */
+uint32_t crc32c(uint32_t crc, const void *buf, size_t len) {
+#ifdef HAVE_CRC32C_SSE42
+    if (__builtin_cpu_supports("sse4.2"))
+        return _crc32cHardware(crc, buf, len);
+#endif
+    return crc32cSoftware(crc, buf, len);
+}
+
+/* Mix the bits, and the length, so that the low bits used to index the
+ * tables depend on all the input. */
+static inline uint64_t _crc32cHashMix(uint64_t h, size_t len) {
+    h ^= len;
+    h ^= h>>33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h>>33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h>>33;
+    return h;
+}
+
+/* Note that the seed doesn't change which keys collide, see hashfunc.h. */
+uint64_t crc32cHash64(const void *key, size_t len, uint64_t seed) {
+#ifdef HAVE_CRC32C_SSE42
+    if (__builtin_cpu_supports("sse4.2"))
+        return _crc32cHashMix(_crc32cHash64Hardware(key, len, seed), len);
+#endif
+    return crc32cHash64Software(key, len, seed);
+}
+
+/* Portable version of crc32cHash64(), returning the same values. */
+uint64_t crc32cHash64Software(const void *key, size_t len, uint64_t seed) {
+    return _crc32cHashMix(_crc32cHash64Software(key, len, seed), len);
+}
+
+/* ------------------------------ Registry ---------------------------------- */
+
+static const hashFunctionEntry hash_functions[] = {
+    {"siphash", sipHash64},
+    {"wyhash", wyHash64},
+    {"crc32c", crc32cHash64},
+    {NULL, NULL}
+};
+
+/* Lookup a hash function by name (case insensitive), for instance to make
+ * it selectable from a configuration file. Returns NULL if not found. */
+hashFunction *hashFunctionByName(const char *name) {
+    const hashFunctionEntry *e;
+
+    for (e = hash_functions; e->name; e++)
+        if (strcasecmp(e->name, name) == 0) return e->fn;
+    return NULL;
+}
+
+/* Return the registry, terminated by an entry with a NULL name. */
+const hashFunctionEntry *hashFunctionList(void) {
+    return hash_functions;
+}
@@ -0,0 +1,670 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fmacros.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include <swdict.h>
+#include <zmalloc.h>
+#include <util.h>
+
+/* Maximum number of used + deleted slots in a table, per group, before the
+ * table is grown: 14 out of 16 slots, that is a 7/8 load factor. Deleted
+ * slots count as they make probe sequences longer exactly like used ones. */
+#define SWDICT_MAX_LOAD_PER_GROUP 14
+
+/* The hash is split in two parts: the higher 57 bits select the first group
+ * to probe (H1), the lower 7 bits are stored as tag in the control byte of
+ * the slot (H2). */
+#define SWDICT_H1(hash) ((hash) >> 7)
+#define SWDICT_H2(hash) ((int8_t)((hash) & 0x7f))
+
+/* -------------------------- private prototypes ---------------------------- */
+
+static int _swdictExpand(swdict *d, unsigned long size, int samesize);
+static int _swdictExpandIfNeeded(swdict *d);
+static unsigned long _swdictNextPower(unsigned long size);
+
+/* ----------------------------- group helpers ------------------------------ */
+
+/* The control bytes of a group are matched all at once: with SSE2 a group
+ * is exactly one 128 bit register, so a single compare + movemask turns the
+ * 16 control bytes into a bitmap of candidate slots. SSE2 is part of the
+ * x86-64 baseline, so there is nothing to detect at runtime there. Other
+ * targets use the SWAR implementation below, which matches 8 control bytes
+ * per 64 bit word, and is exact: a negative lookup calls the key comparison
+ * callback only for the slots where the 7 bit tag collides (1/128 of the
+ * full slots on average), never because of false positives of the match.
+ *
+ * All the functions return a bitmap where the bit N refers to the slot N
+ * of the group. */
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+/* Match the control bytes equal to 'tag'. */
+static inline unsigned int _swdictMatch(const int8_t *ctrl, int8_t tag) {
+    __m128i c = _mm_loadu_si128((const __m128i*)ctrl);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8(tag)));
+}
+
+/* Match the slots that are either empty or deleted, that is all the slots
+ * that can be used to store a new key: these are the control bytes having
+ * the most significant bit set, exactly what movemask extracts. */
+static inline unsigned int _swdictMatchFree(const int8_t *ctrl) {
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+}
+
+#define SWDICT_PROBE_IMPL "sse2"
+#else
+#define SWDICT_LSB 0x0101010101010101ULL
+#define SWDICT_MSB 0x8080808080808080ULL
+
+/* Load 8 control bytes so that the byte of the slot N is the byte N of
+ * the word, counting from the least significant one. */
+static inline uint64_t _swdictLoadWord(const int8_t *ctrl) {
+    uint64_t w;
+
+    memcpy(&w, ctrl, sizeof(w));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    w = __builtin_bswap64(w);
+#endif
+    return w;
+}
+
+/* Turn a word having only the most significant bit of some byte set into
+ * a bitmap of such bytes. The multiplication moves the bit of the byte N
+ * to the bit 56+N without carries. */
+static inline unsigned int _swdictMsbToMask(uint64_t w) {
+    return (unsigned int)(((w >> 7) * 0x0102040810204080ULL) >> 56);
+}
+
+/* Exact zero bytes detection: unlike the classic (x-LSB)&~x&MSB trick this
+ * never reports bytes following a zero byte. */
+static inline uint64_t _swdictZeroBytes(uint64_t x) {
+    return ~(((x & ~SWDICT_MSB) + ~SWDICT_MSB) | x | ~SWDICT_MSB);
+}
+
+static inline unsigned int _swdictMatch(const int8_t *ctrl, int8_t tag) {
+    uint64_t pattern = SWDICT_LSB * (uint8_t)tag;
+    uint64_t lo = _swdictLoadWord(ctrl) ^ pattern;
+    uint64_t hi = _swdictLoadWord(ctrl+8) ^ pattern;
+
+    return _swdictMsbToMask(_swdictZeroBytes(lo)) |
+           _swdictMsbToMask(_swdictZeroBytes(hi)) << 8;
+}
+
+static inline unsigned int _swdictMatchFree(const int8_t *ctrl) {
+    return _swdictMsbToMask(_swdictLoadWord(ctrl) & SWDICT_MSB) |
+           _swdictMsbToMask(_swdictLoadWord(ctrl+8) & SWDICT_MSB) << 8;
+}
+
+#define SWDICT_PROBE_IMPL "swar"
+#endif
+
+/* Match the slots holding a key. */
+static inline unsigned int _swdictMatchFull(const int8_t *ctrl) {
+    return ~_swdictMatchFree(ctrl) & ((1u << SWDICT_GROUP_SLOTS) - 1);
+}
+
+/* Match the empty slots. */
+static inline unsigned int _swdictMatchEmpty(const int8_t *ctrl) {
+    return _swdictMatch(ctrl, SWDICT_CTRL_EMPTY);
+}
+
+/* Groups are probed with triangular numbers (g, g+1, g+3, g+6, ...) that,
+ * since the number of groups is a power of two, are guaranteed to visit
+ * every group of the table exactly once. */
+#define _swdictNextGroup(g, step, ht) (((g) + (step) + 1) & (ht)->sizemask)
+
+/* ----------------------------- API implementation ------------------------- */
+
+static void _swdictReset(swdictht *ht) {
+    ht->groups = NULL;
+    ht->size = 0;
+    ht->sizemask = 0;
+    ht->used = 0;
+    ht->deleted = 0;
+}
+
+/* Create a new hash table */
+swdict *swdictCreate(dictType *type, void *privDataPtr) {
+    swdict *d = zmalloc(sizeof(*d));
+
+    _swdictReset(&d->ht[0]);
+    _swdictReset(&d->ht[1]);
+    d->type = type;
+    d->privdata = privDataPtr;
+    d->rehashidx = -1;
+    d->pauserehash = 0;
+    return d;
+}
+
+/* Expand or create the hash table so that it is able to hold at least
+ * 'size' elements without growing. */
+int swdictExpand(swdict *d, unsigned long size) {
+    /* the size is invalid if it is smaller than the number of
+     * elements already inside the hash table */
+    if (swdictIsRehashing(d) || d->ht[0].used > size)
+        return DICT_ERR;
+    return _swdictExpand(d, size, 0);
+}
+
+/* Performs N steps of incremental rehashing. Returns 1 if there are still
+ * keys to move from the old to the new hash table, otherwise 0 is returned.
+ *
+ * A rehashing step moves a whole group from the old to the new hash table,
+ * the same way dictRehash() moves a whole bucket. Moved slots are marked as
+ * deleted in the old table instead of empty, otherwise the probe sequence
+ * of keys still waiting to be moved could be interrupted. As in dict.c at
+ * most N*10 groups without keys are visited. */
+int swdictRehash(swdict *d, int n) {
+    int empty_visits = n*10; /* Max number of empty groups to visit. */
+    if (!swdictIsRehashing(d)) return 0;
+
+    while (n-- && d->ht[0].used != 0) {
+        swdictGroup *grp;
+        unsigned int m;
+
+        /* Note that rehashidx can't overflow as we are sure there are more
+         * elements because ht[0].used != 0 */
+        assert(d->ht[0].size > (unsigned long)d->rehashidx);
+        while (!(m = _swdictMatchFull(d->ht[0].groups[d->rehashidx].ctrl))) {
+            d->rehashidx++;
+            if (--empty_visits == 0) return 1;
+        }
+        grp = &d->ht[0].groups[d->rehashidx];
+        /* Move all the keys in this group from the old to the new hash HT */
+        while (m) {
+            int j = __builtin_ctz(m);
+            swdictGroup *dst;
+            unsigned long g, step;
+            unsigned int avail;
+            uint64_t h = dictHashKey(d, grp->slots[j].key);
+
+            /* The key is known not to be in the new table, so just take the
+             * first free slot. It may be a deleted one, left by a key added
+             * and deleted during the rehashing. */
+            g = SWDICT_H1(h) & d->ht[1].sizemask;
+            for (step = 0; ; step++) {
+                dst = &d->ht[1].groups[g];
+                if ((avail = _swdictMatchFree(dst->ctrl)) != 0) break;
+                g = _swdictNextGroup(g, step, &d->ht[1]);
+            }
+            avail = __builtin_ctz(avail);
+            if (dst->ctrl[avail] == SWDICT_CTRL_DELETED) d->ht[1].deleted--;
+            dst->ctrl[avail] = SWDICT_H2(h);
+            dst->slots[avail] = grp->slots[j];
+            grp->ctrl[j] = SWDICT_CTRL_DELETED;
+            d->ht[0].used--;
+            d->ht[0].deleted++;
+            d->ht[1].used++;
+            m &= m-1;
+        }
+        d->rehashidx++;
+    }
+
+    /* Check if we already rehashed the whole table... */
+    if (d->ht[0].used == 0) {
+        zfree(d->ht[0].groups);
+        d->ht[0] = d->ht[1];
+        _swdictReset(&d->ht[1]);
+        d->rehashidx = -1;
+        return 0;
+    }
+
+    /* More to rehash... */
+    return 1;
+}
+
+/* Rehash for an amount of time between ms milliseconds and ms+1 milliseconds */
+int swdictRehashMilliseconds(swdict *d, int ms) {
+    long long start = mstime();
+    int rehashes = 0;
+
+    while (swdictRehash(d, 100)) {
+        rehashes += 100;
+        if (mstime()-start > ms) break;
+    }
+    return rehashes;
+}
+
+/* Like _dictRehashStep(), performs a single step of rehashing unless a
+ * scan is in progress. */
+static void _swdictRehashStep(swdict *d) {
+    if (d->pauserehash == 0) swdictRehash(d, 1);
+}
+
+/* Search 'key' inside the table 'ht'. On success the slot is returned, and
+ * if 'grpref' is not NULL it is populated with the group of the slot.
+ *
+ * The probe sequence stops at the first group having at least an empty
+ * slot: since new keys are always stored in the first group of the
+ * sequence with a free slot, the key can't be found after such group. */
+static swdictEntry *_swdictLookup(swdict *d, swdictht *ht, const void *key,
+                                  uint64_t hash, swdictGroup **grpref)
+{
+    unsigned long g, step;
+    int8_t tag = SWDICT_H2(hash);
+
+    if (ht->used == 0) return NULL;
+    g = SWDICT_H1(hash) & ht->sizemask;
+    for (step = 0; step <= ht->sizemask; step++) {
+        swdictGroup *grp = &ht->groups[g];
+        unsigned int m = _swdictMatch(grp->ctrl, tag);
+
+        while (m) {
+            swdictEntry *he = &grp->slots[__builtin_ctz(m)];
+            if (key == he->key || dictCompareKeys(d, key, he->key)) {
+                if (grpref) *grpref = grp;
+                return he;
+            }
+            m &= m-1;
+        }
+        if (_swdictMatchEmpty(grp->ctrl)) break;
+        g = _swdictNextGroup(g, step, ht);
+    }
+    return NULL;
+}
+
+/* Add an element to the target hash table */
+int swdictAdd(swdict *d, void *key, void *val) {
+    swdictEntry *entry = swdictAddRaw(d, key, NULL);
+
+    if (!entry) return DICT_ERR;
+    dictSetVal(d, entry, val);
+    return DICT_OK;
+}
+
+/* Low level add or find, see dictAddRaw().
+ *
+ * Note that the returned slot lives inside the table, so the pointer is
+ * only valid until the next operation that may rehash or resize the
+ * table, that is, any other swdict call except swdictScan(). */
+swdictEntry *swdictAddRaw(swdict *d, void *key, swdictEntry **existing) {
+    swdictEntry *he;
+    swdictht *ht;
+    swdictGroup *grp;
+    unsigned long g, step;
+    unsigned int avail;
+    uint64_t h;
+    int table;
+
+    if (existing) *existing = NULL;
+    if (swdictIsRehashing(d)) _swdictRehashStep(d);
+
+    /* Expand the hash table if needed */
+    if (_swdictExpandIfNeeded(d) == DICT_ERR)
+        return NULL;
+
+    h = dictHashKey(d, key);
+    for (table = 0; table <= 1; table++) {
+        he = _swdictLookup(d, &d->ht[table], key, h, NULL);
+        if (he) {
+            if (existing) *existing = he;
+            return NULL;
+        }
+        if (!swdictIsRehashing(d)) break;
+    }
+
+    /* Store the key in the first free slot of the probe sequence, reusing
+     * deleted slots. If we are rehashing always use the new table. */
+    ht = swdictIsRehashing(d) ? &d->ht[1] : &d->ht[0];
+    g = SWDICT_H1(h) & ht->sizemask;
+    for (step = 0; ; step++) {
+        grp = &ht->groups[g];
+        if ((avail = _swdictMatchFree(grp->ctrl)) != 0) break;
+        g = _swdictNextGroup(g, step, ht);
+    }
+    avail = __builtin_ctz(avail);
+    if (grp->ctrl[avail] == SWDICT_CTRL_DELETED) ht->deleted--;
+    grp->ctrl[avail] = SWDICT_H2(h);
+    ht->used++;
+
+    /* Set the hash entry fields. */
+    he = &grp->slots[avail];
+    dictSetKey(d, he, key);
+    return he;
+}
+
+/* Add or Overwrite, see dictReplace(). */
+int swdictReplace(swdict *d, void *key, void *val) {
+    swdictEntry *entry, *existing, auxentry;
+
+    entry = swdictAddRaw(d, key, &existing);
+    if (entry) {
+        dictSetVal(d, entry, val);
+        return 1;
+    }
+
+    /* Set the new value and free the old one, in this order, as the value
+     * may just be exactly the same as the previous one. */
+    auxentry = *existing;
+    dictSetVal(d, existing, val);
+    dictFreeVal(d, &auxentry);
+    return 0;
+}
+
+/* Remove an element, returning DICT_OK on success or DICT_ERR if the
+ * element was not found. */
+int swdictDelete(swdict *d, const void *key) {
+    swdictEntry *he;
+    swdictGroup *grp;
+    uint64_t h;
+    int table;
+
+    if (swdictSize(d) == 0) return DICT_ERR;
+
+    if (swdictIsRehashing(d)) _swdictRehashStep(d);
+    h = dictHashKey(d, key);
+
+    for (table = 0; table <= 1; table++) {
+        he = _swdictLookup(d, &d->ht[table], key, h, &grp);
+        if (he) {
+            int j = he - grp->slots;
+
+            dictFreeKey(d, he);
+            dictFreeVal(d, he);
+            /* If the group still has an empty slot no probe sequence ever
+             * went past it, so the slot can be marked empty again instead
+             * of leaving a tombstone behind. */
+            if (_swdictMatchEmpty(grp->ctrl)) {
+                grp->ctrl[j] = SWDICT_CTRL_EMPTY;
+            } else {
+                grp->ctrl[j] = SWDICT_CTRL_DELETED;
+                d->ht[table].deleted++;
+            }
+            d->ht[table].used--;
+            return DICT_OK;
+        }
+        if (!swdictIsRehashing(d)) break;
+    }
+    return DICT_ERR; /* not found */
+}
+
+/* Destroy an entire hash table */
+static void _swdictClear(swdict *d, swdictht *ht, void(callback)(void *)) {
+    unsigned long i;
+
+    /* Free all the elements */
+    for (i = 0; i < ht->size && ht->used > 0; i++) {
+        swdictGroup *grp = &ht->groups[i];
+        unsigned int m = _swdictMatchFull(grp->ctrl);
+
+        if (callback && (i & 4095) == 0) callback(d->privdata);
+
+        while (m) {
+            swdictEntry *he = &grp->slots[__builtin_ctz(m)];
+            dictFreeKey(d, he);
+            dictFreeVal(d, he);
+            ht->used--;
+            m &= m-1;
+        }
+    }
+    /* Free the table and re-initialize it */
+    zfree(ht->groups);
+    _swdictReset(ht);
+}
+
+/* Clear & Release the hash table */
+void swdictRelease(swdict *d) {
+    _swdictClear(d, &d->ht[0], NULL);
+    _swdictClear(d, &d->ht[1], NULL);
+    zfree(d);
+}
+
+void swdictEmpty(swdict *d, void(callback)(void*)) {
+    _swdictClear(d, &d->ht[0], callback);
+    _swdictClear(d, &d->ht[1], callback);
+    d->rehashidx = -1;
+    d->pauserehash = 0;
+}
+
+swdictEntry *swdictFind(swdict *d, const void *key) {
+    swdictEntry *he;
+    uint64_t h;
+    int table;
+
+    if (swdictSize(d) == 0) return NULL; /* dict is empty */
+    if (swdictIsRehashing(d)) _swdictRehashStep(d);
+    h = dictHashKey(d, key);
+    for (table = 0; table <= 1; table++) {
+        he = _swdictLookup(d, &d->ht[table], key, h, NULL);
+        if (he) return he;
+        if (!swdictIsRehashing(d)) return NULL;
+    }
+    return NULL;
+}
+
+void *swdictFetchValue(swdict *d, const void *key) {
+    swdictEntry *he;
+
+    he = swdictFind(d, key);
+    return he ? swdictGetVal(he) : NULL;
+}
+
+/* Function to reverse bits, see dict.c. */
+static unsigned long rev(unsigned long v) {
+    unsigned long s = 8 * sizeof(v); // bit size; must be power of 2
+    unsigned long mask = ~0;
+    while ((s >>= 1) > 0) {
+        mask ^= (mask << s);
+        v = ((v >> s) & mask) | ((v << s) & ~mask);
+    }
+    return v;
+}
+
+/* Emit all the keys of 'ht' whose home group (the first group of their
+ * probe sequence) is 'idx'. Since keys may be stored in later groups of the
+ * probe sequence we follow it exactly like a lookup does, and filter the
+ * keys by their home group. */
+static void _swdictScanGroup(swdict *d, swdictht *ht, unsigned long idx,
+                             swdictScanFunction *fn, void *privdata)
+{
+    unsigned long g = idx, step;
+
+    if (ht->used == 0) return;
+    for (step = 0; step <= ht->sizemask; step++) {
+        swdictGroup *grp = &ht->groups[g];
+        unsigned int m = _swdictMatchFull(grp->ctrl);
+
+        while (m) {
+            int j = __builtin_ctz(m);
+            m &= m-1;
+            /* The callback may have deleted other keys of this group. */
+            if (grp->ctrl[j] < 0) continue;
+            if ((SWDICT_H1(dictHashKey(d, grp->slots[j].key)) & ht->sizemask) == idx)
+                fn(privdata, &grp->slots[j]);
+        }
+        if (_swdictMatchEmpty(grp->ctrl)) break;
+        g = _swdictNextGroup(g, step, ht);
+    }
+}
+
+/* swdictScan() is used to iterate over the elements of a dictionary, with
+ * the same cursor semantics and guarantees of dictScan(): please check the
+ * big comment on top of dictScan() in dict.c for the details.
+ *
+ * The reverse binary cursor walks the home groups of the keys, which play
+ * the role of the buckets of dict.c: when the table is resized the keys of
+ * a given home group can only move to the expansions (or the reduction) of
+ * such group, exactly like the keys of a chained bucket do, regardless of
+ * the slot where probing put them.
+ *
+ * Rehashing is paused while the callback runs, so it is safe to delete the
+ * emitted entry from the callback. */
+unsigned long swdictScan(swdict *d, unsigned long v,
+                         swdictScanFunction *fn, void *privdata)
+{
+    swdictht *t0, *t1;
+    unsigned long m0, m1;
+
+    if (swdictSize(d) == 0) return 0;
+
+    d->pauserehash++;
+    if (!swdictIsRehashing(d)) {
+        t0 = &(d->ht[0]);
+        m0 = t0->sizemask;
+
+        /* Emit entries at cursor */
+        _swdictScanGroup(d, t0, v & m0, fn, privdata);
+
+        /* Set unmasked bits so incrementing the reversed cursor
+         * operates on the masked bits */
+        v |= ~m0;
+
+        /* Increment the reverse cursor */
+        v = rev(v);
+        v++;
+        v = rev(v);
+
+    } else {
+        t0 = &d->ht[0];
+        t1 = &d->ht[1];
+
+        /* Make sure t0 is the smaller and t1 is the bigger table */
+        if (t0->size > t1->size) {
+            t0 = &d->ht[1];
+            t1 = &d->ht[0];
+        }
+
+        m0 = t0->sizemask;
+        m1 = t1->sizemask;
+
+        /* Emit entries at cursor */
+        _swdictScanGroup(d, t0, v & m0, fn, privdata);
+
+        /* Iterate over indices in larger table that are the expansion
+         * of the index pointed to by the cursor in the smaller table */
+        do {
+            /* Emit entries at cursor */
+            _swdictScanGroup(d, t1, v & m1, fn, privdata);
+
+            /* Increment the reverse cursor not covered by the smaller mask.*/
+            v |= ~m1;
+            v = rev(v);
+            v++;
+            v = rev(v);
+
+            /* Continue while bits covered by mask difference is non-zero */
+        } while (v & (m0 ^ m1));
+    }
+    d->pauserehash--;
+
+    return v;
+}
+
+/* Return the name of the control bytes matching implementation in use. */
+const char *swdictProbeImplementation(void) {
+    return SWDICT_PROBE_IMPL;
+}
+
+/* ------------------------- private functions ------------------------------ */
+
+/* Allocate a table able to hold 'size' elements. Unlike swdictExpand() a
+ * new table of the same size is allowed when 'samesize' is true: this is
+ * used to get rid of the deleted slots. */
+static int _swdictExpand(swdict *d, unsigned long size, int samesize) {
+    swdictht n; /* the new hash table */
+    unsigned long i, realsize;
+
+    realsize = _swdictNextPower((size + SWDICT_MAX_LOAD_PER_GROUP - 1) /
+                                SWDICT_MAX_LOAD_PER_GROUP);
+
+    /* Rehashing to the same table size is not useful. */
+    if (realsize == d->ht[0].size && !samesize) return DICT_ERR;
+
+    /* Allocate the new hash table and mark all the slots as empty. */
+    n.size = realsize;
+    n.sizemask = realsize-1;
+    n.groups = zmalloc(realsize*sizeof(swdictGroup));
+    n.used = 0;
+    n.deleted = 0;
+    for (i = 0; i < realsize; i++)
+        memset(n.groups[i].ctrl, SWDICT_CTRL_EMPTY, SWDICT_GROUP_SLOTS);
+
+    /* Is this the first initialization? If so it's not really a rehashing
+     * we just set the first hash table so that it can accept keys. */
+    if (d->ht[0].groups == NULL) {
+        d->ht[0] = n;
+        return DICT_OK;
+    }
+
+    /* Prepare a second hash table for incremental rehashing */
+    d->ht[1] = n;
+    d->rehashidx = 0;
+    return DICT_OK;
+}
+
+/* Expand the hash table if needed */
+static int _swdictExpandIfNeeded(swdict *d) {
+    swdictht *ht = &d->ht[0];
+    unsigned long size;
+
+    if (swdictIsRehashing(d)) {
+        /* The target table is sized so that the rehashing completes well
+         * before it fills up, however an open addressing table can't
+         * overflow, so if that ever happens just finish the rehashing now
+         * and check again against the resulting table. */
+        if (d->ht[1].used + d->ht[1].deleted <
+            d->ht[1].size*SWDICT_MAX_LOAD_PER_GROUP) return DICT_OK;
+        while (swdictRehash(d, 100));
+    }
+
+    /* If the hash table is empty expand it to the initial size. */
+    if (ht->size == 0)
+        return _swdictExpand(d, SWDICT_HT_INITIAL_SIZE*SWDICT_MAX_LOAD_PER_GROUP, 0);
+
+    /* If we reached the maximum load, counting deleted slots too, rehash
+     * to a table big enough to hold twice the used slots. This also cleans
+     * the deleted slots, so if they are most of the load the new table
+     * may have the same size or be even smaller. However the new table
+     * must be able to receive the keys added while the rehashing is in
+     * progress, and every step moves at least a group, hence the minimum
+     * of 'used + size'. */
+    if (ht->used + ht->deleted >= ht->size*SWDICT_MAX_LOAD_PER_GROUP) {
+        size = ht->used*2;
+        if (size < ht->used + ht->size) size = ht->used + ht->size;
+        return _swdictExpand(d, size, 1);
+    }
+    return DICT_OK;
+}
+
+/* Our number of groups is a power of two */
+static unsigned long _swdictNextPower(unsigned long size) {
+    unsigned long i = SWDICT_HT_INITIAL_SIZE;
+
+    if (size >= LONG_MAX) return LONG_MAX + 1LU;
+    while(1) {
+        if (i >= size)
+            return i;
+        i *= 2;
+    }
+}
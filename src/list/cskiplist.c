@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fmacros.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+#include <cskiplist.h>
+#include <atomicvar.h>
+#include <zmalloc.h>
+
+/* Links are always published and read with sequentially consistent
+ * atomics, as in cdict. */
+#define cslLoad(var, dst) atomicGetWithSync(var, dst)
+#define cslCas(var, expected, desired, ok) \
+    atomicCompareSwapWithSync(var, expected, desired, ok)
+
+#define cslMarked(v) ((v) & 1)
+#define cslPtr(v) ((cskiplistNode*)((v) & ~(uintptr_t)1))
+
+#define cslNodeOf(node) \
+    ((cskiplistNode*)((char*)(node) - offsetof(cskiplistNode, reclaim)))
+
+/* Values of node->state. A node can be deleted while its inserter is still
+ * linking its upper levels, and then it must not be released before the
+ * inserter is done, or the inserter could link it back after it was
+ * retired. Whoever of the two comes last retires the node. */
+#define CSL_LINKING 0   /* The inserter is linking the upper levels. */
+#define CSL_LINKED 1    /* Fully linked, the deleter retires it. */
+#define CSL_ORPHAN 2    /* Deleted while linking, the inserter retires it. */
+
+/* ------------------------------ levels ------------------------------------ */
+
+/* xorshift64* generator with a per thread state: no lock, unlike random(),
+ * and no shared cache line. */
+static __thread uint64_t csl_rng_state = 0;
+
+static int _cslRandomLevel(void) {
+    uint64_t x = csl_rng_state;
+
+    if (x == 0) {
+        /* splitmix64 of the address of the state and of the time, that
+         * are different for every thread. */
+        x = (uint64_t)(uintptr_t)&csl_rng_state ^ (uint64_t)time(NULL);
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        if (x == 0) x = 1;
+    }
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    csl_rng_state = x;
+    x *= 0x2545f4914f6cdd1dULL;
+    /* Every pair of zero bits is one more level: P = 1/4 like zskiplist. */
+    return 1+__builtin_ctzll(x | (1ULL << (2*(CSKIPLIST_MAXLEVEL-1))))/2;
+}
+
+/* --------------------------- nodes and reclamation ------------------------ */
+
+static cskiplistNode *_cslCreateNode(int level, double score, void *ele) {
+    cskiplistNode *x = zmalloc(sizeof(*x)+level*sizeof(uintptr_t));
+
+    x->ele = ele;
+    x->score = score;
+    x->level = level;
+    x->state = CSL_LINKING;
+    return x;
+}
+
+static void _cslFreeNode(epochNode *node, void *privdata) {
+    cskiplistNode *x = cslNodeOf(node);
+
+    (void)privdata;
+    if (x->ele) zfree(x->ele);
+    zfree(x);
+}
+
+/* Compare the node 'x' with the element 'ele' of score 'score'. */
+static inline int _cslCompare(cskiplist *csl, cskiplistNode *x, double score,
+                              const void *ele, size_t size)
+{
+    if (x->score < score) return -1;
+    if (x->score > score) return 1;
+    return csl->mcmp(x->ele, ele, size);
+}
+
+/* Search the position of the element, filling 'preds' and 'succs' with
+ * the last node before it and the first node not before it, at every
+ * level. The marked nodes met on the way are unlinked, restarting from the
+ * top if a link changed under us. Returns 1 if succs[0] is the element.
+ * Must be called inside a read side critical section. */
+static int _cslSearch(cskiplist *csl, double score, const void *ele, size_t size,
+                      cskiplistNode **preds, cskiplistNode **succs)
+{
+    cskiplistNode *pred, *curr;
+    uintptr_t v, next;
+    int l, ok;
+
+retry:
+    pred = csl->header;
+    for (l = CSKIPLIST_MAXLEVEL-1; l >= 0; l--) {
+        cslLoad(pred->next[l], v);
+        curr = cslPtr(v);
+        while (curr) {
+            cslLoad(curr->next[l], next);
+            if (cslMarked(next)) {
+                /* 'curr' is deleted: unlink it from 'pred' at this level. */
+                uintptr_t expected = (uintptr_t)curr;
+
+                cslCas(pred->next[l], expected, next & ~(uintptr_t)1, ok);
+                if (!ok) goto retry;
+                curr = cslPtr(next);
+                continue;
+            }
+            if (_cslCompare(csl, curr, score, ele, size) >= 0) break;
+            pred = curr;
+            curr = cslPtr(next);
+        }
+        preds[l] = pred;
+        succs[l] = curr;
+    }
+    return succs[0] && _cslCompare(csl, succs[0], score, ele, size) == 0;
+}
+
+/* ----------------------------- API implementation ------------------------- */
+
+/* Create a new concurrent skiplist. If 'mp' is NULL elements are compared
+ * with memcmp(), as in zslCreate(). */
+cskiplist *cslCreate(zslmemcmp mp) {
+    cskiplist *csl = zmalloc(sizeof(*csl));
+    int j;
+
+    csl->header = _cslCreateNode(CSKIPLIST_MAXLEVEL, 0, NULL);
+    for (j = 0; j < CSKIPLIST_MAXLEVEL; j++)
+        csl->header->next[j] = 0;
+    csl->length = 0;
+    csl->mcmp = mp ? mp : memcmp;
+    csl->epoch = epochCreate(csl);
+    return csl;
+}
+
+/* Destroy the skiplist and its elements. No other thread must be using
+ * it. */
+void cslRelease(cskiplist *csl) {
+    cskiplistNode *x = cslPtr(csl->header->next[0]), *next;
+
+    /* Deleted nodes are owned by the epoch domain, and unlinked. */
+    epochRelease(csl->epoch);
+    zfree(csl->header);
+    while (x) {
+        next = cslPtr(x->next[0]);
+        _cslFreeNode(&x->reclaim, NULL);
+        x = next;
+    }
+    zfree(csl);
+}
+
+/* Enter / exit a read side critical section. Nodes returned by cslFind(),
+ * cslFirstInRange() and cslNext() can be accessed only until the matching
+ * cslExit() call. */
+int cslEnter(cskiplist *csl) {
+    return epochEnter(csl->epoch);
+}
+
+void cslExit(cskiplist *csl, int token) {
+    epochExit(csl->epoch, token);
+}
+
+/* Insert an element, that must not be NULL. Returns 1 if it was added, in
+ * which case the skiplist takes ownership of 'ele', or 0 if an equal
+ * element with the same score already exists.
+ *
+ * The node is linked at level 0 first, which makes it visible, then at the
+ * upper levels one by one. Linking stops if the node gets deleted in the
+ * meantime, which the deleter notices with node->state. */
+int cslInsert(cskiplist *csl, double score, void *ele, size_t size) {
+    cskiplistNode *preds[CSKIPLIST_MAXLEVEL], *succs[CSKIPLIST_MAXLEVEL];
+    cskiplistNode *x = NULL;
+    uintptr_t v, expected;
+    int token, level, l, ok, state;
+
+    assert(!isnan(score) && ele != NULL);
+    level = _cslRandomLevel();
+    token = epochEnter(csl->epoch);
+    while (1) {
+        if (_cslSearch(csl, score, ele, size, preds, succs)) {
+            if (x) {
+                x->ele = NULL;
+                _cslFreeNode(&x->reclaim, NULL);
+            }
+            epochExit(csl->epoch, token);
+            return 0;
+        }
+        if (x == NULL) x = _cslCreateNode(level, score, ele);
+        for (l = 0; l < level; l++) x->next[l] = (uintptr_t)succs[l];
+        expected = (uintptr_t)succs[0];
+        cslCas(preds[0]->next[0], expected, (uintptr_t)x, ok);
+        if (ok) break;
+    }
+    atomicIncr(csl->length, 1);
+
+    for (l = 1; l < level; l++) {
+        while (1) {
+            /* Point to the current successor, unless we are deleted. */
+            cslLoad(x->next[l], v);
+            if (cslMarked(v)) goto linked;
+            if (cslPtr(v) != succs[l]) {
+                cslCas(x->next[l], v, (uintptr_t)succs[l], ok);
+                if (!ok) continue;
+            }
+            expected = (uintptr_t)succs[l];
+            cslCas(preds[l]->next[l], expected, (uintptr_t)x, ok);
+            if (ok) break;
+            /* The neighbors changed, search them again. */
+            if (!_cslSearch(csl, score, ele, size, preds, succs) || succs[0] != x)
+                goto linked;
+        }
+    }
+
+linked:
+    state = CSL_LINKING;
+    cslCas(x->state, state, CSL_LINKED, ok);
+    if (!ok) {
+        /* Deleted while we were linking it: the deleter left us the job of
+         * unlinking the levels we may have added after its search. */
+        _cslSearch(csl, score, ele, size, preds, succs);
+        epochRetire(csl->epoch, &x->reclaim, _cslFreeNode);
+    }
+    epochExit(csl->epoch, token);
+    epochReclaim(csl->epoch, 0);
+    return 1;
+}
+
+/* Delete an element. Returns 1 if it was found and deleted, 0 otherwise.
+ * The element is released after a grace period. */
+int cslDelete(cskiplist *csl, double score, const void *ele, size_t size) {
+    cskiplistNode *preds[CSKIPLIST_MAXLEVEL], *succs[CSKIPLIST_MAXLEVEL], *x;
+    uintptr_t v;
+    int token, l, ok, state;
+
+    token = epochEnter(csl->epoch);
+    if (!_cslSearch(csl, score, ele, size, preds, succs)) {
+        epochExit(csl->epoch, token);
+        return 0;
+    }
+    x = succs[0];
+
+    /* Mark the upper levels, then level 0: whoever marks it deleted it. */
+    for (l = x->level-1; l >= 1; l--) {
+        do {
+            cslLoad(x->next[l], v);
+            if (cslMarked(v)) break;
+            cslCas(x->next[l], v, v | 1, ok);
+        } while (!ok);
+    }
+    while (1) {
+        cslLoad(x->next[0], v);
+        if (cslMarked(v)) {
+            epochExit(csl->epoch, token);
+            return 0;
+        }
+        cslCas(x->next[0], v, v | 1, ok);
+        if (ok) break;
+    }
+    atomicDecr(csl->length, 1);
+
+    /* If the inserter is still linking, it'll unlink and retire the node
+     * once done. Otherwise unlink it from every level, then retire it. */
+    state = CSL_LINKING;
+    cslCas(x->state, state, CSL_ORPHAN, ok);
+    if (!ok) {
+        _cslSearch(csl, score, ele, size, preds, succs);
+        epochRetire(csl->epoch, &x->reclaim, _cslFreeNode);
+    }
+    epochExit(csl->epoch, token);
+    epochReclaim(csl->epoch, 0);
+    return 1;
+}
+
+/* Return the node of the first element not before (score, ele), going
+ * through the deleted nodes without unlinking them, so that readers don't
+ * write to the skiplist. 'ele' NULL means the first element with a score
+ * in 'range' instead. */
+static cskiplistNode *_cslSeek(cskiplist *csl, double score, const void *ele,
+                               size_t size, zrangespec *range)
+{
+    cskiplistNode *pred = csl->header, *curr;
+    uintptr_t v;
+    int l;
+
+    for (l = CSKIPLIST_MAXLEVEL-1; l >= 0; l--) {
+        cslLoad(pred->next[l], v);
+        curr = cslPtr(v);
+        while (curr && (range ? !zslValueGteMin(curr->score, range) :
+                        _cslCompare(csl, curr, score, ele, size) < 0))
+        {
+            pred = curr;
+            cslLoad(curr->next[l], v);
+            curr = cslPtr(v);
+        }
+    }
+    /* Skip the deleted nodes. */
+    while (curr) {
+        cslLoad(curr->next[0], v);
+        if (!cslMarked(v)) break;
+        curr = cslPtr(v);
+    }
+    return curr;
+}
+
+/* Lock free lookup, must be called inside cslEnter() / cslExit(). Returns
+ * the node of the element, or NULL if not found. */
+cskiplistNode *cslFind(cskiplist *csl, double score, const void *ele, size_t size) {
+    cskiplistNode *x = _cslSeek(csl, score, ele, size, NULL);
+
+    if (x && _cslCompare(csl, x, score, ele, size) == 0) return x;
+    return NULL;
+}
+
+/* Return the first node with a score in 'range', or NULL if there is
+ * none. The next ones are returned by cslNext(), the caller checks their
+ * score against the max of the range. Must be called inside cslEnter() /
+ * cslExit(). */
+cskiplistNode *cslFirstInRange(cskiplist *csl, zrangespec *range) {
+    cskiplistNode *x;
+
+    if (range->min > range->max ||
+        (range->min == range->max && (range->minex || range->maxex)))
+        return NULL;
+    x = _cslSeek(csl, 0, NULL, 0, range);
+    if (x && !zslValueLteMax(x->score, range)) return NULL;
+    return x;
+}
+
+/* Return the node following 'x' that is not deleted, or NULL at the end of
+ * the skiplist. 'x' itself may have been deleted meanwhile: its links are
+ * still valid until cslExit(). */
+cskiplistNode *cslNext(cskiplist *csl, cskiplistNode *x) {
+    uintptr_t v;
+
+    (void)csl;
+    cslLoad(x->next[0], v);
+    x = cslPtr(v);
+    while (x) {
+        cslLoad(x->next[0], v);
+        if (!cslMarked(v)) break;
+        x = cslPtr(v);
+    }
+    return x;
+}
+
+/* Return the number of elements. The result is exact only if no write is
+ * in progress. */
+unsigned long cslLength(cskiplist *csl) {
+    long length;
+
+    atomicGet(csl->length, length);
+    return length;
+}
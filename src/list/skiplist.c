@@ -28,6 +28,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdint.h>
 #include <assert.h>
 #include <zmalloc.h>
 #include <skiplist.h>
@@ -36,14 +37,79 @@
 #define ZSKIPLIST_P 0.25      /* Skiplist P = 1/4 */
 #define ZSKIPLIST_MAX_SEARCH 10
 
+#define ZSKIPLIST_SLAB_PAGE 4096
+#define ZSKIPLIST_CACHE_LINE 64
+
+/* Node allocator of the inline skiplists. The nodes of each level count
+ * have their own size class, with a list of free slots, and are carved out
+ * of pages of about ZSKIPLIST_SLAB_PAGE bytes: the nodes allocated one
+ * after the other share pages and cache lines, instead of being scattered
+ * by malloc(). The pages are only released by zslFree().
+ *
+ * A slot starts with the level of its node, followed by the node, its
+ * levels and the bytes of the inline element. The slots of a page start
+ * at a cache line boundary, so that a level 1 node with an element of up
+ * to 16 bytes takes a single cache line. */
+typedef struct zskiplistSlab {
+    void *pages;                        /* Linked by their first word. */
+    struct {
+        void *free;                     /* Linked by their first word. */
+        size_t slotsize;
+    } cls[ZSKIPLIST_MAXLEVEL];
+} zskiplistSlab;
+
+#define ZSKIPLIST_SLOT_HDR sizeof(void*)
+#define zslSlotLevel(node) (*(int*)((char*)(node)-ZSKIPLIST_SLOT_HDR))
+#define zslInlineEle(node, lvl) ((void*)&(node)->level[(lvl)])
+
+static zskiplistNode *zslSlabAlloc(zskiplistSlab *slab, int level) {
+    void *slot = slab->cls[level-1].free;
+
+    if (slot == NULL) {
+        size_t slotsize = slab->cls[level-1].slotsize;
+        size_t count = ZSKIPLIST_SLAB_PAGE/slotsize, j;
+        char *page;
+
+        if (count == 0) count = 1;
+        page = zmalloc(ZSKIPLIST_CACHE_LINE+count*slotsize);
+        *(void**)page = slab->pages;
+        slab->pages = page;
+        /* Link the slots in address order, the first one is used now. */
+        slot = (void*)(((uintptr_t)page+sizeof(void*)+ZSKIPLIST_CACHE_LINE-1) &
+                       ~(uintptr_t)(ZSKIPLIST_CACHE_LINE-1));
+        for (j = 1; j < count; j++)
+            *(void**)((char*)slot+(j-1)*slotsize) = (char*)slot+j*slotsize;
+        *(void**)((char*)slot+(count-1)*slotsize) = NULL;
+    }
+    slab->cls[level-1].free = *(void**)slot;
+    *(int*)slot = level;
+    return (zskiplistNode*)((char*)slot+ZSKIPLIST_SLOT_HDR);
+}
+
+static void zslSlabFree(zskiplistSlab *slab, zskiplistNode *node) {
+    void *slot = (char*)node-ZSKIPLIST_SLOT_HDR;
+    int level = *(int*)slot;
+
+    *(void**)slot = slab->cls[level-1].free;
+    slab->cls[level-1].free = slot;
+}
+
 /* Create a skiplist node with the specified number of levels.
- * The SDS string 'ele' is referenced by the node after the call. */
-zskiplistNode *zslCreateNode(int level, double score, void *ele) {
+ * The SDS string 'ele' is referenced by the node after the call, unless
+ * the skiplist is inline: then the 'size' bytes of 'ele' are copied, into
+ * the node itself if they fit in zsl->inlinemax bytes. */
+zskiplistNode *zslCreateNode(zskiplist *zsl, int level, double score, void *ele, size_t size) {
     zskiplistNode *zn;
 
-    zn = zmalloc(sizeof(*zn)+level*sizeof(struct zskiplistLevel));
+    if (zsl->slab == NULL) {
+        zn = zmalloc(sizeof(*zn)+level*sizeof(struct zskiplistLevel));
+        zn->ele = ele;
+    } else {
+        zn = zslSlabAlloc(zsl->slab, level);
+        zn->ele = size <= zsl->inlinemax ? zslInlineEle(zn, level) : zmalloc(size);
+        memcpy(zn->ele, ele, size);
+    }
     zn->score = score;
-    zn->ele = ele;
 
     return zn;
 }
@@ -55,7 +121,9 @@ zskiplist *zslCreate(zslmemcmp mp) {
     zsl = zmalloc(sizeof(*zsl));
     zsl->level = 1;
     zsl->length = 0;
-    zsl->header = zslCreateNode(ZSKIPLIST_MAXLEVEL, 0, NULL);
+    zsl->inlinemax = 0;
+    zsl->slab = NULL;
+    zsl->header = zslCreateNode(zsl, ZSKIPLIST_MAXLEVEL, 0, NULL, 0);
     for (j = 0; j < ZSKIPLIST_MAXLEVEL; j++) {
         zsl->header->level[j].forward = NULL;
         zsl->header->level[j].span = 0;
@@ -66,10 +134,39 @@ zskiplist *zslCreate(zslmemcmp mp) {
     return zsl;
 }
 
+/* Create a skiplist storing its elements inline: zslInsert() copies the
+ * element into the node when it is at most 'inlinemax' bytes (into a
+ * separate allocation otherwise), and the caller keeps the ownership of the
+ * buffer it passed. The nodes come from a slab allocator with a size class
+ * per level count, so a range scan reads the score, the links and the
+ * element of a node from the same cache lines. */
+zskiplist *zslCreateInline(zslmemcmp mp, size_t inlinemax) {
+    zskiplist *zsl = zslCreate(mp);
+    int j;
+
+    /* Keep the slots aligned. */
+    inlinemax = (inlinemax+sizeof(void*)-1) & ~(sizeof(void*)-1);
+    zsl->inlinemax = inlinemax;
+    zsl->slab = zmalloc(sizeof(zskiplistSlab));
+    zsl->slab->pages = NULL;
+    for (j = 0; j < ZSKIPLIST_MAXLEVEL; j++) {
+        zsl->slab->cls[j].free = NULL;
+        zsl->slab->cls[j].slotsize = ZSKIPLIST_SLOT_HDR+sizeof(zskiplistNode)+
+            (j+1)*sizeof(struct zskiplistLevel)+inlinemax;
+    }
+    return zsl;
+}
+
 /* Free the specified skiplist node. The referenced SDS string representation
  * of the element is freed too, unless node->ele is set to NULL before calling
- * this function. */
-void zslFreeNode(zskiplistNode *node) {
+ * this function. The elements of inline skiplists are always released. */
+void zslFreeNode(zskiplist *zsl, zskiplistNode *node) {
+    if (zsl->slab) {
+        if (node->ele != zslInlineEle(node, zslSlotLevel(node)))
+            zfree(node->ele);
+        zslSlabFree(zsl->slab, node);
+        return;
+    }
     if (node->ele)
         zfree(node->ele);
     zfree(node);
@@ -80,9 +177,28 @@ void zslFree(zskiplist *zsl) {
     zskiplistNode *node = zsl->header->level[0].forward, *next;
 
     zfree(zsl->header);
+    if (zsl->slab) {
+        void *page = zsl->slab->pages, *nextpage;
+
+        /* Only the elements too large to be inline are not in the pages. */
+        while (node) {
+            next = node->level[0].forward;
+            if (node->ele != zslInlineEle(node, zslSlotLevel(node)))
+                zfree(node->ele);
+            node = next;
+        }
+        while (page) {
+            nextpage = *(void**)page;
+            zfree(page);
+            page = nextpage;
+        }
+        zfree(zsl->slab);
+        zfree(zsl);
+        return;
+    }
     while (node) {
         next = node->level[0].forward;
-        zslFreeNode(node);
+        zslFreeNode(zsl, node);
         node = next;
     }
     zfree(zsl);
@@ -100,13 +216,55 @@ int zslRandomLevel(void) {
     return (level < ZSKIPLIST_MAXLEVEL) ? level : ZSKIPLIST_MAXLEVEL;
 }
 
+/* Link a new node after the nodes update[i] of rank rank[i], found by the
+ * search of the insertion point, and return it. update[] and rank[] are
+ * only valid up to zsl->level. */
+static zskiplistNode *zslInsertAt(zskiplist *zsl, zskiplistNode **update,
+                                  unsigned long *rank, double score, void *ele, size_t size)
+{
+    zskiplistNode *x;
+    int i, level;
+
+    level = zslRandomLevel();
+    if (level > zsl->level) {
+        for (i = zsl->level; i < level; i++) {
+            rank[i] = 0;
+            update[i] = zsl->header;
+            update[i]->level[i].span = zsl->length;
+        }
+        zsl->level = level;
+    }
+    x = zslCreateNode(zsl, level, score, ele, size);
+    for (i = 0; i < level; i++) {
+        x->level[i].forward = update[i]->level[i].forward;
+        update[i]->level[i].forward = x;
+
+        /* update span covered by update[i] as x is inserted here */
+        x->level[i].span = update[i]->level[i].span - (rank[0] - rank[i]);
+        update[i]->level[i].span = (rank[0] - rank[i]) + 1;
+    }
+
+    /* increment span for untouched levels */
+    for (i = level; i < zsl->level; i++) {
+        update[i]->level[i].span++;
+    }
+
+    x->backward = (update[0] == zsl->header) ? NULL : update[0];
+    if (x->level[0].forward)
+        x->level[0].forward->backward = x;
+    else
+        zsl->tail = x;
+    zsl->length++;
+    return x;
+}
+
 /* Insert a new node in the skiplist. Assumes the element does not already
  * exist (up to the caller to enforce that). The skiplist takes ownership
- * of the passed SDS string 'ele'. */
+ * of the passed SDS string 'ele', unless it is inline and copies it. */
 zskiplistNode *zslInsert(zskiplist *zsl, double score, void *ele, size_t size) {
     zskiplistNode *update[ZSKIPLIST_MAXLEVEL], *x;
     unsigned long rank[ZSKIPLIST_MAXLEVEL];
-    int i, level;
+    int i;
 
     /* If it is not a digital terminal */
     assert(!isnan(score));
@@ -128,37 +286,159 @@ zskiplistNode *zslInsert(zskiplist *zsl, double score, void *ele, size_t size) {
      * scores, reinserting the same element should never happen since the
      * caller of zslInsert() should test in the hash table if the element is
      * already inside or not. */
-    level = zslRandomLevel();
-    if (level > zsl->level) {
-        for (i = zsl->level; i < level; i++) {
-            rank[i] = 0;
-            update[i] = zsl->header;
-            update[i]->level[i].span = zsl->length;
+    return zslInsertAt(zsl, update, rank, score, ele, size);
+}
+
+/* Compare two entries in the order of the skiplist. */
+static int zslEntryCmp(zskiplist *zsl, const zskiplistEntry *a, const zskiplistEntry *b) {
+    if (a->score < b->score) return -1;
+    if (a->score > b->score) return 1;
+    return zsl->mcmp(a->ele, b->ele, b->size);
+}
+
+/* Level of the node of rank 'rank' of a balanced skiplist: one more level
+ * for every factor of 4 in the rank, which is what random levels with
+ * P = 1/4 give on average. */
+static int zslBalancedLevel(unsigned long rank) {
+    int level = 1+__builtin_ctzl(rank)/2;
+    return (level < ZSKIPLIST_MAXLEVEL) ? level : ZSKIPLIST_MAXLEVEL;
+}
+
+/* Load 'count' entries, sorted by score then element and without
+ * duplicates, into the empty skiplist 'zsl' in linear time: every node is
+ * appended after the last node of each of its levels, with no search and
+ * no random level. The skiplist is perfectly balanced and its spans are
+ * exact, so zslGetRank() and zslNthInRange() work as after zslInsert().
+ * The skiplist takes ownership of the elements as with zslInsert().
+ *
+ * Returns 0 on success, or -1 without changing anything if the skiplist
+ * is not empty or the entries are not sorted. */
+int zslBulkLoad(zskiplist *zsl, zskiplistEntry *entries, unsigned long count) {
+    zskiplistNode *last[ZSKIPLIST_MAXLEVEL], *x;
+    unsigned long rank[ZSKIPLIST_MAXLEVEL], j;
+    int i, level;
+
+    if (zsl->length != 0) return -1;
+    for (j = 0; j < count; j++) {
+        assert(!isnan(entries[j].score));
+        if (j > 0 && zslEntryCmp(zsl, &entries[j-1], &entries[j]) >= 0)
+            return -1;
+    }
+
+    for (i = 0; i < ZSKIPLIST_MAXLEVEL; i++) {
+        last[i] = zsl->header;
+        rank[i] = 0;
+    }
+    for (j = 0; j < count; j++) {
+        level = zslBalancedLevel(j+1);
+        x = zslCreateNode(zsl, level, entries[j].score, entries[j].ele, entries[j].size);
+        x->backward = (last[0] == zsl->header) ? NULL : last[0];
+        for (i = 0; i < level; i++) {
+            last[i]->level[i].forward = x;
+            last[i]->level[i].span = j+1-rank[i];
+            last[i] = x;
+            rank[i] = j+1;
         }
-        zsl->level = level;
+        if (level > zsl->level) zsl->level = level;
     }
-    x = zslCreateNode(level, score, ele);
-    for (i = 0; i < level; i++) {
-        x->level[i].forward = update[i]->level[i].forward;
-        update[i]->level[i].forward = x;
+    /* The last node of every level spans up to the end of the list. */
+    for (i = 0; i < zsl->level; i++) {
+        last[i]->level[i].forward = NULL;
+        last[i]->level[i].span = count-rank[i];
+    }
+    zsl->tail = count ? last[0] : NULL;
+    zsl->length = count;
+    return 0;
+}
 
-        /* update span covered by update[i] as x is inserted here */
-        x->level[i].span = update[i]->level[i].span - (rank[0] - rank[i]);
-        update[i]->level[i].span = (rank[0] - rank[i]) + 1;
+/* Sort the entries in place in the order of the skiplist, with a bottom up
+ * merge sort, as qsort() can't pass zsl->mcmp to the comparison function.
+ * Input that is already sorted is detected in a single pass. */
+static void zslSortEntries(zskiplist *zsl, zskiplistEntry *entries, unsigned long count) {
+    zskiplistEntry *src = entries, *dst, *tmp, *buf;
+    unsigned long width, lo, mid, hi, a, b, k;
+
+    for (k = 1; k < count; k++)
+        if (zslEntryCmp(zsl, &entries[k-1], &entries[k]) > 0) break;
+    if (k >= count) return;
+
+    dst = buf = zmalloc(sizeof(*entries)*count);
+    for (width = 1; width < count; width *= 2) {
+        for (lo = 0; lo < count; lo += 2*width) {
+            mid = (lo+width < count) ? lo+width : count;
+            hi = (lo+2*width < count) ? lo+2*width : count;
+            a = lo;
+            b = mid;
+            k = lo;
+            while (a < mid && b < hi) {
+                if (zslEntryCmp(zsl, &src[b], &src[a]) < 0) dst[k++] = src[b++];
+                else dst[k++] = src[a++];
+            }
+            while (a < mid) dst[k++] = src[a++];
+            while (b < hi) dst[k++] = src[b++];
+        }
+        tmp = src;
+        src = dst;
+        dst = tmp;
     }
+    if (src != entries) memcpy(entries, src, sizeof(*entries)*count);
+    zfree(buf);
+}
 
-    /* increment span for untouched levels */
-    for (i = level; i < zsl->level; i++) {
-        update[i]->level[i].span++;
+/* Insert 'count' entries, that are sorted in place first. As with
+ * zslInsert(), none of them must already be in the skiplist, nor appear
+ * twice in the batch. An empty skiplist is bulk loaded.
+ *
+ * Otherwise the batch is merged in a single pass: at every level the search
+ * of an entry resumes from where the previous entry was inserted, unless
+ * the level above already got further, instead of starting again from the
+ * header. So each level is walked forward at most once for the whole
+ * batch, and entries close to each other cost a few steps. */
+void zslInsertMany(zskiplist *zsl, zskiplistEntry *entries, unsigned long count) {
+    zskiplistNode *update[ZSKIPLIST_MAXLEVEL], *x;
+    unsigned long rank[ZSKIPLIST_MAXLEVEL], j, r;
+    int i;
+
+    zslSortEntries(zsl, entries, count);
+    if (zsl->length == 0 && zslBulkLoad(zsl, entries, count) == 0) return;
+
+    for (i = 0; i < ZSKIPLIST_MAXLEVEL; i++) {
+        update[i] = zsl->header;
+        rank[i] = 0;
     }
+    for (j = 0; j < count; j++) {
+        double score = entries[j].score;
+        void *ele = entries[j].ele;
+        size_t size = entries[j].size;
+
+        assert(!isnan(score));
+        x = zsl->header;
+        r = 0;
+        for (i = zsl->level-1; i >= 0; i--) {
+            if (rank[i] > r) {
+                x = update[i];
+                r = rank[i];
+            }
+            while (x->level[i].forward &&
+                    (x->level[i].forward->score < score ||
+                        (x->level[i].forward->score == score &&
+                        zsl->mcmp(x->level[i].forward->ele, ele, size) < 0)))
+            {
+                r += x->level[i].span;
+                x = x->level[i].forward;
+            }
+            update[i] = x;
+            rank[i] = r;
+        }
+        x = zslInsertAt(zsl, update, rank, score, ele, size);
 
-    x->backward = (update[0] == zsl->header) ? NULL : update[0];
-    if (x->level[0].forward)
-        x->level[0].forward->backward = x;
-    else
-        zsl->tail = x;
-    zsl->length++;
-    return x;
+        /* The next entry goes after this node, at each of its levels. */
+        r = rank[0]+1;
+        for (i = 0; i < zsl->level && update[i]->level[i].forward == x; i++) {
+            update[i] = x;
+            rank[i] = r;
+        }
+    }
 }
 
 void zslDeleteNode(zskiplist *zsl, zskiplistNode *x, zskiplistNode **update) {
@@ -188,7 +468,7 @@ void zslDeleteNode(zskiplist *zsl, zskiplistNode *x, zskiplistNode **update) {
  * If 'node' is NULL the deleted node is freed by zslFreeNode(), otherwise
  * it is not freed (but just unlinked) and *node is set to the node pointer,
  * so that it is possible for the caller to reuse the node (including the
- * referenced SDS string at node->ele). */
+ * referenced SDS string at node->ele), then to free it with zslFreeNode(). */
 int zslDelete(zskiplist *zsl, double score, void *ele, size_t size, zskiplistNode **node) {
     zskiplistNode *update[ZSKIPLIST_MAXLEVEL], *x;
     int i;
@@ -210,7 +490,7 @@ int zslDelete(zskiplist *zsl, double score, void *ele, size_t size, zskiplistNod
     if (x && score == x->score && zsl->mcmp(x->ele, ele, size) == 0) {
         zslDeleteNode(zsl, x, update);
         if (!node)
-            zslFreeNode(x);
+            zslFreeNode(zsl, x);
         else
             *node = x;
         return 1;
@@ -267,9 +547,9 @@ zskiplistNode *zslUpdateScore(zskiplist *zsl, double curscore, void *ele, size_t
     zslDeleteNode(zsl, x, update);
     zskiplistNode *newnode = zslInsert(zsl, newscore, x->ele, size);
     /* We reused the old node x->ele SDS string, free the node now
-     * since zslInsert created a new one. */
-    x->ele = NULL;
-    zslFreeNode(x);
+     * since zslInsert created a new one. Inline skiplists copied it. */
+    if (zsl->slab == NULL) x->ele = NULL;
+    zslFreeNode(zsl, x);
     return newnode;
 }
 
@@ -397,67 +677,203 @@ zskiplistNode *zslNthInRange(zskiplist *zsl, zrangespec *range, long n) {
     return x;
 }
 
-/* Delete all the elements with score between min and max from the skiplist.
- * Both min and max can be inclusive or exclusive (see range->minex and
- * range->maxex). When inclusive a score >= min && score <= max is deleted.
- * Note that this function takes the reference to the hash table view of the
- * sorted set, in order to remove the elements from the hash table too. */
-unsigned long zslDeleteRangeByScore(zskiplist *zsl, zrangespec *range) {
-    zskiplistNode *update[ZSKIPLIST_MAXLEVEL], *x;
-    unsigned long removed = 0;
+int zslLexValueGteMin(zskiplist *zsl, void *ele, zlexrangespec *spec) {
+    int cmp;
+
+    if (spec->min == NULL) return 1;
+    cmp = zsl->mcmp(ele, spec->min, spec->minlen);
+    return spec->minex ? (cmp > 0) : (cmp >= 0);
+}
+
+int zslLexValueLteMax(zskiplist *zsl, void *ele, zlexrangespec *spec) {
+    int cmp;
+
+    if (spec->max == NULL) return 1;
+    cmp = zsl->mcmp(ele, spec->max, spec->maxlen);
+    return spec->maxex ? (cmp < 0) : (cmp <= 0);
+}
+
+/* A range by score, element or rank, so that the functions below share the
+ * search of its edges. */
+#define ZSL_RANGE_SCORE 0
+#define ZSL_RANGE_LEX 1
+#define ZSL_RANGE_RANK 2
+
+typedef struct zslRange {
+    int type;
+    zrangespec *score;
+    zlexrangespec *lex;
+    unsigned long start, end;   /* 1-based ranks, inclusive. */
+} zslRange;
+
+/* Is the node 'x' of rank 'rank' before the start of the range? */
+static int zslBeforeRange(zskiplist *zsl, zslRange *range, zskiplistNode *x, unsigned long rank) {
+    switch (range->type) {
+    case ZSL_RANGE_SCORE: return !zslValueGteMin(x->score, range->score);
+    case ZSL_RANGE_LEX: return !zslLexValueGteMin(zsl, x->ele, range->lex);
+    default: return rank < range->start;
+    }
+}
+
+/* Is the node 'x' of rank 'rank' not after the end of the range? */
+static int zslNotAfterRange(zskiplist *zsl, zslRange *range, zskiplistNode *x, unsigned long rank) {
+    switch (range->type) {
+    case ZSL_RANGE_SCORE: return zslValueLteMax(x->score, range->score);
+    case ZSL_RANGE_LEX: return zslLexValueLteMax(zsl, x->ele, range->lex);
+    default: return rank <= range->end;
+    }
+}
+
+/* Find the edges of a range at every level: update[i] is the last node of
+ * level i before the range and last[i] the last one not after it, with
+ * their ranks in rank[i] and lastrank[i]. The second search resumes from
+ * the first one instead of starting again from the header. Returns the
+ * number of elements in the range, in O(log(N)) thanks to the spans. */
+static unsigned long zslFindRange(zskiplist *zsl, zslRange *range,
+                                  zskiplistNode **update, unsigned long *rank,
+                                  zskiplistNode **last, unsigned long *lastrank)
+{
+    zskiplistNode *x;
+    unsigned long r = 0;
     int i;
 
     x = zsl->header;
     for (i = zsl->level-1; i >= 0; i--) {
         while (x->level[i].forward &&
-            !zslValueGteMin(x->level[i].forward->score, range))
+               zslBeforeRange(zsl, range, x->level[i].forward, r+x->level[i].span))
+        {
+            r += x->level[i].span;
             x = x->level[i].forward;
+        }
         update[i] = x;
+        rank[i] = r;
     }
 
-    /* Current node is the last with score < or <= min. */
-    x = x->level[0].forward;
-
-    /* Delete nodes while in range. */
-    while (x && zslValueLteMax(x->score, range)) {
-        zskiplistNode *next = x->level[0].forward;
-        zslDeleteNode(zsl, x, update);
-        zslFreeNode(x); /* Here is where x->ele is actually released. */
-        removed++;
-        x = next;
+    x = update[zsl->level-1];
+    r = rank[zsl->level-1];
+    for (i = zsl->level-1; i >= 0; i--) {
+        if (rank[i] > r) {
+            x = update[i];
+            r = rank[i];
+        }
+        while (x->level[i].forward &&
+               zslNotAfterRange(zsl, range, x->level[i].forward, r+x->level[i].span))
+        {
+            r += x->level[i].span;
+            x = x->level[i].forward;
+        }
+        last[i] = x;
+        lastrank[i] = r;
     }
-    return removed;
+    /* With min > max the end is before the start. */
+    return (lastrank[0] > rank[0]) ? lastrank[0]-rank[0] : 0;
 }
 
-/* Delete all the elements with rank between start and end from the skiplist.
- * Start and end are inclusive. Note that start and end need to be 1-based */
-unsigned long zslDeleteRangeByRank(zskiplist *zsl, unsigned int start, unsigned int end) {
-    zskiplistNode *update[ZSKIPLIST_MAXLEVEL], *x;
-    unsigned long traversed = 0, removed = 0;
+/* Delete the elements of a range. The run of nodes between the edges is
+ * unlinked from every level at once, adjusting the spans of the nodes
+ * before it, instead of deleting the nodes one by one. The nodes are then
+ * released: if 'freefn' is not NULL it is called with every element, that
+ * it takes ownership of (the elements of an inline skiplist are released
+ * with their node anyway, after the call). */
+static unsigned long zslDeleteRange(zskiplist *zsl, zslRange *range,
+                                    zslfreefn freefn, void *privdata)
+{
+    zskiplistNode *update[ZSKIPLIST_MAXLEVEL], *last[ZSKIPLIST_MAXLEVEL], *x, *next;
+    unsigned long rank[ZSKIPLIST_MAXLEVEL], lastrank[ZSKIPLIST_MAXLEVEL];
+    unsigned long removed, j;
     int i;
 
-    x = zsl->header;
-    for (i = zsl->level-1; i >= 0; i--) {
-        while (x->level[i].forward && (traversed + x->level[i].span) < start) {
-            traversed += x->level[i].span;
-            x = x->level[i].forward;
+    removed = zslFindRange(zsl, range, update, rank, last, lastrank);
+    if (removed == 0) return 0;
+
+    x = update[0]->level[0].forward;
+    for (i = 0; i < zsl->level; i++) {
+        if (last[i] != update[i]) {
+            /* Skip the run: the span up to the node after it, minus the run. */
+            update[i]->level[i].span = lastrank[i]+last[i]->level[i].span-rank[i]-removed;
+            update[i]->level[i].forward = last[i]->level[i].forward;
+        } else {
+            update[i]->level[i].span -= removed;
         }
-        update[i] = x;
     }
-
-    traversed++;
-    x = x->level[0].forward;
-    while (x && traversed <= end) {
-        zskiplistNode *next = x->level[0].forward;
-        zslDeleteNode(zsl, x, update);
-        zslFreeNode(x);
-        removed++;
-        traversed++;
+    next = update[0]->level[0].forward;
+    if (next)
+        next->backward = (update[0] == zsl->header) ? NULL : update[0];
+    else
+        zsl->tail = (update[0] == zsl->header) ? NULL : update[0];
+    while (zsl->level > 1 && zsl->header->level[zsl->level-1].forward == NULL)
+        zsl->level--;
+    zsl->length -= removed;
+
+    /* The run is still linked at level 0. */
+    for (j = 0; j < removed; j++) {
+        next = x->level[0].forward;
+        if (freefn) {
+            freefn(x->ele, privdata);
+            if (zsl->slab == NULL) x->ele = NULL;
+        }
+        zslFreeNode(zsl, x);
         x = next;
     }
     return removed;
 }
 
+/* Returns the number of elements with a score in the range, in O(log(N)):
+ * the difference of the ranks of the edges of the range. */
+unsigned long zslCountInRange(zskiplist *zsl, zrangespec *range) {
+    zskiplistNode *update[ZSKIPLIST_MAXLEVEL], *last[ZSKIPLIST_MAXLEVEL];
+    unsigned long rank[ZSKIPLIST_MAXLEVEL], lastrank[ZSKIPLIST_MAXLEVEL];
+    zslRange r = { .type = ZSL_RANGE_SCORE, .score = range };
+
+    return zslFindRange(zsl, &r, update, rank, last, lastrank);
+}
+
+/* Like zslCountInRange() for a range of elements. The elements are ordered
+ * by score first, so this only makes sense if all the elements have the
+ * same score, as in the Redis ZLEXCOUNT command. */
+unsigned long zslCountInLexRange(zskiplist *zsl, zlexrangespec *range) {
+    zskiplistNode *update[ZSKIPLIST_MAXLEVEL], *last[ZSKIPLIST_MAXLEVEL];
+    unsigned long rank[ZSKIPLIST_MAXLEVEL], lastrank[ZSKIPLIST_MAXLEVEL];
+    zslRange r = { .type = ZSL_RANGE_LEX, .lex = range };
+
+    return zslFindRange(zsl, &r, update, rank, last, lastrank);
+}
+
+/* Delete all the elements with score between min and max from the skiplist.
+ * Both min and max can be inclusive or exclusive (see range->minex and
+ * range->maxex). When inclusive a score >= min && score <= max is deleted.
+ * 'freefn', if not NULL, is called with every deleted element, for instance
+ * to remove it from the hash table view of the sorted set too, and then
+ * owns it. Returns the number of deleted elements. */
+unsigned long zslDeleteRangeByScore(zskiplist *zsl, zrangespec *range,
+                                    zslfreefn freefn, void *privdata)
+{
+    zslRange r = { .type = ZSL_RANGE_SCORE, .score = range };
+
+    return zslDeleteRange(zsl, &r, freefn, privdata);
+}
+
+/* Delete all the elements in a range of elements, see zslCountInLexRange().
+ * 'freefn' as for zslDeleteRangeByScore(). */
+unsigned long zslDeleteRangeByLex(zskiplist *zsl, zlexrangespec *range,
+                                  zslfreefn freefn, void *privdata)
+{
+    zslRange r = { .type = ZSL_RANGE_LEX, .lex = range };
+
+    return zslDeleteRange(zsl, &r, freefn, privdata);
+}
+
+/* Delete all the elements with rank between start and end from the skiplist.
+ * Start and end are inclusive. Note that start and end need to be 1-based.
+ * 'freefn' as for zslDeleteRangeByScore(). */
+unsigned long zslDeleteRangeByRank(zskiplist *zsl, unsigned long start, unsigned long end,
+                                   zslfreefn freefn, void *privdata)
+{
+    zslRange r = { .type = ZSL_RANGE_RANK, .start = start, .end = end };
+
+    return zslDeleteRange(zsl, &r, freefn, privdata);
+}
+
 /* Find the rank for an element by both score and key.
  * Returns 0 when the element cannot be found, rank otherwise.
  * Note that the rank is 1-based due to the span of zsl->header to the
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fmacros.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <epoch.h>
+#include <atomicvar.h>
+
+/* Reader counters are updated with sequentially consistent operations:
+ * the increment must be ordered before the reads of the epoch and of the
+ * protected data, and the decrement after them. The release of the
+ * decrement is what the writer waiting for the counter to drain acquires
+ * before freeing anything. */
+#define epochReaderIncr(var) __atomic_add_fetch(&var,1,__ATOMIC_SEQ_CST)
+#define epochReaderDecr(var) __atomic_sub_fetch(&var,1,__ATOMIC_SEQ_CST)
+
+/* Every slot lives in its own cache line: readers of different threads
+ * don't share anything but the (read mostly) epoch counter. */
+typedef struct epochSlot {
+    redisAtomic long readers[2]; /* Readers inside the even / odd epoch. */
+    pthread_mutex_t lock;        /* Protects the retired list. */
+    epochNode *retired;
+    unsigned long nretired;
+} __attribute__((aligned(64))) epochSlot;
+
+struct epochDomain {
+    redisAtomic unsigned long epoch;
+    pthread_mutex_t sync_lock; /* Serializes epochSynchronize() */
+    void *privdata;
+    epochSlot slots[EPOCH_SLOTS];
+};
+
+/* Threads are assigned a slot the first time they use any domain. Slots
+ * may be shared by more threads: it only costs some cache line bouncing. */
+static redisAtomic unsigned int epoch_next_slot = 0;
+static __thread int epoch_thread_slot = -1;
+
+static inline epochSlot *_epochThreadSlot(epochDomain *ed) {
+    if (epoch_thread_slot == -1) {
+        unsigned int slot;
+        atomicGetIncr(epoch_next_slot, slot, 1);
+        epoch_thread_slot = slot & (EPOCH_SLOTS-1);
+    }
+    return &ed->slots[epoch_thread_slot];
+}
+
+epochDomain *epochCreate(void *privdata) {
+    epochDomain *ed;
+    int j;
+
+    if (posix_memalign((void**)&ed, 64, sizeof(*ed)) != 0) return NULL;
+    memset(ed, 0, sizeof(*ed));
+    pthread_mutex_init(&ed->sync_lock, NULL);
+    for (j = 0; j < EPOCH_SLOTS; j++)
+        pthread_mutex_init(&ed->slots[j].lock, NULL);
+    ed->privdata = privdata;
+    return ed;
+}
+
+/* Free all the retired objects and the domain. No reader must be active. */
+void epochRelease(epochDomain *ed) {
+    int j;
+
+    epochReclaim(ed, 1);
+    for (j = 0; j < EPOCH_SLOTS; j++)
+        pthread_mutex_destroy(&ed->slots[j].lock);
+    pthread_mutex_destroy(&ed->sync_lock);
+    free(ed);
+}
+
+/* Enter a read side critical section. The returned token must be passed
+ * to epochExit(). Critical sections can be nested.
+ *
+ * The epoch is checked again after publishing the reader: if a writer
+ * flipped it in the meantime the writer may have already found our counter
+ * drained, so we retry in the new epoch. Without this a reader could sit
+ * in the old epoch unnoticed by the next epochSynchronize() call. */
+int epochEnter(epochDomain *ed) {
+    epochSlot *slot = _epochThreadSlot(ed);
+    unsigned long epoch, check;
+    int idx;
+
+    while (1) {
+        atomicGetWithSync(ed->epoch, epoch);
+        idx = epoch & 1;
+        epochReaderIncr(slot->readers[idx]);
+        atomicGetWithSync(ed->epoch, check);
+        if ((int)(check & 1) == idx) return idx;
+        epochReaderDecr(slot->readers[idx]);
+    }
+}
+
+/* Exit a read side critical section. */
+void epochExit(epochDomain *ed, int token) {
+    epochSlot *slot = _epochThreadSlot(ed);
+
+    epochReaderDecr(slot->readers[token]);
+}
+
+/* Wait for a grace period: when this function returns all the readers that
+ * were inside a critical section when it was called have exited. */
+void epochSynchronize(epochDomain *ed) {
+    unsigned long epoch;
+    long readers;
+    int j, idx;
+
+    pthread_mutex_lock(&ed->sync_lock);
+    atomicGetWithSync(ed->epoch, epoch);
+    idx = epoch & 1;
+    atomicSetWithSync(ed->epoch, epoch+1);
+    for (j = 0; j < EPOCH_SLOTS; j++) {
+        while (1) {
+            atomicGetWithSync(ed->slots[j].readers[idx], readers);
+            if (readers == 0) break;
+            sched_yield();
+        }
+    }
+    pthread_mutex_unlock(&ed->sync_lock);
+}
+
+/* Schedule 'node' to be released by 'fn' once no reader can reference it
+ * anymore. The object must already be unreachable for new readers. */
+void epochRetire(epochDomain *ed, epochNode *node, epochFreeFunction *fn) {
+    epochSlot *slot = _epochThreadSlot(ed);
+
+    node->free = fn;
+    pthread_mutex_lock(&slot->lock);
+    node->next = slot->retired;
+    slot->retired = node;
+    slot->nretired++;
+    pthread_mutex_unlock(&slot->lock);
+}
+
+/* Release the objects retired by the calling thread, if they are at least
+ * EPOCH_RECLAIM_THRESHOLD, waiting for a grace period first. If 'force' is
+ * true the objects retired by all the threads are released regardless of
+ * their number. Must be called outside of read side critical sections. */
+void epochReclaim(epochDomain *ed, int force) {
+    epochNode *list = NULL, *node, *next;
+    int j, first, last;
+
+    if (force) {
+        first = 0;
+        last = EPOCH_SLOTS-1;
+    } else {
+        first = last = _epochThreadSlot(ed) - ed->slots;
+    }
+
+    for (j = first; j <= last; j++) {
+        epochSlot *slot = &ed->slots[j];
+
+        pthread_mutex_lock(&slot->lock);
+        if (slot->retired && (force || slot->nretired >= EPOCH_RECLAIM_THRESHOLD)) {
+            /* Concatenate to the list of objects to free. */
+            node = slot->retired;
+            while (node->next) node = node->next;
+            node->next = list;
+            list = slot->retired;
+            slot->retired = NULL;
+            slot->nretired = 0;
+        }
+        pthread_mutex_unlock(&slot->lock);
+    }
+    if (list == NULL) return;
+
+    epochSynchronize(ed);
+    for (node = list; node; node = next) {
+        next = node->next;
+        node->free(node, ed->privdata);
+    }
+}
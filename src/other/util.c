@@ -44,6 +44,8 @@
  * This should be the size of the buffer given to ld2string */
 #define MAX_LONG_DOUBLE_CHARS 5*1024
 
+#include "numtable.h"
+
 /* Glob-style pattern matching. */
 int stringmatchlen(const char *pattern, int patternLen,
         const char *string, int stringLen, int nocase)
@@ -166,6 +168,320 @@ int stringmatchlen(const char *pattern, int patternLen,
     return 0;
 }
 
+/* Return the number of digits of 'v' in base 10. The number of bits gives
+ * the number of digits up to one, fixed by a single comparison. */
+uint32_t digits10(uint64_t v) {
+    static const uint64_t pow10[20] = {
+        1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+        10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+        100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+        100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+        100000000000000000ULL, 1000000000000000000ULL,
+        10000000000000000000ULL
+    };
+    uint32_t t;
+
+    v |= 1; /* Zero has one digit, and clz(0) is undefined. */
+    t = ((64-__builtin_clzll(v))*1233) >> 12;
+    return t - (v < pow10[t]) + 1;
+}
+
+/* Convert an unsigned long long into a string, two digits at a time from
+ * a table. Returns the number of characters needed to represent the number,
+ * or 0 if the buffer 'dst' of 'dstlen' bytes is too small (the null term
+ * included), in which case 'dst' is set to an empty string if possible. */
+int ull2string(char *dst, size_t dstlen, unsigned long long value) {
+    static const char digits[201] =
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    uint32_t length = digits10(value), next;
+
+    if (length >= dstlen) {
+        if (dstlen > 0) dst[0] = '\0';
+        return 0;
+    }
+
+    next = length-1;
+    dst[length] = '\0';
+    while (value >= 100) {
+        int const i = (value % 100) * 2;
+
+        value /= 100;
+        dst[next] = digits[i+1];
+        dst[next-1] = digits[i];
+        next -= 2;
+    }
+    if (value < 10) {
+        dst[next] = '0' + (uint32_t)value;
+    } else {
+        int i = (uint32_t)value * 2;
+
+        dst[next] = digits[i+1];
+        dst[next-1] = digits[i];
+    }
+    return length;
+}
+
+/* Like ull2string() but for signed long long values. */
+int ll2string(char *dst, size_t dstlen, long long svalue) {
+    unsigned long long value;
+    int negative = svalue < 0, length;
+
+    /* The absolute value of LLONG_MIN doesn't fit a long long. */
+    value = negative ? (unsigned long long)(-(svalue+1))+1 : (unsigned long long)svalue;
+    if (negative) {
+        if (dstlen < 2) {
+            if (dstlen > 0) dst[0] = '\0';
+            return 0;
+        }
+        dst[0] = '-';
+        dst++;
+        dstlen--;
+    }
+    length = ull2string(dst, dstlen, value);
+    if (length == 0) {
+        if (negative) dst[-1] = '\0';
+        return 0;
+    }
+    return length+negative;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+/* Parsing of 8 digits at a time, in the bytes of a 64 bit word. */
+#define HAVE_SWAR_DIGITS 1
+
+static inline int _isEightDigits(const char *p) {
+    uint64_t v;
+
+    memcpy(&v, p, 8);
+    return !(((v + 0x4646464646464646ULL) | (v - 0x3030303030303030ULL)) &
+             0x8080808080808080ULL);
+}
+
+static inline uint64_t _parseEightDigits(const char *p) {
+    uint64_t v;
+
+    memcpy(&v, p, 8);
+    v -= 0x3030303030303030ULL;
+    v = (v * 10) + (v >> 8);
+    return (((v & 0x000000FF000000FFULL) * 0x000F424000000064ULL) +
+            (((v >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >> 32;
+}
+#endif
+
+/* Parse the 'slen' digits at 's' into '*value'. Return 0 if a byte isn't
+ * a digit or on overflow. */
+static int _parseDigits(const char *s, size_t slen, unsigned long long *value) {
+    unsigned long long v = 0;
+    size_t j = 0;
+
+    if (slen > 20) return 0;
+#ifdef HAVE_SWAR_DIGITS
+    for (; j+8 <= slen && j+8 <= 19; j += 8) {
+        if (!_isEightDigits(s+j)) return 0;
+        v = v*100000000 + _parseEightDigits(s+j);
+    }
+#endif
+    /* Up to 19 digits can't overflow. */
+    for (; j < slen && j < 19; j++) {
+        if (s[j] < '0' || s[j] > '9') return 0;
+        v = v*10 + (s[j]-'0');
+    }
+    if (j < slen) {
+        if (s[j] < '0' || s[j] > '9') return 0;
+        if (v > (ULLONG_MAX-(s[j]-'0'))/10) return 0;
+        v = v*10 + (s[j]-'0');
+    }
+    *value = v;
+    return 1;
+}
+
+/* Convert a string into an unsigned long long. Returns 1 if the string
+ * could be parsed into a (non-overflowing) unsigned long long, 0 otherwise.
+ * Only the canonical representation is accepted: no spaces, no sign and
+ * no leading zeros. The value will be set to the parsed value when
+ * appropriate. */
+int string2ull(const char *s, size_t slen, unsigned long long *value) {
+    unsigned long long v;
+
+    if (slen == 0 || (s[0] == '0' && slen > 1)) return 0;
+    if (!_parseDigits(s, slen, &v)) return 0;
+    if (value) *value = v;
+    return 1;
+}
+
+/* Like string2ull() but for long long values, a leading '-' is accepted
+ * ("-0" is not). */
+int string2ll(const char *s, size_t slen, long long *value) {
+    unsigned long long v;
+    int negative = 0;
+
+    if (slen > 0 && s[0] == '-') {
+        negative = 1;
+        s++;
+        slen--;
+        if (slen == 1 && s[0] == '0') return 0;
+    }
+    if (!string2ull(s, slen, &v)) return 0;
+    if (negative) {
+        if (v > (unsigned long long)LLONG_MAX+1) return 0;
+        if (value) *value = v ? -(long long)(v-1)-1 : 0;
+    } else {
+        if (v > LLONG_MAX) return 0;
+        if (value) *value = v;
+    }
+    return 1;
+}
+
+/* Eisel-Lemire (Daniel Lemire, "Number Parsing at a Gigabyte per Second",
+ * 2021): compute the double nearest to 'w' * 10^'q' from the 128 bit
+ * product of 'w' by an approximation of 5^q. Return 0 in the rare cases
+ * the truncated product can't tell how to round, and for subnormals. */
+static int _s2dEiselLemire(uint64_t w, int q, int negative, double *dp) {
+    const uint64_t *pow5 = s2dPow5[q-S2D_SMALLEST_POW10];
+    int64_t exponent = (((152170 + 65536) * (int64_t)q) >> 16) + 1024 + 63;
+    int lz = __builtin_clzll(w);
+    unsigned __int128 product;
+    uint64_t upper, lower, upperbit, mantissa, bits;
+
+    w <<= lz;
+    product = (unsigned __int128)w * pow5[0];
+    lower = (uint64_t)product;
+    upper = (uint64_t)(product >> 64);
+    if ((upper & 0x1FF) == 0x1FF && lower + w < lower) {
+        /* The low word of the power of 5 may carry into the bits used. */
+        unsigned __int128 product2 = (unsigned __int128)w * pow5[1];
+        uint64_t middle = lower + (uint64_t)(product2 >> 64);
+
+        if (middle < lower) upper++;
+        if (middle + 1 == 0 && (upper & 0x1FF) == 0x1FF &&
+            (uint64_t)product2 + w < (uint64_t)product2) return 0;
+        lower = middle;
+    }
+    upperbit = upper >> 63;
+    mantissa = upper >> (upperbit + 9);
+    lz += (int)(1 ^ upperbit);
+    /* Exactly halfway between two doubles, round to even is unknown. */
+    if (lower == 0 && (upper & 0x1FF) == 0 && (mantissa & 3) == 1) return 0;
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (1ULL << 53)) {
+        mantissa = 1ULL << 52;
+        lz--;
+    }
+    mantissa &= ~(1ULL << 52);
+    exponent -= lz;
+    if (exponent < 1 || exponent > 2046) return 0;
+    bits = mantissa | ((uint64_t)exponent << 52) | ((uint64_t)negative << 63);
+    memcpy(dp, &bits, sizeof(*dp));
+    return 1;
+}
+
+/* Convert a string into a double. Returns 1 if the whole string could be
+ * parsed into a finite or infinite number, 0 otherwise (NaN, spaces,
+ * overflows and underflows, trailing characters...).
+ *
+ * Decimal numbers with up to 19 significant digits are converted without
+ * strtod(): with a single multiplication or division when both the digits
+ * and the power of 10 are exact doubles, otherwise with Eisel-Lemire.
+ * Longer numbers, subnormals and the rare ambiguous cases go to strtod(). */
+int string2d(const char *s, size_t slen, double *dp) {
+    static const double pow10[23] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    char buf[MAX_LONG_DOUBLE_CHARS], *eptr;
+    const char *p = s, *end = s+slen, *start;
+    unsigned long long mantissa = 0;
+    int negative = 0, sigdigits = 0, ndigits = 0, exp10 = 0, frac = 0;
+    double value;
+
+    if (slen == 0 || slen >= sizeof(buf)) return 0;
+    if (*p == '-' || *p == '+') negative = *p++ == '-';
+    for (start = p; p < end; p++) {
+        if (*p == '.' && !frac) {
+            frac = 1;
+            continue;
+        }
+        if (*p < '0' || *p > '9') break;
+        ndigits++;
+        if (mantissa == 0 && *p == '0') {
+            exp10 -= frac;
+        } else if (sigdigits < 19) {
+            mantissa = mantissa*10 + (*p-'0');
+            sigdigits++;
+            exp10 -= frac;
+        } else {
+            goto slowpath; /* Too many digits to be exact. */
+        }
+    }
+    if (ndigits == 0) goto slowpath;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        int expneg = 0, e = 0;
+
+        if (++p < end && (*p == '-' || *p == '+')) expneg = *p++ == '-';
+        for (start = p; p < end && *p >= '0' && *p <= '9'; p++)
+            if (e < 10000) e = e*10 + (*p-'0');
+        if (p == start) goto slowpath;
+        exp10 += expneg ? -e : e;
+    }
+    if (p != end) goto slowpath;
+
+    if (mantissa == 0) {
+        value = 0;
+    } else if (mantissa <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+        value = (double)mantissa;
+        if (exp10 < 0) value /= pow10[-exp10];
+        else value *= pow10[exp10];
+    } else if (exp10 < S2D_SMALLEST_POW10 || exp10 > S2D_LARGEST_POW10 ||
+               !_s2dEiselLemire(mantissa, exp10, negative, &value)) {
+        goto slowpath;
+    } else {
+        if (dp) *dp = value;
+        return 1;
+    }
+    if (dp) *dp = negative ? -value : value;
+    return 1;
+
+slowpath:
+    if (isspace((unsigned char)s[0])) return 0;
+    memcpy(buf, s, slen);
+    buf[slen] = '\0';
+    errno = 0;
+    value = strtod(buf, &eptr);
+    if ((size_t)(eptr-buf) != slen ||
+        (errno == ERANGE &&
+            (value == HUGE_VAL || value == -HUGE_VAL || fpclassify(value) == FP_ZERO)) ||
+        isnan(value))
+        return 0;
+    if (dp) *dp = value;
+    return 1;
+}
+
+/* Parse the optionally negative decimal number of 'len' bytes at 'p', that
+ * may have leading zeros unlike string2ll(). */
+static int _memtollDigits(const char *p, size_t len, long long *value) {
+    unsigned long long v = 0;
+    int negative = 0;
+
+    if (len && *p == '-') {
+        negative = 1;
+        p++;
+        len--;
+    }
+    while (len > 1 && *p == '0') {
+        p++;
+        len--;
+    }
+    if (len == 0 || !_parseDigits(p, len, &v)) return 0;
+    if (v > (unsigned long long)LLONG_MAX+negative) return 0;
+    *value = negative ? (v ? -(long long)(v-1)-1 : 0) : (long long)v;
+    return 1;
+}
+
 /* Convert a string representing an amount of memory into the number of
  * bytes, so for instance memtoll("1Gb") will return 1073741824 that is
  * (1024*1024*1024).
@@ -175,10 +491,9 @@ int stringmatchlen(const char *pattern, int patternLen,
  * fact 'err' is NULL or not. */
 long long memtoll(const char *p, int *err) {
     const char *u;
-    char buf[128];
     long mul; /* unit multiplier */
     long long val;
-    unsigned int digits;
+    size_t digits;
 
     if (err) *err = 0;
 
@@ -205,23 +520,262 @@ long long memtoll(const char *p, int *err) {
         return 0;
     }
 
-    /* Copy the digits into a buffer, we'll use strtoll() to convert
-     * the digit (without the unit) into a number. */
+    /* Parse the digits in place, leading zeros included. */
     digits = u-p;
-    if (digits >= sizeof(buf)) {
+    if (!_memtollDigits(p, digits, &val) || val > LLONG_MAX/mul || val < LLONG_MIN/mul) {
         if (err) *err = 1;
         return 0;
     }
-    memcpy(buf, p, digits);
-    buf[digits] = '\0';
+    return val*mul;
+}
 
-    char *endptr;
-    val = strtoll(buf, &endptr, 10);
-    if ((val == 0 && errno == EINVAL) || *endptr != '\0') {
-        if (err) *err = 1;
+/* ----------------------- Shortest double to string -----------------------
+ * d2string() implements Ryu (Ulf Adams, "Ryu: fast float-to-string
+ * conversion", PLDI 2018): the interval of the decimal numbers rounding to
+ * the double is computed with 128 bit multiplications by precomputed powers
+ * of 5, then digits are removed while both bounds stay distinct, which gives
+ * the shortest representation that parses back to the same double, and the
+ * closest to the exact value among them. */
+
+#define D2S_MANTISSA_BITS 52
+#define D2S_EXPONENT_BITS 11
+#define D2S_BIAS 1023
+
+static inline uint32_t _d2sPow5bits(int32_t e) {
+    return (uint32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+static inline uint32_t _d2sLog10Pow2(int32_t e) {
+    return ((uint32_t)e * 78913) >> 18;
+}
+
+static inline uint32_t _d2sLog10Pow5(int32_t e) {
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+static inline uint32_t _d2sPow5Factor(uint64_t v) {
+    uint32_t count = 0;
+
+    while (v % 5 == 0) {
+        v /= 5;
+        count++;
+    }
+    return count;
+}
+
+static inline int _d2sMultipleOfPowerOf5(uint64_t v, uint32_t p) {
+    return _d2sPow5Factor(v) >= p;
+}
+
+static inline int _d2sMultipleOfPowerOf2(uint64_t v, uint32_t p) {
+    return (v & ((1ULL << p)-1)) == 0;
+}
+
+static inline uint64_t _d2sMulShift(uint64_t m, const uint64_t *mul, int32_t j) {
+    unsigned __int128 b0 = (unsigned __int128)m * mul[0];
+    unsigned __int128 b2 = (unsigned __int128)m * mul[1];
+
+    return (uint64_t)(((b0 >> 64) + b2) >> (j-64));
+}
+
+/* Compute the shortest decimal 'output' * 10^'exp10' of the positive finite
+ * double with the given IEEE fields. */
+static void _d2sShortest(uint64_t ieeeMantissa, uint32_t ieeeExponent,
+                         uint64_t *output, int32_t *exp10)
+{
+    int32_t e2, e10;
+    uint64_t m2, mv, vr, vp, vm;
+    uint32_t mmShift;
+    int even, vmIsTrailingZeros = 0, vrIsTrailingZeros = 0;
+    int32_t removed = 0;
+    uint8_t lastRemovedDigit = 0;
+
+    if (ieeeExponent == 0) {
+        e2 = 1 - D2S_BIAS - D2S_MANTISSA_BITS - 2;
+        m2 = ieeeMantissa;
+    } else {
+        e2 = (int32_t)ieeeExponent - D2S_BIAS - D2S_MANTISSA_BITS - 2;
+        m2 = (1ULL << D2S_MANTISSA_BITS) | ieeeMantissa;
+    }
+    even = (m2 & 1) == 0;
+
+    /* The interval of the numbers rounding to the double is [vm, vp],
+     * the bounds included when the mantissa is even. */
+    mv = 4 * m2;
+    mmShift = ieeeMantissa != 0 || ieeeExponent <= 1;
+
+    if (e2 >= 0) {
+        uint32_t q = _d2sLog10Pow2(e2) - (e2 > 3);
+        int32_t k = D2S_POW5_INV_BITCOUNT + _d2sPow5bits(q) - 1;
+        int32_t i = -e2 + (int32_t)q + k;
+
+        e10 = (int32_t)q;
+        vr = _d2sMulShift(4*m2, d2sPow5InvSplit[q], i);
+        vp = _d2sMulShift(4*m2+2, d2sPow5InvSplit[q], i);
+        vm = _d2sMulShift(4*m2-1-mmShift, d2sPow5InvSplit[q], i);
+        if (q <= 21) {
+            /* Only one of mp, mv and mm can be a multiple of 5, if any. */
+            if (mv % 5 == 0) {
+                vrIsTrailingZeros = _d2sMultipleOfPowerOf5(mv, q);
+            } else if (even) {
+                vmIsTrailingZeros = _d2sMultipleOfPowerOf5(mv-1-mmShift, q);
+            } else {
+                vp -= _d2sMultipleOfPowerOf5(mv+2, q);
+            }
+        }
+    } else {
+        uint32_t q = _d2sLog10Pow5(-e2) - (-e2 > 1);
+        int32_t i = -e2 - (int32_t)q;
+        int32_t k = _d2sPow5bits(i) - D2S_POW5_BITCOUNT;
+        int32_t j = (int32_t)q - k;
+
+        e10 = (int32_t)q + e2;
+        vr = _d2sMulShift(4*m2, d2sPow5Split[i], j);
+        vp = _d2sMulShift(4*m2+2, d2sPow5Split[i], j);
+        vm = _d2sMulShift(4*m2-1-mmShift, d2sPow5Split[i], j);
+        if (q <= 1) {
+            /* mv = 4 * m2 has at least 2 trailing zero bits. */
+            vrIsTrailingZeros = 1;
+            if (even) {
+                vmIsTrailingZeros = mmShift == 1;
+            } else {
+                vp--;
+            }
+        } else if (q < 63) {
+            vrIsTrailingZeros = _d2sMultipleOfPowerOf2(mv, q);
+        }
+    }
+
+    if (vmIsTrailingZeros || vrIsTrailingZeros) {
+        /* Rare case: the bounds or the value may be exact decimals, which
+         * matters for the inclusion of vm and for rounding half to even. */
+        while (vp / 10 > vm / 10) {
+            vmIsTrailingZeros &= vm % 10 == 0;
+            vrIsTrailingZeros &= lastRemovedDigit == 0;
+            lastRemovedDigit = (uint8_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vmIsTrailingZeros) {
+            while (vm % 10 == 0) {
+                vrIsTrailingZeros &= lastRemovedDigit == 0;
+                lastRemovedDigit = (uint8_t)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0)
+            lastRemovedDigit = 4;
+        *output = vr + ((vr == vm && (!even || !vmIsTrailingZeros)) ||
+                        lastRemovedDigit >= 5);
+    } else {
+        /* Common case: two digits at a time while it's possible. */
+        int roundUp = 0;
+
+        if (vp / 100 > vm / 100) {
+            roundUp = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            roundUp = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        *output = vr + (vr == vm || roundUp);
+    }
+    *exp10 = e10 + removed;
+}
+
+/* Convert a double into the shortest string that parses back to the same
+ * double, like "0.1", "1e+100" or "-1.2345678901234567e-300". The decimal
+ * notation is used for exponents from -4 to 16, as "%.17g" would, and
+ * "inf", "-inf" and "nan" for the special values.
+ *
+ * Returns the length of the string, or 0 if the buffer 'buf' of 'len'
+ * bytes is too small, MAX_D2STRING_CHARS bytes always suffice. */
+int d2string(char *buf, size_t len, double value) {
+    char digits[24], tmp[MAX_D2STRING_CHARS], *p = tmp;
+    uint64_t bits, ieeeMantissa, output;
+    uint32_t ieeeExponent;
+    int32_t exp10, sciexp;
+    int ndigits, l;
+
+    memcpy(&bits, &value, sizeof(bits));
+    ieeeMantissa = bits & ((1ULL << D2S_MANTISSA_BITS)-1);
+    ieeeExponent = (uint32_t)((bits >> D2S_MANTISSA_BITS) & ((1u << D2S_EXPONENT_BITS)-1));
+    if (bits >> 63) *p++ = '-';
+
+    if (ieeeExponent == ((1u << D2S_EXPONENT_BITS)-1)) {
+        if (ieeeMantissa) {
+            p = tmp;
+            memcpy(p, "nan", 3);
+        } else {
+            memcpy(p, "inf", 3);
+        }
+        p += 3;
+    } else if (ieeeExponent == 0 && ieeeMantissa == 0) {
+        *p++ = '0';
+    } else {
+        _d2sShortest(ieeeMantissa, ieeeExponent, &output, &exp10);
+        ndigits = ull2string(digits, sizeof(digits), output);
+        sciexp = exp10 + ndigits - 1;
+
+        if (sciexp >= -4 && sciexp < 17) {
+            if (sciexp < 0) {
+                /* 0.000ddd */
+                *p++ = '0';
+                *p++ = '.';
+                memset(p, '0', -sciexp-1);
+                p += -sciexp-1;
+                memcpy(p, digits, ndigits);
+                p += ndigits;
+            } else if (sciexp+1 >= ndigits) {
+                /* ddd000 */
+                memcpy(p, digits, ndigits);
+                p += ndigits;
+                memset(p, '0', sciexp+1-ndigits);
+                p += sciexp+1-ndigits;
+            } else {
+                /* dd.ddd */
+                memcpy(p, digits, sciexp+1);
+                p += sciexp+1;
+                *p++ = '.';
+                memcpy(p, digits+sciexp+1, ndigits-sciexp-1);
+                p += ndigits-sciexp-1;
+            }
+        } else {
+            /* d.ddde+XX, with at least two digits of exponent like printf. */
+            *p++ = digits[0];
+            if (ndigits > 1) {
+                *p++ = '.';
+                memcpy(p, digits+1, ndigits-1);
+                p += ndigits-1;
+            }
+            *p++ = 'e';
+            *p++ = sciexp < 0 ? '-' : '+';
+            if (sciexp < 0) sciexp = -sciexp;
+            if (sciexp < 10) *p++ = '0';
+            p += ull2string(p, 4, sciexp);
+        }
+    }
+
+    l = p-tmp;
+    if ((size_t)l >= len) {
+        if (len > 0) buf[0] = '\0';
         return 0;
     }
-    return val*mul;
+    memcpy(buf, tmp, l);
+    buf[l] = '\0';
+    return l;
 }
 
 /* Return the UNIX time in microseconds */
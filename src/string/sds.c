@@ -35,7 +35,10 @@
 #include <assert.h>
 #include <limits.h>
 #include <sds.h>
+#include <strsimd.h>
+#include <util.h>
 #include <zmalloc.h>
+#include <atomicvar.h>
 
 #define s_malloc zmalloc
 #define s_realloc zrealloc
@@ -75,35 +78,83 @@ static inline char sdsReqType(size_t string_size) {
 #endif
 }
 
-/* Create a new sds string with the content specified by the 'init' pointer
- * and 'initlen'.
- * If NULL is used for 'init' the string is initialized with zero bytes.
- * If SDS_NOINIT is used, the buffer is left uninitialized;
- *
- * The string is always null-termined (all the sds strings are, always) so
- * even if you create an sds string with:
- *
- * mystring = sdsnewlen("abc",3);
- *
- * You can print the string with printf() as there is an implicit \0 at the
- * end of the string. However the string is binary safe and can contain
- * \0 characters in the middle, as the length is stored in the sds header. */
-sds sdsnewlen(const void *init, size_t initlen) {
+/* Strings allocated from a mem_pool_t have SDS_POOL_FLAG set in their
+ * flags, and the pool stored just before the header. They are never of
+ * type 5, which keeps the length in the bits of the flag. */
+#define sdsIsPool(s) \
+    (((s)[-1] & SDS_TYPE_MASK) != SDS_TYPE_5 && ((s)[-1] & SDS_POOL_FLAG))
+#define sdsPoolSlot(s) ((mem_pool_t**)((s)-sdsHdrSize((s)[-1]))-1)
+#define sdsPoolAllocSize(hdrlen,alloc) (sizeof(mem_pool_t*)+(hdrlen)+(alloc)+1)
+
+/* Allocate 'size' bytes, the header included, from 'pool'. */
+static void *sdsPoolAlloc(mem_pool_t *pool, size_t size) {
+    mem_pool_t **slot = mem_palloc(pool, sizeof(mem_pool_t*)+size);
+
+    if (slot == NULL) return NULL;
+    *slot = pool;
+    return slot+1;
+}
+
+/* Give the memory of a pool string back to its pool, which is only
+ * possible for the allocations too big for the blocks of the pool. The
+ * others are released by mem_reset_pool(). */
+static void sdsPoolRelease(sds s) {
+    mem_pool_t **slot = sdsPoolSlot(s);
+
+    if (sdsPoolAllocSize(sdsHdrSize(s[-1]), sdsalloc(s)) > (*slot)->max)
+        mem_pfree(*slot, slot);
+}
+
+/* If the pool string 's' is the last allocation of a block of its pool,
+ * return the block, so that the allocation can be resized in place. */
+static mem_pool_t *sdsPoolLastBlock(sds s) {
+    mem_pool_t **slot = sdsPoolSlot(s), *p;
+    size_t size = sdsPoolAllocSize(sdsHdrSize(s[-1]), sdsalloc(s));
+    u_char *end = (u_char*)slot+size;
+
+    if (size > (*slot)->max) return NULL;
+    for (p = (*slot)->current; p; p = p->d.next) {
+        if (p->d.last == end) return p;
+    }
+    return NULL;
+}
+
+/* Shared strings have SDS_SHARED_FLAG set in their flags, and an atomic
+ * reference count stored just before the header. They are never of type 5
+ * either, and never allocated from a pool. */
+#define sdsIsShared(s) \
+    (((s)[-1] & SDS_TYPE_MASK) != SDS_TYPE_5 && ((s)[-1] & SDS_SHARED_FLAG))
+#define sdsSharedRefs(s) (*((redisAtomic long*)((s)-sdsHdrSize((s)[-1]))-1))
+
+/* Create a string from the heap, a pool if 'pool' is not NULL, or a shared
+ * string if 'shared' is not zero. */
+static sds _sdsnewlen(mem_pool_t *pool, int shared, const void *init, size_t initlen) {
     void *sh;
     sds s;
     char type = sdsReqType(initlen);
     /* Empty strings are usually created in order to append. Use type 8
-     * since type 5 is not good at this. */
-    if (type == SDS_TYPE_5 && initlen == 0) type = SDS_TYPE_8;
+     * since type 5 is not good at this. Pool and shared strings need the 5
+     * unused bits of the flags of the other types. */
+    if (type == SDS_TYPE_5 && (initlen == 0 || pool || shared)) type = SDS_TYPE_8;
     int hdrlen = sdsHdrSize(type);
     unsigned char *fp; /* flags pointer. */
 
-    sh = s_malloc(hdrlen+initlen+1);
+    if (pool) {
+        sh = sdsPoolAlloc(pool, hdrlen+initlen+1);
+    } else if (shared) {
+        redisAtomic long *refs = s_malloc(sizeof(long)+hdrlen+initlen+1);
+
+        if (refs == NULL) return NULL;
+        atomicSet(*refs, 1);
+        sh = refs+1;
+    } else {
+        sh = s_malloc(hdrlen+initlen+1);
+    }
+    if (sh == NULL) return NULL;
     if (init == SDS_NOINIT)
         init = NULL;
     else if (!init)
         memset(sh, 0, hdrlen+initlen+1);
-    if (sh == NULL) return NULL;
     s = (char*)sh+hdrlen;
     fp = ((unsigned char*)s)-1;
     switch (type) {
@@ -140,12 +191,119 @@ sds sdsnewlen(const void *init, size_t initlen) {
             break;
         }
     }
+    if (pool) *fp |= SDS_POOL_FLAG;
+    if (shared) *fp |= SDS_SHARED_FLAG;
     if (initlen && init)
         memcpy(s, init, initlen);
     s[initlen] = '\0';
     return s;
 }
 
+/* Create a new sds string with the content specified by the 'init' pointer
+ * and 'initlen'.
+ * If NULL is used for 'init' the string is initialized with zero bytes.
+ * If SDS_NOINIT is used, the buffer is left uninitialized;
+ *
+ * The string is always null-termined (all the sds strings are, always) so
+ * even if you create an sds string with:
+ *
+ * mystring = sdsnewlen("abc",3);
+ *
+ * You can print the string with printf() as there is an implicit \0 at the
+ * end of the string. However the string is binary safe and can contain
+ * \0 characters in the middle, as the length is stored in the sds header. */
+sds sdsnewlen(const void *init, size_t initlen) {
+    return _sdsnewlen(NULL, 0, init, initlen);
+}
+
+/* Like sdsnewlen(), but the string is allocated from 'pool'. All the
+ * following operations on the string keep it in the pool, so the memory of
+ * the strings of a pool is released at once by mem_reset_pool() or
+ * mem_destroy_pool(), the strings becoming invalid. sdsfree() is optional
+ * and only gives back the strings too big for the blocks of the pool.
+ *
+ * Growing a pool string is done in place while it is the last allocation
+ * of its block, otherwise it is copied to a new allocation of the pool. */
+sds sdsnewlen_pool(mem_pool_t *pool, const void *init, size_t initlen) {
+    return _sdsnewlen(pool, 0, init, initlen);
+}
+
+/* Like sdsnew() and sdsempty(), but the string is allocated from 'pool'. */
+sds sdsnew_pool(mem_pool_t *pool, const char *init) {
+    size_t initlen = (init == NULL) ? 0 : strlen(init);
+    return _sdsnewlen(pool, 0, init, initlen);
+}
+
+sds sdsempty_pool(mem_pool_t *pool) {
+    return _sdsnewlen(pool, 0, "", 0);
+}
+
+/* Like sdsnewlen(), but create a shared string: an immutable string with
+ * a reference count, so that sdsdup() only increments the count and
+ * returns the same pointer, and sdsfree() decrements it, freeing the
+ * string when it drops to zero. The count is atomic, so the references of
+ * a shared string can be duplicated and freed from different threads.
+ *
+ * The functions returning the modified string copy a shared string to a
+ * new private string the first time they modify it (copy on write), the
+ * reference they were given being released. The functions modifying the
+ * string in place (sdsrange(), sdstolower(), sdsIncrLen()...) can't do it:
+ * call sdsunshare() before them. */
+sds sdsnewlen_shared(const void *init, size_t initlen) {
+    return _sdsnewlen(NULL, 1, init, initlen);
+}
+
+/* Like sdsnew(), but create a shared string, see sdsnewlen_shared(). */
+sds sdsnew_shared(const char *init) {
+    size_t initlen = (init == NULL) ? 0 : strlen(init);
+    return _sdsnewlen(NULL, 1, init, initlen);
+}
+
+/* Turn 's' into a shared string. 's' is released and must be replaced by
+ * the returned string, unless it was already shared. */
+sds sdsshare(sds s) {
+    sds shared;
+
+    if (sdsIsShared(s)) return s;
+    shared = _sdsnewlen(NULL, 1, s, sdslen(s));
+    if (shared == NULL) return NULL;
+    sdsfree(s);
+    return shared;
+}
+
+/* Return a private (not shared) string with the content of 's', that can
+ * be modified in any way. If 's' is shared, its reference is released and
+ * the content copied, otherwise 's' itself is returned. */
+sds sdsunshare(sds s) {
+    sds private;
+
+    if (!sdsIsShared(s)) return s;
+    private = sdsnewlen(s, sdslen(s));
+    if (private == NULL) return NULL;
+    sdsfree(s);
+    return private;
+}
+
+/* Return the number of references of the shared string 's', or 1 if 's'
+ * is not shared. */
+long sdsrefcount(const sds s) {
+    long refs;
+
+    if (!sdsIsShared(s)) return 1;
+    atomicGet(sdsSharedRefs(s), refs);
+    return refs;
+}
+
+/* Return non zero if 's' is a shared string. */
+int sdsisshared(const sds s) {
+    return sdsIsShared(s);
+}
+
+/* Return the pool 's' was allocated from, or NULL. */
+mem_pool_t *sdsPool(const sds s) {
+    return sdsIsPool(s) ? *sdsPoolSlot(s) : NULL;
+}
+
 /* Create an empty (zero length) sds string. Even in this case the string
  * always has an implicit null term. */
 sds sdsempty(void) {
@@ -158,14 +316,30 @@ sds sdsnew(const char *init) {
     return sdsnewlen(init, initlen);
 }
 
-/* Duplicate an sds string. */
+/* Duplicate an sds string, in the same pool if 's' is a pool string.
+ * Shared strings are not copied, a new reference is returned instead. */
 sds sdsdup(const sds s) {
-    return sdsnewlen(s, sdslen(s));
+    if (sdsIsShared(s)) {
+        atomicIncr(sdsSharedRefs(s), 1);
+        return s;
+    }
+    return _sdsnewlen(sdsPool(s), 0, s, sdslen(s));
 }
 
 /* Free an sds string. No operation is performed if 's' is NULL. */
 void sdsfree(sds s) {
     if (s == NULL) return;
+    if (sdsIsPool(s)) {
+        sdsPoolRelease(s);
+        return;
+    }
+    if (sdsIsShared(s)) {
+        long refs;
+
+        atomicDecrGetWithSync(sdsSharedRefs(s), refs, 1);
+        if (refs == 0) s_free(&sdsSharedRefs(s));
+        return;
+    }
     s_free((char*)s-sdsHdrSize(s[-1]));
 }
 
@@ -184,6 +358,7 @@ void sdsfree(sds s) {
  * the output will be "6" as the string was modified but the logical length
  * remains 6 bytes. */
 void sdsupdatelen(sds s) {
+    assert(sdsrefcount(s) == 1);
     size_t reallen = strlen(s);
     sdssetlen(s, reallen);
 }
@@ -193,10 +368,40 @@ void sdsupdatelen(sds s) {
  * so that next append operations will not require allocations up to the
  * number of bytes previously available. */
 void sdsclear(sds s) {
+    assert(sdsrefcount(s) == 1);
     sdssetlen(s, 0);
     s[0] = '\0';
 }
 
+/* Move the pool string 's' to an allocation of its pool with a header of
+ * 'type' and room for 'newlen' bytes, unless it can be grown in place. */
+static sds sdsPoolResize(sds s, char type, size_t newlen) {
+    mem_pool_t *pool = sdsPool(s), *block;
+    size_t len = sdslen(s), size = sdsPoolAllocSize(sdsHdrSize(type), newlen);
+    u_char *start = (u_char*)sdsPoolSlot(s);
+    void *newsh;
+    sds news;
+
+    if ((s[-1] & SDS_TYPE_MASK) == type && size <= pool->max &&
+        (block = sdsPoolLastBlock(s)) != NULL &&
+        (size_t)(block->d.end-start) >= size)
+    {
+        block->d.last = start+size;
+        sdssetalloc(s, newlen);
+        return s;
+    }
+
+    newsh = sdsPoolAlloc(pool, sdsHdrSize(type)+newlen+1);
+    if (newsh == NULL) return NULL;
+    news = (char*)newsh+sdsHdrSize(type);
+    memcpy(news, s, len+1);
+    news[-1] = type | SDS_POOL_FLAG;
+    sdssetlen(news, len);
+    sdssetalloc(news, newlen);
+    sdsPoolRelease(s);
+    return news;
+}
+
 /* Enlarge the free space at the end of the sds string so that the caller
  * is sure that after calling this function can overwrite up to addlen
  * bytes after the end of the string, plus one more byte for nul term.
@@ -210,6 +415,14 @@ sds sdsMakeRoomFor(sds s, size_t addlen) {
     char type, oldtype = s[-1] & SDS_TYPE_MASK;
     int hdrlen;
 
+    /* Shared strings have no free space, and can't be written. */
+    if (sdsIsShared(s)) {
+        s = sdsunshare(s);
+        if (s == NULL) return NULL;
+        oldtype = s[-1] & SDS_TYPE_MASK;
+        avail = sdsavail(s);
+    }
+
     /* Return ASAP if there is enough space left. */
     if (avail >= addlen) return s;
 
@@ -229,6 +442,7 @@ sds sdsMakeRoomFor(sds s, size_t addlen) {
     if (type == SDS_TYPE_5) type = SDS_TYPE_8;
 
     hdrlen = sdsHdrSize(type);
+    if (sdsIsPool(s)) return sdsPoolResize(s, type, newlen);
     if (oldtype == type) {
         newsh = s_realloc(sh, hdrlen+newlen+1);
         if (newsh == NULL) return NULL;
@@ -261,6 +475,21 @@ sds sdsRemoveFreeSpace(sds s) {
     size_t len = sdslen(s);
     sh = (char*)s-oldhdrlen;
 
+    /* Shared strings never have free space. */
+    if (sdsIsShared(s)) return s;
+
+    /* Pool strings can only give back their free space if they are the
+     * last allocation of their block. */
+    if (sdsIsPool(s)) {
+        mem_pool_t *block = sdsPoolLastBlock(s);
+
+        if (block) {
+            block->d.last = (u_char*)sdsPoolSlot(s)+sdsPoolAllocSize(oldhdrlen, len);
+            sdssetalloc(s, len);
+        }
+        return s;
+    }
+
     /* Check what would be the minimum SDS header that is just good enough to
      * fit this string. */
     type = sdsReqType(len);
@@ -296,12 +525,17 @@ sds sdsRemoveFreeSpace(sds s) {
  */
 size_t sdsAllocSize(sds s) {
     size_t alloc = sdsalloc(s);
+    if (sdsIsPool(s)) return sdsPoolAllocSize(sdsHdrSize(s[-1]), alloc);
+    if (sdsIsShared(s)) return sizeof(long)+sdsHdrSize(s[-1])+alloc+1;
     return sdsHdrSize(s[-1])+alloc+1;
 }
 
 /* Return the pointer of the actual SDS allocation (normally SDS strings
- * are referenced by the start of the string buffer). */
+ * are referenced by the start of the string buffer). For pool and shared
+ * strings it is the pointer to the pool or the refcount before the header. */
 void *sdsAllocPtr(sds s) {
+    if (sdsIsPool(s)) return (void*)sdsPoolSlot(s);
+    if (sdsIsShared(s)) return (void*)&sdsSharedRefs(s);
     return (void*) (s-sdsHdrSize(s[-1]));
 }
 
@@ -331,6 +565,7 @@ void *sdsAllocPtr(sds s) {
 void sdsIncrLen(sds s, ssize_t incr) {
     unsigned char flags = s[-1];
     size_t len;
+    assert(sdsrefcount(s) == 1);
     switch (flags & SDS_TYPE_MASK) {
         case SDS_TYPE_5: {
             unsigned char *fp = ((unsigned char*)s)-1;
@@ -422,6 +657,15 @@ sds sdscatsds(sds s, const sds t) {
 /* Destructively modify the sds string 's' to hold the specified binary
  * safe string pointed by 't' of length 'len' bytes. */
 sds sdscpylen(sds s, const char *t, size_t len) {
+    /* The content of a shared string is replaced, no need to copy it.
+     * Create the new string before releasing our reference, as 't' may
+     * point inside 's'. */
+    if (sdsIsShared(s)) {
+        sds n = sdsnewlen(t, len);
+        if (n == NULL) return NULL;
+        sdsfree(s);
+        return n;
+    }
     if (sdsalloc(s) < len) {
         s = sdsMakeRoomFor(s, len-sdslen(s));
         if (s == NULL) return NULL;
@@ -446,63 +690,12 @@ sds sdscpy(sds s, const char *t) {
  * representation stored at 's'. */
 #define SDS_LLSTR_SIZE 21
 int sdsll2str(char *s, long long value) {
-    char *p, aux;
-    unsigned long long v;
-    size_t l;
-
-    /* Generate the string representation, this method produces
-     * an reversed string. */
-    v = (value < 0) ? -value : value;
-    p = s;
-    do {
-        *p++ = '0'+(v%10);
-        v /= 10;
-    } while(v);
-    if (value < 0) *p++ = '-';
-
-    /* Compute length and add null term. */
-    l = p-s;
-    *p = '\0';
-
-    /* Reverse the string. */
-    p--;
-    while (s < p) {
-        aux = *s;
-        *s = *p;
-        *p = aux;
-        s++;
-        p--;
-    }
-    return l;
+    return ll2string(s, SDS_LLSTR_SIZE, value);
 }
 
 /* Identical sdsll2str(), but for unsigned long long type. */
 int sdsull2str(char *s, unsigned long long v) {
-    char *p, aux;
-    size_t l;
-
-    /* Generate the string representation, this method produces
-     * an reversed string. */
-    p = s;
-    do {
-        *p++ = '0'+(v%10);
-        v /= 10;
-    } while(v);
-
-    /* Compute length and add null term. */
-    l = p-s;
-    *p = '\0';
-
-    /* Reverse the string. */
-    p--;
-    while(s < p) {
-        aux = *s;
-        *s = *p;
-        *p = aux;
-        s++;
-        p--;
-    }
-    return l;
+    return ull2string(s, SDS_LLSTR_SIZE, v);
 }
 
 /* Create an sds string from a long long value. It is much faster than:
@@ -516,6 +709,27 @@ sds sdsfromlonglong(long long value) {
     return sdsnewlen(buf,len);
 }
 
+/* Append to the sds string 's' the shortest representation of 'value'
+ * that parses back to the same double, see d2string(). It is much faster
+ * and shorter than:
+ *
+ * sdscatprintf(s,"%.17g",value);
+ */
+sds sdscatdouble(sds s, double value) {
+    char buf[MAX_D2STRING_CHARS];
+    int len = d2string(buf, sizeof(buf), value);
+
+    return sdscatlen(s,buf,len);
+}
+
+/* Create an sds string from a double, see sdscatdouble(). */
+sds sdsfromdouble(double value) {
+    char buf[MAX_D2STRING_CHARS];
+    int len = d2string(buf, sizeof(buf), value);
+
+    return sdsnewlen(buf,len);
+}
+
 /* Like sdscatprintf() but gets va_list instead of being variadic. */
 sds sdscatvprintf(sds s, const char *fmt, va_list ap) {
     va_list cpy;
@@ -601,6 +815,8 @@ sds sdscatfmt(sds s, char const *fmt, ...) {
     long i;
     va_list ap;
 
+    s = sdsunshare(s);
+    if (s == NULL) return NULL;
     va_start(ap, fmt);
     f = fmt;    /* Next format specifier byte to process. */
     i = initlen; /* Position of the next byte to write to dest str. */
@@ -656,7 +872,7 @@ sds sdscatfmt(sds s, char const *fmt, ...) {
                     unum = va_arg(ap,unsigned long long);
                 {
                     char buf[SDS_LLSTR_SIZE];
-                    l = sdsull2str(buf, num);
+                    l = sdsull2str(buf, unum);
                     if (sdsavail(s) < l) {
                         s = sdsMakeRoomFor(s, l);
                     }
@@ -700,15 +916,17 @@ sds sdscatfmt(sds s, char const *fmt, ...) {
  * Output will be just "Hello World".
  */
 sds sdstrim(sds s, const char *cset) {
-    char *start, *end, *sp, *ep;
-    size_t len;
-
-    sp = start = s;
-    ep = end = s+sdslen(s)-1;
-    while(sp <= end && strchr(cset, *sp)) sp++;
-    while(ep > sp && strchr(cset, *ep)) ep--;
-    len = (sp > ep) ? 0 : ((ep-sp)+1);
-    if (s != sp) memmove(s, sp, len);
+    /* The terminator is part of the set, as strchr() finds it too. */
+    size_t setlen = strlen(cset)+1, start, len = sdslen(s), newlen;
+
+    start = strsimdSpan(s, len, cset, setlen);
+    newlen = len-start;
+    newlen -= strsimdSpanReverse(s+start, newlen, cset, setlen);
+    if (newlen == len) return s;
+    len = newlen;
+    s = sdsunshare(s);
+    if (s == NULL) return NULL;
+    if (start) memmove(s, s+start, len);
     s[len] = '\0';
     sdssetlen(s,len);
     return s;
@@ -733,6 +951,7 @@ sds sdstrim(sds s, const char *cset) {
 void sdsrange(sds s, ssize_t start, ssize_t end) {
     size_t newlen, len = sdslen(s);
 
+    assert(sdsrefcount(s) == 1);
     if (len == 0) return;
     if (start < 0) {
         start = len+start;
@@ -758,18 +977,18 @@ void sdsrange(sds s, ssize_t start, ssize_t end) {
     sdssetlen(s,newlen);
 }
 
-/* Apply tolower() to every character of the sds string 's'. */
+/* Apply tolower() to every character of the sds string 's'. Only ASCII
+ * letters are changed, as tolower() does in the C and UTF-8 locales. */
 void sdstolower(sds s) {
-    size_t len = sdslen(s), j;
-
-    for (j = 0; j < len; j++) s[j] = tolower(s[j]);
+    assert(sdsrefcount(s) == 1);
+    strsimdToLower(s, sdslen(s));
 }
 
-/* Apply toupper() to every character of the sds string 's'. */
+/* Apply toupper() to every character of the sds string 's'. Only ASCII
+ * letters are changed, as toupper() does in the C and UTF-8 locales. */
 void sdstoupper(sds s) {
-    size_t len = sdslen(s), j;
-
-    for (j = 0; j < len; j++) s[j] = toupper(s[j]);
+    assert(sdsrefcount(s) == 1);
+    strsimdToUpper(s, sdslen(s));
 }
 
 /* Compare two sds strings s1 and s2 with memcmp().
@@ -795,6 +1014,62 @@ int sdscmp(const sds s1, const sds s2) {
     return cmp;
 }
 
+/* Like sdscmp(), but ASCII letters are compared ignoring their case. */
+int sdscasecmp(const sds s1, const sds s2) {
+    size_t l1, l2, minlen;
+    int cmp;
+
+    l1 = sdslen(s1);
+    l2 = sdslen(s2);
+    minlen = (l1 < l2) ? l1 : l2;
+    cmp = strsimdCaseCmp(s1, s2, minlen);
+    if (cmp == 0) return l1>l2 ? 1 : (l1<l2? -1: 0);
+    return cmp;
+}
+
+/* Return the index of the first character of 's', starting from 'start',
+ * that is one of the 'setlen' characters in 'set', or -1 if there is
+ * none. */
+ssize_t sdsfindchars(const sds s, size_t start, const char *set, size_t setlen) {
+    size_t len = sdslen(s), pos;
+
+    if (start >= len) return -1;
+    pos = start+strsimdFindChars(s+start, len-start, set, setlen);
+    return pos == len ? -1 : (ssize_t)pos;
+}
+
+/* Initialize 'it' to iterate the tokens of 's' split by the separator
+ * 'sep', as sdssplitlen() would return them: a zero length string has no
+ * tokens, otherwise there is one token more than the separators found.
+ *
+ * The tokens are returned by sdsSplitIterNext() as views into 's', so
+ * nothing is allocated, and 's' and 'sep' must stay valid while the
+ * iterator is used. 'seplen' must be at least 1. */
+void sdsSplitIterInit(sdsSplitIter *it, const char *s, size_t len, const char *sep, size_t seplen) {
+    it->p = s;
+    it->end = s+len;
+    it->sep = sep;
+    it->seplen = seplen;
+    it->done = len == 0;
+}
+
+/* Store the next token in '*tok' and '*toklen' and return 1, or return 0
+ * if there are no more tokens. '*tok' is not null terminated. */
+int sdsSplitIterNext(sdsSplitIter *it, const char **tok, size_t *toklen) {
+    size_t len = it->end-it->p, pos;
+
+    if (it->done) return 0;
+    pos = strsimdFind(it->p, len, it->sep, it->seplen);
+    *tok = it->p;
+    *toklen = pos;
+    if (pos == len) {
+        it->done = 1;
+    } else {
+        it->p += pos+it->seplen;
+    }
+    return 1;
+}
+
 /* Split 's' with separator in 'sep'. An array
  * of sds strings is returned. *count will be set
  * by reference to the number of tokens returned.
@@ -810,10 +1085,14 @@ int sdscmp(const sds s1, const sds s2) {
  * This version of the function is binary-safe but
  * requires length arguments. sdssplit() is just the
  * same function but for zero-terminated strings.
+ *
+ * Use sdsSplitIterInit() instead to walk the tokens without copying them.
  */
 sds *sdssplitlen(const char *s, ssize_t len, const char *sep, int seplen, int *count) {
     int elements = 0, slots = 5;
-    long start = 0, j;
+    sdsSplitIter it;
+    const char *tok;
+    size_t toklen;
     sds *tokens;
 
     if (seplen < 1 || len < 0) return NULL;
@@ -821,13 +1100,9 @@ sds *sdssplitlen(const char *s, ssize_t len, const char *sep, int seplen, int *c
     tokens = s_malloc(sizeof(sds)*slots);
     if (tokens == NULL) return NULL;
 
-    if (len == 0) {
-        *count = 0;
-        return tokens;
-    }
-    for (j = 0; j < (len-(seplen-1)); j++) {
-        /* make sure there is room for the next element and the final one */
-        if (slots < elements+2) {
+    sdsSplitIterInit(&it, s, len, sep, seplen);
+    while (sdsSplitIterNext(&it, &tok, &toklen)) {
+        if (elements == slots) {
             sds *newtokens;
 
             slots *= 2;
@@ -835,19 +1110,10 @@ sds *sdssplitlen(const char *s, ssize_t len, const char *sep, int seplen, int *c
             if (newtokens == NULL) goto cleanup;
             tokens = newtokens;
         }
-        /* search the separator */
-        if ((seplen == 1 && *(s+j) == sep[0]) || (memcmp(s+j,sep,seplen) == 0)) {
-            tokens[elements] = sdsnewlen(s+start, j-start);
-            if (tokens[elements] == NULL) goto cleanup;
-            elements++;
-            start = j+seplen;
-            j = j+seplen-1; /* skip the separator */
-        }
+        tokens[elements] = sdsnewlen(tok, toklen);
+        if (tokens[elements] == NULL) goto cleanup;
+        elements++;
     }
-    /* Add the final element. We are sure there is room in the tokens array. */
-    tokens[elements] = sdsnewlen(s+start,len-start);
-    if (tokens[elements] == NULL) goto cleanup;
-    elements++;
     *count = elements;
     return tokens;
 
@@ -869,35 +1135,77 @@ void sdsfreesplitres(sds *tokens, int count) {
     s_free(tokens);
 }
 
+/* Helper for sdscatrepr(): write the escape sequence of 'c' to 'dst' and
+ * return its length, at most 4, or 0 if 'c' is printed as it is. */
+static inline size_t sdsReprEscape(unsigned char c, char *dst) {
+    static const char hex[] = "0123456789abcdef";
+
+    dst[0] = '\\';
+    switch (c) {
+    case '\\':
+    case '"': dst[1] = c; return 2;
+    case '\n': dst[1] = 'n'; return 2;
+    case '\r': dst[1] = 'r'; return 2;
+    case '\t': dst[1] = 't'; return 2;
+    case '\a': dst[1] = 'a'; return 2;
+    case '\b': dst[1] = 'b'; return 2;
+    default:
+        if (c >= ' ' && c <= '~') return 0;
+        dst[1] = 'x';
+        dst[2] = hex[c>>4];
+        dst[3] = hex[c&15];
+        return 4;
+    }
+}
+
 /* Append to the sds string "s" an escaped string representation where
- * all the non-printable characters (tested with isprint()) are turned into
- * escapes in the form "\n\r\a...." or "\x<hex-number>".
+ * all the non-printable characters are turned into escapes in the form
+ * "\n\r\a...." or "\x<hex-number>".
+ *
+ * The runs of printable characters are found with strsimdReprSpan() and
+ * copied at once, only the other bytes are escaped one by one. Like the
+ * other kernels of strsimd.h only ASCII is printable, as isprint() says in
+ * the C and UTF-8 locales.
  *
  * After the call, the modified sds string is no longer valid and all the
  * references must be substituted with the new pointer returned by the call. */
 sds sdscatrepr(sds s, const char *p, size_t len) {
-    s = sdscatlen(s, "\"", 1);
-    while (len--) {
-        switch (*p) {
-        case '\\':
-        case '"':
-            s = sdscatprintf(s, "\\%c", *p);
-            break;
-        case '\n': s = sdscatlen(s,"\\n",2); break;
-        case '\r': s = sdscatlen(s,"\\r",2); break;
-        case '\t': s = sdscatlen(s,"\\t",2); break;
-        case '\a': s = sdscatlen(s,"\\a",2); break;
-        case '\b': s = sdscatlen(s,"\\b",2); break;
-        default:
-            if (isprint(*p))
-                s = sdscatprintf(s,"%c",*p);
-            else
-                s = sdscatprintf(s,"\\x%02x",(unsigned char)*p);
-            break;
+    const char *end = p+len;
+    size_t i, l, n, alloc;
+
+    /* Enough room if there is nothing to escape. */
+    s = sdsMakeRoomFor(s, len+2);
+    if (s == NULL) return NULL;
+    i = sdslen(s);
+    alloc = sdsalloc(s);
+    s[i++] = '"';
+    while (p < end) {
+        l = strsimdReprSpan(p, end-p);
+        /* Room for the run, an escape and the closing quote. */
+        if (alloc-i < l+5) {
+            sdssetlen(s, i);
+            s = sdsMakeRoomFor(s, l+5);
+            if (s == NULL) return NULL;
+            alloc = sdsalloc(s);
+        }
+        memcpy(s+i, p, l);
+        i += l;
+        p += l;
+        while (p < end && (n = sdsReprEscape(*p, s+i)) != 0) {
+            i += n;
+            p++;
+            if (alloc-i < 5) {
+                sdssetlen(s, i);
+                s = sdsMakeRoomFor(s, 5);
+                if (s == NULL) return NULL;
+                alloc = sdsalloc(s);
+            }
         }
-        p++;
     }
-    return sdscatlen(s,"\"",1);
+    s[i++] = '"';
+    s[i] = '\0';
+    sdssetlen(s, i);
+    return s;
 }
 
 /* Helper function for sdssplitargs() that returns non zero if 'c'
@@ -931,6 +1239,138 @@ int hex_digit_to_int(char c) {
     }
 }
 
+/* Initialize 'it' to iterate the arguments of the null terminated 'line',
+ * in the format parsed by sdssplitargs(). 'line' must stay valid while the
+ * iterator is used, and sdsArgsIterRelease() must be called when done. */
+void sdsArgsIterInit(sdsArgsIter *it, const char *line) {
+    it->p = line;
+    it->buf = NULL;
+}
+
+/* Free the memory used by 'it'. The last token returned becomes invalid. */
+void sdsArgsIterRelease(sdsArgsIter *it) {
+    sdsfree(it->buf);
+    it->buf = NULL;
+}
+
+/* Store the next argument in '*tok' and '*toklen' and return 1, return 0
+ * if there are no more arguments, or -1 if the line contains unbalanced
+ * quotes or closed quotes followed by non space characters.
+ *
+ * An argument without quotes is returned as a view into the line. Quoted
+ * arguments are unescaped into a buffer owned by the iterator and reused
+ * by the next call, so the memory used doesn't grow with the number of
+ * arguments. '*tok' is not null terminated in the first case. */
+int sdsArgsIterNext(sdsArgsIter *it, const char **tok, size_t *toklen) {
+    const char *p = it->p, *start;
+    int inq=0;  /* set to 1 if we are in "quotes" */
+    int insq=0; /* set to 1 if we are in 'single quotes' */
+    int done=0;
+
+    /* skip blanks */
+    while (*p && isspace((unsigned char)*p)) p++;
+    if (!*p) {
+        it->p = p;
+        return 0;
+    }
+
+    /* Fast path: up to the first quote, the argument is the line itself. */
+    start = p;
+    while (*p && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t' &&
+           *p != '"' && *p != '\'') p++;
+    if (*p != '"' && *p != '\'') {
+        *tok = start;
+        *toklen = p-start;
+        if (*p) p++;
+        it->p = p;
+        return 1;
+    }
+
+    if (it->buf == NULL) {
+        it->buf = sdsempty();
+    } else {
+        sdsclear(it->buf);
+    }
+    it->buf = sdscatlen(it->buf,start,p-start);
+    while (!done) {
+        if (inq) {
+            if (*p == '\\' && *(p+1) == 'x' &&
+                                     is_hex_digit(*(p+2)) &&
+                                     is_hex_digit(*(p+3)))
+            {
+                unsigned char byte;
+
+                byte = (hex_digit_to_int(*(p+2))*16)+
+                        hex_digit_to_int(*(p+3));
+                it->buf = sdscatlen(it->buf,(char*)&byte,1);
+                p += 3;
+            } else if (*p == '\\' && *(p+1)) {
+                char c;
+
+                p++;
+                switch(*p) {
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'b': c = '\b'; break;
+                case 'a': c = '\a'; break;
+                default: c = *p; break;
+                }
+                it->buf = sdscatlen(it->buf,&c,1);
+            } else if (*p == '"') {
+                /* closing quote must be followed by a space or
+                 * nothing at all. */
+                if (*(p+1) && !isspace((unsigned char)*(p+1))) return -1;
+                done=1;
+            } else if (!*p) {
+                /* unterminated quotes */
+                return -1;
+            } else {
+                it->buf = sdscatlen(it->buf,p,1);
+            }
+        } else if (insq) {
+            if (*p == '\\' && *(p+1) == '\'') {
+                p++;
+                it->buf = sdscatlen(it->buf,"'",1);
+            } else if (*p == '\'') {
+                /* closing quote must be followed by a space or
+                 * nothing at all. */
+                if (*(p+1) && !isspace((unsigned char)*(p+1))) return -1;
+                done=1;
+            } else if (!*p) {
+                /* unterminated quotes */
+                return -1;
+            } else {
+                it->buf = sdscatlen(it->buf,p,1);
+            }
+        } else {
+            switch(*p) {
+            case ' ':
+            case '\n':
+            case '\r':
+            case '\t':
+            case '\0':
+                done=1;
+                break;
+            case '"':
+                inq=1;
+                break;
+            case '\'':
+                insq=1;
+                break;
+            default:
+                it->buf = sdscatlen(it->buf,p,1);
+                break;
+            }
+        }
+        if (*p) p++;
+    }
+    it->p = p;
+    *tok = it->buf;
+    *toklen = sdslen(it->buf);
+    return 1;
+}
+
 /* Split a line into arguments, where every argument can be in the
  * following programming-language REPL-alike form:
  *
@@ -949,115 +1389,38 @@ int hex_digit_to_int(char c) {
  * input string is empty, or NULL if the input contains unbalanced
  * quotes or closed quotes followed by non space characters
  * as in: "foo"bar or "foo'
+ *
+ * Use sdsArgsIterInit() instead to walk the arguments without copying them.
  */
 sds *sdssplitargs(const char *line, int *argc) {
-    const char *p = line;
-    char *current = NULL;
-    char **vector = NULL;
+    sdsArgsIter it;
+    const char *tok;
+    size_t toklen;
+    sds *vector = NULL;
+    int slots = 0, ret;
 
     *argc = 0;
-    while (1) {
-        /* skip blanks */
-        while (*p && isspace(*p)) p++;
-        if (*p) {
-            /* get a token */
-            int inq=0;  /* set to 1 if we are in "quotes" */
-            int insq=0; /* set to 1 if we are in 'single quotes' */
-            int done=0;
-
-            if (current == NULL) current = sdsempty();
-            while (!done) {
-                if (inq) {
-                    if (*p == '\\' && *(p+1) == 'x' &&
-                                             is_hex_digit(*(p+2)) &&
-                                             is_hex_digit(*(p+3)))
-                    {
-                        unsigned char byte;
-
-                        byte = (hex_digit_to_int(*(p+2))*16)+
-                                hex_digit_to_int(*(p+3));
-                        current = sdscatlen(current,(char*)&byte,1);
-                        p += 3;
-                    } else if (*p == '\\' && *(p+1)) {
-                        char c;
-
-                        p++;
-                        switch(*p) {
-                        case 'n': c = '\n'; break;
-                        case 'r': c = '\r'; break;
-                        case 't': c = '\t'; break;
-                        case 'b': c = '\b'; break;
-                        case 'a': c = '\a'; break;
-                        default: c = *p; break;
-                        }
-                        current = sdscatlen(current,&c,1);
-                    } else if (*p == '"') {
-                        /* closing quote must be followed by a space or
-                         * nothing at all. */
-                        if (*(p+1) && !isspace(*(p+1))) goto err;
-                        done=1;
-                    } else if (!*p) {
-                        /* unterminated quotes */
-                        goto err;
-                    } else {
-                        current = sdscatlen(current,p,1);
-                    }
-                } else if (insq) {
-                    if (*p == '\\' && *(p+1) == '\'') {
-                        p++;
-                        current = sdscatlen(current,"'",1);
-                    } else if (*p == '\'') {
-                        /* closing quote must be followed by a space or
-                         * nothing at all. */
-                        if (*(p+1) && !isspace(*(p+1))) goto err;
-                        done=1;
-                    } else if (!*p) {
-                        /* unterminated quotes */
-                        goto err;
-                    } else {
-                        current = sdscatlen(current,p,1);
-                    }
-                } else {
-                    switch(*p) {
-                    case ' ':
-                    case '\n':
-                    case '\r':
-                    case '\t':
-                    case '\0':
-                        done=1;
-                        break;
-                    case '"':
-                        inq=1;
-                        break;
-                    case '\'':
-                        insq=1;
-                        break;
-                    default:
-                        current = sdscatlen(current,p,1);
-                        break;
-                    }
-                }
-                if (*p) p++;
-            }
-            /* add the token to the vector */
-            vector = s_realloc(vector,((*argc)+1)*sizeof(char*));
-            vector[*argc] = current;
-            (*argc)++;
-            current = NULL;
-        } else {
-            /* Even on empty input string return something not NULL. */
-            if (vector == NULL) vector = s_malloc(sizeof(void*));
-            return vector;
+    sdsArgsIterInit(&it, line);
+    while ((ret = sdsArgsIterNext(&it, &tok, &toklen)) == 1) {
+        if (*argc == slots) {
+            slots = slots ? slots*2 : 4;
+            vector = s_realloc(vector,slots*sizeof(sds));
         }
+        vector[*argc] = sdsnewlen(tok,toklen);
+        (*argc)++;
     }
+    sdsArgsIterRelease(&it);
 
-err:
-    while((*argc)--)
-        sdsfree(vector[*argc]);
-    s_free(vector);
-    if (current) sdsfree(current);
-    *argc = 0;
-    return NULL;
+    if (ret == -1) {
+        while((*argc)--)
+            sdsfree(vector[*argc]);
+        s_free(vector);
+        *argc = 0;
+        return NULL;
+    }
+    /* Even on empty input string return something not NULL. */
+    if (vector == NULL) vector = s_malloc(sizeof(void*));
+    return vector;
 }
 
 /* Modify the string substituting all the occurrences of the set of
@@ -1068,18 +1431,12 @@ err:
  * will have the effect of turning the string "hello" into "0ell1".
  *
  * The function returns the sds string pointer, that is always the same
- * as the input pointer since no resize is needed. */
+ * as the input pointer since no resize is needed, unless 's' is a shared
+ * string that gets copied. */
 sds sdsmapchars(sds s, const char *from, const char *to, size_t setlen) {
-    size_t j, i, l = sdslen(s);
-
-    for (j = 0; j < l; j++) {
-        for (i = 0; i < setlen; i++) {
-            if (s[j] == from[i]) {
-                s[j] = to[i];
-                break;
-            }
-        }
-    }
+    s = sdsunshare(s);
+    if (s == NULL) return NULL;
+    strsimdMapChars(s, sdslen(s), from, to, setlen);
     return s;
 }
 
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdarg.h>
+#include <string.h>
+#include <sdsbuilder.h>
+#include <util.h>
+#include <zmalloc.h>
+
+/* Initialize an empty builder, allocating its chunks from 'pool' if it is
+ * not NULL, or from the heap. Pool chunks are given back when the pool is
+ * reset, unless they are larger than the blocks of the pool. A 'chunksize'
+ * of zero selects SDS_BUILDER_CHUNK_SIZE. */
+void sdsBuilderInit(sdsBuilder *b, mem_pool_t *pool, size_t chunksize) {
+    b->pool = pool;
+    b->head = b->tail = NULL;
+    b->chunksize = chunksize ? chunksize : SDS_BUILDER_CHUNK_SIZE;
+    b->len = 0;
+    b->offset = 0;
+    b->chunks = 0;
+}
+
+static sdsBuilderChunk *sdsBuilderChunkCreate(sdsBuilder *b, size_t size) {
+    sdsBuilderChunk *c;
+
+    if (b->pool)
+        c = mem_palloc(b->pool, sizeof(*c)+size);
+    else
+        c = zmalloc(sizeof(*c)+size);
+    if (c == NULL) return NULL;
+    c->next = NULL;
+    c->data = c->buf;
+    c->len = 0;
+    c->size = size;
+    c->ref = NULL;
+    if (b->tail)
+        b->tail->next = c;
+    else
+        b->head = c;
+    b->tail = c;
+    b->chunks++;
+    return c;
+}
+
+static void sdsBuilderChunkFree(sdsBuilder *b, sdsBuilderChunk *c) {
+    if (c->ref) sdsfree(c->ref);
+    /* Only the large allocations of a pool can be given back. */
+    if (b->pool)
+        mem_pfree(b->pool, c);
+    else
+        zfree(c);
+    b->chunks--;
+}
+
+/* Free all the chunks. The builder is empty and can be reused. */
+void sdsBuilderReset(sdsBuilder *b) {
+    sdsBuilderChunk *c = b->head, *next;
+
+    while (c) {
+        next = c->next;
+        sdsBuilderChunkFree(b, c);
+        c = next;
+    }
+    b->head = b->tail = NULL;
+    b->len = 0;
+    b->offset = 0;
+}
+
+/* Free all the resources of the builder. */
+void sdsBuilderRelease(sdsBuilder *b) {
+    sdsBuilderReset(b);
+}
+
+/* Slow path of sdsBuilderCatLen(): the bytes fill the free space of the
+ * last chunk, then a new chunk, large enough for all the remaining bytes. */
+int _sdsBuilderCatLen(sdsBuilder *b, const void *t, size_t len) {
+    sdsBuilderChunk *c = b->tail;
+    const char *p = t;
+
+    if (c && c->size > c->len) {
+        size_t l = c->size-c->len;
+
+        if (l > len) l = len;
+        memcpy(c->buf+c->len, p, l);
+        c->len += l;
+        b->len += l;
+        p += l;
+        len -= l;
+    }
+    if (len == 0) return 0;
+    c = sdsBuilderChunkCreate(b, len > b->chunksize ? len : b->chunksize);
+    if (c == NULL) return -1;
+    memcpy(c->buf, p, len);
+    c->len = len;
+    b->len += len;
+    return 0;
+}
+
+int sdsBuilderCat(sdsBuilder *b, const char *t) {
+    return sdsBuilderCatLen(b, t, strlen(t));
+}
+
+/* Append the sds string 's'. Large shared strings are referenced by a new
+ * chunk instead of being copied, and stay alive until the chunk is freed:
+ * they must not be modified in place meanwhile, as for any shared string. */
+int sdsBuilderCatSds(sdsBuilder *b, const sds s) {
+    size_t len = sdslen(s);
+    sdsBuilderChunk *c;
+
+    if (len < SDS_BUILDER_REF_MIN || !sdsisshared(s))
+        return sdsBuilderCatLen(b, s, len);
+    c = sdsBuilderChunkCreate(b, 0);
+    if (c == NULL) return -1;
+    c->ref = sdsdup(s);
+    c->data = c->ref;
+    c->len = c->size = len;
+    b->len += len;
+    return 0;
+}
+
+/* Append a string formatted like sdscatfmt() does, with the same subset of
+ * format specifiers: %s, %S, %i, %I, %u, %U and %%. The pieces are appended
+ * as they are parsed, without building the whole string first. */
+int sdsBuilderCatFmt(sdsBuilder *b, char const *fmt, ...) {
+    const char *f = fmt, *str;
+    char buf[LONG_STR_SIZE];
+    size_t l;
+    va_list ap;
+    int err = 0;
+
+    va_start(ap, fmt);
+    while (*f && !err) {
+        /* Literal text up to the next specifier. */
+        for (l = 0; f[l] && f[l] != '%'; l++);
+        if (l) {
+            err = sdsBuilderCatLen(b, f, l);
+            f += l;
+            continue;
+        }
+        f++;
+        switch (*f) {
+        case 's':
+        case 'S':
+            str = va_arg(ap, char*);
+            l = (*f == 's') ? strlen(str) : sdslen((sds)str);
+            err = sdsBuilderCatLen(b, str, l);
+            break;
+        case 'i':
+            l = ll2string(buf, sizeof(buf), va_arg(ap, int));
+            err = sdsBuilderCatLen(b, buf, l);
+            break;
+        case 'I':
+            l = ll2string(buf, sizeof(buf), va_arg(ap, long long));
+            err = sdsBuilderCatLen(b, buf, l);
+            break;
+        case 'u':
+            l = ull2string(buf, sizeof(buf), va_arg(ap, unsigned int));
+            err = sdsBuilderCatLen(b, buf, l);
+            break;
+        case 'U':
+            l = ull2string(buf, sizeof(buf), va_arg(ap, unsigned long long));
+            err = sdsBuilderCatLen(b, buf, l);
+            break;
+        case '\0':
+            /* A lone % at the end is dropped, as sdscatfmt() does. */
+            f--;
+            break;
+        default: /* Handle %% and generally %<unknown>. */
+            err = sdsBuilderCatLen(b, f, 1);
+            break;
+        }
+        f++;
+    }
+    va_end(ap);
+    return err;
+}
+
+/* Fill up to 'iovcnt' entries of 'iov' with the bytes not consumed yet,
+ * in order and without copying them, and return the number of entries
+ * filled. Once written, the bytes are released with sdsBuilderConsume(). */
+int sdsBuilderIovec(const sdsBuilder *b, struct iovec *iov, int iovcnt) {
+    sdsBuilderChunk *c = b->head;
+    size_t offset = b->offset;
+    int j = 0;
+
+    while (c && j < iovcnt) {
+        iov[j].iov_base = c->data+offset;
+        iov[j].iov_len = c->len-offset;
+        offset = 0;
+        c = c->next;
+        j++;
+    }
+    return j;
+}
+
+/* Drop the first 'n' bytes, usually the bytes written by writev() from the
+ * entries filled by sdsBuilderIovec(), freeing the chunks fully consumed. */
+void sdsBuilderConsume(sdsBuilder *b, size_t n) {
+    if (n >= b->len) {
+        sdsBuilderReset(b);
+        return;
+    }
+    b->len -= n;
+    n += b->offset;
+    while (n >= b->head->len) {
+        sdsBuilderChunk *c = b->head;
+
+        n -= c->len;
+        b->head = c->next;
+        sdsBuilderChunkFree(b, c);
+    }
+    b->offset = n;
+}
+
+/* Return a new sds string with the bytes not consumed yet. */
+sds sdsBuilderToSds(const sdsBuilder *b) {
+    sds s = sdsnewlen(SDS_NOINIT, b->len);
+    sdsBuilderChunk *c;
+    size_t offset = b->offset;
+    char *p = s;
+
+    if (s == NULL) return NULL;
+    for (c = b->head; c; c = c->next) {
+        memcpy(p, c->data+offset, c->len-offset);
+        p += c->len-offset;
+        offset = 0;
+    }
+    return s;
+}
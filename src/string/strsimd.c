@@ -0,0 +1,685 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fmacros.h>
+#include <stdint.h>
+#include <string.h>
+#include <strsimd.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_STRSIMD_X86 1
+#endif
+
+/* Mapping costs a compare and a blend per char of the set and per vector:
+ * longer sets are faster with the table of the scalar version. */
+#define STRSIMD_MAP_SSE2_MAX 4
+#define STRSIMD_MAP_AVX2_MAX 8
+
+static int strsimdForced = STRSIMD_AUTO;
+
+/* ------------------------------- Scalar ----------------------------------*/
+
+/* ASCII case mapping tables, generated by the preprocessor. */
+#define _strsimdLower(c) ((c) >= 'A' && (c) <= 'Z' ? (c)|0x20 : (c))
+#define _strsimdUpper(c) ((c) >= 'a' && (c) <= 'z' ? (c)&~0x20 : (c))
+#define _strsimdT4(f,n) f(n), f(n+1), f(n+2), f(n+3)
+#define _strsimdT16(f,n) _strsimdT4(f,n), _strsimdT4(f,n+4), _strsimdT4(f,n+8), _strsimdT4(f,n+12)
+#define _strsimdT64(f,n) _strsimdT16(f,n), _strsimdT16(f,n+16), _strsimdT16(f,n+32), _strsimdT16(f,n+48)
+#define _strsimdT256(f) _strsimdT64(f,0), _strsimdT64(f,64), _strsimdT64(f,128), _strsimdT64(f,192)
+
+static const unsigned char strsimdLowerTable[256] = {_strsimdT256(_strsimdLower)};
+static const unsigned char strsimdUpperTable[256] = {_strsimdT256(_strsimdUpper)};
+
+#define _strsimdLowerByte(c) strsimdLowerTable[(unsigned char)(c)]
+#define _strsimdUpperByte(c) strsimdUpperTable[(unsigned char)(c)]
+
+/* A set of bytes as a 256 bit bitmap. */
+typedef struct strsimdSet {
+    uint64_t bits[4];
+} strsimdSet;
+
+static inline void _strsimdSetInit(strsimdSet *s, const char *set, size_t setlen) {
+    const unsigned char *c = (const unsigned char*)set;
+
+    memset(s, 0, sizeof(*s));
+    while (setlen--) {
+        s->bits[*c>>6] |= 1ULL<<(*c&63);
+        c++;
+    }
+}
+
+#define _strsimdSetHas(s, c) \
+    (((s)->bits[(unsigned char)(c)>>6] >> ((unsigned char)(c)&63)) & 1)
+
+static void _strsimdToLowerScalar(char *p, size_t len) {
+    unsigned char *u = (unsigned char*)p;
+    size_t j;
+
+    for (j = 0; j < len; j++) u[j] = _strsimdLowerByte(u[j]);
+}
+
+static void _strsimdToUpperScalar(char *p, size_t len) {
+    unsigned char *u = (unsigned char*)p;
+    size_t j;
+
+    for (j = 0; j < len; j++) u[j] = _strsimdUpperByte(u[j]);
+}
+
+static void _strsimdMapCharsScalar(char *p, size_t len, const char *from, const char *to, size_t setlen) {
+    unsigned char map[256];
+    size_t i, j;
+
+    /* Building the table is only worth it for enough work. */
+    if (len*setlen <= sizeof(map)) {
+        for (j = 0; j < len; j++) {
+            for (i = 0; i < setlen; i++) {
+                if (p[j] == from[i]) {
+                    p[j] = to[i];
+                    break;
+                }
+            }
+        }
+        return;
+    }
+    for (j = 0; j < sizeof(map); j++) map[j] = j;
+    /* The first occurrence of a char in 'from' wins. */
+    for (i = setlen; i > 0; i--) map[(unsigned char)from[i-1]] = to[i-1];
+    for (j = 0; j < len; j++) p[j] = map[(unsigned char)p[j]];
+}
+
+static size_t _strsimdSpanScalar(const char *p, size_t len, const char *set, size_t setlen) {
+    strsimdSet s;
+    size_t j;
+
+    _strsimdSetInit(&s, set, setlen);
+    for (j = 0; j < len && _strsimdSetHas(&s, p[j]); j++);
+    return j;
+}
+
+static size_t _strsimdSpanReverseScalar(const char *p, size_t len, const char *set, size_t setlen) {
+    strsimdSet s;
+    size_t j;
+
+    _strsimdSetInit(&s, set, setlen);
+    for (j = len; j > 0 && _strsimdSetHas(&s, p[j-1]); j--);
+    return len-j;
+}
+
+static size_t _strsimdFindCharsScalar(const char *p, size_t len, const char *set, size_t setlen) {
+    strsimdSet s;
+    size_t j;
+
+    _strsimdSetInit(&s, set, setlen);
+    for (j = 0; j < len && !_strsimdSetHas(&s, p[j]); j++);
+    return j;
+}
+
+static size_t _strsimdFindScalar(const char *p, size_t len, const char *needle, size_t nlen) {
+    const char *q = p, *end = p+len;
+
+    if (nlen == 0) return 0;
+    while ((size_t)(end-q) >= nlen) {
+        q = memchr(q, needle[0], (end-q)-(nlen-1));
+        if (q == NULL) break;
+        if (memcmp(q+1, needle+1, nlen-1) == 0) return q-p;
+        q++;
+    }
+    return len;
+}
+
+/* Printable ASCII, except the quote and the backslash escaped by
+ * sdscatrepr(). */
+#define _strsimdReprPlain(c) \
+    ((c) >= ' ' && (c) <= '~' && (c) != '"' && (c) != '\\')
+
+static size_t _strsimdReprSpanScalar(const char *p, size_t len) {
+    size_t j;
+
+    for (j = 0; j < len && _strsimdReprPlain(p[j]); j++);
+    return j;
+}
+
+static int _strsimdCaseCmpScalar(const char *p1, const char *p2, size_t len) {
+    const unsigned char *u1 = (const unsigned char*)p1, *u2 = (const unsigned char*)p2;
+    size_t j;
+
+    for (j = 0; j < len; j++) {
+        int c1 = _strsimdLowerByte(u1[j]), c2 = _strsimdLowerByte(u2[j]);
+        if (c1 != c2) return c1-c2;
+    }
+    return 0;
+}
+
+#ifdef HAVE_STRSIMD_X86
+/* -------------------------------- SSE2 -----------------------------------*/
+
+/* Bytes are compared as signed: bytes >= 128 are negative, so they are
+ * never inside the ranges of letters. */
+static inline __m128i _strsimdRange16(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo-1)),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(hi+1)));
+}
+
+static inline __m128i _strsimdLower16(__m128i v) {
+    return _mm_or_si128(v, _mm_and_si128(_strsimdRange16(v, 'A', 'Z'), _mm_set1_epi8(0x20)));
+}
+
+static inline __m128i _strsimdUpper16(__m128i v) {
+    return _mm_andnot_si128(_mm_and_si128(_strsimdRange16(v, 'a', 'z'), _mm_set1_epi8(0x20)), v);
+}
+
+static inline __m128i _strsimdMatch16(__m128i v, const __m128i *set, size_t setlen) {
+    __m128i m = _mm_cmpeq_epi8(v, set[0]);
+    size_t i;
+
+    for (i = 1; i < setlen; i++) m = _mm_or_si128(m, _mm_cmpeq_epi8(v, set[i]));
+    return m;
+}
+
+static inline void _strsimdSplat16(__m128i *dst, const char *set, size_t setlen) {
+    size_t i;
+
+    for (i = 0; i < setlen; i++) dst[i] = _mm_set1_epi8(set[i]);
+}
+
+static void _strsimdToLowerSse2(char *p, size_t len) {
+    size_t j = 0;
+
+    for (; j+16 <= len; j += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p+j));
+        _mm_storeu_si128((__m128i*)(p+j), _strsimdLower16(v));
+    }
+    _strsimdToLowerScalar(p+j, len-j);
+}
+
+static void _strsimdToUpperSse2(char *p, size_t len) {
+    size_t j = 0;
+
+    for (; j+16 <= len; j += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p+j));
+        _mm_storeu_si128((__m128i*)(p+j), _strsimdUpper16(v));
+    }
+    _strsimdToUpperScalar(p+j, len-j);
+}
+
+static void _strsimdMapCharsSse2(char *p, size_t len, const char *from, const char *to, size_t setlen) {
+    __m128i vfrom[STRSIMD_MAP_SSE2_MAX], vto[STRSIMD_MAP_SSE2_MAX];
+    size_t i, j = 0;
+
+    if (setlen == 0) return;
+    if (setlen <= STRSIMD_MAP_SSE2_MAX && len >= 16) {
+        _strsimdSplat16(vfrom, from, setlen);
+        _strsimdSplat16(vto, to, setlen);
+        for (; j+16 <= len; j += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p+j));
+            __m128i out = v, done = _mm_setzero_si128();
+
+            for (i = 0; i < setlen; i++) {
+                __m128i m = _mm_andnot_si128(done, _mm_cmpeq_epi8(v, vfrom[i]));
+                out = _mm_or_si128(_mm_andnot_si128(m, out), _mm_and_si128(m, vto[i]));
+                done = _mm_or_si128(done, m);
+            }
+            _mm_storeu_si128((__m128i*)(p+j), out);
+        }
+    }
+    _strsimdMapCharsScalar(p+j, len-j, from, to, setlen);
+}
+
+static size_t _strsimdSpanSse2(const char *p, size_t len, const char *set, size_t setlen) {
+    __m128i vset[STRSIMD_SET_MAX];
+    size_t j = 0;
+
+    if (setlen == 0) return 0;
+    if (setlen <= STRSIMD_SET_MAX && len >= 16) {
+        _strsimdSplat16(vset, set, setlen);
+        for (; j+16 <= len; j += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p+j));
+            unsigned int mask = _mm_movemask_epi8(_strsimdMatch16(v, vset, setlen));
+
+            if (mask != 0xffff) return j+__builtin_ctz(~mask);
+        }
+    }
+    return j+_strsimdSpanScalar(p+j, len-j, set, setlen);
+}
+
+static size_t _strsimdSpanReverseSse2(const char *p, size_t len, const char *set, size_t setlen) {
+    __m128i vset[STRSIMD_SET_MAX];
+    size_t j = len;
+
+    if (setlen == 0) return 0;
+    if (setlen <= STRSIMD_SET_MAX && len >= 16) {
+        _strsimdSplat16(vset, set, setlen);
+        for (; j >= 16; j -= 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p+j-16));
+            unsigned int mask = _mm_movemask_epi8(_strsimdMatch16(v, vset, setlen));
+
+            /* The last byte not in the set is the highest zero bit. */
+            if (mask != 0xffff)
+                return (len-j)+(15-(31-__builtin_clz(~mask & 0xffff)));
+        }
+    }
+    return (len-j)+_strsimdSpanReverseScalar(p, j, set, setlen);
+}
+
+static size_t _strsimdFindCharsSse2(const char *p, size_t len, const char *set, size_t setlen) {
+    __m128i vset[STRSIMD_SET_MAX];
+    size_t j = 0;
+
+    if (setlen == 0) return len;
+    if (setlen <= STRSIMD_SET_MAX && len >= 16) {
+        _strsimdSplat16(vset, set, setlen);
+        for (; j+16 <= len; j += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p+j));
+            unsigned int mask = _mm_movemask_epi8(_strsimdMatch16(v, vset, setlen));
+
+            if (mask) return j+__builtin_ctz(mask);
+        }
+    }
+    return j+_strsimdFindCharsScalar(p+j, len-j, set, setlen);
+}
+
+/* Substring search: the candidates are the positions where both the first
+ * and the last byte of the needle match, only those are checked with
+ * memcmp(). A single byte needle is left to memchr(). */
+static size_t _strsimdFindSse2(const char *p, size_t len, const char *needle, size_t nlen) {
+    size_t j = 0;
+
+    if (nlen < 2) return _strsimdFindScalar(p, len, needle, nlen);
+    if (len >= nlen+15) {
+        __m128i first = _mm_set1_epi8(needle[0]);
+        __m128i last = _mm_set1_epi8(needle[nlen-1]);
+
+        for (; j+nlen+15 <= len; j += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(p+j));
+            __m128i b = _mm_loadu_si128((const __m128i*)(p+j+nlen-1));
+            unsigned int mask = _mm_movemask_epi8(_mm_and_si128(
+                _mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+
+            while (mask) {
+                size_t k = j+__builtin_ctz(mask);
+
+                if (memcmp(p+k+1, needle+1, nlen-2) == 0) return k;
+                mask &= mask-1;
+            }
+        }
+    }
+    return j+_strsimdFindScalar(p+j, len-j, needle, nlen);
+}
+
+static size_t _strsimdReprSpanSse2(const char *p, size_t len) {
+    const __m128i quote = _mm_set1_epi8('"'), bslash = _mm_set1_epi8('\\');
+    size_t j = 0;
+
+    for (; j+16 <= len; j += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p+j));
+        __m128i esc = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash));
+        unsigned int mask = _mm_movemask_epi8(_mm_andnot_si128(esc, _strsimdRange16(v, ' ', '~')));
+
+        if (mask != 0xffff) return j+__builtin_ctz(~mask);
+    }
+    return j+_strsimdReprSpanScalar(p+j, len-j);
+}
+
+static int _strsimdCaseCmpSse2(const char *p1, const char *p2, size_t len) {
+    size_t j = 0;
+
+    for (; j+16 <= len; j += 16) {
+        __m128i v1 = _strsimdLower16(_mm_loadu_si128((const __m128i*)(p1+j)));
+        __m128i v2 = _strsimdLower16(_mm_loadu_si128((const __m128i*)(p2+j)));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2));
+
+        if (mask != 0xffff) {
+            j += __builtin_ctz(~mask);
+            return _strsimdCaseCmpScalar(p1+j, p2+j, 1);
+        }
+    }
+    return _strsimdCaseCmpScalar(p1+j, p2+j, len-j);
+}
+
+/* -------------------------------- AVX2 -----------------------------------*/
+
+/* Every AVX2 kernel leaves the last bytes, less than 32, to its SSE2
+ * version. The upper halves of the registers are cleared before, as GCC
+ * doesn't when the call is a tail call, and mixing AVX and legacy SSE code
+ * with dirty upper halves is very slow on some CPUs. */
+
+#define STRSIMD_TARGET_AVX2 __attribute__((target("avx2")))
+
+STRSIMD_TARGET_AVX2
+static inline __m256i _strsimdRange32(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo-1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(hi+1), v));
+}
+
+STRSIMD_TARGET_AVX2
+static inline __m256i _strsimdLower32(__m256i v) {
+    return _mm256_or_si256(v, _mm256_and_si256(_strsimdRange32(v, 'A', 'Z'), _mm256_set1_epi8(0x20)));
+}
+
+STRSIMD_TARGET_AVX2
+static inline __m256i _strsimdUpper32(__m256i v) {
+    return _mm256_andnot_si256(_mm256_and_si256(_strsimdRange32(v, 'a', 'z'), _mm256_set1_epi8(0x20)), v);
+}
+
+STRSIMD_TARGET_AVX2
+static inline __m256i _strsimdMatch32(__m256i v, const __m256i *set, size_t setlen) {
+    __m256i m = _mm256_cmpeq_epi8(v, set[0]);
+    size_t i;
+
+    for (i = 1; i < setlen; i++) m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, set[i]));
+    return m;
+}
+
+STRSIMD_TARGET_AVX2
+static inline void _strsimdSplat32(__m256i *dst, const char *set, size_t setlen) {
+    size_t i;
+
+    for (i = 0; i < setlen; i++) dst[i] = _mm256_set1_epi8(set[i]);
+}
+
+STRSIMD_TARGET_AVX2
+static void _strsimdToLowerAvx2(char *p, size_t len) {
+    size_t j = 0;
+
+    for (; j+32 <= len; j += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p+j));
+        _mm256_storeu_si256((__m256i*)(p+j), _strsimdLower32(v));
+    }
+    _mm256_zeroupper();
+    _strsimdToLowerSse2(p+j, len-j);
+}
+
+STRSIMD_TARGET_AVX2
+static void _strsimdToUpperAvx2(char *p, size_t len) {
+    size_t j = 0;
+
+    for (; j+32 <= len; j += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p+j));
+        _mm256_storeu_si256((__m256i*)(p+j), _strsimdUpper32(v));
+    }
+    _mm256_zeroupper();
+    _strsimdToUpperSse2(p+j, len-j);
+}
+
+STRSIMD_TARGET_AVX2
+static void _strsimdMapCharsAvx2(char *p, size_t len, const char *from, const char *to, size_t setlen) {
+    __m256i vfrom[STRSIMD_MAP_AVX2_MAX], vto[STRSIMD_MAP_AVX2_MAX];
+    size_t i, j = 0;
+
+    if (setlen == 0) return;
+    if (setlen <= STRSIMD_MAP_AVX2_MAX && len >= 32) {
+        _strsimdSplat32(vfrom, from, setlen);
+        _strsimdSplat32(vto, to, setlen);
+        for (; j+32 <= len; j += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(p+j));
+            __m256i out = v, done = _mm256_setzero_si256();
+
+            for (i = 0; i < setlen; i++) {
+                __m256i m = _mm256_andnot_si256(done, _mm256_cmpeq_epi8(v, vfrom[i]));
+                out = _mm256_blendv_epi8(out, vto[i], m);
+                done = _mm256_or_si256(done, m);
+            }
+            _mm256_storeu_si256((__m256i*)(p+j), out);
+        }
+    }
+    _mm256_zeroupper();
+    _strsimdMapCharsSse2(p+j, len-j, from, to, setlen);
+}
+
+STRSIMD_TARGET_AVX2
+static size_t _strsimdSpanAvx2(const char *p, size_t len, const char *set, size_t setlen) {
+    __m256i vset[STRSIMD_SET_MAX];
+    size_t j = 0;
+
+    if (setlen == 0) return 0;
+    if (setlen <= STRSIMD_SET_MAX && len >= 32) {
+        _strsimdSplat32(vset, set, setlen);
+        for (; j+32 <= len; j += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(p+j));
+            unsigned int mask = _mm256_movemask_epi8(_strsimdMatch32(v, vset, setlen));
+
+            if (mask != 0xffffffff) return j+__builtin_ctz(~mask);
+        }
+    }
+    _mm256_zeroupper();
+    return j+_strsimdSpanSse2(p+j, len-j, set, setlen);
+}
+
+STRSIMD_TARGET_AVX2
+static size_t _strsimdSpanReverseAvx2(const char *p, size_t len, const char *set, size_t setlen) {
+    __m256i vset[STRSIMD_SET_MAX];
+    size_t j = len;
+
+    if (setlen == 0) return 0;
+    if (setlen <= STRSIMD_SET_MAX && len >= 32) {
+        _strsimdSplat32(vset, set, setlen);
+        for (; j >= 32; j -= 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(p+j-32));
+            unsigned int mask = _mm256_movemask_epi8(_strsimdMatch32(v, vset, setlen));
+
+            if (mask != 0xffffffff)
+                return (len-j)+__builtin_clz(~mask);
+        }
+    }
+    _mm256_zeroupper();
+    return (len-j)+_strsimdSpanReverseSse2(p, j, set, setlen);
+}
+
+STRSIMD_TARGET_AVX2
+static size_t _strsimdFindCharsAvx2(const char *p, size_t len, const char *set, size_t setlen) {
+    __m256i vset[STRSIMD_SET_MAX];
+    size_t j = 0;
+
+    if (setlen == 0) return len;
+    if (setlen <= STRSIMD_SET_MAX && len >= 32) {
+        _strsimdSplat32(vset, set, setlen);
+        for (; j+32 <= len; j += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(p+j));
+            unsigned int mask = _mm256_movemask_epi8(_strsimdMatch32(v, vset, setlen));
+
+            if (mask) return j+__builtin_ctz(mask);
+        }
+    }
+    _mm256_zeroupper();
+    return j+_strsimdFindCharsSse2(p+j, len-j, set, setlen);
+}
+
+STRSIMD_TARGET_AVX2
+static size_t _strsimdFindAvx2(const char *p, size_t len, const char *needle, size_t nlen) {
+    size_t j = 0;
+
+    if (nlen < 2) return _strsimdFindScalar(p, len, needle, nlen);
+    if (len >= nlen+31) {
+        __m256i first = _mm256_set1_epi8(needle[0]);
+        __m256i last = _mm256_set1_epi8(needle[nlen-1]);
+
+        for (; j+nlen+31 <= len; j += 32) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(p+j));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(p+j+nlen-1));
+            unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(
+                _mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+
+            while (mask) {
+                size_t k = j+__builtin_ctz(mask);
+
+                if (memcmp(p+k+1, needle+1, nlen-2) == 0) {
+                    _mm256_zeroupper();
+                    return k;
+                }
+                mask &= mask-1;
+            }
+        }
+    }
+    _mm256_zeroupper();
+    return j+_strsimdFindSse2(p+j, len-j, needle, nlen);
+}
+
+STRSIMD_TARGET_AVX2
+static size_t _strsimdReprSpanAvx2(const char *p, size_t len) {
+    const __m256i quote = _mm256_set1_epi8('"'), bslash = _mm256_set1_epi8('\\');
+    size_t j = 0;
+
+    for (; j+32 <= len; j += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p+j));
+        __m256i esc = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, bslash));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_andnot_si256(esc, _strsimdRange32(v, ' ', '~')));
+
+        if (mask != 0xffffffff) return j+__builtin_ctz(~mask);
+    }
+    _mm256_zeroupper();
+    return j+_strsimdReprSpanSse2(p+j, len-j);
+}
+
+STRSIMD_TARGET_AVX2
+static int _strsimdCaseCmpAvx2(const char *p1, const char *p2, size_t len) {
+    size_t j = 0;
+
+    for (; j+32 <= len; j += 32) {
+        __m256i v1 = _strsimdLower32(_mm256_loadu_si256((const __m256i*)(p1+j)));
+        __m256i v2 = _strsimdLower32(_mm256_loadu_si256((const __m256i*)(p2+j)));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v1, v2));
+
+        if (mask != 0xffffffff) {
+            j += __builtin_ctz(~mask);
+            return _strsimdCaseCmpScalar(p1+j, p2+j, 1);
+        }
+    }
+    _mm256_zeroupper();
+    return _strsimdCaseCmpSse2(p1+j, p2+j, len-j);
+}
+#endif
+
+/* ------------------------------ Dispatch ---------------------------------*/
+
+/* Return the implementation used by the kernels: the forced one if any,
+ * otherwise the best one supported by the CPU. */
+int strsimdImplementation(void) {
+    if (strsimdForced != STRSIMD_AUTO) return strsimdForced;
+#ifdef HAVE_STRSIMD_X86
+    if (__builtin_cpu_supports("avx2")) return STRSIMD_AVX2;
+    return STRSIMD_SSE2; /* Part of x86-64. */
+#else
+    return STRSIMD_SCALAR;
+#endif
+}
+
+/* Force the implementation used by the kernels, or go back to the run time
+ * detection with STRSIMD_AUTO. Return -1 if the CPU doesn't support it. */
+int strsimdSetImplementation(int impl) {
+    switch (impl) {
+    case STRSIMD_AUTO:
+    case STRSIMD_SCALAR:
+        break;
+#ifdef HAVE_STRSIMD_X86
+    case STRSIMD_SSE2:
+        break;
+    case STRSIMD_AVX2:
+        if (!__builtin_cpu_supports("avx2")) return -1;
+        break;
+#endif
+    default:
+        return -1;
+    }
+    strsimdForced = impl;
+    return 0;
+}
+
+const char *strsimdImplementationName(int impl) {
+    switch (impl) {
+    case STRSIMD_SCALAR: return "scalar";
+    case STRSIMD_SSE2: return "sse2";
+    case STRSIMD_AVX2: return "avx2";
+    default: return "auto";
+    }
+}
+
+/* Call the implementation 'name' in use, 'ret' is 'return' or nothing. */
+#ifdef HAVE_STRSIMD_X86
+#define STRSIMD_DISPATCH(ret, name, args) do {                  \
+    switch (strsimdImplementation()) {                          \
+    case STRSIMD_AVX2: ret _strsimd##name##Avx2 args; break;    \
+    case STRSIMD_SSE2: ret _strsimd##name##Sse2 args; break;    \
+    default: ret _strsimd##name##Scalar args; break;            \
+    }                                                           \
+} while(0)
+#else
+#define STRSIMD_DISPATCH(ret, name, args) do {                  \
+    ret _strsimd##name##Scalar args;                            \
+} while(0)
+#endif
+
+/* Map the ASCII letters of 'p' to lower case. */
+void strsimdToLower(char *p, size_t len) {
+    STRSIMD_DISPATCH(, ToLower, (p, len));
+}
+
+/* Map the ASCII letters of 'p' to upper case. */
+void strsimdToUpper(char *p, size_t len) {
+    STRSIMD_DISPATCH(, ToUpper, (p, len));
+}
+
+/* Replace every byte of 'p' found in 'from' with the byte at the same
+ * position in 'to'. If a byte is more than once in 'from', the first one
+ * is used. */
+void strsimdMapChars(char *p, size_t len, const char *from, const char *to, size_t setlen) {
+    STRSIMD_DISPATCH(, MapChars, (p, len, from, to, setlen));
+}
+
+/* Return the number of bytes at the start of 'p' that are in 'set'. */
+size_t strsimdSpan(const char *p, size_t len, const char *set, size_t setlen) {
+    STRSIMD_DISPATCH(return, Span, (p, len, set, setlen));
+}
+
+/* Return the number of bytes at the end of 'p' that are in 'set'. */
+size_t strsimdSpanReverse(const char *p, size_t len, const char *set, size_t setlen) {
+    STRSIMD_DISPATCH(return, SpanReverse, (p, len, set, setlen));
+}
+
+/* Return the index of the first byte of 'p' that is in 'set', or 'len' if
+ * there is none. */
+size_t strsimdFindChars(const char *p, size_t len, const char *set, size_t setlen) {
+    STRSIMD_DISPATCH(return, FindChars, (p, len, set, setlen));
+}
+
+/* Return the index of the first occurrence of 'needle' in 'p', or 'len' if
+ * there is none. An empty needle is found at index 0. */
+size_t strsimdFind(const char *p, size_t len, const char *needle, size_t nlen) {
+    STRSIMD_DISPATCH(return, Find, (p, len, needle, nlen));
+}
+
+/* Return the length of the initial part of 'p' made of bytes that
+ * sdscatrepr() copies as they are: printable ASCII except '"' and '\\'. */
+size_t strsimdReprSpan(const char *p, size_t len) {
+    STRSIMD_DISPATCH(return, ReprSpan, (p, len));
+}
+
+/* Compare 'len' bytes like memcmp(), but ignoring the case of ASCII
+ * letters. */
+int strsimdCaseCmp(const char *p1, const char *p2, size_t len) {
+    STRSIMD_DISPATCH(return, CaseCmp, (p1, p2, len));
+}
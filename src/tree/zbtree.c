@@ -0,0 +1,585 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <zmalloc.h>
+#include <zbtree.h>
+
+#define zbtLeaf(n) ((zbtreeLeaf*)(n))
+#define zbtInner(n) ((zbtreeInner*)(n))
+
+/* ----------------------------- nodes ------------------------------------- */
+
+static zbtreeLeaf *zbtCreateLeaf(void) {
+    zbtreeLeaf *leaf = zmalloc(sizeof(*leaf));
+
+    leaf->hdr.leaf = 1;
+    leaf->hdr.count = 0;
+    leaf->prev = leaf->next = NULL;
+    return leaf;
+}
+
+static zbtreeInner *zbtCreateInner(void) {
+    zbtreeInner *in = zmalloc(sizeof(*in));
+
+    in->hdr.leaf = 0;
+    in->hdr.count = 0;
+    return in;
+}
+
+/* Number of elements under a node. */
+static unsigned long zbtNodeSize(zbtreeNode *node) {
+    unsigned long size = 0;
+    int j;
+
+    if (node->leaf) return node->count;
+    for (j = 0; j < node->count; j++)
+        size += zbtInner(node)->sizes[j];
+    return size;
+}
+
+/* Set the key of the child 'i' of 'in' to the smallest key under it. */
+static void zbtRefreshKey(zbtreeInner *in, int i) {
+    zbtreeNode *child = in->children[i];
+
+    if (child->leaf) {
+        in->scores[i] = zbtLeaf(child)->scores[0];
+        in->eles[i] = zbtLeaf(child)->eles[0];
+    } else {
+        in->scores[i] = zbtInner(child)->scores[0];
+        in->eles[i] = zbtInner(child)->eles[0];
+    }
+}
+
+/* Compare the key (kscore, kele) with the element 'ele' of score 'score'. */
+static inline int zbtCompare(zbtree *zbt, double kscore, void *kele,
+                             double score, const void *ele, size_t size)
+{
+    if (kscore < score) return -1;
+    if (kscore > score) return 1;
+    return zbt->mcmp(kele, ele, size);
+}
+
+/* Binary search of the first of 'count' keys greater than the element if
+ * 'upper' is true, not lower otherwise. */
+static int zbtSearch(zbtree *zbt, double *scores, void **eles, int count,
+                     double score, const void *ele, size_t size, int upper)
+{
+    int lo = 0, hi = count, mid, cmp;
+
+    while (lo < hi) {
+        mid = (lo+hi)/2;
+        cmp = zbtCompare(zbt, scores[mid], eles[mid], score, ele, size);
+        if (cmp < 0 || (upper && cmp == 0)) lo = mid+1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/* Index of the child of 'in' that holds the element if it exists: the
+ * last one with a smallest key not greater than the element. */
+static int zbtChildIndex(zbtree *zbt, zbtreeInner *in, double score,
+                         const void *ele, size_t size)
+{
+    int i = zbtSearch(zbt, in->scores, in->eles, in->hdr.count, score, ele, size, 1);
+
+    return i > 0 ? i-1 : 0;
+}
+
+static void zbtFreeNode(zbtreeNode *node) {
+    int j;
+
+    if (node->leaf) {
+        for (j = 0; j < node->count; j++)
+            zfree(zbtLeaf(node)->eles[j]);
+    } else {
+        for (j = 0; j < node->count; j++)
+            zbtFreeNode(zbtInner(node)->children[j]);
+    }
+    zfree(node);
+}
+
+/* ----------------------------- insertion --------------------------------- */
+
+/* Insert the element in a leaf, splitting it first if it is full. Returns
+ * the new right sibling of the leaf if it was split, NULL otherwise. */
+static zbtreeNode *zbtInsertLeaf(zbtree *zbt, zbtreeLeaf *leaf, double score,
+                                 void *ele, size_t size)
+{
+    zbtreeLeaf *right = NULL, *dst = leaf;
+    int pos = zbtSearch(zbt, leaf->scores, leaf->eles, leaf->hdr.count, score, ele, size, 0);
+
+    if (leaf->hdr.count == ZBTREE_LEAF_MAX) {
+        int half = ZBTREE_LEAF_MAX/2;
+
+        right = zbtCreateLeaf();
+        right->hdr.count = ZBTREE_LEAF_MAX-half;
+        memcpy(right->scores, leaf->scores+half, sizeof(double)*right->hdr.count);
+        memcpy(right->eles, leaf->eles+half, sizeof(void*)*right->hdr.count);
+        leaf->hdr.count = half;
+        right->prev = leaf;
+        right->next = leaf->next;
+        if (leaf->next) leaf->next->prev = right;
+        else zbt->tail = right;
+        leaf->next = right;
+        if (pos > half) {
+            dst = right;
+            pos -= half;
+        }
+    }
+    memmove(dst->scores+pos+1, dst->scores+pos, sizeof(double)*(dst->hdr.count-pos));
+    memmove(dst->eles+pos+1, dst->eles+pos, sizeof(void*)*(dst->hdr.count-pos));
+    dst->scores[pos] = score;
+    dst->eles[pos] = ele;
+    dst->hdr.count++;
+    return (zbtreeNode*)right;
+}
+
+/* Insert 'child', with 'size' elements, at index 'pos' of 'in', splitting
+ * 'in' first if it is full. Returns the new right sibling of 'in' if it was
+ * split, NULL otherwise. */
+static zbtreeNode *zbtInsertChild(zbtreeInner *in, int pos, zbtreeNode *child,
+                                  unsigned long size)
+{
+    zbtreeInner *right = NULL, *dst = in;
+    int n;
+
+    if (in->hdr.count == ZBTREE_INNER_MAX) {
+        int half = ZBTREE_INNER_MAX/2;
+
+        right = zbtCreateInner();
+        n = right->hdr.count = ZBTREE_INNER_MAX-half;
+        memcpy(right->scores, in->scores+half, sizeof(double)*n);
+        memcpy(right->eles, in->eles+half, sizeof(void*)*n);
+        memcpy(right->sizes, in->sizes+half, sizeof(unsigned long)*n);
+        memcpy(right->children, in->children+half, sizeof(zbtreeNode*)*n);
+        in->hdr.count = half;
+        if (pos > half) {
+            dst = right;
+            pos -= half;
+        }
+    }
+    n = dst->hdr.count-pos;
+    memmove(dst->scores+pos+1, dst->scores+pos, sizeof(double)*n);
+    memmove(dst->eles+pos+1, dst->eles+pos, sizeof(void*)*n);
+    memmove(dst->sizes+pos+1, dst->sizes+pos, sizeof(unsigned long)*n);
+    memmove(dst->children+pos+1, dst->children+pos, sizeof(zbtreeNode*)*n);
+    dst->children[pos] = child;
+    dst->sizes[pos] = size;
+    dst->hdr.count++;
+    zbtRefreshKey(dst, pos);
+    return (zbtreeNode*)right;
+}
+
+static zbtreeNode *zbtInsertNode(zbtree *zbt, zbtreeNode *node, double score,
+                                 void *ele, size_t size)
+{
+    zbtreeInner *in;
+    zbtreeNode *split;
+    unsigned long splitsize;
+    int i;
+
+    if (node->leaf) return zbtInsertLeaf(zbt, zbtLeaf(node), score, ele, size);
+    in = zbtInner(node);
+    i = zbtChildIndex(zbt, in, score, ele, size);
+    split = zbtInsertNode(zbt, in->children[i], score, ele, size);
+    in->sizes[i]++;
+    /* The element may be the new smallest one of the child. */
+    zbtRefreshKey(in, i);
+    if (split == NULL) return NULL;
+    splitsize = zbtNodeSize(split);
+    in->sizes[i] -= splitsize;
+    return zbtInsertChild(in, i+1, split, splitsize);
+}
+
+/* ------------------------------ deletion --------------------------------- */
+
+/* Remove the child 'i' of 'in' from its arrays. */
+static void zbtRemoveChild(zbtreeInner *in, int i) {
+    int n = in->hdr.count-i-1;
+
+    memmove(in->scores+i, in->scores+i+1, sizeof(double)*n);
+    memmove(in->eles+i, in->eles+i+1, sizeof(void*)*n);
+    memmove(in->sizes+i, in->sizes+i+1, sizeof(unsigned long)*n);
+    memmove(in->children+i, in->children+i+1, sizeof(zbtreeNode*)*n);
+    in->hdr.count--;
+}
+
+/* The child 'i' of 'in' has too few entries: merge it with a sibling if
+ * they fit in a node, otherwise move an entry from the sibling. */
+static void zbtRebalance(zbtree *zbt, zbtreeInner *in, int i) {
+    int l = (i+1 < in->hdr.count) ? i : i-1, r = l+1;
+    zbtreeNode *left = in->children[l], *right = in->children[r];
+
+    if (left->leaf) {
+        zbtreeLeaf *L = zbtLeaf(left), *R = zbtLeaf(right);
+
+        if (L->hdr.count+R->hdr.count <= ZBTREE_LEAF_MAX) {
+            memcpy(L->scores+L->hdr.count, R->scores, sizeof(double)*R->hdr.count);
+            memcpy(L->eles+L->hdr.count, R->eles, sizeof(void*)*R->hdr.count);
+            L->hdr.count += R->hdr.count;
+            L->next = R->next;
+            if (R->next) R->next->prev = L;
+            else zbt->tail = L;
+            in->sizes[l] += in->sizes[r];
+            zbtRemoveChild(in, r);
+            zfree(R);
+            zbtRefreshKey(in, l);
+            return;
+        }
+        if (L->hdr.count < R->hdr.count) {
+            /* The first element of R goes at the end of L. */
+            L->scores[L->hdr.count] = R->scores[0];
+            L->eles[L->hdr.count] = R->eles[0];
+            L->hdr.count++;
+            R->hdr.count--;
+            memmove(R->scores, R->scores+1, sizeof(double)*R->hdr.count);
+            memmove(R->eles, R->eles+1, sizeof(void*)*R->hdr.count);
+            in->sizes[l]++;
+            in->sizes[r]--;
+        } else {
+            memmove(R->scores+1, R->scores, sizeof(double)*R->hdr.count);
+            memmove(R->eles+1, R->eles, sizeof(void*)*R->hdr.count);
+            L->hdr.count--;
+            R->scores[0] = L->scores[L->hdr.count];
+            R->eles[0] = L->eles[L->hdr.count];
+            R->hdr.count++;
+            in->sizes[l]--;
+            in->sizes[r]++;
+        }
+    } else {
+        zbtreeInner *L = zbtInner(left), *R = zbtInner(right);
+        int n;
+
+        if (L->hdr.count+R->hdr.count <= ZBTREE_INNER_MAX) {
+            n = R->hdr.count;
+            memcpy(L->scores+L->hdr.count, R->scores, sizeof(double)*n);
+            memcpy(L->eles+L->hdr.count, R->eles, sizeof(void*)*n);
+            memcpy(L->sizes+L->hdr.count, R->sizes, sizeof(unsigned long)*n);
+            memcpy(L->children+L->hdr.count, R->children, sizeof(zbtreeNode*)*n);
+            L->hdr.count += n;
+            in->sizes[l] += in->sizes[r];
+            zbtRemoveChild(in, r);
+            zfree(R);
+            zbtRefreshKey(in, l);
+            return;
+        }
+        if (L->hdr.count < R->hdr.count) {
+            unsigned long size = R->sizes[0];
+
+            zbtInsertChild(L, L->hdr.count, R->children[0], size);
+            zbtRemoveChild(R, 0);
+            in->sizes[l] += size;
+            in->sizes[r] -= size;
+        } else {
+            unsigned long size = L->sizes[L->hdr.count-1];
+
+            zbtInsertChild(R, 0, L->children[L->hdr.count-1], size);
+            L->hdr.count--;
+            in->sizes[l] -= size;
+            in->sizes[r] += size;
+        }
+    }
+    zbtRefreshKey(in, l);
+    zbtRefreshKey(in, r);
+}
+
+/* Delete the element from the subtree of 'node', setting '*removed' to its
+ * pointer. Returns 1 if it was found, 0 otherwise. The keys of the inner
+ * nodes on the way are refreshed, so that none of them references the
+ * element after the call. */
+static int zbtDeleteNode(zbtree *zbt, zbtreeNode *node, double score,
+                         const void *ele, size_t size, void **removed)
+{
+    zbtreeInner *in;
+    zbtreeNode *child;
+    int i, min;
+
+    if (node->leaf) {
+        zbtreeLeaf *leaf = zbtLeaf(node);
+        int pos = zbtSearch(zbt, leaf->scores, leaf->eles, leaf->hdr.count, score, ele, size, 0);
+
+        if (pos == leaf->hdr.count ||
+            zbtCompare(zbt, leaf->scores[pos], leaf->eles[pos], score, ele, size) != 0)
+            return 0;
+        *removed = leaf->eles[pos];
+        leaf->hdr.count--;
+        memmove(leaf->scores+pos, leaf->scores+pos+1, sizeof(double)*(leaf->hdr.count-pos));
+        memmove(leaf->eles+pos, leaf->eles+pos+1, sizeof(void*)*(leaf->hdr.count-pos));
+        return 1;
+    }
+    in = zbtInner(node);
+    i = zbtChildIndex(zbt, in, score, ele, size);
+    child = in->children[i];
+    if (!zbtDeleteNode(zbt, child, score, ele, size, removed)) return 0;
+    in->sizes[i]--;
+    min = child->leaf ? ZBTREE_LEAF_MIN : ZBTREE_INNER_MIN;
+    if (child->count < min && in->hdr.count > 1)
+        zbtRebalance(zbt, in, i);
+    else if (child->count > 0)
+        zbtRefreshKey(in, i);
+    return 1;
+}
+
+/* ----------------------------- API implementation ------------------------ */
+
+/* Create a new B+tree. If 'mp' is NULL elements are compared with
+ * memcmp(), as in zslCreate(). */
+zbtree *zbtCreate(zslmemcmp mp) {
+    zbtree *zbt = zmalloc(sizeof(*zbt));
+    zbtreeLeaf *leaf = zbtCreateLeaf();
+
+    zbt->root = (zbtreeNode*)leaf;
+    zbt->head = zbt->tail = leaf;
+    zbt->length = 0;
+    zbt->height = 1;
+    zbt->mcmp = mp ? mp : memcmp;
+    return zbt;
+}
+
+/* Free the B+tree and its elements. */
+void zbtFree(zbtree *zbt) {
+    zbtFreeNode(zbt->root);
+    zfree(zbt);
+}
+
+/* Insert an element. Assumes it does not already exist, as zslInsert().
+ * The B+tree takes ownership of 'ele'. */
+void zbtInsert(zbtree *zbt, double score, void *ele, size_t size) {
+    zbtreeNode *split;
+
+    assert(!isnan(score));
+    split = zbtInsertNode(zbt, zbt->root, score, ele, size);
+    if (split) {
+        zbtreeInner *root = zbtCreateInner();
+        unsigned long splitsize = zbtNodeSize(split);
+
+        root->hdr.count = 2;
+        root->children[0] = zbt->root;
+        root->children[1] = split;
+        root->sizes[0] = zbt->length+1-splitsize;
+        root->sizes[1] = splitsize;
+        zbtRefreshKey(root, 0);
+        zbtRefreshKey(root, 1);
+        zbt->root = (zbtreeNode*)root;
+        zbt->height++;
+    }
+    zbt->length++;
+}
+
+/* Delete an element. Returns 1 if it was found and deleted, 0 otherwise.
+ * If 'removed' is NULL the element is freed, otherwise it is returned in
+ * '*removed' and owned by the caller, as the node of zslDelete(). */
+int zbtDelete(zbtree *zbt, double score, void *ele, size_t size, void **removed) {
+    void *old;
+
+    if (!zbtDeleteNode(zbt, zbt->root, score, ele, size, &old)) return 0;
+    if (!zbt->root->leaf && zbt->root->count == 1) {
+        zbtreeNode *root = zbt->root;
+
+        zbt->root = zbtInner(root)->children[0];
+        zfree(root);
+        zbt->height--;
+    }
+    zbt->length--;
+    if (removed) *removed = old;
+    else zfree(old);
+    return 1;
+}
+
+/* Find the rank of an element. Returns 0 when the element cannot be found,
+ * its 1-based rank otherwise. */
+unsigned long zbtGetRank(zbtree *zbt, double score, void *ele, size_t size) {
+    zbtreeNode *node = zbt->root;
+    zbtreeLeaf *leaf;
+    unsigned long rank = 0;
+    int i, j, pos;
+
+    while (!node->leaf) {
+        zbtreeInner *in = zbtInner(node);
+
+        i = zbtChildIndex(zbt, in, score, ele, size);
+        for (j = 0; j < i; j++) rank += in->sizes[j];
+        node = in->children[i];
+    }
+    leaf = zbtLeaf(node);
+    pos = zbtSearch(zbt, leaf->scores, leaf->eles, leaf->hdr.count, score, ele, size, 0);
+    if (pos < leaf->hdr.count &&
+        zbtCompare(zbt, leaf->scores[pos], leaf->eles[pos], score, ele, size) == 0)
+        return rank+pos+1;
+    return 0;
+}
+
+/* Return the leaf holding the element of 1-based rank 'rank' and its index
+ * in '*idx', or NULL if out of range. */
+static zbtreeLeaf *zbtLeafByRank(zbtree *zbt, unsigned long rank, int *idx) {
+    zbtreeNode *node = zbt->root;
+    int i;
+
+    if (rank == 0 || rank > zbt->length) return NULL;
+    rank--;
+    while (!node->leaf) {
+        zbtreeInner *in = zbtInner(node);
+
+        for (i = 0; rank >= in->sizes[i]; i++) rank -= in->sizes[i];
+        node = in->children[i];
+    }
+    *idx = (int)rank;
+    return zbtLeaf(node);
+}
+
+/* Get the element of 1-based rank 'rank'. Returns 1 if it exists, 0
+ * otherwise. */
+int zbtGetElementByRank(zbtree *zbt, unsigned long rank, double *score, void **ele) {
+    zbtreeLeaf *leaf;
+    int idx;
+
+    if ((leaf = zbtLeafByRank(zbt, rank, &idx)) == NULL) return 0;
+    if (score) *score = leaf->scores[idx];
+    if (ele) *ele = leaf->eles[idx];
+    return 1;
+}
+
+/* Elements before the max of the range, or before its min if 'max' is 0,
+ * are a prefix of the tree. */
+static inline int zbtBeforeEdge(double score, zrangespec *range, int max) {
+    return max ? zslValueLteMax(score, range) : !zslValueGteMin(score, range);
+}
+
+/* Count the elements before one of the edges of the range, descending into
+ * the last child with a smallest key before the edge at each level, with a
+ * binary search on the scores. */
+static unsigned long zbtCountBefore(zbtree *zbt, zrangespec *range, int max) {
+    zbtreeNode *node = zbt->root;
+    unsigned long count = 0;
+    int lo, hi, mid, j;
+
+    while (!node->leaf) {
+        zbtreeInner *in = zbtInner(node);
+
+        lo = 1;
+        hi = in->hdr.count;
+        while (lo < hi) {
+            mid = (lo+hi)/2;
+            if (zbtBeforeEdge(in->scores[mid], range, max)) lo = mid+1;
+            else hi = mid;
+        }
+        for (j = 0; j < lo-1; j++) count += in->sizes[j];
+        node = in->children[lo-1];
+    }
+    lo = 0;
+    hi = node->count;
+    while (lo < hi) {
+        mid = (lo+hi)/2;
+        if (zbtBeforeEdge(zbtLeaf(node)->scores[mid], range, max)) lo = mid+1;
+        else hi = mid;
+    }
+    return count+lo;
+}
+
+/* Returns the number of elements with a score in the range, in
+ * O(log(N)). */
+unsigned long zbtCountInRange(zbtree *zbt, zrangespec *range) {
+    unsigned long first, last;
+
+    if (range->min > range->max ||
+        (range->min == range->max && (range->minex || range->maxex)))
+        return 0;
+    first = zbtCountBefore(zbt, range, 0);
+    last = zbtCountBefore(zbt, range, 1);
+    return last > first ? last-first : 0;
+}
+
+/* Return an iterator on the Nth element in the range, N being 0-based, or
+ * NULL if there is no such element. Negative N works for reversed order,
+ * -1 being the last element. The iterator goes towards the tail for N >= 0
+ * and towards the head otherwise, its first zbtNext() call returns the
+ * Nth element, and it must be released with zbtReleaseIterator(). */
+zbtreeIter *zbtNthInRange(zbtree *zbt, zrangespec *range, long n) {
+    unsigned long first, count, rank;
+    zbtreeIter *iter;
+
+    count = zbtCountInRange(zbt, range);
+    if (count == 0) return NULL;
+    first = zbtCountBefore(zbt, range, 0);
+    if (n >= 0) {
+        if ((unsigned long)n >= count) return NULL;
+        rank = first+1+n;
+    } else {
+        if ((unsigned long)-n > count) return NULL;
+        rank = first+count+1+n;
+    }
+    iter = zmalloc(sizeof(*iter));
+    iter->leaf = zbtLeafByRank(zbt, rank, &iter->idx);
+    iter->direction = n >= 0 ? ZL_START_HEAD : ZL_START_TAIL;
+    return iter;
+}
+
+/* Returns an iterator from the first element with ZL_START_HEAD, or from
+ * the last one with ZL_START_TAIL. */
+zbtreeIter *zbtGetIterator(zbtree *zbt, int direction) {
+    zbtreeIter *iter = zmalloc(sizeof(*iter));
+
+    iter->direction = direction;
+    if (direction == ZL_START_HEAD) {
+        iter->leaf = zbt->head;
+        iter->idx = 0;
+    } else {
+        iter->leaf = zbt->tail;
+        iter->idx = zbt->tail->hdr.count-1;
+    }
+    return iter;
+}
+
+/* Return the next element in '*score' and '*ele'. Returns 0 when there are
+ * no more elements. The tree must not be changed while iterating. */
+int zbtNext(zbtreeIter *iter, double *score, void **ele) {
+    zbtreeLeaf *leaf = iter->leaf;
+
+    if (leaf == NULL || iter->idx < 0 || iter->idx >= leaf->hdr.count) return 0;
+    if (score) *score = leaf->scores[iter->idx];
+    if (ele) *ele = leaf->eles[iter->idx];
+    if (iter->direction == ZL_START_HEAD) {
+        if (++iter->idx == leaf->hdr.count) {
+            iter->leaf = leaf->next;
+            iter->idx = 0;
+        }
+    } else {
+        if (--iter->idx < 0) {
+            iter->leaf = leaf->prev;
+            iter->idx = iter->leaf ? iter->leaf->hdr.count-1 : 0;
+        }
+    }
+    return 1;
+}
+
+void zbtReleaseIterator(zbtreeIter *iter) {
+    zfree(iter);
+}
@@ -38,6 +38,18 @@
 #include "test_mempool.c"
 #include "test_array.c"
 #include "test_ringbuf.c"
+#include "test_dict.c"
+#include "test_swdict.c"
+#include "test_cdict.c"
+#include "test_hashfunc.c"
+#include "test_fdict.c"
+#include "test_strsimd.c"
+#include "test_util.c"
+#include "test_sdspool.c"
+#include "test_sdsshared.c"
+#include "test_sdsbuilder.c"
+#include "test_cskiplist.c"
+#include "test_zbtree.c"
 
 void setUp(void) {
 
@@ -55,9 +67,16 @@ int main(void) {
     RUN_TEST(test_zslGetRank);
     RUN_TEST(test_zslDelete);
     RUN_TEST(test_zslIterator);
+    RUN_TEST(test_zslInline);
+    RUN_TEST(test_zslBulkLoad);
+    RUN_TEST(test_zslRange);
+    RUN_TEST(test_cskiplist);
+    RUN_TEST(test_cskiplistConcurrent);
+    RUN_TEST(test_zbtree);
     // rax test
     RUN_TEST(test_rax_regression);
     RUN_TEST(test_raxInsert);
+    RUN_TEST(test_raxFindMany);
     // intset test
     RUN_TEST(test_intset);
     // listpack test
@@ -73,6 +92,28 @@ int main(void) {
     RUN_TEST(test_mempool);
     RUN_TEST(test_arrayfunc);
     RUN_TEST(test_ringbuf);
+    RUN_TEST(test_dictFindMany);
+    RUN_TEST(test_dictEmbeddedKeys);
+    RUN_TEST(test_dictBackgroundRehash);
+    RUN_TEST(test_dictStats);
+    RUN_TEST(test_dictImage);
+    RUN_TEST(test_dictScanPartition);
+    RUN_TEST(test_dictSample);
+    RUN_TEST(test_swdict);
+    RUN_TEST(test_swdictScan);
+    RUN_TEST(test_swdictProbe);
+    RUN_TEST(test_swdictRehashDeleted);
+    RUN_TEST(test_cdict);
+    RUN_TEST(test_cdictConcurrent);
+    RUN_TEST(test_hashFunctions);
+    RUN_TEST(test_dictHashTypes);
+    RUN_TEST(test_fdict);
+    RUN_TEST(test_strsimd);
+    RUN_TEST(test_sdsSplitIter);
+    RUN_TEST(test_numconv);
+    RUN_TEST(test_sdsPool);
+    RUN_TEST(test_sdsShared);
+    RUN_TEST(test_sdsBuilder);
 
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <cdict.h>
+#include <atomicvar.h>
+
+#define CDICT_TEST_KEYS 20000
+#define CDICT_TEST_THREADS 4
+
+static uint64_t cdictTestHash(const void *key) {
+    return dictGenHashFunction(&key, sizeof(key));
+}
+
+static void cdictTestValDestructor(void *privdata, void *val) {
+    DICT_NOTUSED(privdata);
+    free(val);
+}
+
+static dictType cdictTestType = {
+    .hashFunction = cdictTestHash,
+};
+
+static dictType cdictTestValType = {
+    .hashFunction = cdictTestHash,
+    .valDestructor = cdictTestValDestructor,
+};
+
+void test_cdict(void) {
+    cdict *d;
+    void *val;
+    long j;
+
+    d = cdictCreate(&cdictTestValType, NULL);
+    TEST_ASSERT_NOT_EQUAL(NULL, d);
+
+    for (j = 1; j <= CDICT_TEST_KEYS; j++) {
+        long *v = malloc(sizeof(*v));
+        *v = j;
+        TEST_ASSERT_EQUAL(DICT_OK, cdictAdd(d, (void*)(intptr_t)j, v));
+    }
+    TEST_ASSERT_EQUAL(CDICT_TEST_KEYS, cdictSize(d));
+    TEST_ASSERT_EQUAL(DICT_ERR, cdictAdd(d, (void*)(intptr_t)1, NULL));
+
+    while (cdictRehash(d, 100));
+    for (j = 1; j <= CDICT_TEST_KEYS; j++) {
+        TEST_ASSERT_EQUAL(DICT_OK, cdictFetchValue(d, (void*)(intptr_t)j, &val));
+        TEST_ASSERT_EQUAL(j, *(long*)val);
+    }
+    TEST_ASSERT_EQUAL(DICT_ERR, cdictFetchValue(d, (void*)(intptr_t)0, &val));
+
+    /* Replace half of the values and delete the other half. */
+    for (j = 1; j <= CDICT_TEST_KEYS; j++) {
+        if (j & 1) {
+            long *v = malloc(sizeof(*v));
+            *v = -j;
+            TEST_ASSERT_EQUAL(0, cdictReplace(d, (void*)(intptr_t)j, v));
+        } else {
+            TEST_ASSERT_EQUAL(DICT_OK, cdictDelete(d, (void*)(intptr_t)j));
+        }
+    }
+    TEST_ASSERT_EQUAL(CDICT_TEST_KEYS/2, cdictSize(d));
+    TEST_ASSERT_EQUAL(DICT_ERR, cdictDelete(d, (void*)(intptr_t)2));
+    for (j = 1; j <= CDICT_TEST_KEYS; j++) {
+        int retval = cdictFetchValue(d, (void*)(intptr_t)j, &val);
+        if (j & 1) {
+            TEST_ASSERT_EQUAL(DICT_OK, retval);
+            TEST_ASSERT_EQUAL(-j, *(long*)val);
+        } else {
+            TEST_ASSERT_EQUAL(DICT_ERR, retval);
+        }
+    }
+    cdictRelease(d);
+}
+
+typedef struct cdictTestArg {
+    cdict *d;
+    long id;
+    redisAtomic int *stop;
+    long errors;
+} cdictTestArg;
+
+/* Writers add and delete their own range of keys, so that the dict keeps
+ * growing and rehashing while the readers run. */
+static void *cdictTestWriter(void *privdata) {
+    cdictTestArg *arg = privdata;
+    long j, base = (arg->id+1)*1000000;
+
+    for (j = 0; j < CDICT_TEST_KEYS; j++) {
+        if (cdictAdd(arg->d, (void*)(intptr_t)(base+j), (void*)(intptr_t)j) != DICT_OK)
+            arg->errors++;
+        /* Delete base+k for every k multiple of 3, lagging behind. */
+        if (j % 2 == 0 && (j/2) % 3 == 0 &&
+            cdictDelete(arg->d, (void*)(intptr_t)(base+j/2)) != DICT_OK)
+            arg->errors++;
+    }
+    return NULL;
+}
+
+/* Readers look up the keys added before the writers started, that must
+ * always be found with their value regardless of concurrent rehashing. */
+static void *cdictTestReader(void *privdata) {
+    cdictTestArg *arg = privdata;
+    int stop = 0, token;
+    long j;
+
+    while (!stop) {
+        for (j = 1; j <= 1000; j++) {
+            cdictEntry *he;
+
+            token = cdictEnter(arg->d);
+            he = cdictFind(arg->d, (void*)(intptr_t)j);
+            if (he == NULL || cdictGetVal(he) != (void*)(intptr_t)-j)
+                arg->errors++;
+            cdictExit(arg->d, token);
+        }
+        atomicGet(*arg->stop, stop);
+    }
+    return NULL;
+}
+
+void test_cdictConcurrent(void) {
+    pthread_t writers[CDICT_TEST_THREADS], readers[CDICT_TEST_THREADS];
+    cdictTestArg wargs[CDICT_TEST_THREADS], rargs[CDICT_TEST_THREADS];
+    redisAtomic int stop = 0;
+    unsigned long expected = 1000;
+    cdict *d;
+    long j;
+
+    d = cdictCreate(&cdictTestType, NULL);
+    for (j = 1; j <= 1000; j++)
+        cdictAdd(d, (void*)(intptr_t)j, (void*)(intptr_t)-j);
+
+    for (j = 0; j < CDICT_TEST_THREADS; j++) {
+        rargs[j] = (cdictTestArg){d, j, &stop, 0};
+        wargs[j] = (cdictTestArg){d, j, &stop, 0};
+        pthread_create(&readers[j], NULL, cdictTestReader, &rargs[j]);
+    }
+    for (j = 0; j < CDICT_TEST_THREADS; j++)
+        pthread_create(&writers[j], NULL, cdictTestWriter, &wargs[j]);
+    for (j = 0; j < CDICT_TEST_THREADS; j++)
+        pthread_join(writers[j], NULL);
+    atomicSet(stop, 1);
+    for (j = 0; j < CDICT_TEST_THREADS; j++)
+        pthread_join(readers[j], NULL);
+
+    for (j = 0; j < CDICT_TEST_THREADS; j++) {
+        TEST_ASSERT_EQUAL(0, wargs[j].errors);
+        TEST_ASSERT_EQUAL(0, rargs[j].errors);
+    }
+
+    for (j = 0; j < CDICT_TEST_KEYS; j++) {
+        int deleted = j % 3 == 0 && j <= (CDICT_TEST_KEYS-1)/2;
+        if (!deleted) expected += CDICT_TEST_THREADS;
+    }
+    TEST_ASSERT_EQUAL(expected, cdictSize(d));
+    for (j = 0; j < CDICT_TEST_KEYS; j++) {
+        void *val;
+        int deleted = j % 3 == 0 && j <= (CDICT_TEST_KEYS-1)/2;
+        int retval = cdictFetchValue(d, (void*)(intptr_t)(1000000+j), &val);
+        TEST_ASSERT_EQUAL(deleted ? DICT_ERR : DICT_OK, retval);
+    }
+    cdictRelease(d);
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <pthread.h>
+#include <cskiplist.h>
+#include <atomicvar.h>
+#include <zmalloc.h>
+
+#define CSL_TEST_KEYS 20000
+#define CSL_TEST_THREADS 4
+
+static long *cslTestEle(long v) {
+    long *ele = zmalloc(sizeof(*ele));
+    *ele = v;
+    return ele;
+}
+
+/* Check that the live elements are sorted, and return how many they are. */
+static long cslTestCount(cskiplist *csl) {
+    cskiplistNode *x;
+    double prev = -1;
+    long count = 0;
+    int token;
+
+    token = cslEnter(csl);
+    for (x = cslNext(csl, csl->header); x; x = cslNext(csl, x)) {
+        TEST_ASSERT_TRUE(x->score > prev);
+        TEST_ASSERT_EQUAL((long)x->score, *(long*)x->ele);
+        prev = x->score;
+        count++;
+    }
+    cslExit(csl, token);
+    return count;
+}
+
+void test_cskiplist(void) {
+    cskiplist *csl = cslCreate(NULL);
+    zrangespec range = {100, 200, 1, 0};
+    cskiplistNode *x;
+    long j, k, *ele;
+    int token;
+
+    /* Insert the keys in a scattered order. */
+    for (j = 0; j < CSL_TEST_KEYS; j++) {
+        k = (j * 7919) % CSL_TEST_KEYS;
+        TEST_ASSERT_EQUAL(1, cslInsert(csl, k, cslTestEle(k), sizeof(long)));
+    }
+    ele = cslTestEle(5);
+    TEST_ASSERT_EQUAL(0, cslInsert(csl, 5, ele, sizeof(long)));
+    zfree(ele);
+    TEST_ASSERT_EQUAL(CSL_TEST_KEYS, cslLength(csl));
+    TEST_ASSERT_EQUAL(CSL_TEST_KEYS, cslTestCount(csl));
+
+    for (j = 0; j < CSL_TEST_KEYS; j += 2)
+        TEST_ASSERT_EQUAL(1, cslDelete(csl, j, &j, sizeof(j)));
+    TEST_ASSERT_EQUAL(0, cslDelete(csl, 0, &(long){0}, sizeof(long)));
+    TEST_ASSERT_EQUAL(CSL_TEST_KEYS/2, cslLength(csl));
+    TEST_ASSERT_EQUAL(CSL_TEST_KEYS/2, cslTestCount(csl));
+
+    token = cslEnter(csl);
+    for (j = 0; j < CSL_TEST_KEYS; j++) {
+        x = cslFind(csl, j, &j, sizeof(j));
+        if (j & 1) {
+            TEST_ASSERT_NOT_NULL(x);
+            TEST_ASSERT_EQUAL(j, *(long*)x->ele);
+        } else {
+            TEST_ASSERT_NULL(x);
+        }
+    }
+    /* (100, 200] holds the odd keys from 101 to 199. */
+    k = 101;
+    for (x = cslFirstInRange(csl, &range); x && zslValueLteMax(x->score, &range);
+         x = cslNext(csl, x))
+    {
+        TEST_ASSERT_EQUAL(k, *(long*)x->ele);
+        k += 2;
+    }
+    TEST_ASSERT_EQUAL(201, k);
+    range.min = range.max = 100;
+    range.minex = 0;
+    TEST_ASSERT_NULL(cslFirstInRange(csl, &range));
+    range.min = CSL_TEST_KEYS;
+    range.max = CSL_TEST_KEYS*2;
+    TEST_ASSERT_NULL(cslFirstInRange(csl, &range));
+    cslExit(csl, token);
+    cslRelease(csl);
+}
+
+typedef struct cslTestArg {
+    cskiplist *csl;
+    long id;
+    redisAtomic int *stop;
+    long errors;
+} cslTestArg;
+
+/* Every writer inserts its own keys, interleaved with the others, and
+ * deletes them back, lagging behind. All the writers also fight over the
+ * shared keys below CSL_TEST_KEYS/10. */
+static void *cslTestWriter(void *privdata) {
+    cslTestArg *arg = privdata;
+    long j, k;
+
+    for (j = 0; j < CSL_TEST_KEYS; j++) {
+        k = CSL_TEST_KEYS + j*CSL_TEST_THREADS + arg->id;
+        if (cslInsert(arg->csl, k, cslTestEle(k), sizeof(k)) != 1)
+            arg->errors++;
+        if (j % 2 == 0) {
+            k = CSL_TEST_KEYS + (j/2)*CSL_TEST_THREADS + arg->id;
+            if (cslDelete(arg->csl, k, &k, sizeof(k)) != 1) arg->errors++;
+        }
+
+        k = j % (CSL_TEST_KEYS/10);
+        if ((j + arg->id) & 1) {
+            long *ele = cslTestEle(k);
+            if (!cslInsert(arg->csl, k, ele, sizeof(k))) zfree(ele);
+        } else {
+            cslDelete(arg->csl, k, &k, sizeof(k));
+        }
+    }
+    return NULL;
+}
+
+/* Readers walk the skiplist, that must always be sorted. */
+static void *cslTestReader(void *privdata) {
+    cslTestArg *arg = privdata;
+    cskiplistNode *x;
+    int stop = 0, token;
+    double prev;
+
+    while (!stop) {
+        token = cslEnter(arg->csl);
+        prev = -1;
+        for (x = cslNext(arg->csl, arg->csl->header); x; x = cslNext(arg->csl, x)) {
+            if (x->score <= prev || (long)x->score != *(long*)x->ele)
+                arg->errors++;
+            prev = x->score;
+        }
+        cslExit(arg->csl, token);
+        atomicGet(*arg->stop, stop);
+    }
+    return NULL;
+}
+
+void test_cskiplistConcurrent(void) {
+    pthread_t writers[CSL_TEST_THREADS], readers[CSL_TEST_THREADS];
+    cslTestArg wargs[CSL_TEST_THREADS], rargs[CSL_TEST_THREADS];
+    cskiplist *csl = cslCreate(NULL);
+    redisAtomic int stop = 0;
+    cskiplistNode *x;
+    long j, shared = 0;
+    int token;
+
+    for (j = 0; j < CSL_TEST_THREADS; j++) {
+        rargs[j] = (cslTestArg){csl, j, &stop, 0};
+        wargs[j] = (cslTestArg){csl, j, &stop, 0};
+        pthread_create(&readers[j], NULL, cslTestReader, &rargs[j]);
+    }
+    for (j = 0; j < CSL_TEST_THREADS; j++)
+        pthread_create(&writers[j], NULL, cslTestWriter, &wargs[j]);
+    for (j = 0; j < CSL_TEST_THREADS; j++)
+        pthread_join(writers[j], NULL);
+    atomicSet(stop, 1);
+    for (j = 0; j < CSL_TEST_THREADS; j++)
+        pthread_join(readers[j], NULL);
+
+    for (j = 0; j < CSL_TEST_THREADS; j++) {
+        TEST_ASSERT_EQUAL(0, wargs[j].errors);
+        TEST_ASSERT_EQUAL(0, rargs[j].errors);
+    }
+
+    /* The own keys left are the second half of every writer. */
+    token = cslEnter(csl);
+    for (j = 0; j < CSL_TEST_KEYS*CSL_TEST_THREADS; j++) {
+        long k = CSL_TEST_KEYS + j;
+        int deleted = j/CSL_TEST_THREADS < CSL_TEST_KEYS/2;
+        x = cslFind(csl, k, &k, sizeof(k));
+        TEST_ASSERT_EQUAL(deleted, x == NULL);
+    }
+    for (j = 0; j < CSL_TEST_KEYS/10; j++)
+        if (cslFind(csl, j, &j, sizeof(j))) shared++;
+    cslExit(csl, token);
+    TEST_ASSERT_EQUAL(CSL_TEST_KEYS*CSL_TEST_THREADS/2 + shared, cslLength(csl));
+    TEST_ASSERT_EQUAL(cslLength(csl), cslTestCount(csl));
+    cslRelease(csl);
+}
@@ -0,0 +1,544 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <dict.h>
+#include <dictimage.h>
+#include <dictscan.h>
+
+#define DICT_TEST_KEYS 10000
+
+static uint64_t dictTestHash(const void *key) {
+    return dictGenHashFunction(&key, sizeof(key));
+}
+
+static dictType dictTestType = {
+    .hashFunction = dictTestHash,
+};
+
+void test_dictFindMany(void) {
+    void **keys = malloc(sizeof(void*)*DICT_TEST_KEYS*2);
+    dictEntry **entries = malloc(sizeof(dictEntry*)*DICT_TEST_KEYS*2);
+    dict *d = dictCreate(&dictTestType, NULL);
+    long j;
+
+    for (j = 0; j < DICT_TEST_KEYS*2; j++)
+        keys[j] = (void*)(intptr_t)(j+1);
+
+    /* Empty dict. */
+    TEST_ASSERT_EQUAL(0, dictFindMany(d, (const void**)keys, 100, entries));
+    for (j = 0; j < 100; j++) TEST_ASSERT_EQUAL(NULL, entries[j]);
+
+    /* Add the first half as keys and values, the second add of a key
+     * must be skipped. Rehashing is in progress most of the time. */
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS,
+        dictAddMany(d, keys, keys, DICT_TEST_KEYS));
+    TEST_ASSERT_EQUAL(0, dictAddMany(d, keys, keys, 100));
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS, dictSize(d));
+
+    /* Lookup both halves, with a count that is not a multiple of the
+     * batch size. */
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS,
+        dictFindMany(d, (const void**)keys, DICT_TEST_KEYS*2-3, entries));
+    for (j = 0; j < DICT_TEST_KEYS*2-3; j++) {
+        if (j < DICT_TEST_KEYS) {
+            TEST_ASSERT_NOT_EQUAL(NULL, entries[j]);
+            TEST_ASSERT_EQUAL_PTR(keys[j], dictGetKey(entries[j]));
+            TEST_ASSERT_EQUAL_PTR(keys[j], dictGetVal(entries[j]));
+            TEST_ASSERT_EQUAL_PTR(dictFind(d, keys[j]), entries[j]);
+        } else {
+            TEST_ASSERT_EQUAL(NULL, entries[j]);
+        }
+    }
+
+    dictRelease(d);
+    free(entries);
+    free(keys);
+}
+
+void test_dictEmbeddedKeys(void) {
+    dict *d = dictCreate(&dictTypeHeapStringCopyKey, NULL);
+    char key[128];
+    dictEntry *de;
+    long j;
+
+    for (j = 0; j < DICT_TEST_KEYS; j++) {
+        /* Every 10th key is too long to be embedded. */
+        if (j % 10 == 0)
+            snprintf(key, sizeof(key), "%0*ld", DICT_EMBED_KEY_MAX, j);
+        else
+            snprintf(key, sizeof(key), "key:%ld", j);
+        de = dictAddRaw(d, key, NULL);
+        TEST_ASSERT_NOT_EQUAL(NULL, de);
+        dictSetUnsignedIntegerVal(de, j);
+        TEST_ASSERT_EQUAL(j % 10 != 0, dictEntryKeyIsEmbedded(de));
+        TEST_ASSERT_EQUAL_STRING(key, dictGetKey(de));
+    }
+    TEST_ASSERT_EQUAL(DICT_ERR, dictAdd(d, "key:1", NULL));
+
+    for (j = 0; j < DICT_TEST_KEYS; j++) {
+        if (j % 10 == 0)
+            snprintf(key, sizeof(key), "%0*ld", DICT_EMBED_KEY_MAX, j);
+        else
+            snprintf(key, sizeof(key), "key:%ld", j);
+        de = dictFind(d, key);
+        TEST_ASSERT_NOT_EQUAL(NULL, de);
+        TEST_ASSERT_EQUAL_STRING(key, dictGetKey(de));
+        TEST_ASSERT_EQUAL(j, dictGetUnsignedIntegerVal(de));
+        if (j % 2) TEST_ASSERT_EQUAL(DICT_OK, dictDelete(d, key));
+    }
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS/2, dictSize(d));
+    dictRelease(d);
+
+    /* Values are duplicated too. */
+    d = dictCreate(&dictTypeHeapStringCopyKeyValue, NULL);
+    TEST_ASSERT_EQUAL(DICT_OK, dictAdd(d, "foo", "bar"));
+    TEST_ASSERT_EQUAL(0, dictReplace(d, "foo", "baz"));
+    TEST_ASSERT_EQUAL_STRING("baz", dictFetchValue(d, "foo"));
+    dictRelease(d);
+}
+
+void test_dictBackgroundRehash(void) {
+    dict *d = dictCreate(&dictTestType, NULL);
+    unsigned long moved, total, count;
+    dictIterator *iter;
+    dictEntry *de;
+    long j;
+
+    TEST_ASSERT_EQUAL(DICT_OK, dictEnableBackgroundRehash(d));
+    TEST_ASSERT_EQUAL(DICT_ERR, dictEnableBackgroundRehash(d));
+
+    /* Keys are added and looked up while the helper moves them. */
+    for (j = 1; j <= DICT_TEST_KEYS*10; j++) {
+        TEST_ASSERT_EQUAL(DICT_OK, dictAdd(d, (void*)(intptr_t)j, (void*)(intptr_t)-j));
+        TEST_ASSERT_EQUAL_PTR((void*)(intptr_t)-(j/2+1),
+            dictFetchValue(d, (void*)(intptr_t)(j/2+1)));
+        if (j % 1000 == 0 && dictRehashProgress(d, &moved, &total))
+            TEST_ASSERT_TRUE(moved <= total);
+    }
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS*10, dictSize(d));
+
+    /* Iterators pause the helper. */
+    count = 0;
+    iter = dictGetIterator(d);
+    while ((de = dictNext(iter)) != NULL) count++;
+    dictReleaseIterator(iter);
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS*10, count);
+
+    /* The helper completes the rehashing alone. */
+    dictExpand(d, DICT_TEST_KEYS*40);
+    while (dictRehashProgress(d, &moved, &total)) sched_yield();
+    TEST_ASSERT_EQUAL(0, moved);
+    TEST_ASSERT_EQUAL(0, total);
+
+    /* Key pointers are replaced under the lock. */
+    TEST_ASSERT_EQUAL(DICT_OK, dictReplaceKeyPtr(d, (void*)(intptr_t)2,
+        (void*)(intptr_t)2, dictGetHash(d, (void*)(intptr_t)2)));
+    TEST_ASSERT_EQUAL(DICT_ERR, dictReplaceKeyPtr(d, (void*)(intptr_t)-1,
+        (void*)(intptr_t)-2, dictGetHash(d, (void*)(intptr_t)-1)));
+
+    for (j = 1; j <= DICT_TEST_KEYS*10; j += 2)
+        TEST_ASSERT_EQUAL(DICT_OK, dictDelete(d, (void*)(intptr_t)j));
+    dictDisableBackgroundRehash(d);
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS*5, dictSize(d));
+    for (j = 1; j <= DICT_TEST_KEYS*10; j++)
+        TEST_ASSERT_EQUAL(j % 2 == 0, dictFind(d, (void*)(intptr_t)j) != NULL);
+    dictRelease(d);
+}
+
+void test_dictStats(void) {
+    dict *d = dictCreate(&dictTypeHeapStringCopyKey, NULL);
+    unsigned long chained;
+    dictStats stats;
+    char key[128];
+    long j;
+
+    dictCollectStats(d, &stats, DICT_STATS_CHAINS|DICT_STATS_MEMORY);
+    TEST_ASSERT_EQUAL(0, stats.ht[0].size);
+    TEST_ASSERT_EQUAL(stats.dict_bytes, stats.total_bytes);
+
+    for (j = 0; j < DICT_TEST_KEYS; j++) {
+        /* Every 4th key is too long to be embedded. */
+        if (j % 4 == 0)
+            snprintf(key, sizeof(key), "%0*ld", DICT_EMBED_KEY_MAX, j);
+        else
+            snprintf(key, sizeof(key), "key:%ld", j);
+        dictAdd(d, key, NULL);
+    }
+    while (dictRehash(d, 100));
+
+    /* The cheap version doesn't walk the table. */
+    dictCollectStats(d, &stats, 0);
+    TEST_ASSERT_EQUAL(0, stats.rehashing);
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS, stats.ht[0].used);
+    TEST_ASSERT_EQUAL(0, stats.ht[0].buckets);
+    TEST_ASSERT_EQUAL(0, stats.ht[0].key_bytes);
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS*sizeof(dictEntry), stats.ht[0].entry_bytes);
+    TEST_ASSERT_TRUE(stats.ht[0].table_bytes >= stats.ht[0].size*sizeof(dictEntry*));
+
+    dictCollectStats(d, &stats, DICT_STATS_CHAINS|DICT_STATS_MEMORY|DICT_STATS_KEYS);
+    TEST_ASSERT_EQUAL(stats.ht[0].size, stats.ht[0].buckets+stats.ht[0].chains[0]);
+    chained = 0;
+    for (j = 0; j < DICT_STATS_VECTLEN; j++)
+        chained += stats.ht[0].chains[j]*j;
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS, chained);
+    TEST_ASSERT_TRUE(stats.ht[0].max_chain >= 1);
+    /* Entries with embedded keys are bigger than a bare entry. */
+    TEST_ASSERT_TRUE(stats.ht[0].entry_bytes > DICT_TEST_KEYS*sizeof(dictEntry));
+    TEST_ASSERT_TRUE(stats.ht[0].key_bytes >= DICT_TEST_KEYS/4*(DICT_EMBED_KEY_MAX+1));
+    TEST_ASSERT_EQUAL(stats.dict_bytes+stats.ht[0].table_bytes+
+        stats.ht[0].entry_bytes+stats.ht[0].key_bytes, stats.total_bytes);
+
+    /* Rehashing state. */
+    dictExpand(d, DICT_TEST_KEYS*4);
+    dictRehash(d, 10);
+    dictCollectStats(d, &stats, DICT_STATS_CHAINS);
+    TEST_ASSERT_EQUAL(1, stats.rehashing);
+    TEST_ASSERT_EQUAL(stats.ht[0].size, stats.rehash_total);
+    TEST_ASSERT_TRUE(stats.rehash_moved >= 10);
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS, stats.ht[0].used+stats.ht[1].used);
+    TEST_ASSERT_EQUAL(stats.ht[1].size, stats.ht[1].buckets+stats.ht[1].chains[0]);
+    dictRelease(d);
+}
+
+static uint64_t dictImageTestHash(const void *key) {
+    return dictGenHashFunction(key, strlen(key));
+}
+
+static int dictImageTestCompare(void *privdata, const void *key1, const void *key2) {
+    DICT_NOTUSED(privdata);
+    return strcmp(key1, key2) == 0;
+}
+
+static void *dictImageTestKeyDup(void *privdata, const void *key) {
+    DICT_NOTUSED(privdata);
+    return strdup(key);
+}
+
+static void dictImageTestKeyFree(void *privdata, void *key) {
+    DICT_NOTUSED(privdata);
+    free(key);
+}
+
+static size_t dictImageTestKeyEmbedLen(const void *key) {
+    return strlen(key)+1;
+}
+
+static dictType dictImageTestType = {
+    .hashFunction = dictImageTestHash,
+    .keyDup = dictImageTestKeyDup,
+    .keyCompare = dictImageTestCompare,
+    .keyDestructor = dictImageTestKeyFree,
+    .keyEmbedLen = dictImageTestKeyEmbedLen,
+};
+
+static size_t dictImageTestKeyBytes(const dictEntry *de, const void **data) {
+    *data = de->key;
+    return strlen(de->key)+1;
+}
+
+static size_t dictImageTestValBytes(const dictEntry *de, const void **data) {
+    *data = &de->v.u64;
+    return sizeof(de->v.u64);
+}
+
+static void *dictImageTestKeyLoad(void *privdata, const void *data, size_t len) {
+    DICT_NOTUSED(privdata);
+    return memcpy(malloc(len), data, len);
+}
+
+static void dictImageTestValLoad(void *privdata, dictEntry *de, const void *data, size_t len) {
+    DICT_NOTUSED(privdata);
+    DICT_NOTUSED(len);
+    memcpy(&de->v.u64, data, sizeof(de->v.u64));
+}
+
+/* Overwrite the record count in the header of the image at 'path'. */
+static void dictImageTestSetCount(const char *path, uint64_t count) {
+    FILE *fp = fopen(path, "r+");
+
+    TEST_ASSERT_NOT_NULL(fp);
+    fseek(fp, offsetof(dictImageHeader, count), SEEK_SET);
+    TEST_ASSERT_EQUAL(1, fwrite(&count, sizeof(count), 1, fp));
+    fclose(fp);
+}
+
+static dictImageType dictImageTestImageType = {
+    .keyBytes = dictImageTestKeyBytes,
+    .valBytes = dictImageTestValBytes,
+    .keyLoad = dictImageTestKeyLoad,
+    .valLoad = dictImageTestValLoad,
+};
+
+void test_dictImage(void) {
+    dict *d = dictCreate(&dictImageTestType, NULL), *loaded;
+    char path[64], key[128];
+    const dictImageRecord *r;
+    dictImage *img;
+    dictEntry *de;
+    uint64_t val;
+    FILE *fp;
+    long j;
+
+    snprintf(path, sizeof(path), "/tmp/dictimage-%ld.img", (long)getpid());
+    for (j = 0; j < DICT_TEST_KEYS; j++) {
+        /* Every 4th key is too long to be embedded. */
+        if (j % 4 == 0)
+            snprintf(key, sizeof(key), "%0*ld", DICT_EMBED_KEY_MAX, j);
+        else
+            snprintf(key, sizeof(key), "key:%ld", j);
+        de = dictAddRaw(d, key, NULL);
+        dictSetUnsignedIntegerVal(de, j);
+    }
+    TEST_ASSERT_EQUAL(DICT_OK, dictImageSave(d, &dictImageTestImageType, path));
+
+    img = dictImageOpen(path);
+    TEST_ASSERT_NOT_NULL(img);
+    TEST_ASSERT_EQUAL(DICT_OK, dictImageVerify(img));
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS, dictImageCount(img));
+
+    /* Lookups in place. */
+    for (j = 0; j < DICT_TEST_KEYS; j++) {
+        if (j % 4 == 0)
+            snprintf(key, sizeof(key), "%0*ld", DICT_EMBED_KEY_MAX, j);
+        else
+            snprintf(key, sizeof(key), "key:%ld", j);
+        r = dictImageFind(img, dictImageTestHash(key), key, strlen(key)+1);
+        TEST_ASSERT_NOT_NULL(r);
+        memcpy(&val, dictImageRecordVal(r), sizeof(val));
+        TEST_ASSERT_EQUAL(j, val);
+    }
+    TEST_ASSERT_NULL(dictImageFind(img, dictImageTestHash("nokey"), "nokey", 6));
+
+    /* Bulk load, then compare with the original. */
+    loaded = dictImageLoad(img, &dictImageTestType, &dictImageTestImageType, NULL);
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL(DICT_TEST_KEYS, dictSize(loaded));
+    TEST_ASSERT_FALSE(dictIsRehashing(loaded));
+    for (j = 0; j < DICT_TEST_KEYS; j++) {
+        if (j % 4 == 0)
+            snprintf(key, sizeof(key), "%0*ld", DICT_EMBED_KEY_MAX, j);
+        else
+            snprintf(key, sizeof(key), "key:%ld", j);
+        de = dictFind(loaded, key);
+        TEST_ASSERT_NOT_NULL(de);
+        TEST_ASSERT_EQUAL(j, dictGetUnsignedIntegerVal(de));
+        TEST_ASSERT_EQUAL(j % 4 != 0, dictEntryKeyIsEmbedded(de));
+    }
+    /* The loaded dict is a normal dict. */
+    TEST_ASSERT_EQUAL(DICT_OK, dictDelete(loaded, "key:1"));
+    TEST_ASSERT_EQUAL(DICT_OK, dictAdd(loaded, "key:1", NULL));
+    dictRelease(loaded);
+    dictImageClose(img);
+
+    /* The count is not covered by the checksum: one that can't fit the
+     * file is rejected, one that doesn't match the records fails the load. */
+    dictImageTestSetCount(path, UINT64_MAX/2);
+    TEST_ASSERT_NULL(dictImageOpen(path));
+    dictImageTestSetCount(path, 0);
+    img = dictImageOpen(path);
+    TEST_ASSERT_NOT_NULL(img);
+    TEST_ASSERT_NULL(dictImageLoad(img, &dictImageTestType, &dictImageTestImageType, NULL));
+    dictImageClose(img);
+    dictImageTestSetCount(path, DICT_TEST_KEYS+1);
+    img = dictImageOpen(path);
+    TEST_ASSERT_NOT_NULL(img);
+    TEST_ASSERT_NULL(dictImageLoad(img, &dictImageTestType, &dictImageTestImageType, NULL));
+    dictImageClose(img);
+    dictImageTestSetCount(path, DICT_TEST_KEYS);
+
+    /* A corrupted record is detected by the checksum. */
+    fp = fopen(path, "r+");
+    TEST_ASSERT_NOT_NULL(fp);
+    fseek(fp, -1, SEEK_END);
+    fputc('x', fp);
+    fclose(fp);
+    img = dictImageOpen(path);
+    TEST_ASSERT_NOT_NULL(img);
+    TEST_ASSERT_EQUAL(DICT_ERR, dictImageVerify(img));
+    dictImageClose(img);
+
+    /* A truncated file is rejected. */
+    TEST_ASSERT_EQUAL(0, truncate(path, sizeof(dictImageHeader)+8));
+    TEST_ASSERT_NULL(dictImageOpen(path));
+
+    /* Empty dict. */
+    dictEmpty(d, NULL);
+    TEST_ASSERT_EQUAL(DICT_OK, dictImageSave(d, &dictImageTestImageType, path));
+    img = dictImageOpen(path);
+    TEST_ASSERT_NOT_NULL(img);
+    TEST_ASSERT_EQUAL(DICT_OK, dictImageVerify(img));
+    loaded = dictImageLoad(img, &dictImageTestType, &dictImageTestImageType, NULL);
+    TEST_ASSERT_EQUAL(0, dictSize(loaded));
+    dictRelease(loaded);
+    dictImageClose(img);
+
+    unlink(path);
+    dictRelease(d);
+}
+
+static void dictScanTestCount(void *privdata, const dictEntry *de) {
+    unsigned char *seen = privdata;
+
+    seen[(intptr_t)de->key-1]++;
+}
+
+void test_dictScanPartition(void) {
+    unsigned char *seen = malloc(DICT_TEST_KEYS);
+    unsigned char *threadseen[4];
+    dict *d = dictCreate(&dictTestType, NULL);
+    unsigned long part, nparts, v;
+    dictScanPool *pool;
+    long j, k;
+
+    for (j = 0; j < DICT_TEST_KEYS; j++)
+        dictAdd(d, (void*)(intptr_t)(j+1), NULL);
+    while (dictRehash(d, 100));
+
+    /* Partitions are disjoint and cover every key once, even with more
+     * partitions than buckets. */
+    for (nparts = 1; nparts <= dictSlots(d)*4; nparts <<= 3) {
+        memset(seen, 0, DICT_TEST_KEYS);
+        for (part = 0; part < nparts; part++) {
+            v = 0;
+            do {
+                v = dictScanPartition(d, v, part, nparts, dictScanTestCount, NULL, seen);
+            } while (v);
+        }
+        for (j = 0; j < DICT_TEST_KEYS; j++) {
+            if (nparts <= dictSlots(d)) TEST_ASSERT_EQUAL(1, seen[j]);
+            else TEST_ASSERT_TRUE(seen[j] >= 1);
+        }
+    }
+
+    /* The table grows during the scan: keys may be returned more than once
+     * but none is missed. */
+    memset(seen, 0, DICT_TEST_KEYS);
+    nparts = 16;
+    for (part = 0; part < nparts; part++) {
+        v = 0;
+        do {
+            v = dictScanPartition(d, v, part, nparts, dictScanTestCount, NULL, seen);
+            if (part == 3 && !dictIsRehashing(d)) dictExpand(d, dictSlots(d)*2);
+            dictRehash(d, 1);
+        } while (v);
+    }
+    for (j = 0; j < DICT_TEST_KEYS; j++) TEST_ASSERT_TRUE(seen[j] >= 1);
+
+    /* Thread pool, every thread with its own counters. */
+    pool = dictScanPoolCreate(4);
+    TEST_ASSERT_NOT_NULL(pool);
+    for (k = 0; k < 4; k++) threadseen[k] = calloc(1, DICT_TEST_KEYS);
+    for (j = 0; j < 2; j++) {
+        /* Second round while rehashing. */
+        if (j == 1) {
+            dictExpand(d, dictSlots(d)*2);
+            dictRehash(d, 10);
+        }
+        for (k = 0; k < 4; k++) memset(threadseen[k], 0, DICT_TEST_KEYS);
+        dictScanPoolRun(pool, d, dictScanTestCount, NULL, (void**)threadseen);
+        for (k = 0; k < DICT_TEST_KEYS; k++) {
+            TEST_ASSERT_EQUAL(1, threadseen[0][k]+threadseen[1][k]+
+                threadseen[2][k]+threadseen[3][k]);
+        }
+    }
+    for (k = 0; k < 4; k++) free(threadseen[k]);
+    dictScanPoolRelease(pool);
+
+    free(seen);
+    dictRelease(d);
+}
+
+static double dictSampleTestScore(void *privdata, const dictEntry *de) {
+    DICT_NOTUSED(privdata);
+    return (double)(intptr_t)de->key;
+}
+
+void test_dictSample(void) {
+    dictEntry *des[16], *other[16];
+    unsigned long *hits = calloc(1000, sizeof(*hits)), min, max;
+    dict *d = dictCreate(&dictTestType, NULL);
+    double scores[16];
+    unsigned int n, j, k;
+
+    TEST_ASSERT_EQUAL(0, dictSampleKeys(d, des, 8));
+    for (j = 0; j < 1000; j++)
+        dictAdd(d, (void*)(intptr_t)(j+1), NULL);
+    while (dictRehash(d, 100));
+
+    /* Samples are distinct, and every key is about as likely. */
+    for (j = 0; j < 20000; j++) {
+        n = dictSampleKeys(d, des, 8);
+        TEST_ASSERT_EQUAL(8, n);
+        for (k = 0; k < n; k++) {
+            unsigned int i;
+            for (i = 0; i < k; i++) TEST_ASSERT_TRUE(des[i] != des[k]);
+            hits[(intptr_t)des[k]->key-1]++;
+        }
+    }
+    min = max = hits[0];
+    for (j = 0; j < 1000; j++) {
+        if (hits[j] < min) min = hits[j];
+        if (hits[j] > max) max = hits[j];
+    }
+    /* 160 expected hits per key. */
+    TEST_ASSERT_TRUE(min > 40);
+    TEST_ASSERT_TRUE(max < 640);
+
+    /* The same seed gives the same samples. */
+    dictSetSampleSeed(d, 1234);
+    n = dictSampleKeys(d, des, 8);
+    dictSetSampleSeed(d, 1234);
+    TEST_ASSERT_EQUAL(n, dictSampleKeys(d, other, 8));
+    TEST_ASSERT_EQUAL_MEMORY(des, other, sizeof(dictEntry*)*n);
+
+    /* Best keys are sorted by score, and with more samples than keys the
+     * whole dict is visited. */
+    n = dictSampleBestKeys(d, des, scores, 5, 100, dictSampleTestScore, NULL);
+    TEST_ASSERT_EQUAL(5, n);
+    for (k = 1; k < n; k++) TEST_ASSERT_TRUE(scores[k-1] >= scores[k]);
+    n = dictSampleBestKeys(d, des, NULL, 5, 100000, dictSampleTestScore, NULL);
+    TEST_ASSERT_EQUAL(5, n);
+    for (k = 0; k < n; k++) TEST_ASSERT_EQUAL(1000-k, (intptr_t)des[k]->key);
+
+    /* While rehashing, entries of both tables are sampled. */
+    dictExpand(d, 4096);
+    dictRehash(d, 100);
+    TEST_ASSERT_TRUE(dictIsRehashing(d));
+    n = dictSampleBestKeys(d, des, scores, 16, 100000, dictSampleTestScore, NULL);
+    TEST_ASSERT_EQUAL(16, n);
+    for (k = 0; k < n; k++) TEST_ASSERT_EQUAL(1000-k, (intptr_t)des[k]->key);
+
+    free(hits);
+    dictRelease(d);
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fdict.h>
+
+#define FDICT_TEST_KEYS 50000
+
+static uint64_t fdictTestHash(const void *key) {
+    return dictGenHashFunction(&key, sizeof(key));
+}
+
+static void fdictTestValDestructor(void *privdata, void *val) {
+    DICT_NOTUSED(privdata);
+    free(val);
+}
+
+static dictType fdictTestType = {
+    .hashFunction = fdictTestHash,
+    .valDestructor = fdictTestValDestructor,
+};
+
+static void fdictTestKey(char *buf, size_t len, long j) {
+    /* Every 4th key is too long to be embedded. */
+    if (j % 4 == 0)
+        snprintf(buf, len, "%0*ld", DICT_EMBED_KEY_MAX, j);
+    else
+        snprintf(buf, len, "key:%ld", j);
+}
+
+void test_fdict(void) {
+    dict *d = dictCreate(&dictTypeHeapStringCopyKey, NULL);
+    size_t dictbytes;
+    unsigned long seen;
+    dictStats stats;
+    char key[128];
+    fdictEntry *he;
+    fdict *fd;
+    long j;
+
+    /* Empty dict. */
+    fd = fdictFreeze(dictCreate(&fdictTestType, NULL));
+    TEST_ASSERT_NOT_NULL(fd);
+    TEST_ASSERT_EQUAL(0, fdictSize(fd));
+    TEST_ASSERT_NULL(fdictFind(fd, (void*)1));
+    fdictRelease(fd);
+
+    /* String keys, some embedded in the entries and some not. */
+    for (j = 0; j < FDICT_TEST_KEYS; j++) {
+        fdictTestKey(key, sizeof(key), j);
+        dictSetUnsignedIntegerVal(dictAddRaw(d, key, NULL), j);
+    }
+    dictCollectStats(d, &stats, DICT_STATS_MEMORY);
+    dictbytes = stats.total_bytes;
+
+    fd = fdictFreeze(d);
+    TEST_ASSERT_NOT_NULL(fd);
+    TEST_ASSERT_EQUAL(FDICT_TEST_KEYS, fdictSize(fd));
+    /* The flat table uses less memory than the chained one, even counting
+     * the embedded keys. */
+    TEST_ASSERT_TRUE(fdictMemoryUsage(fd) < dictbytes*2/3);
+
+    for (j = 0; j < FDICT_TEST_KEYS; j++) {
+        fdictTestKey(key, sizeof(key), j);
+        he = fdictFind(fd, key);
+        TEST_ASSERT_NOT_NULL(he);
+        TEST_ASSERT_EQUAL_STRING(key, fdictGetKey(he));
+        TEST_ASSERT_EQUAL(j, fdictGetUnsignedIntegerVal(he));
+    }
+    for (j = FDICT_TEST_KEYS; j < FDICT_TEST_KEYS*2; j++) {
+        fdictTestKey(key, sizeof(key), j);
+        TEST_ASSERT_NULL(fdictFind(fd, key));
+    }
+
+    /* Entries are a flat array holding every key once. */
+    seen = 0;
+    for (j = 0; j < (long)fdictSize(fd); j++) {
+        he = fdictEntryAt(fd, j);
+        TEST_ASSERT_EQUAL(he, fdictFind(fd, fdictGetKey(he)));
+        seen += fdictGetUnsignedIntegerVal(he);
+    }
+    TEST_ASSERT_EQUAL((unsigned long)FDICT_TEST_KEYS*(FDICT_TEST_KEYS-1)/2, seen);
+    fdictRelease(fd);
+
+    /* Pointer keys, values released with the fdict. */
+    d = dictCreate(&fdictTestType, NULL);
+    for (j = 1; j <= FDICT_TEST_KEYS; j++) {
+        long *val = malloc(sizeof(*val));
+
+        *val = j;
+        dictAdd(d, (void*)(intptr_t)j, val);
+    }
+    dictCollectStats(d, &stats, DICT_STATS_MEMORY);
+    dictbytes = stats.total_bytes;
+    fd = fdictFreeze(d);
+    TEST_ASSERT_NOT_NULL(fd);
+    TEST_ASSERT_TRUE(fdictMemoryUsage(fd) < dictbytes/2);
+    for (j = 1; j <= FDICT_TEST_KEYS; j++)
+        TEST_ASSERT_EQUAL(j, *(long*)fdictFetchValue(fd, (void*)(intptr_t)j));
+    TEST_ASSERT_NULL(fdictFetchValue(fd, (void*)(intptr_t)(FDICT_TEST_KEYS+1)));
+    fdictRelease(fd);
+}
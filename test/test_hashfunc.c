@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <hashfunc.h>
+#include <dict.h>
+
+void test_hashFunctions(void) {
+    /* Test vectors of wyhash final 4, the seed is the index. */
+    static const struct { const char *s; uint64_t h; } wyvectors[] = {
+        {"", 0x93228a4de0eec5a2ULL},
+        {"a", 0xc5bac3db178713c4ULL},
+        {"abc", 0xa97f2f7b1d9b3314ULL},
+        {"message digest", 0x786d1f1df3801df4ULL},
+        {"abcdefghijklmnopqrstuvwxyz", 0xdca5a8138ad37c87ULL},
+    };
+    unsigned char buf[128];
+    size_t len, j;
+
+    for (j = 0; j < sizeof(wyvectors)/sizeof(wyvectors[0]); j++)
+        TEST_ASSERT_TRUE(wyHash64(wyvectors[j].s, strlen(wyvectors[j].s), j) ==
+                         wyvectors[j].h);
+
+    TEST_ASSERT_EQUAL_HEX32(0xe3069283, crc32c(0, "123456789", 9));
+    TEST_ASSERT_EQUAL_HEX32(0xe3069283, crc32cSoftware(0, "123456789", 9));
+    TEST_ASSERT_EQUAL_HEX32(0xe3069283, crc32c(crc32c(0, "1234", 4), "56789", 5));
+
+    /* Hardware and software paths agree, every length and seed matters,
+     * and flipping any bit of the key changes the hash. */
+    for (j = 0; j < sizeof(buf); j++) buf[j] = j*7;
+    for (len = 0; len <= sizeof(buf); len++) {
+        uint64_t wy = wyHash64(buf, len, 0), crc = crc32cHash64(buf, len, 0);
+
+        TEST_ASSERT_TRUE(crc == crc32cHash64Software(buf, len, 0));
+        TEST_ASSERT_TRUE(crc32cHash64(buf, len, 1) == crc32cHash64Software(buf, len, 1));
+        TEST_ASSERT_TRUE(wy != wyHash64(buf, len, 1));
+        TEST_ASSERT_TRUE(crc != crc32cHash64(buf, len, 1ULL<<32));
+        if (len < sizeof(buf)) {
+            TEST_ASSERT_TRUE(wy != wyHash64(buf, len+1, 0));
+            TEST_ASSERT_TRUE(crc != crc32cHash64(buf, len+1, 0));
+        }
+        for (j = 0; j < len*8; j++) {
+            buf[j/8] ^= 1<<(j%8);
+            TEST_ASSERT_TRUE(wy != wyHash64(buf, len, 0));
+            TEST_ASSERT_TRUE(crc != crc32cHash64(buf, len, 0));
+            buf[j/8] ^= 1<<(j%8);
+        }
+    }
+
+    TEST_ASSERT_TRUE(hashFunctionByName("wyhash") == wyHash64);
+    TEST_ASSERT_TRUE(hashFunctionByName("CRC32C") == crc32cHash64);
+    TEST_ASSERT_TRUE(hashFunctionByName("siphash") == sipHash64);
+    TEST_ASSERT_TRUE(hashFunctionByName("md5") == NULL);
+}
+
+void test_dictHashTypes(void) {
+    dictType *types[] = {
+        &dictTypeStringCopyKeyWyhash,
+        &dictTypeStringCopyKeyWyhashUnseeded,
+        &dictTypeStringCopyKeyCrc32c,
+    };
+    char key[32];
+    size_t t;
+    long j;
+
+    for (t = 0; t < sizeof(types)/sizeof(types[0]); t++) {
+        dict *d = dictCreate(types[t], NULL);
+
+        for (j = 0; j < 1000; j++) {
+            snprintf(key, sizeof(key), "key:%ld", j);
+            TEST_ASSERT_EQUAL(DICT_OK, dictAdd(d, key, (void*)(intptr_t)j));
+        }
+        for (j = 0; j < 1000; j++) {
+            snprintf(key, sizeof(key), "key:%ld", j);
+            TEST_ASSERT_EQUAL_PTR((void*)(intptr_t)j, dictFetchValue(d, key));
+        }
+        TEST_ASSERT_EQUAL(NULL, dictFind(d, "key:1000"));
+        dictRelease(d);
+    }
+}
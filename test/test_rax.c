@@ -76,4 +76,48 @@ void test_raxInsert(void) {
     ret = raxInsert(rt,(unsigned char *)"abc",3,(void *)102,NULL);
     TEST_ASSERT_EQUAL_INT(0, ret);
     raxFree(rt);
-}
\ No newline at end of file
+}
+
+void test_raxFindMany(void) {
+    static unsigned char bufs[3000][24];
+    unsigned char *keys[3000];
+    size_t lens[3000];
+    void *values[3000], *value;
+    int found[3000], j, expected = 0;
+    rax *rt = raxNew();
+
+    /* Keys sharing prefixes of various lengths, some keys being prefixes
+     * of others, the empty key, and some NULL values. */
+    for (j = 0; j < 3000; j++) {
+        lens[j] = snprintf((char*)bufs[j], sizeof(bufs[j]), "route:%d:%d",
+                           (j*37) % 100, j % 7 == 0 ? j/7 : j);
+        if (j % 5 == 0) lens[j] -= 2;
+        if (j == 1000) lens[j] = 0;
+        keys[j] = bufs[j];
+        /* Only the even ones are in the tree. */
+        if (j % 2 == 0)
+            raxInsert(rt, keys[j], lens[j], j % 3 ? (void*)(long)(j+1) : NULL, NULL);
+    }
+    for (j = 0; j < 3000; j++)
+        expected += raxFind(rt, keys[j], lens[j], NULL);
+
+    TEST_ASSERT_TRUE(expected >= 1000);
+    TEST_ASSERT_EQUAL(expected, raxFindMany(rt, keys, lens, 3000, values, found));
+    for (j = 0; j < 3000; j++) {
+        int ok = raxFind(rt, keys[j], lens[j], &value);
+
+        TEST_ASSERT_EQUAL(ok, found[j]);
+        TEST_ASSERT_TRUE(values[j] == (ok ? value : NULL));
+    }
+    /* Fewer keys than a batch, and no output arrays. */
+    TEST_ASSERT_EQUAL(raxFind(rt, keys[0], lens[0], NULL) + raxFind(rt, keys[1], lens[1], NULL),
+                      raxFindMany(rt, keys, lens, 2, NULL, NULL));
+    TEST_ASSERT_EQUAL(0, raxFindMany(rt, keys, lens, 0, NULL, NULL));
+    raxFree(rt);
+
+    /* Empty tree. */
+    rt = raxNew();
+    TEST_ASSERT_EQUAL(0, raxFindMany(rt, keys, lens, 100, values, found));
+    TEST_ASSERT_EQUAL(0, found[99]);
+    raxFree(rt);
+}
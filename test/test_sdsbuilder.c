@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <mempool.h>
+#include <sdsbuilder.h>
+
+/* Write the builder to a pipe a few entries at a time and read it back. */
+static sds sdsBuilderTestDrain(sdsBuilder *b) {
+    struct iovec iov[3];
+    sds out = sdsempty();
+    char buf[4096];
+    int fds[2], cnt;
+    ssize_t n;
+
+    TEST_ASSERT_EQUAL(0, pipe(fds));
+    while (sdsBuilderLen(b)) {
+        cnt = sdsBuilderIovec(b, iov, 3);
+        TEST_ASSERT_TRUE(cnt > 0);
+        /* Short writes, as a socket would do. */
+        if (iov[cnt-1].iov_len > 7) iov[cnt-1].iov_len -= 7;
+        n = writev(fds[1], iov, cnt);
+        TEST_ASSERT_TRUE(n > 0);
+        sdsBuilderConsume(b, n);
+        TEST_ASSERT_EQUAL(n, read(fds[0], buf, n));
+        out = sdscatlen(out, buf, n);
+    }
+    close(fds[0]);
+    close(fds[1]);
+    return out;
+}
+
+void test_sdsBuilder(void) {
+    mem_pool_t *pool = mem_create_pool(MEM_DEFAULT_POOL_SIZE);
+    sdsBuilder b;
+    struct iovec iov[8];
+    sds expected, s, big;
+    int j, p;
+
+    for (p = 0; p < 2; p++) {
+        sdsBuilderInit(&b, p ? pool : NULL, 16);
+        expected = sdsempty();
+        TEST_ASSERT_EQUAL(0, sdsBuilderIovec(&b, iov, 8));
+        for (j = 0; j < 200; j++) {
+            TEST_ASSERT_EQUAL(0, sdsBuilderCatFmt(&b, "*%i\r\n$%U\r\n", j, (unsigned long long)j*1000));
+            expected = sdscatfmt(expected, "*%i\r\n$%U\r\n", j, (unsigned long long)j*1000);
+            TEST_ASSERT_EQUAL(0, sdsBuilderCat(&b, "value"));
+            expected = sdscat(expected, "value");
+        }
+        /* Appends larger than a chunk get a single chunk. */
+        big = sdsnewlen(SDS_NOINIT, 100);
+        memset(big, 'b', 100);
+        TEST_ASSERT_EQUAL(0, sdsBuilderCatSds(&b, big));
+        expected = sdscatsds(expected, big);
+        TEST_ASSERT_TRUE(b.tail->len > 16);
+        TEST_ASSERT_TRUE(b.tail->data == b.tail->buf);
+        sdsfree(big);
+        TEST_ASSERT_EQUAL(0, sdsBuilderCatLen(&b, "", 0));
+        TEST_ASSERT_EQUAL(sdslen(expected), sdsBuilderLen(&b));
+
+        s = sdsBuilderToSds(&b);
+        TEST_ASSERT_EQUAL(sdslen(expected), sdslen(s));
+        TEST_ASSERT_EQUAL_MEMORY(expected, s, sdslen(s));
+        sdsfree(s);
+
+        s = sdsBuilderTestDrain(&b);
+        TEST_ASSERT_EQUAL(0, sdsBuilderLen(&b));
+        TEST_ASSERT_EQUAL(0, b.chunks);
+        TEST_ASSERT_EQUAL(sdslen(expected), sdslen(s));
+        TEST_ASSERT_EQUAL_MEMORY(expected, s, sdslen(s));
+        sdsfree(s);
+        sdsfree(expected);
+        sdsBuilderRelease(&b);
+    }
+
+    /* Every format specifier of sdscatfmt(). */
+    sdsBuilderInit(&b, NULL, 0);
+    s = sdsnew("sds");
+    TEST_ASSERT_EQUAL(0, sdsBuilderCatFmt(&b, "%s %S %i %I %u %U 100%% %x%",
+        "str", s, -1, -9223372036854775807LL-1, 4294967295u,
+        18446744073709551615ULL));
+    sdsfree(s);
+    s = sdsBuilderToSds(&b);
+    TEST_ASSERT_EQUAL_STRING("str sds -1 -9223372036854775808 4294967295 "
+        "18446744073709551615 100% x", s);
+    sdsfree(s);
+    sdsBuilderRelease(&b);
+
+    /* Large shared strings are referenced, not copied. */
+    sdsBuilderInit(&b, NULL, 0);
+    big = sdsnewlen_shared(SDS_NOINIT, SDS_BUILDER_REF_MIN);
+    TEST_ASSERT_EQUAL(0, sdsBuilderCat(&b, "$1024\r\n"));
+    TEST_ASSERT_EQUAL(0, sdsBuilderCatSds(&b, big));
+    TEST_ASSERT_EQUAL(0, sdsBuilderCat(&b, "\r\n"));
+    TEST_ASSERT_EQUAL(2, sdsrefcount(big));
+    TEST_ASSERT_EQUAL(3, b.chunks);
+    TEST_ASSERT_EQUAL(3, sdsBuilderIovec(&b, iov, 8));
+    TEST_ASSERT_TRUE(iov[1].iov_base == big);
+    TEST_ASSERT_EQUAL(SDS_BUILDER_REF_MIN, iov[1].iov_len);
+    TEST_ASSERT_EQUAL_MEMORY("\r\n", iov[2].iov_base, 2);
+    sdsBuilderConsume(&b, 3);
+    TEST_ASSERT_EQUAL(1, sdsBuilderIovec(&b, iov, 1));
+    TEST_ASSERT_EQUAL_MEMORY("24\r\n", iov[0].iov_base, 4);
+    sdsBuilderConsume(&b, 4+SDS_BUILDER_REF_MIN);
+    TEST_ASSERT_EQUAL(1, sdsrefcount(big));
+    TEST_ASSERT_EQUAL(2, sdsBuilderLen(&b));
+    sdsBuilderRelease(&b);
+    sdsfree(big);
+    mem_destroy_pool(pool);
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <mempool.h>
+#include <sds.h>
+
+void test_sdsPool(void) {
+    mem_pool_t *pool = mem_create_pool(MEM_DEFAULT_POOL_SIZE);
+    sds s, t, u, first, heap;
+    mem_pool_large_t *l;
+    int j, large;
+
+    TEST_ASSERT_NOT_NULL(pool);
+    first = s = sdsnew_pool(pool, "hello");
+    TEST_ASSERT_TRUE(sdsPool(s) == pool);
+    TEST_ASSERT_EQUAL(5, sdslen(s));
+    TEST_ASSERT_EQUAL_STRING("hello", s);
+
+    /* The last allocation of the pool grows in place. */
+    s = sdscat(s, " world");
+    TEST_ASSERT_TRUE(s == first);
+    TEST_ASSERT_EQUAL_STRING("hello world", s);
+
+    /* Once it isn't the last anymore, it moves within the pool. */
+    t = sdsdup(s);
+    TEST_ASSERT_TRUE(sdsPool(t) == pool);
+    for (j = 0; j < 10; j++) s = sdscatfmt(s, " %i", j);
+    TEST_ASSERT_TRUE(s != first);
+    TEST_ASSERT_TRUE(sdsPool(s) == pool);
+    TEST_ASSERT_EQUAL_STRING("hello world 0 1 2 3 4 5 6 7 8 9", s);
+    TEST_ASSERT_EQUAL_STRING("hello world", t);
+
+    /* Giving back the free space of the last allocation. */
+    s = sdsRemoveFreeSpace(s);
+    TEST_ASSERT_EQUAL(sdslen(s), sdsalloc(s));
+    TEST_ASSERT_TRUE((u_char*)sdsAllocPtr(s)+sdsAllocSize(s) == pool->current->d.last);
+
+    /* Strings too big for the blocks are given back by sdsfree(). */
+    u = sdsempty_pool(pool);
+    for (j = 0; j < 1000; j++) u = sdscatlen(u, "0123456789", 10);
+    TEST_ASSERT_EQUAL(10000, sdslen(u));
+    TEST_ASSERT_TRUE(sdsPool(u) == pool);
+    TEST_ASSERT_EQUAL_MEMORY("0123456789", u+9990, 10);
+    for (large = 0, l = pool->large; l; l = l->next) large += l->alloc == sdsAllocPtr(u);
+    TEST_ASSERT_EQUAL(1, large);
+    sdsfree(u);
+    for (large = 0, l = pool->large; l; l = l->next) large += l->alloc != NULL;
+    TEST_ASSERT_EQUAL(0, large);
+    sdsfree(t);
+    TEST_ASSERT_EQUAL_STRING("hello world 0 1 2 3 4 5 6 7 8 9", s);
+
+    /* Heap strings are left alone. */
+    heap = sdsnew("heap");
+    TEST_ASSERT_NULL(sdsPool(heap));
+    heap = sdscatsds(heap, s);
+    TEST_ASSERT_NULL(sdsPool(heap));
+    TEST_ASSERT_EQUAL_STRING("heaphello world 0 1 2 3 4 5 6 7 8 9", heap);
+    sdsfree(heap);
+
+    /* After a reset the pool memory is used again from the start. */
+    mem_reset_pool(pool);
+    s = sdsnewlen_pool(pool, "abc", 3);
+    TEST_ASSERT_TRUE(s == first);
+    TEST_ASSERT_EQUAL_STRING("abc", s);
+    s = sdsnewlen_pool(pool, NULL, 40);
+    TEST_ASSERT_EQUAL(40, sdslen(s));
+    for (j = 0; j < 40; j++) TEST_ASSERT_EQUAL(0, s[j]);
+    mem_destroy_pool(pool);
+}
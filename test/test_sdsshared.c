@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sds.h>
+
+#define SDS_SHARED_TEST_THREADS 4
+#define SDS_SHARED_TEST_LOOPS 100000
+
+static void *sdsSharedTestWorker(void *arg) {
+    sds s = arg, refs[8];
+    int j, k;
+
+    for (j = 0; j < SDS_SHARED_TEST_LOOPS; j++) {
+        for (k = 0; k < 8; k++) refs[k] = sdsdup(s);
+        for (k = 0; k < 8; k++) sdsfree(refs[k]);
+    }
+    return NULL;
+}
+
+void test_sdsShared(void) {
+    pthread_t threads[SDS_SHARED_TEST_THREADS];
+    sds s, t, u;
+    int j;
+
+    s = sdsnew_shared("hello");
+    TEST_ASSERT_TRUE(sdsisshared(s));
+    TEST_ASSERT_EQUAL(1, sdsrefcount(s));
+    TEST_ASSERT_EQUAL(5, sdslen(s));
+    TEST_ASSERT_EQUAL_STRING("hello", s);
+
+    /* Duplicating only takes a new reference. */
+    t = sdsdup(s);
+    TEST_ASSERT_TRUE(t == s);
+    TEST_ASSERT_EQUAL(2, sdsrefcount(s));
+
+    /* Appending copies, the other reference is left untouched. */
+    t = sdscat(t, " world");
+    TEST_ASSERT_TRUE(t != s);
+    TEST_ASSERT_FALSE(sdsisshared(t));
+    TEST_ASSERT_EQUAL_STRING("hello world", t);
+    TEST_ASSERT_EQUAL_STRING("hello", s);
+    TEST_ASSERT_EQUAL(1, sdsrefcount(s));
+    sdsfree(t);
+
+    t = sdsdup(s);
+    t = sdscatfmt(t, "%i", 42);
+    TEST_ASSERT_EQUAL_STRING("hello42", t);
+    TEST_ASSERT_EQUAL_STRING("hello", s);
+    sdsfree(t);
+
+    t = sdsdup(s);
+    t = sdsmapchars(t, "ho", "01", 2);
+    TEST_ASSERT_EQUAL_STRING("0ell1", t);
+    TEST_ASSERT_EQUAL_STRING("hello", s);
+    sdsfree(t);
+
+    t = sdsdup(s);
+    t = sdscpy(t, "a");
+    TEST_ASSERT_EQUAL_STRING("a", t);
+    TEST_ASSERT_EQUAL_STRING("hello", s);
+    sdsfree(t);
+
+    /* Copying a part of the last reference of a shared string into it. */
+    t = sdsnew_shared("hello world");
+    t = sdscpylen(t, t+6, 5);
+    TEST_ASSERT_FALSE(sdsisshared(t));
+    TEST_ASSERT_EQUAL_STRING("world", t);
+    sdsfree(t);
+
+    /* Trimming nothing doesn't copy. */
+    t = sdsdup(s);
+    t = sdstrim(t, "x");
+    TEST_ASSERT_TRUE(t == s);
+    t = sdstrim(t, "ho");
+    TEST_ASSERT_EQUAL_STRING("ell", t);
+    TEST_ASSERT_EQUAL_STRING("hello", s);
+    TEST_ASSERT_EQUAL(1, sdsrefcount(s));
+    sdsfree(t);
+
+    /* Shared strings have no free space to give back. */
+    TEST_ASSERT_TRUE(sdsRemoveFreeSpace(s) == s);
+    TEST_ASSERT_EQUAL(sdslen(s), sdsalloc(s));
+
+    /* Unsharing the last reference, then sharing again. */
+    t = sdsdup(s);
+    u = sdsunshare(t);
+    TEST_ASSERT_TRUE(u != s);
+    TEST_ASSERT_FALSE(sdsisshared(u));
+    TEST_ASSERT_EQUAL(1, sdsrefcount(s));
+    sdstoupper(u);
+    TEST_ASSERT_EQUAL_STRING("HELLO", u);
+    u = sdsshare(u);
+    TEST_ASSERT_TRUE(sdsisshared(u));
+    TEST_ASSERT_TRUE(sdsshare(u) == u);
+    TEST_ASSERT_EQUAL_STRING("HELLO", u);
+    sdsfree(u);
+
+    /* Short strings are never of type 5, binary safe content. */
+    t = sdsnewlen_shared("a\0b", 3);
+    TEST_ASSERT_TRUE(sdsisshared(t));
+    TEST_ASSERT_EQUAL(3, sdslen(t));
+    TEST_ASSERT_EQUAL_MEMORY("a\0b", t, 3);
+    sdsfree(t);
+    t = sdsnew("abc");
+    TEST_ASSERT_FALSE(sdsisshared(t));
+    TEST_ASSERT_EQUAL(1, sdsrefcount(t));
+    TEST_ASSERT_TRUE(sdsunshare(t) == t);
+    sdsfree(t);
+
+    /* References taken and released from several threads. */
+    for (j = 0; j < SDS_SHARED_TEST_THREADS; j++)
+        pthread_create(&threads[j], NULL, sdsSharedTestWorker, s);
+    for (j = 0; j < SDS_SHARED_TEST_THREADS; j++)
+        pthread_join(threads[j], NULL);
+    TEST_ASSERT_EQUAL(1, sdsrefcount(s));
+    TEST_ASSERT_EQUAL_STRING("hello", s);
+    sdsfree(s);
+}
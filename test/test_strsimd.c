@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sds.h>
+#include <strsimd.h>
+
+#define STRSIMD_TEST_LEN 200
+
+/* Random bytes, mostly letters and separators to get matches. */
+static void strsimdTestFill(char *p, size_t len) {
+    static const char alphabet[] = "aZ \t\r\n:,=zA09\x80\xff";
+    size_t j;
+
+    for (j = 0; j < len; j++)
+        p[j] = rand() % 4 ? alphabet[rand() % (sizeof(alphabet)-1)] : (char)rand();
+}
+
+/* Join the tokens from an iterator with '|' as separator. */
+static sds strsimdTestJoinSplit(const char *p, size_t len, const char *sep, size_t seplen) {
+    sdsSplitIter it;
+    const char *tok;
+    size_t toklen;
+    sds out = sdsempty();
+    int first = 1;
+
+    sdsSplitIterInit(&it, p, len, sep, seplen);
+    while (sdsSplitIterNext(&it, &tok, &toklen)) {
+        if (!first) out = sdscatlen(out, "|", 1);
+        out = sdscatlen(out, tok, toklen);
+        first = 0;
+    }
+    return out;
+}
+
+/* sdscatrepr() as it was before strsimdReprSpan(), byte by byte. */
+static sds strsimdTestRepr(sds s, const char *p, size_t len) {
+    s = sdscatlen(s, "\"", 1);
+    while (len--) {
+        switch (*p) {
+        case '\\':
+        case '"':
+            s = sdscatprintf(s, "\\%c", *p);
+            break;
+        case '\n': s = sdscatlen(s,"\\n",2); break;
+        case '\r': s = sdscatlen(s,"\\r",2); break;
+        case '\t': s = sdscatlen(s,"\\t",2); break;
+        case '\a': s = sdscatlen(s,"\\a",2); break;
+        case '\b': s = sdscatlen(s,"\\b",2); break;
+        default:
+            if (isprint((unsigned char)*p))
+                s = sdscatprintf(s,"%c",*p);
+            else
+                s = sdscatprintf(s,"\\x%02x",(unsigned char)*p);
+            break;
+        }
+        p++;
+    }
+    return sdscatlen(s,"\"",1);
+}
+
+static int strsimdTestInSet(char c, const char *set, size_t setlen) {
+    return memchr(set, c, setlen) != NULL;
+}
+
+void test_strsimd(void) {
+    char buf[STRSIMD_TEST_LEN+32], ref[STRSIMD_TEST_LEN+32], other[STRSIMD_TEST_LEN+32];
+    char set[24], to[24];
+    int impl, round;
+    size_t len, setlen, j, i;
+    sds s;
+
+    srand(42);
+    for (impl = STRSIMD_SCALAR; impl <= STRSIMD_AVX2; impl++) {
+        if (strsimdSetImplementation(impl) == -1) continue;
+        TEST_ASSERT_EQUAL(impl, strsimdImplementation());
+
+        for (round = 0; round < 2000; round++) {
+            /* Unaligned strings of every length up to a few vectors. */
+            char *p = buf+rand()%32;
+
+            len = rand() % STRSIMD_TEST_LEN;
+            setlen = rand() % (STRSIMD_SET_MAX+4);
+            strsimdTestFill(p, len);
+            strsimdTestFill(set, setlen);
+            strsimdTestFill(to, setlen);
+
+            memcpy(ref, p, len);
+            for (j = 0; j < len; j++) ref[j] = (unsigned char)p[j] < 128 ? tolower(p[j]) : p[j];
+            memcpy(other, p, len);
+            strsimdToLower(other, len);
+            if (len) TEST_ASSERT_EQUAL_MEMORY(ref, other, len);
+
+            for (j = 0; j < len; j++) ref[j] = (unsigned char)p[j] < 128 ? toupper(p[j]) : p[j];
+            memcpy(other, p, len);
+            strsimdToUpper(other, len);
+            if (len) TEST_ASSERT_EQUAL_MEMORY(ref, other, len);
+
+            for (j = 0; j < len; j++) {
+                ref[j] = p[j];
+                for (i = 0; i < setlen; i++) {
+                    if (p[j] == set[i]) {
+                        ref[j] = to[i];
+                        break;
+                    }
+                }
+            }
+            memcpy(other, p, len);
+            strsimdMapChars(other, len, set, to, setlen);
+            if (len) TEST_ASSERT_EQUAL_MEMORY(ref, other, len);
+
+            for (j = 0; j < len && strsimdTestInSet(p[j], set, setlen); j++);
+            TEST_ASSERT_EQUAL(j, strsimdSpan(p, len, set, setlen));
+            for (j = len; j > 0 && strsimdTestInSet(p[j-1], set, setlen); j--);
+            TEST_ASSERT_EQUAL(len-j, strsimdSpanReverse(p, len, set, setlen));
+            for (j = 0; j < len && !strsimdTestInSet(p[j], set, setlen); j++);
+            TEST_ASSERT_EQUAL(j, strsimdFindChars(p, len, set, setlen));
+
+            /* Substring search, with needles that are often in 'p'. */
+            {
+                size_t nlen = rand() % 6, pos = len ? rand() % len : 0;
+                const char *needle = set;
+
+                if (nlen > len-pos) nlen = len-pos;
+                if (nlen && rand() % 2) needle = p+pos;
+                else strsimdTestFill(set, nlen);
+                for (j = 0; j+nlen <= len && memcmp(p+j, needle, nlen); j++);
+                if (j+nlen > len) j = len;
+                TEST_ASSERT_EQUAL(j, strsimdFind(p, len, needle, nlen));
+            }
+
+            /* Long runs of the set, to go through whole vectors. */
+            if (setlen) {
+                for (j = 0; j < len; j++) other[j] = set[rand() % setlen];
+                j = rand() % (len+1);
+                TEST_ASSERT_EQUAL(len, strsimdSpan(other, len, set, setlen));
+                if (j < len && !strsimdTestInSet('\x01', set, setlen)) {
+                    other[j] = '\x01';
+                    TEST_ASSERT_EQUAL(j, strsimdSpan(other, len, set, setlen));
+                    TEST_ASSERT_EQUAL(len-j-1, strsimdSpanReverse(other, len, set, setlen));
+                }
+            }
+
+            /* Escaping, of random bytes and of mostly printable text. */
+            for (j = 0; j < 2; j++) {
+                sds r1, r2;
+
+                for (i = 0; j && i < len; i++)
+                    if (rand() % 8) p[i] = ' '+rand()%95;
+                r1 = strsimdTestRepr(sdsnew("k="), p, len);
+                r2 = sdscatrepr(sdsnew("k="), p, len);
+                TEST_ASSERT_EQUAL(sdslen(r1), sdslen(r2));
+                TEST_ASSERT_EQUAL_MEMORY(r1, r2, sdslen(r1));
+                sdsfree(r1);
+                sdsfree(r2);
+                for (i = 0; i < len && p[i] >= ' ' && p[i] <= '~' && p[i] != '"' && p[i] != '\\'; i++);
+                TEST_ASSERT_EQUAL(i, strsimdReprSpan(p, len));
+            }
+
+            /* Case insensitive comparisons of a string with a copy with
+             * random cases, and maybe one different byte. */
+            for (j = 0; j < len; j++)
+                other[j] = rand() % 2 ? ref[j] : (char)tolower((unsigned char)ref[j]);
+            for (j = 0; j < len; j++)
+                if ((unsigned char)ref[j] >= 128) other[j] = ref[j];
+            TEST_ASSERT_EQUAL(0, strsimdCaseCmp(ref, other, len));
+            if (len) {
+                j = rand() % len;
+                other[j] = (char)rand();
+                i = (unsigned char)ref[j] < 128 ? tolower((unsigned char)ref[j]) : (unsigned char)ref[j];
+                {
+                    int c2 = (unsigned char)other[j] < 128 ?
+                        tolower((unsigned char)other[j]) : (unsigned char)other[j];
+                    int cmp = strsimdCaseCmp(ref, other, len);
+
+                    if ((int)i == c2) TEST_ASSERT_EQUAL(0, cmp);
+                    else TEST_ASSERT_EQUAL((int)i-c2, cmp);
+                }
+            }
+        }
+    }
+    strsimdSetImplementation(STRSIMD_AUTO);
+
+    /* The sds functions built on the kernels. */
+    s = sdsnew("  \t HelloWorld of the 123 sds strings to trim \r\n");
+    s = sdstrim(s, " \t\r\n");
+    TEST_ASSERT_EQUAL_STRING("HelloWorld of the 123 sds strings to trim", s);
+    sdstoupper(s);
+    TEST_ASSERT_EQUAL_STRING("HELLOWORLD OF THE 123 SDS STRINGS TO TRIM", s);
+    sdstolower(s);
+    TEST_ASSERT_EQUAL_STRING("helloworld of the 123 sds strings to trim", s);
+    s = sdsmapchars(s, " o", "_0", 2);
+    TEST_ASSERT_EQUAL_STRING("hell0w0rld_0f_the_123_sds_strings_t0_trim", s);
+    TEST_ASSERT_EQUAL(7, sdsfindchars(s, 0, "fr", 2));
+    TEST_ASSERT_EQUAL(4, sdsfindchars(s, 0, "0", 1));
+    TEST_ASSERT_EQUAL(6, sdsfindchars(s, 5, "0", 1));
+    TEST_ASSERT_EQUAL(-1, sdsfindchars(s, 0, "#", 1));
+    TEST_ASSERT_EQUAL(-1, sdsfindchars(s, 100, "0", 1));
+    sdsfree(s);
+
+    /* A NUL byte is trimmed, as strchr() finds the terminator of cset. */
+    s = sdsnewlen("\0abc\0", 5);
+    s = sdstrim(s, "x");
+    TEST_ASSERT_EQUAL(3, sdslen(s));
+    TEST_ASSERT_EQUAL_STRING("abc", s);
+    sdsfree(s);
+
+    s = sdsnew("Content-Length");
+    {
+        sds t = sdsnew("content-length"), u = sdsnew("content-lengtH:");
+
+        TEST_ASSERT_EQUAL(0, sdscasecmp(s, t));
+        TEST_ASSERT_TRUE(sdscmp(s, t) < 0);
+        TEST_ASSERT_TRUE(sdscasecmp(s, u) < 0);
+        TEST_ASSERT_TRUE(sdscasecmp(u, s) > 0);
+        sdsfree(t);
+        sdsfree(u);
+    }
+    sdsfree(s);
+}
+
+void test_sdsSplitIter(void) {
+    const char *tok;
+    size_t toklen;
+    sdsArgsIter ait;
+    sds *tokens, out;
+    int count, j;
+
+    out = strsimdTestJoinSplit("foo_-_bar_-__-_baz_-_", 21, "_-_", 3);
+    TEST_ASSERT_EQUAL_STRING("foo|bar||baz|", out);
+    sdsfree(out);
+    out = strsimdTestJoinSplit("a,b", 3, ",", 1);
+    TEST_ASSERT_EQUAL_STRING("a|b", out);
+    sdsfree(out);
+    out = strsimdTestJoinSplit("abc", 3, "abcd", 4);
+    TEST_ASSERT_EQUAL_STRING("abc", out);
+    sdsfree(out);
+    out = strsimdTestJoinSplit("", 0, ",", 1);
+    TEST_ASSERT_EQUAL_STRING("", out);
+    sdsfree(out);
+
+    /* Separators far apart, to go through whole vectors. */
+    out = sdsempty();
+    for (j = 0; j < 20; j++) {
+        out = sdscatprintf(out, "%0*d", j*7, j);
+        out = sdscatlen(out, "\r\n", 2);
+    }
+    tokens = sdssplitlen(out, sdslen(out), "\r\n", 2, &count);
+    TEST_ASSERT_EQUAL(21, count);
+    for (j = 0; j < 20; j++) TEST_ASSERT_EQUAL(j ? j*7 : 1, sdslen(tokens[j]));
+    TEST_ASSERT_EQUAL(0, sdslen(tokens[20]));
+    sdsfreesplitres(tokens, count);
+    sdsfree(out);
+
+    tokens = sdssplitlen("", 0, ",", 1, &count);
+    TEST_ASSERT_NOT_NULL(tokens);
+    TEST_ASSERT_EQUAL(0, count);
+    sdsfreesplitres(tokens, count);
+    TEST_ASSERT_NULL(sdssplitlen("a,b", 3, "", 0, &count));
+
+    /* Unquoted arguments are views into the line, quoted ones are unescaped. */
+    {
+        const char *line = "  set key\tx \"va\\x41l\\n\" 'it\\'s' a\"b c\"  ";
+
+        sdsArgsIterInit(&ait, line);
+        TEST_ASSERT_EQUAL(1, sdsArgsIterNext(&ait, &tok, &toklen));
+        TEST_ASSERT_TRUE(tok == line+2);
+        TEST_ASSERT_EQUAL(3, toklen);
+        TEST_ASSERT_EQUAL(1, sdsArgsIterNext(&ait, &tok, &toklen));
+        TEST_ASSERT_EQUAL(3, toklen);
+        TEST_ASSERT_EQUAL_MEMORY("key", tok, 3);
+        TEST_ASSERT_EQUAL(1, sdsArgsIterNext(&ait, &tok, &toklen));
+        TEST_ASSERT_EQUAL_MEMORY("x", tok, 1);
+        TEST_ASSERT_EQUAL(1, sdsArgsIterNext(&ait, &tok, &toklen));
+        TEST_ASSERT_EQUAL(5, toklen);
+        TEST_ASSERT_EQUAL_MEMORY("vaAl\n", tok, 5);
+        TEST_ASSERT_EQUAL(1, sdsArgsIterNext(&ait, &tok, &toklen));
+        TEST_ASSERT_EQUAL(4, toklen);
+        TEST_ASSERT_EQUAL_MEMORY("it's", tok, 4);
+        TEST_ASSERT_EQUAL(1, sdsArgsIterNext(&ait, &tok, &toklen));
+        TEST_ASSERT_EQUAL(4, toklen);
+        TEST_ASSERT_EQUAL_MEMORY("ab c", tok, 4);
+        TEST_ASSERT_EQUAL(0, sdsArgsIterNext(&ait, &tok, &toklen));
+        sdsArgsIterRelease(&ait);
+    }
+
+    tokens = sdssplitargs("a \"\\x00b\" ''", &count);
+    TEST_ASSERT_NOT_NULL(tokens);
+    TEST_ASSERT_EQUAL(3, count);
+    TEST_ASSERT_EQUAL_STRING("a", tokens[0]);
+    TEST_ASSERT_EQUAL(2, sdslen(tokens[1]));
+    TEST_ASSERT_EQUAL_MEMORY("\0b", tokens[1], 2);
+    TEST_ASSERT_EQUAL(0, sdslen(tokens[2]));
+    sdsfreesplitres(tokens, count);
+
+    tokens = sdssplitargs("   ", &count);
+    TEST_ASSERT_NOT_NULL(tokens);
+    TEST_ASSERT_EQUAL(0, count);
+    sdsfreesplitres(tokens, count);
+    TEST_ASSERT_NULL(sdssplitargs("a \"foo\"bar", &count));
+    TEST_ASSERT_EQUAL(0, count);
+    TEST_ASSERT_NULL(sdssplitargs("a 'foo", &count));
+}
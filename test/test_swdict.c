@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <swdict.h>
+
+#define SWDICT_TEST_KEYS 20000
+
+static uint64_t swdictTestHash(const void *key) {
+    return dictGenHashFunction(&key, sizeof(key));
+}
+
+static dictType swdictTestType = {
+    .hashFunction = swdictTestHash,
+};
+
+static void swdictTestScanCallback(void *privdata, const swdictEntry *de) {
+    unsigned char *seen = privdata;
+    seen[(intptr_t)swdictGetKey(de)]++;
+}
+
+void test_swdict(void) {
+    swdict *d;
+    swdictEntry *de, *existing;
+    long j;
+
+    d = swdictCreate(&swdictTestType, NULL);
+    TEST_ASSERT_NOT_EQUAL(NULL, d);
+
+    for (j = 1; j <= SWDICT_TEST_KEYS; j++) {
+        de = swdictAddRaw(d, (void*)(intptr_t)j, NULL);
+        TEST_ASSERT_NOT_EQUAL(NULL, de);
+        swdictGetUnsignedIntegerVal(de) = j*2;
+    }
+    TEST_ASSERT_EQUAL(SWDICT_TEST_KEYS, swdictSize(d));
+
+    /* Duplicated keys are refused and the existing slot is returned. */
+    de = swdictAddRaw(d, (void*)(intptr_t)42, &existing);
+    TEST_ASSERT_EQUAL(NULL, de);
+    TEST_ASSERT_NOT_EQUAL(NULL, existing);
+    TEST_ASSERT_EQUAL(84, swdictGetUnsignedIntegerVal(existing));
+
+    for (j = 1; j <= SWDICT_TEST_KEYS; j++) {
+        de = swdictFind(d, (void*)(intptr_t)j);
+        TEST_ASSERT_NOT_EQUAL(NULL, de);
+        TEST_ASSERT_EQUAL(j*2, swdictGetUnsignedIntegerVal(de));
+    }
+    TEST_ASSERT_EQUAL(NULL, swdictFind(d, (void*)(intptr_t)(SWDICT_TEST_KEYS+1)));
+
+    /* Delete the even keys, then add them back: this exercises deleted
+     * slots reuse and the same size rehashing. */
+    for (j = 2; j <= SWDICT_TEST_KEYS; j += 2)
+        TEST_ASSERT_EQUAL(DICT_OK, swdictDelete(d, (void*)(intptr_t)j));
+    TEST_ASSERT_EQUAL(DICT_ERR, swdictDelete(d, (void*)(intptr_t)2));
+    TEST_ASSERT_EQUAL(SWDICT_TEST_KEYS/2, swdictSize(d));
+    for (j = 1; j <= SWDICT_TEST_KEYS; j++) {
+        de = swdictFind(d, (void*)(intptr_t)j);
+        if (j % 2) TEST_ASSERT_NOT_EQUAL(NULL, de);
+        else TEST_ASSERT_EQUAL(NULL, de);
+    }
+    for (j = 2; j <= SWDICT_TEST_KEYS; j += 2)
+        TEST_ASSERT_EQUAL(DICT_OK, swdictAdd(d, (void*)(intptr_t)j, NULL));
+    TEST_ASSERT_EQUAL(SWDICT_TEST_KEYS, swdictSize(d));
+
+    swdictRelease(d);
+}
+
+void test_swdictScan(void) {
+    swdict *d;
+    unsigned char *seen;
+    unsigned long cursor = 0;
+    long j;
+
+    d = swdictCreate(&swdictTestType, NULL);
+    seen = calloc(SWDICT_TEST_KEYS*2+1, 1);
+    for (j = 1; j <= SWDICT_TEST_KEYS; j++)
+        swdictAdd(d, (void*)(intptr_t)j, NULL);
+
+    /* Keys present for the whole scan must be returned even if the table
+     * is resized (and rehashed) between the calls. */
+    do {
+        cursor = swdictScan(d, cursor, swdictTestScanCallback, seen);
+        for (j = 0; j < 16 && swdictSize(d) < SWDICT_TEST_KEYS*2; j++)
+            swdictAdd(d, (void*)(intptr_t)(swdictSize(d)+1), NULL);
+    } while (cursor);
+
+    for (j = 1; j <= SWDICT_TEST_KEYS; j++)
+        TEST_ASSERT_TRUE(seen[j] >= 1);
+
+    free(seen);
+    swdictRelease(d);
+}
+
+static long swdictTestCompareCalls = 0;
+
+static int swdictTestCompare(void *privdata, const void *key1, const void *key2) {
+    DICT_NOTUSED(privdata);
+    swdictTestCompareCalls++;
+    return key1 == key2;
+}
+
+static dictType swdictTestCountingType = {
+    .hashFunction = swdictTestHash,
+    .keyCompare = swdictTestCompare,
+};
+
+void test_swdictProbe(void) {
+    swdict *d;
+    long j;
+
+    TEST_ASSERT_NOT_EQUAL(NULL, swdictProbeImplementation());
+    d = swdictCreate(&swdictTestCountingType, NULL);
+    for (j = 1; j <= SWDICT_TEST_KEYS; j++)
+        swdictAdd(d, (void*)(intptr_t)j, NULL);
+
+    /* Negative lookups should only call the comparison callback when the
+     * 7 bit tag collides, that is seldom. */
+    swdictTestCompareCalls = 0;
+    for (j = SWDICT_TEST_KEYS+1; j <= SWDICT_TEST_KEYS*2; j++)
+        TEST_ASSERT_EQUAL(NULL, swdictFind(d, (void*)(intptr_t)j));
+    TEST_ASSERT_TRUE(swdictTestCompareCalls < SWDICT_TEST_KEYS/4);
+
+    swdictRelease(d);
+}
+
+/* Count the deleted control bytes of a table. */
+static unsigned long swdictTestCountDeleted(swdictht *ht) {
+    unsigned long deleted = 0, g;
+    int j;
+
+    for (g = 0; g < ht->size; g++)
+        for (j = 0; j < SWDICT_GROUP_SLOTS; j++)
+            if (ht->groups[g].ctrl[j] == SWDICT_CTRL_DELETED) deleted++;
+    return deleted;
+}
+
+void test_swdictRehashDeleted(void) {
+    swdict *d = swdictCreate(&swdictTestType, NULL);
+    long j;
+
+    for (j = 1; j <= SWDICT_TEST_KEYS; j++)
+        swdictAdd(d, (void*)(intptr_t)j, NULL);
+    while (swdictRehash(d, 1000));
+    TEST_ASSERT_EQUAL(DICT_OK, swdictExpand(d, SWDICT_TEST_KEYS*4));
+    TEST_ASSERT_TRUE(swdictIsRehashing(d));
+
+    /* Keys added and deleted during the rehashing leave deleted slots in
+     * the full groups of the new table, that the moved keys then reuse.
+     * Keep the rehashing paused so the new table fills up with them. */
+    d->pauserehash++;
+    for (j = SWDICT_TEST_KEYS+1; j <= SWDICT_TEST_KEYS*5; j++)
+        TEST_ASSERT_EQUAL(DICT_OK, swdictAdd(d, (void*)(intptr_t)j, NULL));
+    for (j = SWDICT_TEST_KEYS+1; j <= SWDICT_TEST_KEYS*5; j++)
+        TEST_ASSERT_EQUAL(DICT_OK, swdictDelete(d, (void*)(intptr_t)j));
+    d->pauserehash--;
+    TEST_ASSERT_TRUE(d->ht[1].deleted > 0);
+    TEST_ASSERT_TRUE(swdictIsRehashing(d));
+    TEST_ASSERT_EQUAL(swdictTestCountDeleted(&d->ht[1]), d->ht[1].deleted);
+    while (swdictRehash(d, 1000));
+    TEST_ASSERT_EQUAL(swdictTestCountDeleted(&d->ht[0]), d->ht[0].deleted);
+    TEST_ASSERT_EQUAL(SWDICT_TEST_KEYS, swdictSize(d));
+    for (j = 1; j <= SWDICT_TEST_KEYS; j++)
+        TEST_ASSERT_NOT_EQUAL(NULL, swdictFind(d, (void*)(intptr_t)j));
+    swdictRelease(d);
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <sds.h>
+#include <util.h>
+
+static uint64_t utilTestRandState = 88172645463325252ULL;
+
+static uint64_t utilTestRand(void) {
+    utilTestRandState ^= utilTestRandState << 13;
+    utilTestRandState ^= utilTestRandState >> 7;
+    utilTestRandState ^= utilTestRandState << 17;
+    return utilTestRandState;
+}
+
+void test_numconv(void) {
+    char buf[MAX_D2STRING_CHARS], ref[MAX_D2STRING_CHARS];
+    long long v;
+    unsigned long long uv;
+    double d, back;
+    int err, j, p;
+    sds s;
+
+    /* Integers to strings. */
+    TEST_ASSERT_EQUAL(1, ll2string(buf, sizeof(buf), 0));
+    TEST_ASSERT_EQUAL_STRING("0", buf);
+    TEST_ASSERT_EQUAL(20, ll2string(buf, sizeof(buf), LLONG_MIN));
+    TEST_ASSERT_EQUAL_STRING("-9223372036854775808", buf);
+    TEST_ASSERT_EQUAL(20, ull2string(buf, sizeof(buf), ULLONG_MAX));
+    TEST_ASSERT_EQUAL_STRING("18446744073709551615", buf);
+    TEST_ASSERT_EQUAL(0, ll2string(buf, 3, -10));
+    TEST_ASSERT_EQUAL_STRING("", buf);
+    TEST_ASSERT_EQUAL(3, ll2string(buf, 4, -10));
+    for (j = 0; j < 100000; j++) {
+        v = (long long)(utilTestRand() >> (utilTestRand() % 64));
+        if (j & 1) v = -v;
+        snprintf(ref, sizeof(ref), "%lld", v);
+        TEST_ASSERT_EQUAL(strlen(ref), ll2string(buf, sizeof(buf), v));
+        TEST_ASSERT_EQUAL_STRING(ref, buf);
+        TEST_ASSERT_EQUAL(1, string2ll(buf, strlen(buf), &v));
+        TEST_ASSERT_EQUAL(strtoll(ref, NULL, 10), v);
+    }
+
+    /* Strings to integers, only the canonical forms. */
+    TEST_ASSERT_EQUAL(1, string2ll("-9223372036854775808", 20, &v));
+    TEST_ASSERT_TRUE(v == LLONG_MIN);
+    TEST_ASSERT_EQUAL(0, string2ll("9223372036854775808", 19, &v));
+    TEST_ASSERT_EQUAL(1, string2ull("18446744073709551615", 20, &uv));
+    TEST_ASSERT_TRUE(uv == ULLONG_MAX);
+    TEST_ASSERT_EQUAL(0, string2ull("18446744073709551616", 20, &uv));
+    TEST_ASSERT_EQUAL(0, string2ll("-0", 2, &v));
+    TEST_ASSERT_EQUAL(0, string2ll("01", 2, &v));
+    TEST_ASSERT_EQUAL(0, string2ll("1 ", 2, &v));
+    TEST_ASSERT_EQUAL(0, string2ll("+1", 2, &v));
+    TEST_ASSERT_EQUAL(0, string2ll("-", 1, &v));
+    TEST_ASSERT_EQUAL(0, string2ll("", 0, &v));
+    TEST_ASSERT_EQUAL(0, string2ll("1234567a", 8, &v));
+    TEST_ASSERT_EQUAL(1, string2ll("12345678", 7, &v));
+    TEST_ASSERT_EQUAL(1234567, v);
+
+    TEST_ASSERT_EQUAL(1073741824, memtoll("1Gb", &err));
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(-7340032, memtoll("-007MB", &err));
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(0, memtoll("9999999999g", &err));
+    TEST_ASSERT_EQUAL(1, err);
+    TEST_ASSERT_EQUAL(0, memtoll("1.5k", &err));
+    TEST_ASSERT_EQUAL(1, err);
+    TEST_ASSERT_EQUAL(0, memtoll("kb", &err));
+    TEST_ASSERT_EQUAL(1, err);
+
+    /* Doubles to strings. */
+    d2string(buf, sizeof(buf), 0.1);
+    TEST_ASSERT_EQUAL_STRING("0.1", buf);
+    d2string(buf, sizeof(buf), -0.0);
+    TEST_ASSERT_EQUAL_STRING("-0", buf);
+    d2string(buf, sizeof(buf), 1e100);
+    TEST_ASSERT_EQUAL_STRING("1e+100", buf);
+    d2string(buf, sizeof(buf), 5e-324);
+    TEST_ASSERT_EQUAL_STRING("5e-324", buf);
+    d2string(buf, sizeof(buf), 1.7976931348623157e308);
+    TEST_ASSERT_EQUAL_STRING("1.7976931348623157e+308", buf);
+    d2string(buf, sizeof(buf), 123456);
+    TEST_ASSERT_EQUAL_STRING("123456", buf);
+    d2string(buf, sizeof(buf), 1e-5);
+    TEST_ASSERT_EQUAL_STRING("1e-05", buf);
+    d2string(buf, sizeof(buf), -HUGE_VAL);
+    TEST_ASSERT_EQUAL_STRING("-inf", buf);
+    d2string(buf, sizeof(buf), NAN);
+    TEST_ASSERT_EQUAL_STRING("nan", buf);
+    TEST_ASSERT_EQUAL(0, d2string(buf, 3, 0.25));
+
+    /* Random doubles give the shortest string that round trips, with the
+     * same digits as the shortest correctly rounded printf(). */
+    for (j = 0; j < 100000; j++) {
+        uint64_t bits = utilTestRand();
+
+        memcpy(&d, &bits, sizeof(d));
+        if (!isfinite(d)) continue;
+        TEST_ASSERT_TRUE(d2string(buf, sizeof(buf), d) > 0);
+        TEST_ASSERT_EQUAL(1, string2d(buf, strlen(buf), &back));
+        TEST_ASSERT_TRUE(back == d && signbit(back) == signbit(d));
+        for (p = 1; p < 17; p++) {
+            snprintf(ref, sizeof(ref), "%.*g", p, d);
+            if (strtod(ref, NULL) == d) break;
+        }
+        snprintf(ref, sizeof(ref), "%.*g", p, d);
+        TEST_ASSERT_TRUE(strtod(buf, NULL) == strtod(ref, NULL));
+        TEST_ASSERT_TRUE(strlen(buf) <= strlen(ref)+1);
+    }
+
+    /* Strings to doubles, fast path and fallback. */
+    for (j = 0; j < 100000; j++) {
+        uint64_t r = utilTestRand();
+
+        switch (j % 3) {
+        case 0: snprintf(ref, sizeof(ref), "%.*g", (int)(r % 17)+1, (double)(int64_t)r / 1e9); break;
+        case 1:
+            snprintf(ref, sizeof(ref), "%llu.%02llue%d", (unsigned long long)(r % 100000),
+                     (unsigned long long)((r>>20) % 100), (int)(r % 50)-25);
+            break;
+        default: snprintf(ref, sizeof(ref), "-%llue-%d", (unsigned long long)r, (int)(r % 320)); break;
+        }
+        TEST_ASSERT_EQUAL(1, string2d(ref, strlen(ref), &d));
+        TEST_ASSERT_TRUE(d == strtod(ref, NULL));
+    }
+    TEST_ASSERT_EQUAL(0, string2d(" 1", 2, &d));
+    TEST_ASSERT_EQUAL(0, string2d("1 ", 2, &d));
+    TEST_ASSERT_EQUAL(0, string2d(".", 1, &d));
+    TEST_ASSERT_EQUAL(0, string2d("1e", 2, &d));
+    TEST_ASSERT_EQUAL(0, string2d("nan", 3, &d));
+    TEST_ASSERT_EQUAL(0, string2d("1e400", 5, &d));
+    TEST_ASSERT_EQUAL(1, string2d("-inf", 4, &d));
+    TEST_ASSERT_TRUE(isinf(d) && d < 0);
+    TEST_ASSERT_EQUAL(1, string2d("1.5", 2, &d));
+    TEST_ASSERT_TRUE(d == 1);
+
+    /* The sds functions built on them. */
+    s = sdscatfmt(sdsempty(), "%i %I %u %U", -1, LLONG_MIN, 4000000000u, ULLONG_MAX);
+    TEST_ASSERT_EQUAL_STRING("-1 -9223372036854775808 4000000000 18446744073709551615", s);
+    s = sdscatdouble(s, 0.5);
+    TEST_ASSERT_EQUAL_STRING("-1 -9223372036854775808 4000000000 184467440737095516150.5", s);
+    sdsfree(s);
+    s = sdsfromdouble(-2.5e-7);
+    TEST_ASSERT_EQUAL_STRING("-2.5e-07", s);
+    sdsfree(s);
+}
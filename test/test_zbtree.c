@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2024-2024, yanruibinghxu@gmail.com All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <zbtree.h>
+#include <skiplist.h>
+#include <zmalloc.h>
+
+#define ZBT_TEST_ELES 20000
+
+static char *zbtTestEle(int id) {
+    char *ele = zmalloc(16);
+
+    snprintf(ele, 16, "ele:%011d", id);
+    return ele;
+}
+
+/* Check the B+tree against a skiplist with the same elements: order in
+ * both directions, ranks and range queries. */
+static void zbtTestCompare(zbtree *zbt, zskiplist *zsl) {
+    zskiplistNode *x;
+    zbtreeIter *iter;
+    unsigned long rank = 0;
+    double score;
+    void *ele;
+    int j;
+
+    TEST_ASSERT_EQUAL(zsl->length, zbt->length);
+    iter = zbtGetIterator(zbt, ZL_START_HEAD);
+    for (x = zsl->header->level[0].forward; x; x = x->level[0].forward) {
+        rank++;
+        TEST_ASSERT_EQUAL(1, zbtNext(iter, &score, &ele));
+        TEST_ASSERT_TRUE(score == x->score);
+        TEST_ASSERT_EQUAL_MEMORY(x->ele, ele, 16);
+        TEST_ASSERT_EQUAL(rank, zbtGetRank(zbt, score, ele, 16));
+    }
+    TEST_ASSERT_EQUAL(0, zbtNext(iter, &score, &ele));
+    zbtReleaseIterator(iter);
+
+    iter = zbtGetIterator(zbt, ZL_START_TAIL);
+    for (x = zsl->tail; x; x = x->backward) {
+        TEST_ASSERT_EQUAL(1, zbtNext(iter, &score, &ele));
+        TEST_ASSERT_EQUAL_MEMORY(x->ele, ele, 16);
+    }
+    TEST_ASSERT_EQUAL(0, zbtNext(iter, &score, &ele));
+    zbtReleaseIterator(iter);
+
+    for (j = 0; j < 100; j++) {
+        zrangespec range;
+        long n = rand() % 20 - 10;
+
+        range.min = rand() % 1100 - 50;
+        range.max = range.min + rand() % 50;
+        range.minex = rand() & 1;
+        range.maxex = rand() & 1;
+        TEST_ASSERT_EQUAL(zslCountInRange(zsl, &range), zbtCountInRange(zbt, &range));
+        x = zslNthInRange(zsl, &range, n);
+        iter = zbtNthInRange(zbt, &range, n);
+        TEST_ASSERT_EQUAL(x == NULL, iter == NULL);
+        if (x == NULL) continue;
+        /* Both go the same way from there. */
+        while (x) {
+            TEST_ASSERT_EQUAL(1, zbtNext(iter, &score, &ele));
+            TEST_ASSERT_EQUAL_MEMORY(x->ele, ele, 16);
+            x = n >= 0 ? x->level[0].forward : x->backward;
+        }
+        TEST_ASSERT_EQUAL(0, zbtNext(iter, &score, &ele));
+        zbtReleaseIterator(iter);
+    }
+}
+
+void test_zbtree(void) {
+    static double scores[ZBT_TEST_ELES];
+    zbtree *zbt = zbtCreate(NULL);
+    zskiplist *zsl = zslCreateInline(NULL, 16);
+    zbtreeIter *iter;
+    char *ele;
+    void *removed;
+    double score;
+    int j;
+
+    /* Empty. */
+    iter = zbtGetIterator(zbt, ZL_START_TAIL);
+    TEST_ASSERT_EQUAL(0, zbtNext(iter, &score, &removed));
+    zbtReleaseIterator(iter);
+    TEST_ASSERT_NULL(zbtNthInRange(zbt, &(zrangespec){0, 10, 0, 0}, 0));
+
+    /* Few distinct scores, so that the elements break the ties. */
+    for (j = 0; j < ZBT_TEST_ELES; j++) {
+        scores[j] = rand() % 1000;
+        ele = zbtTestEle(j);
+        zslInsert(zsl, scores[j], ele, 16);
+        zbtInsert(zbt, scores[j], ele, 16);
+    }
+    TEST_ASSERT_TRUE(zbt->height >= 3);
+    zbtTestCompare(zbt, zsl);
+    TEST_ASSERT_EQUAL(1, zbtGetElementByRank(zbt, 1, &score, &removed));
+    TEST_ASSERT_EQUAL_MEMORY(zsl->header->level[0].forward->ele, removed, 16);
+    TEST_ASSERT_EQUAL(0, zbtGetElementByRank(zbt, ZBT_TEST_ELES+1, &score, &removed));
+
+    /* Delete most of the elements, in another order, shrinking the tree. */
+    for (j = 0; j < ZBT_TEST_ELES; j++) {
+        int id = (j * 7919) % ZBT_TEST_ELES;
+        char buf[16];
+
+        if (j % 10 == 9) continue;
+        snprintf(buf, sizeof(buf), "ele:%011d", id);
+        TEST_ASSERT_EQUAL(1, zslDelete(zsl, scores[id], buf, 16, NULL));
+        if (j == 0) {
+            TEST_ASSERT_EQUAL(1, zbtDelete(zbt, scores[id], buf, 16, &removed));
+            TEST_ASSERT_EQUAL_MEMORY(buf, removed, 16);
+            zfree(removed);
+        } else {
+            TEST_ASSERT_EQUAL(1, zbtDelete(zbt, scores[id], buf, 16, NULL));
+        }
+        TEST_ASSERT_EQUAL(0, zbtDelete(zbt, scores[id], buf, 16, NULL));
+        if (j % 4000 == 0) zbtTestCompare(zbt, zsl);
+    }
+    zbtTestCompare(zbt, zsl);
+    TEST_ASSERT_EQUAL(ZBT_TEST_ELES/10, zbt->length);
+
+    /* Then the others, down to a single empty leaf. */
+    while (zbtGetElementByRank(zbt, 1, &score, &removed))
+        TEST_ASSERT_EQUAL(1, zbtDelete(zbt, score, removed, 16, NULL));
+    TEST_ASSERT_EQUAL(0, zbt->length);
+    TEST_ASSERT_EQUAL(1, zbt->height);
+    zslFree(zsl);
+    zbtFree(zbt);
+}
@@ -285,4 +285,265 @@ void test_zslIterator(void) {
     n = zslNext(iter);
     TEST_ASSERT_EQUAL_INT(42, *((int*)n->ele));
     zslReleaseIterator(iter);
-}
\ No newline at end of file
+}
+
+void test_zslInline(void) {
+    static const size_t inlinemax[] = {16, 8};
+    char ele[16], prev[16];
+    double scores[2000];
+    zskiplist *zl;
+    zskiplistNode *n;
+    zskiplistIter *iter;
+    double prevscore;
+    unsigned long count;
+    size_t c;
+    int j;
+
+    /* Elements stored in the nodes, then all too large to be inline. */
+    for (c = 0; c < sizeof(inlinemax)/sizeof(inlinemax[0]); c++) {
+        zl = zslCreateInline(NULL, inlinemax[c]);
+        TEST_ASSERT_NOT_EQUAL(NULL, zl);
+        for (j = 0; j < 2000; j++) {
+            scores[j] = rand() % 500;
+            snprintf(ele, sizeof(ele), "ele:%011d", j);
+            n = zslInsert(zl, scores[j], ele, sizeof(ele));
+            TEST_ASSERT_NOT_EQUAL(NULL, n);
+            /* The element is copied, the buffer can be reused. */
+            TEST_ASSERT_TRUE(n->ele != ele);
+            TEST_ASSERT_EQUAL_MEMORY(ele, n->ele, sizeof(ele));
+        }
+        TEST_ASSERT_EQUAL(2000, zl->length);
+
+        /* Delete every other element, reusing a node once. */
+        for (j = 0; j < 2000; j++) {
+            double score = scores[j];
+
+            if (j % 2) continue;
+            snprintf(ele, sizeof(ele), "ele:%011d", j);
+            if (j == 0) {
+                TEST_ASSERT_EQUAL(1, zslDelete(zl, score, ele, sizeof(ele), &n));
+                TEST_ASSERT_EQUAL_MEMORY(ele, n->ele, sizeof(ele));
+                zslFreeNode(zl, n);
+            } else {
+                TEST_ASSERT_EQUAL(1, zslDelete(zl, score, ele, sizeof(ele), NULL));
+            }
+            TEST_ASSERT_EQUAL(0, zslGetRank(zl, score, ele, sizeof(ele)));
+        }
+        TEST_ASSERT_EQUAL(1000, zl->length);
+
+        /* Freed nodes are reused by the next insertions. */
+        for (j = 0; j < 1000; j++) {
+            snprintf(ele, sizeof(ele), "new:%011d", j);
+            zslInsert(zl, j % 700, ele, sizeof(ele));
+        }
+        TEST_ASSERT_EQUAL(2000, zl->length);
+
+        /* In order, with ranks matching the positions. */
+        iter = zslGetIterator(zl, ZL_START_HEAD);
+        count = 0;
+        prevscore = -1;
+        while ((n = zslNext(iter)) != NULL) {
+            count++;
+            TEST_ASSERT_TRUE(n->score >= prevscore);
+            if (n->score == prevscore)
+                TEST_ASSERT_TRUE(memcmp(prev, n->ele, sizeof(prev)) < 0);
+            TEST_ASSERT_EQUAL(count, zslGetRank(zl, n->score, n->ele, sizeof(ele)));
+            prevscore = n->score;
+            memcpy(prev, n->ele, sizeof(prev));
+        }
+        zslReleaseIterator(iter);
+        TEST_ASSERT_EQUAL(2000, count);
+
+        {
+            zrangespec range = { .min = 100, .max = 200, .minex = 0, .maxex = 1 };
+
+            n = zslNthInRange(zl, &range, 0);
+            TEST_ASSERT_NOT_EQUAL(NULL, n);
+            TEST_ASSERT_TRUE(n->score >= 100);
+            TEST_ASSERT_TRUE(n->backward == NULL || n->backward->score < 100);
+            n = zslNthInRange(zl, &range, -1);
+            TEST_ASSERT_NOT_EQUAL(NULL, n);
+            TEST_ASSERT_TRUE(n->score < 200);
+            TEST_ASSERT_TRUE(n->level[0].forward->score >= 200);
+        }
+        zslFree(zl);
+    }
+}
+
+/* Check the order, the ranks and the backward links of a skiplist of 16
+ * bytes elements. */
+static void zslCheckList(zskiplist *zl, unsigned long length) {
+    zskiplistNode *n, *prev = NULL;
+    unsigned long count = 0;
+
+    for (n = zl->header->level[0].forward; n; n = n->level[0].forward) {
+        count++;
+        TEST_ASSERT_TRUE(n->backward == prev);
+        if (prev) {
+            TEST_ASSERT_TRUE(n->score >= prev->score);
+            if (n->score == prev->score)
+                TEST_ASSERT_TRUE(memcmp(prev->ele, n->ele, 16) < 0);
+        }
+        TEST_ASSERT_EQUAL(count, zslGetRank(zl, n->score, n->ele, 16));
+        prev = n;
+    }
+    TEST_ASSERT_TRUE(zl->tail == prev);
+    TEST_ASSERT_EQUAL(length, count);
+    TEST_ASSERT_EQUAL(length, zl->length);
+}
+
+void test_zslBulkLoad(void) {
+    static char eles[3000][16];
+    zskiplistEntry entries[3000], tmp;
+    zrangespec range = { .min = 100, .max = 200, .minex = 0, .maxex = 0 };
+    zskiplist *zl;
+    zskiplistNode *n;
+    int j, k;
+
+    for (j = 0; j < 3000; j++) {
+        snprintf(eles[j], sizeof(eles[j]), "ele:%011d", j);
+        entries[j].score = j/2;
+        entries[j].ele = eles[j];
+        entries[j].size = sizeof(eles[j]);
+    }
+
+    /* Sorted input, loaded without search. */
+    zl = zslCreateInline(NULL, 16);
+    TEST_ASSERT_EQUAL(0, zslBulkLoad(zl, entries, 2000));
+    zslCheckList(zl, 2000);
+    /* Balanced: a node every 4 at level 2, every 16 at level 3... */
+    for (n = zl->header->level[1].forward, j = 4; n; n = n->level[1].forward, j += 4)
+        TEST_ASSERT_EQUAL(j, zslGetRank(zl, n->score, n->ele, 16));
+    TEST_ASSERT_EQUAL(6, zl->level);
+    n = zslNthInRange(zl, &range, 0);
+    TEST_ASSERT_EQUAL_MEMORY(eles[200], n->ele, 16);
+    n = zslNthInRange(zl, &range, -1);
+    TEST_ASSERT_EQUAL_MEMORY(eles[401], n->ele, 16);
+
+    /* Not empty any more. */
+    TEST_ASSERT_EQUAL(-1, zslBulkLoad(zl, entries+2000, 10));
+
+    /* The skiplist keeps working after a bulk load. */
+    TEST_ASSERT_EQUAL(1, zslDelete(zl, 0, eles[1], 16, NULL));
+    zslInsert(zl, 0.5, eles[1], 16);
+    zslCheckList(zl, 2000);
+    zslFree(zl);
+
+    /* Unsorted input is rejected. */
+    zl = zslCreateInline(NULL, 16);
+    tmp = entries[5]; entries[5] = entries[6]; entries[6] = tmp;
+    TEST_ASSERT_EQUAL(-1, zslBulkLoad(zl, entries, 10));
+    TEST_ASSERT_EQUAL(0, zl->length);
+
+    /* A batch is sorted and bulk loaded into an empty skiplist. */
+    zslInsertMany(zl, entries, 1000);
+    zslCheckList(zl, 1000);
+
+    /* Then merged: the other half, shuffled, in batches. */
+    for (j = 2999; j > 1000; j--) {
+        k = 1000+rand() % (j-1000+1);
+        tmp = entries[j]; entries[j] = entries[k]; entries[k] = tmp;
+    }
+    zslInsertMany(zl, entries+1000, 1500);
+    zslCheckList(zl, 2500);
+    zslInsertMany(zl, entries+2500, 500);
+    zslCheckList(zl, 3000);
+    for (j = 0; j < 3000; j++) {
+        n = zslNthInRange(zl, &(zrangespec){0, 3000, 0, 0}, j);
+        TEST_ASSERT_EQUAL_MEMORY(eles[j], n->ele, 16);
+    }
+    zslFree(zl);
+}
+
+/* Counts the deleted elements, and marks them in the array of the ids. */
+static void zslTestFreeEle(void *ele, void *privdata) {
+    char *deleted = privdata;
+
+    deleted[atoi((char*)ele+4)]++;
+}
+
+void test_zslRange(void) {
+    static char eles[3000][16], deleted[3000];
+    zskiplistEntry entries[3000];
+    zskiplist *zl;
+    unsigned long count, removed;
+    int j, round;
+
+    /* Random levels, with 3 elements per score. */
+    zl = zslCreateInline(NULL, 16);
+    for (j = 0; j < 3000; j++) {
+        snprintf(eles[j], sizeof(eles[j]), "ele:%011d", j);
+        zslInsert(zl, j/3, eles[j], 16);
+    }
+    memset(deleted, 0, sizeof(deleted));
+    for (round = 0; round < 200; round++) {
+        zrangespec range;
+        int min = rand() % 1100 - 50, max = min + rand() % 100;
+
+        range.min = min;
+        range.max = max;
+        range.minex = rand() & 1;
+        range.maxex = rand() & 1;
+        count = 0;
+        for (j = 0; j < 3000; j++)
+            if (!deleted[j] && zslValueGteMin(j/3, &range) && zslValueLteMax(j/3, &range))
+                count++;
+        TEST_ASSERT_EQUAL(count, zslCountInRange(zl, &range));
+        if (round % 4 == 0) {
+            removed = zslDeleteRangeByScore(zl, &range, zslTestFreeEle, deleted);
+            TEST_ASSERT_EQUAL(count, removed);
+        }
+    }
+    for (j = 0, count = 0; j < 3000; j++) {
+        TEST_ASSERT_TRUE(deleted[j] <= 1);
+        count += !deleted[j];
+    }
+    zslCheckList(zl, count);
+
+    /* By rank: the first, some in the middle, then past the end. */
+    for (round = 0; round < 50; round++) {
+        unsigned long start = 1 + rand() % (zl->length+10), end = start + rand() % 30;
+        unsigned long length = zl->length;
+
+        if (round == 0) start = 1;
+        count = start > length ? 0 : ((end < length ? end : length) - start + 1);
+        TEST_ASSERT_EQUAL(count, zslDeleteRangeByRank(zl, start, end, NULL, NULL));
+        zslCheckList(zl, length - count);
+    }
+    TEST_ASSERT_EQUAL(0, zslDeleteRangeByRank(zl, 10, 5, NULL, NULL));
+    TEST_ASSERT_EQUAL(zl->length, zslDeleteRangeByRank(zl, 1, zl->length, NULL, NULL));
+    zslCheckList(zl, 0);
+    TEST_ASSERT_EQUAL(1, zl->level);
+    zslFree(zl);
+
+    /* By element, on a bulk loaded skiplist with a single score. */
+    zl = zslCreateInline(NULL, 16);
+    for (j = 0; j < 3000; j++) {
+        entries[j].score = 0;
+        entries[j].ele = eles[j];
+        entries[j].size = 16;
+    }
+    TEST_ASSERT_EQUAL(0, zslBulkLoad(zl, entries, 3000));
+    memset(deleted, 0, sizeof(deleted));
+    {
+        zlexrangespec all = { NULL, NULL, 0, 0, 0, 0 };
+        zlexrangespec range = { eles[100], eles[200], 16, 16, 1, 0 };
+        zlexrangespec empty = { eles[200], eles[100], 16, 16, 0, 0 };
+
+        TEST_ASSERT_EQUAL(3000, zslCountInLexRange(zl, &all));
+        TEST_ASSERT_EQUAL(100, zslCountInLexRange(zl, &range));
+        TEST_ASSERT_EQUAL(0, zslCountInLexRange(zl, &empty));
+        TEST_ASSERT_EQUAL(0, zslDeleteRangeByLex(zl, &empty, zslTestFreeEle, deleted));
+        TEST_ASSERT_EQUAL(100, zslDeleteRangeByLex(zl, &range, zslTestFreeEle, deleted));
+        zslCheckList(zl, 2900);
+        for (j = 0; j < 3000; j++)
+            TEST_ASSERT_EQUAL(j > 100 && j <= 200, deleted[j]);
+        range.min = NULL;
+        range.max = eles[999];
+        range.maxex = 1;
+        TEST_ASSERT_EQUAL(899, zslDeleteRangeByLex(zl, &range, NULL, NULL));
+        zslCheckList(zl, 2001);
+        TEST_ASSERT_EQUAL(2, zslGetRank(zl, 0, eles[1000], 16));
+    }
+    zslFree(zl);
+}